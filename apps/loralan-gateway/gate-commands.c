@@ -44,11 +44,210 @@ extern "C" {
 #include "ls-config.h"
 #include "ls-settings.h"
 #include "periph/rtc.h"
+#include "gate-proto.h"
 
-static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, char *data) {
+/* UART protocol mode, switched by the host with CMD_SET_PROTOCOL */
+static volatile gp_mode_t protocol = GP_MODE_TEXT;
+
+static void put_be(uint8_t *buf, uint64_t v, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		buf[size - 1 - i] = v & 0xFF;
+		v >>= 8;
+	}
+}
+
+static uint64_t get_be(const uint8_t *buf, size_t size) {
+	uint64_t v = 0;
+	for (size_t i = 0; i < size; i++) {
+		v = (v << 8) | buf[i];
+	}
+
+	return v;
+}
+
+static bool push_binary(gc_pending_fifo_t *fifo, const uint8_t *data, size_t len) {
+	uint8_t frame[GC_MAX_REPLY_LEN];
+	size_t size = gp_frame_encode(data, len, frame, sizeof(frame));
+
+	if (size == 0) {
+		puts("gc: reply is too long");
+		return false;
+	}
+
+	return gc_pending_fifo_push_n(fifo, (char *) frame, size);
+}
+
+static void flush(kernel_pid_t writer) {
+	msg_t msg;
+	msg_send(&msg, writer);
+}
+
+static void send_devlist(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo) {
 	ls_gate_devices_t *devs = &ls->devices;
-	ls_gate_channel_t *channels = ls->channels;
 
+	for (int i = 0; i < LS_GATE_MAX_NODES; i++) {
+		if (!ls_devlist_is_in_network(devs, i)) {
+			continue;
+		}
+
+		ls_gate_node_t *node = &devs->nodes[i];
+		uint32_t last_seen = (ls->_internal.ping_count - node->last_seen) * LS_PING_TIMEOUT_S;
+		char reply[GC_MAX_REPLY_LEN];
+		size_t len;
+
+		if (protocol == GP_MODE_BINARY) {
+			/* L, node ID, app ID, seconds since last seen, class */
+			uint8_t buf[1 + 8 + 8 + 4 + 1];
+			buf[0] = REPLY_LIST;
+			put_be(buf + 1, node->node_id, 8);
+			put_be(buf + 9, node->app_id, 8);
+			put_be(buf + 17, last_seen, 4);
+			buf[21] = node->node_class;
+
+			len = gp_frame_encode(buf, sizeof(buf), (uint8_t *) reply, sizeof(reply));
+		} else {
+			/* L */
+			len = sprintf(reply, "%c%08X%08X%08X%08X%04X%04X\n", REPLY_LIST,
+					(unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF),
+					(unsigned int) (node->app_id >> 32), (unsigned int) (node->app_id & 0xFFFFFFFF),
+					(unsigned int) last_seen,
+					(unsigned int) node->node_class);
+		}
+
+		/* List is much longer than the FIFO, hand it over to the writer as it fills up
+		 * and sleep until the writer has taken a reply out */
+		while (!gc_pending_fifo_push_n(fifo, reply, len)) {
+			flush(writer);
+			gc_pending_fifo_wait_space(fifo);
+		}
+	}
+
+	flush(writer);
+}
+
+static void send_ind(ls_gate_t *ls, uint64_t nodeid, uint8_t *data, size_t len) {
+	ls_gate_node_t *node = ls_devlist_get_by_nodeid(&ls->devices, nodeid);
+	if (node == NULL) {
+		printf("[error] Node with ID %08X%08X was not found.\n",
+				(unsigned int) (nodeid >> 32),
+				(unsigned int) (nodeid & 0xFFFFFFFF));
+		return;
+	}
+
+	/* Send LoRa message */
+	ls_gate_send_to(ls, node->addr, data, len);
+}
+
+static void set_pending(ls_gate_t *ls, uint64_t nodeid, uint8_t num_pending) {
+	ls_gate_node_t *node = ls_devlist_get_by_nodeid(&ls->devices, nodeid);
+	if (node == NULL) {
+		puts("[error] Node with specified node ID is not found.\n");
+		return;
+	}
+
+	node->num_pending = num_pending;
+
+	printf("[pending] setting node 0x%08X%08X has %u frames pending\n",
+			(unsigned int) (node->node_id >> 32),
+			(unsigned int) (node->node_id & 0xFFFFFFFF), num_pending);
+}
+
+static void invite(ls_gate_t *ls, uint64_t nodeid) {
+	printf("[invite] Sending invite to node with ID 0x%08X%08X\n",
+			(unsigned int) (nodeid >> 32),
+			(unsigned int) (nodeid & 0xFFFFFFFF));
+
+	ls_gate_invite(ls, nodeid);
+}
+
+static void add_static(ls_gate_t *ls, uint64_t nodeid, uint64_t appid, ls_addr_t addr, uint32_t dev_nonce, uint8_t channel) {
+	ls_gate_devices_t *devs = &ls->devices;
+
+	if (addr >= LS_GATE_MAX_NODES) {
+		printf("[error] Unable to add node with address %u >= %u\n", (unsigned int) addr, (unsigned int) LS_GATE_MAX_NODES);
+		return;
+	}
+
+	if (channel >= ls->num_channels) {
+		printf("[error] Unable to add node on channel %u >= %u\n", (unsigned int) channel, (unsigned int) ls->num_channels);
+		return;
+	}
+
+	printf("[gate-commands] Added device: ");
+	printf("eui: 0x%08X%08X ",
+					(unsigned int) (nodeid >> 32),
+					(unsigned int) (nodeid & 0xFFFFFFFF));
+	printf("appid: 0x%08X%08X ",
+					(unsigned int) (appid >> 32),
+					(unsigned int) (appid & 0xFFFFFFFF));
+
+	printf("addr: 0x%08X ", (unsigned int) addr);
+	printf("nonce: 0x%08X ", (unsigned int) dev_nonce);
+	printf("ch: 0x%02X\n", (unsigned int) channel);
+
+	/* Kick previous device if present */
+	if (ls_devlist_is_in_network(devs, addr)) {
+		ls_devlist_remove_device(devs, addr);
+	}
+
+	/* Add device with specified nonce and address */
+	ls_gate_node_t *node = ls_devlist_add_by_addr(devs, addr, nodeid, appid, dev_nonce, &ls->channels[channel]);
+	if (node == NULL)
+		return;
+
+	node->app_nonce = 0;
+}
+
+static void kick_all_static(ls_gate_t *ls) {
+	ls_gate_devices_t *devs = &ls->devices;
+
+	for (int i = 0; i < LS_GATE_MAX_NODES; i++) {
+		if (ls_devlist_is_in_network(devs, i)) {
+			if (devs->nodes[i].is_static) {
+				/* Remove device */
+				ls_devlist_remove_device(devs, i);
+			}
+		}
+	}
+
+	puts("[gate-commands] All statically personalized devices are kicked");
+}
+
+static void set_joinkey(uint8_t joinkey[16]) {
+	uint64_t appid64 = config_get_appid();
+
+	if (config_write_main_block(appid64, joinkey, 0)) {
+		char s[33] = {};
+		bytes_to_hex(joinkey, 16, s, false);
+		printf("[ok] JOINKEY = %s\n", s);
+	} else {
+		printf("[error] Error saving config\n");
+	}
+}
+
+static void set_protocol(kernel_pid_t writer, gc_pending_fifo_t *fifo, uint8_t mode) {
+	if (mode > GP_MODE_BINARY) {
+		printf("[error] Unsupported protocol mode %u\n", (unsigned int) mode);
+		return;
+	}
+
+	/* Confirmation is sent in the current mode, host switches after receiving it */
+	if (protocol == GP_MODE_BINARY) {
+		uint8_t buf[2] = { REPLY_PROTOCOL, mode };
+		push_binary(fifo, buf, sizeof(buf));
+	} else {
+		char buf[5];
+		sprintf(buf, "%c%02X\n", REPLY_PROTOCOL, (unsigned int) mode);
+		gc_pending_fifo_push(fifo, buf);
+	}
+
+	flush(writer);
+
+	protocol = (gp_mode_t) mode;
+	printf("[gate-commands] Protocol mode: %s\n", (mode == GP_MODE_BINARY) ? "binary" : "text");
+}
+
+static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, char *data) {
 	gate_cmd_type_t c = data[0];
 	char *payload = data + 1;
 
@@ -58,29 +257,12 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 		gc_pending_fifo_push(fifo, "!\n");
 
 		/* Send flush message */
-		msg_t msg;
-		msg_send(&msg, writer);
+		flush(writer);
 
 		break;
 
 	case CMD_DEVLIST:
-		for (int i = 0; i < LS_GATE_MAX_NODES; i++) {
-			if (!devs->nodes_free_list[i]) {
-				char buf[128];
-
-				/* L */
-				sprintf(buf, "%c%08X%08X%08X%08X%04X%04X\n", REPLY_LIST,
-						(unsigned int) (devs->nodes[i].node_id >> 32), (unsigned int) (devs->nodes[i].node_id & 0xFFFFFFFF),
-						(unsigned int) (devs->nodes[i].app_id >> 32), (unsigned int) (devs->nodes[i].app_id & 0xFFFFFFFF),
-						(unsigned int) ((ls->_internal.ping_count - devs->nodes[i].last_seen) * LS_PING_TIMEOUT_S),
-						(unsigned int) devs->nodes[i].node_class);
-
-				if (!gc_pending_fifo_push(fifo, buf)) {
-					puts("gc: pending fifo overflowed!");
-				}
-			}
-		}
-
+		send_devlist(ls, writer, fifo);
 		break;
 
 	case CMD_IND: {
@@ -96,14 +278,6 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 			return;
 		}
 
-		ls_gate_node_t *node = ls_devlist_get_by_nodeid(devs, nodeid);
-		if (node == NULL) {
-			printf("[error] Node with ID %08X%08X was not found.\n",
-                    (unsigned int) (nodeid >> 32),
-                    (unsigned int) (nodeid & 0xFFFFFFFF));
-			return;
-		}
-
 		/* Skip nodeid */
 		payload += 16;
 
@@ -120,15 +294,13 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 			return;
 		}
 
-		/* Send LoRa message */
-		ls_gate_send_to(ls, node->addr, a, numdigits / 2);
+		send_ind(ls, nodeid, a, numdigits / 2);
 		break;
 	}
 
 	case CMD_FLUSH: {
 		/* Send flush message */
-		msg_t msg;
-		msg_send(&msg, writer);
+		flush(writer);
 		break;
 	}
 
@@ -145,22 +317,10 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 			return;
 		}
 
-		ls_gate_node_t *node = ls_devlist_get_by_nodeid(devs, nodeid);
-		if (node == NULL) {
-			puts("[error] Node with specified node ID is not found.\n");
-			return;
-		}
-
 		/* Skip nodeid */
 		payload += 16;
 
-		uint8_t num_pending = strtol(payload, NULL, 16);
-		node->num_pending = num_pending;
-
-		printf("[pending] setting node 0x%08X%08X has %u frames pending\n",
-				(unsigned int) (node->node_id >> 32),
-				(unsigned int) (node->node_id & 0xFFFFFFFF), num_pending);
-
+		set_pending(ls, nodeid, strtol(payload, NULL, 16));
 		break;
 	}
 
@@ -177,11 +337,7 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 			return;
 		}
 
-		printf("[invite] Sending invite to node with ID 0x%08X%08X\n",
-				(unsigned int) (nodeid >> 32),
-				(unsigned int) (nodeid & 0xFFFFFFFF));
-
-		ls_gate_invite(ls, nodeid);
+		invite(ls, nodeid);
 		break;
 	}
 
@@ -235,11 +391,6 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 			return;
 		}
 
-		if (addr >= LS_GATE_MAX_NODES) {
-			printf("[error] Unable to add node with address %u >= %u\n", (unsigned int) addr, (unsigned int) LS_GATE_MAX_NODES);
-			return;
-		}
-
 		/* Skip address */
 		payload += 8;
 
@@ -258,45 +409,12 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 			return;
 		}
 
-		printf("[gate-commands] Added device: ");
-		printf("eui: 0x%08X%08X ",
-						(unsigned int) (nodeid >> 32),
-						(unsigned int) (nodeid & 0xFFFFFFFF));
-		printf("appid: 0x%08X%08X ",
-						(unsigned int) (appid >> 32),
-						(unsigned int) (appid & 0xFFFFFFFF));
-
-		printf("addr: 0x%08X ", (unsigned int) addr);
-		printf("nonce: 0x%08X ", (unsigned int) dev_nonce);
-		printf("ch: 0x%02X\n", (unsigned int) channel);
-
-		/* Kick previous device if present */
-		if (ls_devlist_is_in_network(devs, addr)) {
-			ls_devlist_remove_device(devs, addr);
-		}
-
-		/* Add device with specified nonce and address */
-		ls_gate_node_t *node = ls_devlist_add_by_addr(devs, addr, nodeid, appid, dev_nonce, &channels[channel]);
-		if (node == NULL)
-			return;
-
-		node->app_nonce = 0;
-
+		add_static(ls, nodeid, appid, addr, dev_nonce, channel);
 		break;
 	}
 
 	case CMD_KICK_ALL_STATIC: {
-		for (int i = 0; i < LS_GATE_MAX_NODES; i++) {
-			if (!devs->nodes_free_list[i]) {
-				if (devs->nodes[i].is_static) {
-					/* Remove device */
-					ls_devlist_remove_device(devs, i);
-				}
-			}
-		}
-
-		puts("[gate-commands] All statically personalized devices are kicked");
-
+		kick_all_static(ls);
 		break;
 	}
     
@@ -339,21 +457,13 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 		}
         
         uint8_t joinkey[16] = {};
-        uint64_t appid64 = config_get_appid();
 
         if (!hex_to_bytes(payload, joinkey, false)) {
         	printf("[error] Invalid hex data received: %s\n", payload);
 			return;
 		}
              
-        if (config_write_main_block(appid64, joinkey, 0)) {
-            char s[32] = {};
-            bytes_to_hex(joinkey, 16, s, false);
-            printf("[ok] JOINKEY = %s\n", s);
-        } else {
-            printf("[error] Error saving config\n");
-        }
-        
+        set_joinkey(joinkey);
         break;
     }
     case CMD_REBOOT: {
@@ -365,6 +475,17 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
         NVIC_SystemReset();
         break;
     }
+    case CMD_SET_PROTOCOL: {
+        /* Two hex digits of mode and EOL character */
+        uint8_t mode = 0;
+        if ((strlen(payload) != 3) || !hex_to_bytesn(payload, 2, &mode, true)) {
+            printf("[error] Invalid command received: %s\n", data);
+            return;
+        }
+
+        set_protocol(writer, fifo, mode);
+        break;
+    }
 
 	default:
 		printf("[gate-commands] Unsupported: %s\n", data);
@@ -372,10 +493,211 @@ static void exec_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *
 	}
 }
 
+/* Arguments are raw big-endian fields in the same order as in text commands */
+static void exec_binary_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, uint8_t *data, size_t len) {
+	gate_cmd_type_t c = data[0];
+	uint8_t *payload = data + 1;
+	size_t payload_len = len - 1;
+
+	switch (c) {
+	case CMD_PING: {
+		uint8_t pong = REPLY_PONG;
+		push_binary(fifo, &pong, 1);
+		flush(writer);
+		break;
+	}
+
+	case CMD_DEVLIST:
+		send_devlist(ls, writer, fifo);
+		break;
+
+	case CMD_IND:
+		if ((payload_len < 8 + 1) || (payload_len > 8 + UNWDS_MAX_DATA_LEN + 2)) {
+			break;
+		}
+		send_ind(ls, get_be(payload, 8), payload + 8, payload_len - 8);
+		return;
+
+	case CMD_FLUSH:
+		flush(writer);
+		return;
+
+	case CMD_HAS_PENDING:
+		if (payload_len != 8 + 1) {
+			break;
+		}
+		set_pending(ls, get_be(payload, 8), payload[8]);
+		return;
+
+	case CMD_INVITE:
+		if (payload_len != 8) {
+			break;
+		}
+		invite(ls, get_be(payload, 8));
+		return;
+
+	case CMD_BROADCAST:
+		if ((payload_len == 0) || (payload_len > UNWDS_MAX_DATA_LEN + 2)) {
+			break;
+		}
+		ls_gate_broadcast(ls, payload, payload_len);
+		return;
+
+	case CMD_ADD_STATIC_DEV:
+		/* Node ID, app ID, address, device nonce, channel */
+		if (payload_len != 8 + 8 + 4 + 4 + 1) {
+			break;
+		}
+		add_static(ls, get_be(payload, 8), get_be(payload + 8, 8), get_be(payload + 16, 4),
+				   get_be(payload + 20, 4), payload[24]);
+		return;
+
+	case CMD_KICK_ALL_STATIC:
+		kick_all_static(ls);
+		return;
+
+	case CMD_SET_REGION:
+		if (payload_len != 1) {
+			break;
+		}
+		unwds_set_region(payload[0]);
+		return;
+
+	case CMD_SET_DATARATE:
+		if (payload_len != 1) {
+			break;
+		}
+		unwds_set_dr(payload[0]);
+		return;
+
+	case CMD_SET_CHANNEL:
+		if (payload_len != 1) {
+			break;
+		}
+		unwds_set_channel(payload[0]);
+		return;
+
+	case CMD_SET_JOINKEY:
+		if (payload_len != 16) {
+			break;
+		}
+		set_joinkey(payload);
+		return;
+
+	case CMD_REBOOT:
+		NVIC_SystemReset();
+		return;
+
+	case CMD_FW_UPDATE:
+		rtc_save_backup(RTC_REGBACKUP_BOOTLOADER_VALUE, RTC_REGBACKUP_BOOTLOADER);
+		NVIC_SystemReset();
+		return;
+
+	case CMD_SET_PROTOCOL:
+		if (payload_len != 1) {
+			break;
+		}
+		set_protocol(writer, fifo, payload[0]);
+		return;
+
+	default:
+		printf("[gate-commands] Unsupported binary command 0x%02X\n", (unsigned int) c);
+		return;
+	}
+
+	printf("[error] Invalid binary command 0x%02X, %u bytes\n", (unsigned int) c, (unsigned int) len);
+}
+
 void gc_parse_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, char *cmd) {
 	exec_command(ls, writer, fifo, cmd);
 }
 
+void gc_parse_binary_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, uint8_t *frame, size_t len) {
+	int data_len = gp_frame_decode(frame, len);
+	if (data_len <= 0) {
+		printf("[error] Damaged binary frame, %u bytes\n", (unsigned int) len);
+		return;
+	}
+
+	exec_binary_command(ls, writer, fifo, frame, data_len);
+}
+
+gp_mode_t gc_get_protocol(void) {
+	return protocol;
+}
+
+void gc_reply_node(gc_pending_fifo_t *fifo, gate_reply_type_t type, uint64_t node_id) {
+	if (protocol == GP_MODE_BINARY) {
+		uint8_t buf[1 + 8];
+		buf[0] = type;
+		put_be(buf + 1, node_id, 8);
+
+		push_binary(fifo, buf, sizeof(buf));
+	} else {
+		char str[19] = {};
+		sprintf(str, "%c%08X%08X\n", type, (unsigned int) (node_id >> 32), (unsigned int) (node_id & 0xFFFFFFFF));
+
+		gc_pending_fifo_push(fifo, str);
+	}
+}
+
+void gc_reply_join(gc_pending_fifo_t *fifo, uint64_t node_id, uint8_t node_class) {
+	if (protocol == GP_MODE_BINARY) {
+		uint8_t buf[1 + 8 + 1];
+		buf[0] = REPLY_JOIN;
+		put_be(buf + 1, node_id, 8);
+		buf[9] = node_class;
+
+		push_binary(fifo, buf, sizeof(buf));
+	} else {
+		char str[32] = {};
+		sprintf(str, "%c%08X%08X%u\n", REPLY_JOIN, (unsigned int) (node_id >> 32), (unsigned int) (node_id & 0xFFFFFFFF), (unsigned int) node_class);
+
+		gc_pending_fifo_push(fifo, str);
+	}
+}
+
+void gc_reply_data(gc_pending_fifo_t *fifo, uint64_t node_id, int16_t rssi, uint8_t status, uint8_t *data, size_t len) {
+	if (protocol == GP_MODE_BINARY) {
+		/* I, node ID, RSSI, status, data */
+		uint8_t buf[1 + 8 + 2 + 1 + UNWDS_MAX_DATA_LEN + 2];
+		if (len > UNWDS_MAX_DATA_LEN + 2) {
+			len = UNWDS_MAX_DATA_LEN + 2;
+		}
+
+		buf[0] = REPLY_IND;
+		put_be(buf + 1, node_id, 8);
+		put_be(buf + 9, (uint16_t) rssi, 2);
+		buf[11] = status;
+		memcpy(buf + 12, data, len);
+
+		push_binary(fifo, buf, 12 + len);
+	} else {
+		/* Type, node ID, RSSI and status take 1 + 16 + 4 + 2 characters, plus '\n' and '\0' */
+		char hex[GC_MAX_REPLY_LEN - 25] = {};
+		if (len > (sizeof(hex) - 1) / 2) {
+			len = (sizeof(hex) - 1) / 2;
+		}
+
+		char buf_rssi[5] = {};
+		bytes_to_hex((uint8_t *) &rssi, 2, buf_rssi, true);
+
+		char buf_status[3]  = {};
+		bytes_to_hex(&status, 1, buf_status, true);
+
+		bytes_to_hex(data, len, hex, false);
+
+		char str[GC_MAX_REPLY_LEN] = { };
+		sprintf(str, "%c%08X%08X%s%s%s\n", REPLY_IND,
+				(unsigned int) (node_id >> 32), (unsigned int) (node_id & 0xFFFFFFFF),
+				buf_rssi,
+				buf_status,
+				hex);
+
+		gc_pending_fifo_push(fifo, str);
+	}
+}
+
 #ifdef __cplusplus
 }
 #endif
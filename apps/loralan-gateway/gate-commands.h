@@ -33,6 +33,7 @@
 
 #include "ls-gate.h"
 #include "pending-fifo.h"
+#include "gate-proto.h"
 
 typedef enum {
 	CMD_PING = 'P',				/* Command to ping/pong with client */
@@ -53,6 +54,7 @@ typedef enum {
     CMD_SET_JOINKEY = 'J',
     CMD_REBOOT = 'R',
     CMD_FW_UPDATE = 'U',
+    CMD_SET_PROTOCOL = 'M',		/* Switches UART protocol mode, see gp_mode_t */
 } gate_cmd_type_t;
 
 typedef enum {
@@ -66,8 +68,38 @@ typedef enum {
 	REPLY_ACK = 'A',		/* Application data acknowledged by the node */
 
 	REPLY_PENDING_REQ = 'R', /* Gate requesting pending frames from upper layer */
+
+	REPLY_PROTOCOL = 'M',	/* Protocol mode switch confirmation, sent in the previous mode */
 } gate_reply_type_t;
 
+/**
+ * @brief Executes text command terminated by EOL character.
+ */
 void gc_parse_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, char *cmd);
 
+/**
+ * @brief Decodes binary frame in place and executes the command.
+ */
+void gc_parse_binary_command(ls_gate_t *ls, kernel_pid_t writer, gc_pending_fifo_t *fifo, uint8_t *frame, size_t len);
+
+/**
+ * @brief Returns current UART protocol mode.
+ */
+gp_mode_t gc_get_protocol(void);
+
+/**
+ * @brief Queues reply carrying only node ID (kick, ack, pending frames request).
+ */
+void gc_reply_node(gc_pending_fifo_t *fifo, gate_reply_type_t type, uint64_t node_id);
+
+/**
+ * @brief Queues node joined reply.
+ */
+void gc_reply_join(gc_pending_fifo_t *fifo, uint64_t node_id, uint8_t node_class);
+
+/**
+ * @brief Queues application data received from the node.
+ */
+void gc_reply_data(gc_pending_fifo_t *fifo, uint64_t node_id, int16_t rssi, uint8_t status, uint8_t *data, size_t len);
+
 #endif /* GATE_COMMANDS_H_ */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2016-2018 Unwired Devices LLC <info@unwds.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @defgroup
+ * @ingroup
+ * @brief
+ * @{
+ * @file		gate-proto.c
+ * @brief       Binary framing of the gate UART protocol
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "checksum/crc16_ccitt.h"
+
+#include "gate-proto.h"
+
+size_t gp_frame_encode(const uint8_t *data, size_t len, uint8_t *out, size_t outsize)
+{
+	if (outsize < GP_ENCODED_SIZE(len)) {
+		return 0;
+	}
+
+	uint16_t crc = crc16_ccitt_calc(data, len);
+	uint8_t crc_buf[GP_CRC_SIZE] = { crc >> 8, crc & 0xFF };
+
+	/* COBS: every zero is replaced by the distance to the next one */
+	size_t code_idx = 0;
+	size_t out_idx = 1;
+	uint8_t code = 1;
+
+	for (size_t i = 0; i < len + GP_CRC_SIZE; i++) {
+		uint8_t b = (i < len) ? data[i] : crc_buf[i - len];
+
+		if (b != 0) {
+			out[out_idx++] = b;
+			code++;
+		}
+
+		if ((b == 0) || (code == 0xFF)) {
+			out[code_idx] = code;
+			code_idx = out_idx++;
+			code = 1;
+		}
+	}
+
+	out[code_idx] = code;
+	out[out_idx++] = GP_DELIMITER;
+
+	return out_idx;
+}
+
+int gp_frame_decode(uint8_t *buf, size_t len)
+{
+	if ((len > 0) && (buf[len - 1] == GP_DELIMITER)) {
+		len--;
+	}
+
+	size_t in_idx = 0;
+	size_t out_idx = 0;
+
+	while (in_idx < len) {
+		uint8_t code = buf[in_idx++];
+
+		if ((code == 0) || (in_idx + code - 1 > len)) {
+			return -1;
+		}
+
+		for (uint8_t i = 1; i < code; i++) {
+			buf[out_idx++] = buf[in_idx++];
+		}
+
+		/* Group shorter than maximum ends with zero, except the last one */
+		if ((code != 0xFF) && (in_idx < len)) {
+			buf[out_idx++] = 0;
+		}
+	}
+
+	if (out_idx < 1 + GP_CRC_SIZE) {
+		return -1;
+	}
+
+	size_t data_len = out_idx - GP_CRC_SIZE;
+	uint16_t crc = (buf[data_len] << 8) | buf[data_len + 1];
+
+	if (crc16_ccitt_calc(buf, data_len) != crc) {
+		return -1;
+	}
+
+	return data_len;
+}
+
+#ifdef __cplusplus
+}
+#endif
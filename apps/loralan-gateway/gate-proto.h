@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016-2018 Unwired Devices LLC <info@unwds.com>
+
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software
+ * is furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @defgroup
+ * @ingroup
+ * @brief
+ * @{
+ * @file		gate-proto.h
+ * @brief       Binary framing of the gate UART protocol
+ *
+ * Binary frame is the command or reply type byte, raw big-endian arguments
+ * and CRC16-CCITT of both (big-endian), COBS-encoded and terminated by 0x00.
+ */
+#ifndef GATE_PROTO_H_
+#define GATE_PROTO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Binary frames delimiter, COBS guarantees it never appears inside a frame
+ */
+#define GP_DELIMITER 0x00
+
+/**
+ * @brief Size of the frame CRC
+ */
+#define GP_CRC_SIZE 2
+
+/**
+ * @brief Worst-case size of the encoded frame carrying len bytes, including CRC and delimiter
+ */
+#define GP_ENCODED_SIZE(len) ((len) + GP_CRC_SIZE + (((len) + GP_CRC_SIZE) / 254) + 1 + 1)
+
+/**
+ * @brief UART protocol modes
+ */
+typedef enum {
+	GP_MODE_TEXT = 0,		/**< Hex-encoded text lines */
+	GP_MODE_BINARY = 1,		/**< COBS-framed binary with CRC16 */
+} gp_mode_t;
+
+/**
+ * @brief Encodes data into the binary frame.
+ *
+ * @param	data	frame content, starting with the type byte
+ * @param	len		length of the content
+ * @param	out		output buffer
+ * @param	outsize	size of the output buffer
+ *
+ * @return	number of bytes written including delimiter, 0 if output buffer is too small
+ */
+size_t gp_frame_encode(const uint8_t *data, size_t len, uint8_t *out, size_t outsize);
+
+/**
+ * @brief Decodes the binary frame in place and checks its CRC.
+ *
+ * @param	buf		received frame with or without delimiter
+ * @param	len		length of the received frame
+ *
+ * @return	length of the frame content without CRC, -1 if frame is malformed or damaged
+ */
+int gp_frame_decode(uint8_t *buf, size_t len);
+
+#endif /* GATE_PROTO_H_ */
@@ -119,7 +119,8 @@ static void rx_cb(void *arg, uint8_t data)
     
     ringbuffer_add_one(&rx_buf, data);
 
-    if (data == EOL) {
+    char delimiter = (gc_get_protocol() == GP_MODE_BINARY) ? GP_DELIMITER : EOL;
+    if (data == delimiter) {
         msg_t msg;
         msg_send(&msg, gate_reader_pid);
     }
@@ -139,8 +140,9 @@ static void *writer(void *arg)
 
         char buf[GC_MAX_REPLY_LEN];
         while (!gc_pending_fifo_empty(&fifo)) {
-            if (gc_pending_fifo_pop(&fifo, buf)) {
-                uart_write(uart, (uint8_t *) buf, strlen(buf));
+            size_t len = gc_pending_fifo_pop(&fifo, buf);
+            if (len > 0) {
+                uart_write(uart, (uint8_t *) buf, len);
             }
         }
     }
@@ -160,6 +162,27 @@ static void *reader(void *arg)
     while (1) {
         msg_receive(&msg);
 
+        if (gc_get_protocol() == GP_MODE_BINARY) {
+            /* Binary frame ends with zero byte, COBS guarantees there are no others in it */
+            size_t i = 0;
+            int c;
+            while ((c = ringbuffer_get_one(&rx_buf)) >= 0) {
+                if (c == GP_DELIMITER) {
+                    break;
+                }
+
+                if (i < sizeof(buf)) {
+                    buf[i++] = c;
+                }
+            }
+
+            /* Empty frame is sent by the host to resynchronize */
+            if (i > 0) {
+                gc_parse_binary_command(&ls, writer_pid, &fifo, (uint8_t *) buf, i);
+            }
+            continue;
+        }
+
         char c;
         int i = 0;
         do {
@@ -232,11 +255,7 @@ static void node_kicked_cb(ls_gate_node_t *node)
 {
     printf("ls-gate: node 0x%08X%08X kicked for long silence\n", (unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF));
 
-    char str[18] = {};
-
-    sprintf(str, "%c%08X%08X\n", REPLY_KICK, (unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF));
-
-    gc_pending_fifo_push(&fifo, str);
+    gc_reply_node(&fifo, REPLY_KICK, node->node_id);
 }
 
 static uint32_t node_joined_cb(ls_gate_node_t *node)
@@ -246,10 +265,7 @@ static uint32_t node_joined_cb(ls_gate_node_t *node)
            (unsigned int) node->addr);
 
     /* Notify the gate */
-    char str[128] = { '\0' };
-    sprintf(str, "%c%08X%08X%u\n", REPLY_JOIN, (unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF), (unsigned int) node->node_class);
-
-    gc_pending_fifo_push(&fifo, str);
+    gc_reply_join(&fifo, node->node_id, node->node_class);
 
     /* Return random app nonce */
     return sx127x_random(&sx127x);
@@ -265,29 +281,9 @@ static bool accept_node_join_cb(uint64_t dev_id, uint64_t app_id)
 
 void app_data_received_cb(ls_gate_node_t *node, ls_gate_channel_t *ch, uint8_t *buf, size_t bufsize, uint8_t status)
 {
-    char hex[GC_MAX_REPLY_LEN - 19] = {};
-    if (bufsize > sizeof(hex))
-    	bufsize = sizeof(hex);
-
-    int16_t rssi = ch->last_rssi;
-
-    char buf_rssi[5] = {};
-    bytes_to_hex((uint8_t *) &rssi, 2, buf_rssi, true);
-    
-    char buf_status[5]  = {};
-    bytes_to_hex(&status, 1, buf_status, true);
-
-    bytes_to_hex(buf, bufsize, hex, false);
-    printf("Data: %u bytes, 0x%s\n", bufsize, hex);
-
-    char str[GC_MAX_REPLY_LEN] = { };
-    sprintf(str, "%c%08X%08X%s%s%s\n", REPLY_IND,
-    		(unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF),
-			buf_rssi,
-            buf_status,
-			hex);
+    printf("Data: %u bytes\n", (unsigned int) bufsize);
 
-    gc_pending_fifo_push(&fifo, str);
+    gc_reply_data(&fifo, node->node_id, ch->last_rssi, status, buf, bufsize);
 }
 
 void app_data_ack_cb(ls_gate_node_t *node, ls_gate_channel_t *ch)
@@ -296,20 +292,13 @@ void app_data_ack_cb(ls_gate_node_t *node, ls_gate_channel_t *ch)
     
     printf("ls-gate: data acknowledged from 0x%08X%08X\n", (unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF));
 
-    char str[18] = {};
-
-    sprintf(str, "%c%08X%08X\n", REPLY_ACK, (unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF));
-
-    gc_pending_fifo_push(&fifo, str);
+    gc_reply_node(&fifo, REPLY_ACK, node->node_id);
 }
 
 static void pending_frames_req_cb(ls_gate_node_t *node) {
 	printf("ls-gate: requesting next pending frame for 0x%08X%08X\n", (unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF));
 
-    char str[18] = {};
-    sprintf(str, "%c%08X%08X\n", REPLY_PENDING_REQ,
-    		(unsigned int) (node->node_id >> 32), (unsigned int) (node->node_id & 0xFFFFFFFF));
-    gc_pending_fifo_push(&fifo, str);
+    gc_reply_node(&fifo, REPLY_PENDING_REQ, node->node_id);
 }
 
 static void ls_setup(ls_gate_t *ls)
@@ -403,10 +392,12 @@ static int ls_list_cmd(int argc, char **argv)
     ls_gate_devices_t *devs = &ls.devices;
 
     printf("Total devices: %d\n", (unsigned int) devs->num_nodes);
+    printf("Kicked for idle: %u on last ping, %u total\n",
+           (unsigned int) ls._internal.kicked_last_ping, (unsigned int) ls._internal.kicked_total);
     printf("num.\t|\taddr.\t\t|\tnode id.\t\t|\tapp id.\t\t\t|\tlast seen\n");
 
     for (int i = 0; i < LS_GATE_MAX_NODES; i++) {
-        if (!devs->nodes_free_list[i]) {
+        if (ls_devlist_is_in_network(devs, i)) {
             printf("%02d.\t|\t0x%08X\t|\t0x%08X%08X\t|\t0x%08X%08X\t|\t%d sec. ago\n", (unsigned int) (i + 1),
                    (unsigned int) devs->nodes[i].addr,
                    (unsigned int) (devs->nodes[i].node_id >> 32), (unsigned int) (devs->nodes[i].node_id & 0xFFFFFFFF),
@@ -529,6 +520,27 @@ static int kick_cmd(int argc, char **argv) {
 	return -1;
 }
 
+static int channels_cmd(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    for (size_t i = 0; i < ls.num_channels; i++) {
+        ls_gate_channel_t *ch = &ls.channels[i];
+        uint16_t tx, rx;
+
+        ls_gate_channel_utilization(ch, &tx, &rx);
+
+        printf("%u. %u Hz DR%u | TX %u.%u%% | RX %u.%u%% | sent %u | failed %u | received %u | queued %u\n",
+               (unsigned int) i, (unsigned int) ch->frequency, (unsigned int) ch->dr,
+               tx / 10, tx % 10, rx / 10, rx % 10,
+               (unsigned int) ch->stats.frames_sent, (unsigned int) ch->stats.frames_failed,
+               (unsigned int) ch->stats.frames_received,
+               (unsigned int) ls_frame_fifo_size(&ch->_internal.ul_fifo));
+    }
+
+    return 0;
+}
+
 static void iwdg_reset (void *arg) {
     (void)arg;
     
@@ -544,6 +556,7 @@ shell_command_t shell_commands[UNWDS_SHELL_COMMANDS_MAX] = {
     { "list", "-- prints list of connected devices", ls_list_cmd },
 	{ "add", "<nodeid> <appid> <addr> <devnonce> <channel> -- adds node to the list", add_cmd },
 	{ "kick", "<addr> -- kicks node from the list by its address", kick_cmd},
+	{ "channels", "-- prints channels airtime utilization", channels_cmd },
     { NULL, NULL, NULL }
 };
 
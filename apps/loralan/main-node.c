@@ -70,6 +70,25 @@ extern "C" {
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
+#ifdef MODULE_SENSORLOG
+#include <time.h>
+
+#include "fs/littlefs_fs.h"
+#include "sensorlog.h"
+#include "vfs.h"
+
+#ifndef MTD_0
+#error "sensorlog needs a board with an MTD_0 flash"
+#endif
+
+/* batch buffer of one flash page */
+#ifndef NODE_LOG_BUF_SIZE
+#define NODE_LOG_BUF_SIZE   (256U)
+#endif
+#define NODE_LOG_FILE_SIZE  (4096U)
+#define NODE_LOG_FILES      (16U)
+#endif
+
 static rtctimers_millis_t iwdg_timer;
 static rtctimers_millis_t pm_enable_timer;
 
@@ -80,6 +99,99 @@ static ls_ed_t ls;
 
 static uint8_t current_join_retries = 0;
 
+#ifdef MODULE_SENSORLOG
+static littlefs_desc_t log_fs_desc;
+static vfs_mount_t log_fs = {
+    .fs = &littlefs_file_system,
+    .mount_point = "/log",
+    .private_data = &log_fs_desc,
+};
+
+static uint8_t log_buf[NODE_LOG_BUF_SIZE];
+static sensorlog_t sensorlog = {
+    .dir = "/log/data",
+    .buf = log_buf,
+    .buf_size = sizeof(log_buf),
+    .file_size = NODE_LOG_FILE_SIZE,
+    .files = NODE_LOG_FILES,
+};
+static bool log_ready = false;
+
+static void log_init(void)
+{
+    log_fs_desc.dev = MTD_0;
+
+    if (vfs_mount(&log_fs) < 0) {
+        puts("[log] formatting flash");
+        if ((vfs_format(&log_fs) < 0) || (vfs_mount(&log_fs) < 0)) {
+            puts("[error] Cannot mount the log flash");
+            return;
+        }
+    }
+
+    if (sensorlog_init(&sensorlog) < 0) {
+        puts("[error] Cannot open the data log");
+        return;
+    }
+    log_ready = true;
+
+    if (!sensorlog_empty(&sensorlog)) {
+        puts("[log] stored data will be sent after joining");
+    }
+}
+
+/* keeps app. data on the flash while the node is not joined, the uplink
+ * queue would drop the oldest data */
+static bool log_store(module_data_t *buf)
+{
+    if (!log_ready || unwds_get_node_settings().no_join || ls._internal.is_joined) {
+        return false;
+    }
+
+    struct tm t;
+    rtc_get_time(&t);
+
+    if (sensorlog_write(&sensorlog, mktime(&t), buf->data[0], buf->data, buf->length) < 0) {
+        return false;
+    }
+
+    puts("[log] data stored until the node is joined");
+    return true;
+}
+
+static int log_send(void *arg, const sensorlog_record_t *rec, const uint8_t *data)
+{
+    (void)arg;
+
+    /* leave room for the app. data delayed by the join */
+    if (ls_frame_fifo_size(&ls._internal.uplink_queue) >= LS_MAX_FRAME_FIFO_SIZE - APPDATA_FIFO_SIZE) {
+        return -1;
+    }
+
+    /* a record that was not queued stays in the log */
+    if (ls_ed_send_app_data(&ls, (uint8_t *)data, rec->len, true, false, true) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* sends stored data as long as the uplink queue has room */
+static void log_replay(void)
+{
+    if (!log_ready) {
+        return;
+    }
+
+    int res = sensorlog_replay(&sensorlog, log_send, NULL, LS_MAX_FRAME_FIFO_SIZE);
+    if (res > 0) {
+        printf("[log] %d stored records sent\n", res);
+    }
+    else if (res < 0) {
+        printf("[error] Cannot read the data log: %d\n", res);
+    }
+}
+#endif
+
 void radio_init(void)
 {
     sx127x_params_t sx127x_params;
@@ -158,6 +270,10 @@ void joined_cb(void)
 
     puts("[LoRa] successfully joined to the network");
     blink_led(LED_GREEN);
+
+#ifdef MODULE_SENSORLOG
+    log_replay();
+#endif
     
     /* Synchronize time if necessary */
     if (unwds_get_node_settings().req_time) {
@@ -626,7 +742,21 @@ shell_command_t shell_commands[UNWDS_SHELL_COMMANDS_MAX] = {
 
 static void unwds_callback(module_data_t *buf)
 {
-    int res = ls_ed_send_app_data(&ls, buf->data, buf->length, true, buf->as_ack, false);
+    int res;
+
+#ifdef MODULE_SENSORLOG
+    if (log_store(buf)) {
+        res = -LS_SEND_E_NOT_JOINED;
+    }
+    else {
+        res = ls_ed_send_app_data(&ls, buf->data, buf->length, true, buf->as_ack, false);
+        if (res == LS_OK) {
+            log_replay();
+        }
+    }
+#else
+    res = ls_ed_send_app_data(&ls, buf->data, buf->length, true, buf->as_ack, false);
+#endif
 
     if (res < 0) {
         if (res == -LS_SEND_E_FQ_OVERFLOW) {
@@ -718,6 +848,9 @@ void init_normal(shell_command_t *commands)
             blink_led(LED_GREEN);
         }
         else {
+#ifdef MODULE_SENSORLOG
+            log_init();
+#endif
             unwds_init_modules(unwds_callback);
             
             /* reset IWDG timer every 15 seconds */
@@ -45,59 +45,86 @@ extern "C" {
 
 void appdata_fifo_init(appdata_fifo_t *fifo) {
 	mutex_init(&fifo->mutex);
-	fifo->front = fifo->start = -1;
+	fifo->head = fifo->count = 0;
 }
 
-bool appdata_fifo_pop(appdata_fifo_t *fifo, appdata_fifo_entry_t *e) {
+appdata_fifo_entry_t *appdata_fifo_reserve(appdata_fifo_t *fifo) {
+	mutex_lock(&fifo->mutex);
+
+	if (appdata_fifo_full(fifo)) {
+		mutex_unlock(&fifo->mutex);
+		return NULL;
+	}
+
+	return &fifo->fifo[(fifo->head + fifo->count) % APPDATA_FIFO_SIZE];
+}
+
+void appdata_fifo_commit(appdata_fifo_t *fifo) {
+	int c = irq_disable();
+	fifo->count++;
+	irq_restore(c);
+
+	mutex_unlock(&fifo->mutex);
+}
+
+void appdata_fifo_cancel(appdata_fifo_t *fifo) {
+	mutex_unlock(&fifo->mutex);
+}
+
+appdata_fifo_entry_t *appdata_fifo_peek_ref(appdata_fifo_t *fifo) {
 	if (appdata_fifo_empty(fifo)) {
-		return false;
+		return NULL;
 	}
 
-	mutex_lock(&fifo->mutex);
+	return &fifo->fifo[fifo->head];
+}
 
-	if (e != NULL) {
-		*e = fifo->fifo[fifo->front];
+void appdata_fifo_release(appdata_fifo_t *fifo) {
+	int c = irq_disable();
+
+	if (fifo->count > 0) {
+		fifo->head = (fifo->head + 1) % APPDATA_FIFO_SIZE;
+		fifo->count--;
 	}
 
-	if (fifo->front == fifo->start) {
-		fifo->front = fifo->start = -1;
+	irq_restore(c);
+}
 
-		mutex_unlock(&fifo->mutex);
-		return true;
+bool appdata_fifo_pop(appdata_fifo_t *fifo, appdata_fifo_entry_t *e) {
+	appdata_fifo_entry_t *entry = appdata_fifo_peek_ref(fifo);
+	if (entry == NULL) {
+		return false;
 	}
-	fifo->front = (fifo->front + 1) % APPDATA_FIFO_SIZE;
 
-	mutex_unlock(&fifo->mutex);
+	if (e != NULL) {
+		*e = *entry;
+	}
+
+	appdata_fifo_release(fifo);
 	return true;
 }
 
 bool appdata_fifo_peek(appdata_fifo_t *fifo, appdata_fifo_entry_t *e) {
-	if (appdata_fifo_empty(fifo)) {
+	appdata_fifo_entry_t *entry = appdata_fifo_peek_ref(fifo);
+	if (entry == NULL) {
 		return false;
 	}
 
-	mutex_lock(&fifo->mutex);
-	*e = fifo->fifo[fifo->front];
-	mutex_unlock(&fifo->mutex);
+	*e = *entry;
 
 	return true;
 }
 
 bool appdata_fifo_push(appdata_fifo_t *fifo, uint8_t *buf, size_t bufsize, uint8_t id, bool is_confirmed, bool is_with_ack) {
-	if (appdata_fifo_full(fifo)) {
+	if (bufsize > APPDATA_FIFO_MAX_APPDATA_SIZE) {
 		return false;
 	}
 
-	int c = irq_disable();
-
-	if (appdata_fifo_empty(fifo)) {
-		fifo->front = fifo->start = 0;
-	} else {
-		fifo->start = (fifo->start + 1) % APPDATA_FIFO_SIZE;
+	appdata_fifo_entry_t *e = appdata_fifo_reserve(fifo);
+	if (e == NULL) {
+		return false;
 	}
 
-	appdata_fifo_entry_t *e = &fifo->fifo[fifo->start];
-	memset(e, 0, sizeof(appdata_fifo_entry_t));
 	memcpy(e->data, buf, bufsize);
 
 	e->size = bufsize;
@@ -106,36 +133,26 @@ bool appdata_fifo_push(appdata_fifo_t *fifo, uint8_t *buf, size_t bufsize, uint8
 	e->is_confirmed = is_confirmed;
 	e->is_with_ack = is_with_ack;
 
-	irq_restore(c);
+	appdata_fifo_commit(fifo);
 
 	return true;
 }
 
 bool appdata_fifo_full(appdata_fifo_t *fifo) {
-	return ((fifo->start + 1) % APPDATA_FIFO_SIZE) == fifo->front;
+	return fifo->count == APPDATA_FIFO_SIZE;
 }
 
 bool appdata_fifo_empty(appdata_fifo_t *fifo) {
-	return (fifo->front == -1 && fifo->start == -1);
+	return fifo->count == 0;
 }
 
 int appdata_fifo_size(appdata_fifo_t *fifo) {
-	if (appdata_fifo_empty(fifo)) {
-		return 0;
-	}
-
-	int size = fifo->start - fifo->front;
-
-	/* Front may be behind of start */
-	if (size < 0)
-		size = -size;
-
-	return size;
+	return fifo->count;
 }
 
 void appdata_fifo_clear(appdata_fifo_t *fifo) {
 	int c = irq_disable();
-	fifo->front = fifo->start = -1;
+	fifo->count = 0;
 	irq_restore(c);
 }
 
@@ -55,14 +55,16 @@ typedef struct {
 
 /**
  * @brief describes the frame queue.
+ *
+ * Same in place access as ls_frame_fifo_t: reserve/commit for the producer, peek_ref/release for the consumer
  */
 typedef struct {
 	appdata_fifo_entry_t fifo[APPDATA_FIFO_SIZE];	/**< Queue data */
 
-	int front;	/**< Pointer to the queue's front */
-	int start;	/**< Pointer to the queue's start */
+	uint8_t head;	/**< Index of the oldest entry */
+	uint8_t count;	/**< Number of committed entries */
 
-	mutex_t mutex; /**< FIFO's mutex */
+	mutex_t mutex; /**< Held by the producer from reserve till commit */
 } appdata_fifo_t;
 
 void appdata_fifo_init(appdata_fifo_t *fifo);
@@ -73,6 +75,16 @@ bool appdata_fifo_peek(appdata_fifo_t *fifo, appdata_fifo_entry_t *e);
 
 bool appdata_fifo_push(appdata_fifo_t *fifo, uint8_t *buf, size_t bufsize, uint8_t id, bool is_confirmed, bool is_with_ack);
 
+appdata_fifo_entry_t *appdata_fifo_reserve(appdata_fifo_t *fifo);
+
+void appdata_fifo_commit(appdata_fifo_t *fifo);
+
+void appdata_fifo_cancel(appdata_fifo_t *fifo);
+
+appdata_fifo_entry_t *appdata_fifo_peek_ref(appdata_fifo_t *fifo);
+
+void appdata_fifo_release(appdata_fifo_t *fifo);
+
 bool appdata_fifo_full(appdata_fifo_t *fifo);
 
 bool appdata_fifo_empty(appdata_fifo_t *fifo);
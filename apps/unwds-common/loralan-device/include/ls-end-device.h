@@ -205,9 +205,9 @@ typedef struct {
      * Blocking sending of other frames from queue until current frame is confirmed */
 	bool confirmation_required;
 
-	/* Current frame to send (to reduce stack consumption) */
+	/* Copy of the frame being transmitted (to reduce stack consumption) */
 	ls_frame_t current_frame;
-	mutex_t curr_frame_mutex; /**< Mutex on current frame */
+	mutex_t curr_frame_mutex; /**< Serializes frame enqueueing */
 
 	int16_t last_rssi;		  /**< RSSI value of the last frame received */
     
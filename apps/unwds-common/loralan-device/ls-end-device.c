@@ -185,24 +185,27 @@ static int send_frame(ls_ed_t *ls, ls_type_t type, uint8_t *buf, size_t buflen)
 
     mutex_lock(&ls->_internal.curr_frame_mutex);
 
-    ls_frame_t *frame = &ls->_internal.current_frame;
-    ls_assemble_frame(ls->_internal.dev_addr, type, buf, buflen, frame);
-
-    frame->header.fid = ls->_internal.last_fid;
-    frame->header.status = get_node_status();
-
     /* Enqueue frame */
     if (ls_frame_fifo_full(&ls->_internal.uplink_queue)) {
         DEBUG("[LoRa] remove oldest frame from queue\n");
-        ls_frame_fifo_pop(&ls->_internal.uplink_queue, NULL);
+        ls_frame_fifo_release(&ls->_internal.uplink_queue);
     }
     
-    if (!ls_frame_fifo_push(&ls->_internal.uplink_queue, frame)) {
+    /* Assemble frame right in the queue */
+    ls_frame_t *frame = ls_frame_fifo_reserve(&ls->_internal.uplink_queue);
+    if (frame == NULL) {
     	mutex_unlock(&ls->_internal.curr_frame_mutex);
         DEBUG("[LoRa] FIFO error\n");
         return -LS_SEND_E_FIFO_ERROR;
     }
 
+    ls_assemble_frame(ls->_internal.dev_addr, type, buf, buflen, frame);
+
+    frame->header.fid = ls->_internal.last_fid;
+    frame->header.status = get_node_status();
+
+    ls_frame_fifo_commit(&ls->_internal.uplink_queue);
+
     send_next(ls);
 
     mutex_unlock(&ls->_internal.curr_frame_mutex);
@@ -239,7 +242,7 @@ static bool ack_recv(ls_ed_t *ls, ls_frame_t  *frame) {
     }
 
 	/* Pop frame from uplink queue */
-	ls_frame_fifo_pop(&ls->_internal.uplink_queue, NULL);
+	ls_frame_fifo_release(&ls->_internal.uplink_queue);
 
 	/* Advance frame ID */
 	ls->_internal.last_fid++;
@@ -361,7 +364,7 @@ static bool frame_recv(ls_ed_t *ls, ls_frame_t *frame)
             /* Remove app data we've got ACK for from FIFO */
             if (!appdata_fifo_empty(&ls->_internal.appdata_fifo)) {
                 DEBUG("[LoRa] remove FIFO entry\n");
-                appdata_fifo_pop(&ls->_internal.appdata_fifo, NULL);
+                appdata_fifo_release(&ls->_internal.appdata_fifo);
             }
 
             DEBUG("[LoRa] decrypting payload\n");
@@ -380,7 +383,7 @@ static bool frame_recv(ls_ed_t *ls, ls_frame_t *frame)
             /* Remove app data we've got ACK for from FIFO */
             if (!appdata_fifo_empty(&ls->_internal.appdata_fifo)) {
                 DEBUG("[LoRa] remove FIFO entry\n");
-                appdata_fifo_pop(&ls->_internal.appdata_fifo, NULL);
+                appdata_fifo_release(&ls->_internal.appdata_fifo);
             }
 
             return ack_recv(ls, frame);
@@ -441,16 +444,13 @@ static bool frame_recv(ls_ed_t *ls, ls_frame_t *frame)
             appdata_fifo_t *fifo = &ls->_internal.appdata_fifo;
             DEBUG("[LoRa] checking FIFO after join\n");
 
-    		while(!appdata_fifo_empty(fifo)) {
-    			appdata_fifo_entry_t e;
+    		appdata_fifo_entry_t *e;
+    		while ((e = appdata_fifo_peek_ref(fifo)) != NULL) {
+    			DEBUG("[LoRa] sending delayed app. data [fid: %d, size: %d]\n", e->id, e->size);
 
-    			if (!appdata_fifo_pop(fifo, &e)) {
-    				break;
-    			}
-
-    			DEBUG("[LoRa] sending delayed app. data [fid: %d, size: %d]\n", e.id, e.size);
-
-    			ls_ed_send_app_data(ls, e.data, e.size, e.is_confirmed, e.is_with_ack, true);
+    			/* Delayed data isn't queued again, entry is copied into the uplink frame */
+    			ls_ed_send_app_data(ls, e->data, e->size, e->is_confirmed, e->is_with_ack, true);
+    			appdata_fifo_release(fifo);
     		}
             
             DEBUG("[LoRa] done\n");
@@ -723,22 +723,20 @@ static void *uq_handler(void *arg)
             continue;
         }
 
-        /* Get frame from queue top */
-        ls_frame_t *f;
-        ls_frame_t frame;
-        if (!ls_frame_fifo_peek(&ls->_internal.uplink_queue, &frame)) {
+        /* Get frame from queue top. Frame is encrypted in place, so it's copied
+         * to keep the queued one intact for retransmission */
+        ls_frame_t *f = &ls->_internal.current_frame;
+        if (!ls_frame_fifo_peek(&ls->_internal.uplink_queue, f)) {
             DEBUG("[LoRa] error getting frame from FIFO\n");
             continue;
         }
 
-        f = &frame;
-
         ls->_internal.confirmation_required = (f->header.type == LS_UL_CONF);
 
         /* Current frame is not confirmed app. data */
         if (!ls->_internal.confirmation_required) {
         	/* Remove frame from queue */
-        	ls_frame_fifo_pop(&ls->_internal.uplink_queue, NULL);
+        	ls_frame_fifo_release(&ls->_internal.uplink_queue);
 
         	/* Update frame's FID to the last one and advance it */
         	f->header.fid = ls->_internal.last_fid++;
@@ -1078,7 +1076,7 @@ int ls_ed_send_app_data(ls_ed_t *ls, uint8_t *buf, size_t buflen, bool confirmed
 
         /* Last data has priority, so we can pop oldest item from the queue if it's full */
         if (appdata_fifo_full(fifo)) {
-            appdata_fifo_pop(fifo, NULL);
+            appdata_fifo_release(fifo);
         }
 
         appdata_fifo_push(fifo, buf, buflen, ls->_internal.last_fid, confirmed, with_ack);
@@ -1092,13 +1090,12 @@ int ls_ed_send_app_data(ls_ed_t *ls, uint8_t *buf, size_t buflen, bool confirmed
         if (appdata_fifo_size(fifo) > 1) {
             DEBUG("[LoRa] FIFO is not empty, postpone new data\n");
             
-            appdata_fifo_entry_t e;
-            appdata_fifo_peek(fifo, &e);
-            DEBUG("[LoRa] send oldest data instead [fid: %d, size: %d]\n", e.id, e.size);
-            buf = e.data;
-            buflen = e.size;
-            confirmed = e.is_confirmed;
-            with_ack = e.is_with_ack;
+            appdata_fifo_entry_t *e = appdata_fifo_peek_ref(fifo);
+            DEBUG("[LoRa] send oldest data instead [fid: %d, size: %d]\n", e->id, e->size);
+            buf = e->data;
+            buflen = e->size;
+            confirmed = e->is_confirmed;
+            with_ack = e->is_with_ack;
         }
     }
 
@@ -35,6 +35,7 @@
 #include <stdbool.h>
 
 #include "mutex.h"
+#include "bloom.h"
 
 #include "ls-crypto.h"
 #include "ls-mac-types.h"
@@ -42,18 +43,108 @@
 #include "ls-frame-fifo.h"
 
 /**
- * Max device number that gate can hold simultaneously and nonce counts per device to remember
+ * Max device number that gate can hold simultaneously and size of the nonce replay filter
  * depend on available RAM
  */
 
 #if defined(CPU_FAM_STM32L4)
+    #ifndef LS_GATE_MAX_NODES
     #define LS_GATE_MAX_NODES 1000
-    #define LS_GATE_NONCES_PER_DEVICE 20
+    #endif
+    #ifndef LS_GATE_MIC_CACHE_SIZE
+    #define LS_GATE_MIC_CACHE_SIZE 128
+    #endif
+    #ifndef LS_GATE_AES_CACHE_SIZE
+    #define LS_GATE_AES_CACHE_SIZE 32
+    #endif
+    #define LS_GATE_NONCE_FILTER_BITS (64 * 1024)
 #else
+    #ifndef LS_GATE_MAX_NODES
     #define LS_GATE_MAX_NODES 100
-    #define LS_GATE_NONCES_PER_DEVICE 8
+    #endif
+    #ifndef LS_GATE_MIC_CACHE_SIZE
+    #define LS_GATE_MIC_CACHE_SIZE 16
+    #endif
+    #ifndef LS_GATE_AES_CACHE_SIZE
+    #define LS_GATE_AES_CACHE_SIZE 4
+    #endif
+    #define LS_GATE_NONCE_FILTER_BITS (8 * 1024)
 #endif
 
+/**
+ * Precomputed MIC key state takes 64 bytes, too much to keep one in every node record.
+ * States are cached in a table of LS_GATE_MIC_CACHE_SIZE slots indexed by node address,
+ * so the first LS_GATE_MIC_CACHE_SIZE addresses never evict each other
+ */
+#if (LS_GATE_MIC_CACHE_SIZE & (LS_GATE_MIC_CACHE_SIZE - 1)) != 0
+    #error "LS_GATE_MIC_CACHE_SIZE must be a power of two"
+#endif
+
+/**
+ * Expanded AES key schedules take 244 bytes each and are cached the same way in a table
+ * of LS_GATE_AES_CACHE_SIZE slots
+ */
+#if (LS_GATE_AES_CACHE_SIZE & (LS_GATE_AES_CACHE_SIZE - 1)) != 0
+    #error "LS_GATE_AES_CACHE_SIZE must be a power of two"
+#endif
+
+/**
+ * Accepted device nonces are remembered in two generations of bloom filters shared by all devices.
+ * When the current generation is full the older one is wiped and takes its place,
+ * so at least LS_GATE_NONCES_PER_GENERATION latest nonces are always remembered.
+ * 16 bits per nonce and 4 hash functions keep false positive rate of one generation below 0.3%
+ */
+#define LS_GATE_NONCES_PER_GENERATION (LS_GATE_NONCE_FILTER_BITS / 16)
+#define LS_GATE_NONCE_FILTER_HASHES 4
+
+/**
+ * Number of slots in the node ID hash index. Must be a power of two, index is kept
+ * at most half full so that open addressing probe sequences stay short
+ */
+#ifndef LS_GATE_NODEID_HASH_SIZE
+    #if LS_GATE_MAX_NODES <= 64
+        #define LS_GATE_NODEID_HASH_SIZE 128
+    #elif LS_GATE_MAX_NODES <= 128
+        #define LS_GATE_NODEID_HASH_SIZE 256
+    #elif LS_GATE_MAX_NODES <= 256
+        #define LS_GATE_NODEID_HASH_SIZE 512
+    #elif LS_GATE_MAX_NODES <= 512
+        #define LS_GATE_NODEID_HASH_SIZE 1024
+    #elif LS_GATE_MAX_NODES <= 1024
+        #define LS_GATE_NODEID_HASH_SIZE 2048
+    #elif LS_GATE_MAX_NODES <= 2048
+        #define LS_GATE_NODEID_HASH_SIZE 4096
+    #elif LS_GATE_MAX_NODES <= 4096
+        #define LS_GATE_NODEID_HASH_SIZE 8192
+    #elif LS_GATE_MAX_NODES <= 8192
+        #define LS_GATE_NODEID_HASH_SIZE 16384
+    #elif LS_GATE_MAX_NODES <= 16384
+        #define LS_GATE_NODEID_HASH_SIZE 32768
+    #else
+        #error "LS_GATE_MAX_NODES is too big for the node ID hash index"
+    #endif
+#endif
+
+/**
+ * Number of 32-bit words in the free addresses bitmap
+ */
+#define LS_GATE_FREE_MAP_WORDS ((LS_GATE_MAX_NODES + 31) / 32)
+
+/**
+ * End of the idle nodes list
+ */
+#define LS_GATE_LRU_NONE 0xFFFF
+
+/**
+ * Free MIC key state cache slot
+ */
+#define LS_GATE_MIC_CACHE_EMPTY 0xFFFF
+
+/**
+ * Free AES key schedule cache slot
+ */
+#define LS_GATE_AES_CACHE_EMPTY 0xFFFF
+
 typedef struct __attribute__((__packed__)){
     uint64_t node_id;			/**< Node unique ID */
 	uint64_t app_id;			/**< Application unique ID */    
@@ -61,18 +152,41 @@ typedef struct __attribute__((__packed__)){
 	uint32_t app_nonce;			/**< Application nonce */
     ls_addr_t addr;				/**< Node unique address in network */
 	void *node_ch;				/**< Node's channel */
-    ls_nonce_t nonce[LS_GATE_NONCES_PER_DEVICE]; /**< List of accepted device nonces */
+    ls_nonce_t last_nonce;		/**< Nonce of the last accepted join, session keys are derived from it */
+	uint8_t mic_key[AES_BLOCK_SIZE];	/**< Session MIC key, derived once per join */
+	uint8_t aes_key[AES_BLOCK_SIZE];	/**< Session AES key, derived once per join */
 	ls_node_class_t node_class;	/**< Node's class */
     ls_device_status_t status;	/**< Last received device status */
 	ls_frame_id_t last_fid;		/**< Last received frame ID */
-	uint8_t num_nonces;			/**< Number of remembered nonces  */
 	uint8_t num_pending;		/**< Number of frames pending */
 	bool is_static;				/**< Statically personalized device, won't be kicked for idle */
+	uint16_t lru_prev;			/**< Address of the node seen just before this one */
+	uint16_t lru_next;			/**< Address of the node seen just after this one */
 } ls_gate_node_t;
 
+typedef struct {
+	uint16_t addr;						/**< Address of the node the state belongs to */
+	hmac_sha256_snapshot_t mic_state;	/**< Node's precomputed MIC key state */
+} ls_gate_mic_cache_t;
+
+typedef struct {
+	uint16_t addr;						/**< Address of the node the schedule belongs to */
+	AES_KEY aes_schedule;				/**< Node's expanded session AES key */
+} ls_gate_aes_cache_t;
+
 typedef struct {
 	ls_gate_node_t nodes[LS_GATE_MAX_NODES];
-	bool nodes_free_list[LS_GATE_MAX_NODES];
+	uint32_t nodes_free_map[LS_GATE_FREE_MAP_WORDS];	/**< Bit is set if corresponding address is free */
+	uint16_t nodes_index[LS_GATE_NODEID_HASH_SIZE];		/**< Node ID hash index, holds (address + 1) or 0 for empty slot */
+	size_t free_hint;			/**< All free map words below this one are known to be full */
+	uint8_t nonce_bits[2][LS_GATE_NONCE_FILTER_BITS / 8];	/**< Nonce replay filter generations */
+	bloom_t nonce_filter[2];	/**< Bloom filters over nonce_bits */
+	uint8_t nonce_gen;			/**< Current nonce filter generation */
+	size_t num_gen_nonces;		/**< Number of nonces added to the current generation */
+	uint16_t lru_head;			/**< Least recently seen node */
+	uint16_t lru_tail;			/**< Most recently seen node */
+	ls_gate_mic_cache_t mic_cache[LS_GATE_MIC_CACHE_SIZE];	/**< MIC key states of the recently active nodes */
+	ls_gate_aes_cache_t aes_cache[LS_GATE_AES_CACHE_SIZE];	/**< AES key schedules of the recently active nodes */
     size_t num_nodes;
     mutex_t mutex;
 } ls_gate_devices_t;
@@ -93,4 +207,36 @@ bool ls_devlist_is_full(ls_gate_devices_t *devlist);
 
 bool ls_devlist_remove_device(ls_gate_devices_t *devlist, ls_addr_t addr);
 
+/**
+ * @brief Updates node's last seen time and moves it to the end of the idle nodes list
+ *
+ * Nodes are kept in the list in order of their last activity, static nodes are never in the list.
+ * Newly added node gets into the list on its first touch
+ */
+void ls_devlist_touch(ls_gate_devices_t *devlist, ls_gate_node_t *node, uint32_t now);
+
+/**
+ * @brief Returns the least recently seen node if it was idle for at least max_idle
+ *
+ * @return NULL if there is no such node
+ */
+ls_gate_node_t *ls_devlist_get_idle(ls_gate_devices_t *devlist, uint32_t now, uint32_t max_idle);
+
+/**
+ * @brief Derives node's session keys from its nonces, precomputes its MIC key state and expands its AES key
+ *
+ * Must be called whenever node's nonces change, i.e. on every join
+ */
+void ls_devlist_derive_keys(ls_gate_devices_t *devlist, ls_gate_node_t *node);
+
+/**
+ * @brief Copies node's precomputed MIC key state, the state is computed again if it was evicted
+ */
+void ls_devlist_get_mic_state(ls_gate_devices_t *devlist, ls_gate_node_t *node, hmac_sha256_snapshot_t *mic_state);
+
+/**
+ * @brief Copies node's expanded session AES key schedule, the schedule is expanded again if it was evicted
+ */
+void ls_devlist_get_aes_schedule(ls_gate_devices_t *devlist, ls_gate_node_t *node, AES_KEY *aes_schedule);
+
 #endif /* LS_GATE_DEVICE_LIST_H_ */
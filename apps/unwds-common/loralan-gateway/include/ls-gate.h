@@ -133,12 +133,12 @@ typedef struct {
 	netdev_t *device;			/**< Transceiver instance for this channel */
 	void *gate;					/**< Gate instance pointer */
 
-	ls_frame_t current_frame;	/**< Memory for current frame */
 	mutex_t channel_mutex;		/**< Mutex on the channel */
 
 	ls_frame_fifo_t ul_fifo;	/**< Uplink frame queue */
 
 	xtimer_t	rx_window1;		/**< First receive window timer */
+	msg_t		rx_window1_msg;	/**< First receive window expiry message, one per channel */
 } ls_channel_internal_t;
 
 typedef enum {
@@ -147,6 +147,21 @@ typedef enum {
 	LS_GATE_CHANNEL_STATE_TX,
 } ls_channel_state_t;
 
+/**
+ * @brief Channel airtime accounting.
+ *
+ * Times are in milliseconds since the channel was opened
+ */
+typedef struct {
+	uint32_t started;					/**< Time the channel was opened [ms] */
+	uint32_t state_since;				/**< Time of the last channel state change [ms] */
+	uint32_t tx_time;					/**< Total time spent transmitting [ms] */
+	uint32_t rx_time;					/**< Total time spent in RX window or receiving [ms] */
+	uint32_t frames_sent;				/**< Number of frames transmitted */
+	uint32_t frames_failed;				/**< Number of frames the transceiver refused to send */
+	uint32_t frames_received;			/**< Number of frames received */
+} ls_channel_stats_t;
+
 /**
  * @brief Holds channel-related information.
  *
@@ -159,6 +174,7 @@ typedef struct {
 	int16_t	last_rssi;					/**< RSSI of last received packet on this channel */
 
 	ls_channel_state_t state;			/**< State of the channel */
+	ls_channel_stats_t stats;			/**< Airtime accounting of the channel */
 
 	ls_channel_internal_t _internal;	/**< Internal channel-specific data */
 } ls_gate_channel_t;
@@ -177,6 +193,12 @@ typedef struct {
     xtimer_t ping_timer;				/**< Timer for periodic ping count increment */
     xtimer_t keepalive_timer;			/**< Timer for periodic keepalive callback calls */
 
+    uint32_t kicked_last_ping;			/**< Number of idle nodes kicked on the last ping count increment */
+    uint32_t kicked_total;				/**< Total number of idle nodes kicked */
+
+    AES_KEY join_key_schedule;			/**< Expanded join key, used for join, invite and broadcast frames */
+    hmac_sha256_snapshot_t join_mic_state;	/**< Precomputed join key MIC state */
+
     /* Timeout message handler data */
     kernel_pid_t tim_thread_pid;
     char tim_thread_stack[LS_TIM_HANDLER_STACKSIZE];
@@ -244,4 +266,13 @@ int ls_gate_broadcast(ls_gate_t *ls, uint8_t *buf, size_t bufsize);
  */
 void ls_gate_sleep(ls_gate_t *ls);
 
+/**
+ * @brief Calculates channel utilization since the channel was opened.
+ *
+ * @param[in]  ch		channel
+ * @param[out] tx		share of time spent transmitting, in 0.1 %
+ * @param[out] rx		share of time spent in RX windows or receiving, in 0.1 %
+ */
+void ls_gate_channel_utilization(ls_gate_channel_t *ch, uint16_t *tx, uint16_t *rx);
+
 #endif /* UNWIRED_MODULES_LORA_STAR_INCLUDE_LS_H_ */
@@ -32,6 +32,8 @@
 #define PENDING_FIFO_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "mutex.h"
 
@@ -43,11 +45,14 @@
  */
 typedef struct {
 	char fifo[GC_MAX_PENDING][GC_MAX_REPLY_LEN];	/**< Queue data */
+	uint16_t len[GC_MAX_PENDING];				/**< Length of each element, replies could be binary */
 
 	int front;	/**< Pointer to the queue's front */
 	int rear;	/**< Pointer to the queue's start */
 
 	mutex_t mutex; /**< FIFO's mutex */
+	mutex_t space; /**< Unlocked by the reader when a writer waits for a free element */
+	volatile bool space_waiting; /**< A writer waits for a free element */
 } gc_pending_fifo_t;
 
 /**
@@ -61,21 +66,42 @@ void gc_pending_fifo_init(gc_pending_fifo_t *fifo);
  * @brief evicts element from the end of a queue.
  *
  * @param	[IN]	*fifo	pointer to the FIFO structure
- * @param	[OUT]	*reply	pointer to the buf to write
+ * @param	[OUT]	*reply	pointer to the buf to write, at least GC_MAX_REPLY_LEN bytes
  *
- * @return false if queue is empty
+ * @return length of the element, 0 if queue is empty
  */
-bool gc_pending_fifo_pop(gc_pending_fifo_t *fifo, char *buf);
+size_t gc_pending_fifo_pop(gc_pending_fifo_t *fifo, char *buf);
 
 /**
- * @brief inserts element into the queue.
+ * @brief inserts null-terminated string into the queue.
  *
  * @param	*fifo	pointer to the FIFO structure
- * @param	*buf	pointer to the reply buffer to insert
+ * @param	*buf	pointer to the reply string to insert
  *
  * @return 	false if frame is full
  */
-bool gc_pending_fifo_push(gc_pending_fifo_t *fifo, char buf[GC_MAX_REPLY_LEN]);
+bool gc_pending_fifo_push(gc_pending_fifo_t *fifo, const char *buf);
+
+/**
+ * @brief inserts binary element into the queue.
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ * @param	*buf	pointer to the reply data to insert
+ * @param	len		length of the data, up to GC_MAX_REPLY_LEN
+ *
+ * @return 	false if frame is full
+ */
+bool gc_pending_fifo_push_n(gc_pending_fifo_t *fifo, const char *buf, size_t len);
+
+/**
+ * @brief waits until the queue has a free element.
+ *
+ * Returns right away if the queue is not full, otherwise sleeps until the reader pops an element.
+ * Only one thread may wait at a time
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ */
+void gc_pending_fifo_wait_space(gc_pending_fifo_t *fifo);
 
 /**
  * @biref checks that queue is empty or not.
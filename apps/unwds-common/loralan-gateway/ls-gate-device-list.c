@@ -36,8 +36,13 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <string.h>
+
 #include "xtimer.h"
 #include "mutex.h"
+#include "bitarithm.h"
+#include "bloom.h"
+#include "hashes.h"
 
 #include "ls-mac-types.h"
 #include "ls-gate-device-list.h"
@@ -46,64 +51,271 @@ extern "C" {
 #include "debug.h"
 
 /**
- * @brief Initialize list of connected nodes
+ * @brief Hashes 64-bit node ID into the node index slot number
  */
-void ls_devlist_init(ls_gate_devices_t *devlist) {
-	memset(devlist, 0, sizeof(ls_gate_devices_t));
+static inline uint32_t nodeid_hash(uint64_t node_id) {
+    uint32_t h = (uint32_t) node_id ^ (uint32_t) (node_id >> 32);
+
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+
+    return h & (LS_GATE_NODEID_HASH_SIZE - 1);
+}
 
-	for(int i = 0; i < LS_GATE_MAX_NODES; i++) {
-		devlist->nodes_free_list[i] = true;
+static inline bool is_free(ls_gate_devices_t *devlist, ls_addr_t addr) {
+    return (devlist->nodes_free_map[addr / 32] & (1UL << (addr % 32))) != 0;
+}
+
+static inline void mark_free(ls_gate_devices_t *devlist, ls_addr_t addr) {
+    devlist->nodes_free_map[addr / 32] |= (1UL << (addr % 32));
+
+    if (addr / 32 < devlist->free_hint) {
+        devlist->free_hint = addr / 32;
     }
-	mutex_init(&devlist->mutex);    
-    DEBUG("ls-gate-device-list: device list initialized\n");
+}
+
+static inline void mark_used(ls_gate_devices_t *devlist, ls_addr_t addr) {
+    devlist->nodes_free_map[addr / 32] &= ~(1UL << (addr % 32));
 }
 
 /**
- * @brief Clears tracked nonces list
+ * @brief Looks for the lowest free network address
+ *
+ * @return LS_ADDR_UNDEFINED if there's no free address
  */
-static void clear_nonce_list(ls_gate_devices_t *devlist, ls_addr_t addr) {
-    DEBUG("ls-gate-device-list: clearing nonce list\n");
-	if (addr >= LS_GATE_MAX_NODES) {
-        DEBUG("ls-gate-device-list: address out of range\n");
-		return;
+static ls_addr_t find_free_addr(ls_gate_devices_t *devlist) {
+    for (size_t i = devlist->free_hint; i < LS_GATE_FREE_MAP_WORDS; i++) {
+        uint32_t word = devlist->nodes_free_map[i];
+
+        if (word) {
+            devlist->free_hint = i;
+            return i * 32 + bitarithm_lsb(word);
+        }
     }
 
-	ls_gate_node_t *node = &devlist->nodes[addr];
-    
-    memset((void *)node->nonce, 0, sizeof(ls_nonce_t) * LS_GATE_NONCES_PER_DEVICE);
-	node->num_nonces = 0;
-    
-    DEBUG("ls-gate-device-list: nonce list cleared\n");
+    devlist->free_hint = LS_GATE_FREE_MAP_WORDS;
+    return LS_ADDR_UNDEFINED;
+}
+
+/**
+ * @brief Looks for the node ID in the hash index
+ *
+ * @return index slot number holding the node or -1 if node is not in the index
+ */
+static int index_find(ls_gate_devices_t *devlist, uint64_t node_id) {
+    uint32_t slot = nodeid_hash(node_id);
+
+    /* Index is never full, so the empty slot terminates the probe sequence */
+    while (devlist->nodes_index[slot]) {
+        if (devlist->nodes[devlist->nodes_index[slot] - 1].node_id == node_id) {
+            return slot;
+        }
+
+        slot = (slot + 1) & (LS_GATE_NODEID_HASH_SIZE - 1);
+    }
+
+    return -1;
+}
+
+static void index_insert(ls_gate_devices_t *devlist, uint64_t node_id, ls_addr_t addr) {
+    uint32_t slot = nodeid_hash(node_id);
+
+    while (devlist->nodes_index[slot]) {
+        slot = (slot + 1) & (LS_GATE_NODEID_HASH_SIZE - 1);
+    }
+
+    devlist->nodes_index[slot] = addr + 1;
+}
+
+/**
+ * @brief Removes node ID from the hash index
+ *
+ * Entries following the removed one are shifted back into the gap,
+ * so no tombstones are needed and lookups stay short after many joins and kicks
+ */
+static void index_remove(ls_gate_devices_t *devlist, uint64_t node_id) {
+    int found = index_find(devlist, node_id);
+    if (found < 0) {
+        return;
+    }
+
+    uint32_t gap = found;
+    uint32_t slot = gap;
+
+    while (1) {
+        slot = (slot + 1) & (LS_GATE_NODEID_HASH_SIZE - 1);
+
+        if (!devlist->nodes_index[slot]) {
+            break;
+        }
+
+        uint32_t home = nodeid_hash(devlist->nodes[devlist->nodes_index[slot] - 1].node_id);
+
+        /* Entry may be moved into the gap only if its home slot isn't between the gap and its current slot */
+        if (((slot - home) & (LS_GATE_NODEID_HASH_SIZE - 1)) >= ((slot - gap) & (LS_GATE_NODEID_HASH_SIZE - 1))) {
+            devlist->nodes_index[gap] = devlist->nodes_index[slot];
+            gap = slot;
+        }
+    }
+
+    devlist->nodes_index[gap] = 0;
+}
+
+static hashfp_t nonce_hashes[LS_GATE_NONCE_FILTER_HASHES] = {
+    (hashfp_t) fnv_hash, (hashfp_t) sdbm_hash,
+    (hashfp_t) djb2_hash, (hashfp_t) one_at_a_time_hash,
+};
+
+/**
+ * @brief Key of the nonce replay filter, the same nonce may be used by different devices
+ */
+typedef struct __attribute__((__packed__)) {
+    uint64_t node_id;
+    ls_nonce_t nonce;
+} nonce_key_t;
+
+/**
+ * @brief Remembers accepted nonce in the replay filter, devlist mutex must be held
+ */
+static void remember_nonce(ls_gate_devices_t *devlist, uint64_t node_id, ls_nonce_t nonce) {
+    nonce_key_t key = { .node_id = node_id, .nonce = nonce };
+
+    /* Current generation is full, wipe the older one and switch to it */
+    if (devlist->num_gen_nonces >= LS_GATE_NONCES_PER_GENERATION) {
+        DEBUG("ls-gate-device-list: nonce filter generation is full, rotating\n");
+        devlist->nonce_gen ^= 1;
+        memset(devlist->nonce_bits[devlist->nonce_gen], 0, sizeof(devlist->nonce_bits[0]));
+        devlist->num_gen_nonces = 0;
+    }
+
+    bloom_add(&devlist->nonce_filter[devlist->nonce_gen], (uint8_t *) &key, sizeof(key));
+    devlist->num_gen_nonces++;
+}
+
+static inline bool lru_is_linked(ls_gate_devices_t *devlist, ls_gate_node_t *node) {
+    return (node->lru_prev != LS_GATE_LRU_NONE) || (devlist->lru_head == node->addr);
+}
+
+static void lru_unlink(ls_gate_devices_t *devlist, ls_gate_node_t *node) {
+    if (!lru_is_linked(devlist, node)) {
+        return;
+    }
+
+    if (node->lru_prev != LS_GATE_LRU_NONE) {
+        devlist->nodes[node->lru_prev].lru_next = node->lru_next;
+    } else {
+        devlist->lru_head = node->lru_next;
+    }
+
+    if (node->lru_next != LS_GATE_LRU_NONE) {
+        devlist->nodes[node->lru_next].lru_prev = node->lru_prev;
+    } else {
+        devlist->lru_tail = node->lru_prev;
+    }
+
+    node->lru_prev = node->lru_next = LS_GATE_LRU_NONE;
+}
+
+static void lru_append(ls_gate_devices_t *devlist, ls_gate_node_t *node) {
+    node->lru_prev = devlist->lru_tail;
+    node->lru_next = LS_GATE_LRU_NONE;
+
+    if (devlist->lru_tail != LS_GATE_LRU_NONE) {
+        devlist->nodes[devlist->lru_tail].lru_next = node->addr;
+    } else {
+        devlist->lru_head = node->addr;
+    }
+
+    devlist->lru_tail = node->addr;
+}
+
+static inline ls_gate_mic_cache_t *mic_cache_slot(ls_gate_devices_t *devlist, ls_addr_t addr) {
+	return &devlist->mic_cache[addr & (LS_GATE_MIC_CACHE_SIZE - 1)];
+}
+
+static void mic_cache_fill(ls_gate_devices_t *devlist, ls_gate_node_t *node) {
+	ls_gate_mic_cache_t *slot = mic_cache_slot(devlist, node->addr);
+
+	ls_precompute_mic_key(node->mic_key, &slot->mic_state);
+	slot->addr = node->addr;
+}
+
+static void mic_cache_drop(ls_gate_devices_t *devlist, ls_addr_t addr) {
+	ls_gate_mic_cache_t *slot = mic_cache_slot(devlist, addr);
+
+	if (slot->addr == addr) {
+		slot->addr = LS_GATE_MIC_CACHE_EMPTY;
+	}
+}
+
+static inline ls_gate_aes_cache_t *aes_cache_slot(ls_gate_devices_t *devlist, ls_addr_t addr) {
+	return &devlist->aes_cache[addr & (LS_GATE_AES_CACHE_SIZE - 1)];
+}
+
+static void aes_cache_fill(ls_gate_devices_t *devlist, ls_gate_node_t *node) {
+	ls_gate_aes_cache_t *slot = aes_cache_slot(devlist, node->addr);
+
+	aes_expand_encrypt_key(node->aes_key, AES_KEY_SIZE, &slot->aes_schedule);
+	slot->addr = node->addr;
+}
+
+static void aes_cache_drop(ls_gate_devices_t *devlist, ls_addr_t addr) {
+	ls_gate_aes_cache_t *slot = aes_cache_slot(devlist, addr);
+
+	if (slot->addr == addr) {
+		slot->addr = LS_GATE_AES_CACHE_EMPTY;
+	}
+}
+
+/**
+ * @brief Initialize list of connected nodes
+ */
+void ls_devlist_init(ls_gate_devices_t *devlist) {
+	memset(devlist, 0, sizeof(ls_gate_devices_t));
+
+	for (ls_addr_t i = 0; i < LS_GATE_MAX_NODES; i++) {
+		mark_free(devlist, i);
+    }
+	devlist->free_hint = 0;
+
+	for (int i = 0; i < 2; i++) {
+		bloom_init(&devlist->nonce_filter[i], LS_GATE_NONCE_FILTER_BITS, devlist->nonce_bits[i],
+				   nonce_hashes, LS_GATE_NONCE_FILTER_HASHES);
+	}
+
+	devlist->lru_head = devlist->lru_tail = LS_GATE_LRU_NONE;
+
+	for (int i = 0; i < LS_GATE_MIC_CACHE_SIZE; i++) {
+		devlist->mic_cache[i].addr = LS_GATE_MIC_CACHE_EMPTY;
+	}
+
+	for (int i = 0; i < LS_GATE_AES_CACHE_SIZE; i++) {
+		devlist->aes_cache[i].addr = LS_GATE_AES_CACHE_EMPTY;
+	}
+
+	mutex_init(&devlist->mutex);    
+    DEBUG("ls-gate-device-list: device list initialized\n");
 }
 
 ls_gate_node_t *add_nonce(ls_gate_devices_t *devlist, uint64_t node_id, uint32_t nonce) {
     DEBUG("ls-gate-device-list: adding nonce\n");
-	/* Look for a free cell (and address) to insert */
-	for (uint32_t i = 0; i < LS_GATE_MAX_NODES; i++) {
-		if (!devlist->nodes_free_list[i]) {
-			ls_gate_node_t *node = &devlist->nodes[i];
-
-			if (node->node_id == node_id) {
-				/* Clear nonces list if it's full */
-				if (node->num_nonces == LS_GATE_NONCES_PER_DEVICE) {
-					clear_nonce_list(devlist, i);
-				}
-
-				/* Add current nonce to nonce list */
-                for (uint32_t j = 0; j < LS_GATE_NONCES_PER_DEVICE; j++) {
-                    if (node->nonce[j] == 0) {
-                        node->nonce[j] = nonce;
-                        node->num_nonces++;
-                        DEBUG("ls-gate-device-list: nonce successfully added\n");
-                        break;
-                    }
-                }
-                return node;
-			}
-		}
+	ls_gate_node_t *node = ls_devlist_get_by_nodeid(devlist, node_id);
+	if (node == NULL) {
+		DEBUG("ls-gate-device-list: error adding nonce\n");
+		return NULL;
 	}
-    DEBUG("ls-gate-device-list: error adding nonce\n");
-	return NULL;
+
+	mutex_lock(&devlist->mutex);
+
+	/* Add current nonce to the replay filter */
+	remember_nonce(devlist, node_id, nonce);
+	node->last_nonce = nonce;
+
+	mutex_unlock(&devlist->mutex);
+
+	DEBUG("ls-gate-device-list: nonce successfully added\n");
+	return node;
 }
 
 static void init_node(ls_gate_devices_t *devlist, ls_gate_node_t *node, ls_addr_t addr, uint64_t node_id, uint64_t app_id, uint32_t nonce, void *ch) {
@@ -114,22 +326,11 @@ static void init_node(ls_gate_devices_t *devlist, ls_gate_node_t *node, ls_addr_
 	node->app_id = app_id;
 	node->addr = addr;
 	node->is_static = false;
+	node->lru_prev = node->lru_next = LS_GATE_LRU_NONE;
 
-	/* Clear nonces list if it's full */
-	if (node->num_nonces >= LS_GATE_NONCES_PER_DEVICE) {
-		DEBUG("ls-gate-device-list: clear nonce list");
-		clear_nonce_list(devlist, addr);
-	}
-
-	/* Append nonce to the nonce list */
-    for (uint32_t j = 0; j < LS_GATE_NONCES_PER_DEVICE; j++) {
-        if (node->nonce[j] == 0) {
-            node->nonce[j] = nonce;
-            node->num_nonces++;
-            DEBUG("ls-gate-device-list: nonce successfully added\n");
-            break;
-        }
-    }
+	/* Remember the nonce, session keys are derived from it */
+	remember_nonce(devlist, node_id, nonce);
+	node->last_nonce = nonce;
     
     DEBUG("ls-gate-device-list: node initialized\n");
 }
@@ -154,7 +355,7 @@ ls_gate_node_t *ls_devlist_add_by_addr(ls_gate_devices_t *devlist, ls_addr_t add
     }
 
 	/* This network address is occupied */
-	if (!devlist->nodes_free_list[addr]) {
+	if (!is_free(devlist, addr)) {
         DEBUG("ls-gate-device-list: network address already occupied\n");
 		return NULL;
     }
@@ -162,7 +363,7 @@ ls_gate_node_t *ls_devlist_add_by_addr(ls_gate_devices_t *devlist, ls_addr_t add
 	mutex_lock(&devlist->mutex);
 
 	/* Occupy node record */
-	devlist->nodes_free_list[addr] = false;
+	mark_used(devlist, addr);
 
 	/* Fill node record */
 	ls_gate_node_t *node = &devlist->nodes[addr];
@@ -172,8 +373,12 @@ ls_gate_node_t *ls_devlist_add_by_addr(ls_gate_devices_t *devlist, ls_addr_t add
 	node->app_nonce = 0;
 	node->is_static = true;
 
-	node->num_nonces = 1;
-	node->nonce[0] = nonce;
+	/* Static device never joins, so its session keys are known right away */
+	ls_derive_keys(nonce, node->app_nonce, addr, node->mic_key, node->aes_key);
+	mic_cache_fill(devlist, node);
+	aes_cache_fill(devlist, node);
+
+	index_insert(devlist, node_id, addr);
 
 	/* Increase number of connected devices */
 	devlist->num_nodes++;
@@ -200,54 +405,42 @@ ls_gate_node_t *ls_devlist_add(ls_gate_devices_t *devlist, uint64_t node_id, uin
 	mutex_lock(&devlist->mutex);
 
 	/* Look for a free cell (and address) to insert */
-	for (uint32_t i = 0; i < LS_GATE_MAX_NODES; i++) {
-		if (devlist->nodes_free_list[i]) {
-			/* Occupy node record */
-			devlist->nodes_free_list[i] = false;
+	ls_addr_t addr = find_free_addr(devlist);
+	if (addr == LS_ADDR_UNDEFINED) {
+		mutex_unlock(&devlist->mutex);
+		DEBUG("ls-gate-device-list: error adding device\n");
+		return NULL;
+	}
 
-			/* Fill node record */
-			ls_gate_node_t *node = &devlist->nodes[i];
-			init_node(devlist, node, i, node_id, app_id, nonce, ch);
+	/* Occupy node record */
+	mark_used(devlist, addr);
 
-			/* Increase number of connected devices */
-			devlist->num_nodes++;
+	/* Fill node record */
+	ls_gate_node_t *node = &devlist->nodes[addr];
+	init_node(devlist, node, addr, node_id, app_id, nonce, ch);
 
-			/* Free lock */
-			mutex_unlock(&devlist->mutex);
+	index_insert(devlist, node_id, addr);
 
-			/* Return pointer to the node in the list */
-            DEBUG("ls-gate-device-list: device successfully added\n");
-			return node;
-		}
-	}
+	/* Increase number of connected devices */
+	devlist->num_nodes++;
 
+	/* Free lock */
 	mutex_unlock(&devlist->mutex);
-    DEBUG("ls-gate-device-list: error adding device\n");
-	return NULL;
+
+	/* Return pointer to the node in the list */
+	DEBUG("ls-gate-device-list: device successfully added\n");
+	return node;
 }
 
 bool ls_devlist_check_nonce(ls_gate_devices_t *devlist, uint64_t node_id, uint32_t nonce) {
     DEBUG("ls-gate-device-list: checking nonce for the device\n");
-	for (uint32_t i = 0; i < LS_GATE_MAX_NODES; i++) {
-		if (devlist->nodes_free_list[i])
-			continue;
-
-		ls_gate_node_t *node = &devlist->nodes[i];
-
-		if (node->node_id == node_id) {
-			/* Iterate through remembered nonce list */
-            for (uint32_t k = 0; k < LS_GATE_NONCES_PER_DEVICE; k++) {
-                if (node->nonce[k] == 0) {
-                    DEBUG("ls-gate-device-list: end of nonce list\n");
-                    break;
-                }
-                
-                if (node->nonce[k] == nonce) {
-                    DEBUG("ls-gate-device-list: nonce value was used before\n");
-					return false;
-                }
-            }
-            break;
+	nonce_key_t key = { .node_id = node_id, .nonce = nonce };
+
+	/* Look through both generations of remembered nonces */
+	for (int i = 0; i < 2; i++) {
+		if (bloom_check(&devlist->nonce_filter[i], (uint8_t *) &key, sizeof(key))) {
+			DEBUG("ls-gate-device-list: nonce value was used before\n");
+			return false;
 		}
 	}
     DEBUG("ls-gate-device-list: nonce checked, is ok\n");
@@ -256,17 +449,9 @@ bool ls_devlist_check_nonce(ls_gate_devices_t *devlist, uint64_t node_id, uint32
 
 bool ls_devlist_is_added(ls_gate_devices_t *devlist, uint64_t node_id) {
     DEBUG("ls-gate-device-list: check if device is in the list\n");
-	for (uint32_t i = 0; i < LS_GATE_MAX_NODES; i++) {
-		/* Skip free cells */
-		if (devlist->nodes_free_list[i])
-			continue;
-
-		ls_gate_node_t *node = &devlist->nodes[i];
-
-		if (node->node_id == node_id) {
-            DEBUG("ls-gate-device-list: device found\n");
-			return true;
-        }
+	if (index_find(devlist, node_id) >= 0) {
+		DEBUG("ls-gate-device-list: device found\n");
+		return true;
 	}
     DEBUG("ls-gate-device-list: device not found\n");
 	return false;
@@ -280,14 +465,14 @@ bool ls_devlist_is_in_network(ls_gate_devices_t *devlist, ls_addr_t addr) {
     }
     
 #if ENABLE_DEBUG
-    if (!devlist->nodes_free_list[addr]) {
+    if (!is_free(devlist, addr)) {
         DEBUG("ls-gate-device-list: device is in the list\n");
     } else {
         DEBUG("ls-gate-device-list: device is not in the list\n");
     }
 #endif
 
-	return !devlist->nodes_free_list[addr];
+	return !is_free(devlist, addr);
 }
 
 bool ls_devlist_remove_device(ls_gate_devices_t *devlist, ls_addr_t addr) {
@@ -297,18 +482,21 @@ bool ls_devlist_remove_device(ls_gate_devices_t *devlist, ls_addr_t addr) {
 		return false;
     }
 
-	if (devlist->nodes_free_list[addr]) {
+	if (is_free(devlist, addr)) {
         DEBUG("ls-gate-device-list: device already removed\n");
 		return false;
     }
 
 	mutex_lock(&devlist->mutex);
 
-	/* Remove all tracked nonces from memory */
-	clear_nonce_list(devlist, addr);
+	/* Drop node ID from the index and idle nodes list */
+	index_remove(devlist, devlist->nodes[addr].node_id);
+	lru_unlink(devlist, &devlist->nodes[addr]);
+	mic_cache_drop(devlist, addr);
+	aes_cache_drop(devlist, addr);
 
 	/* Mark cell as free */
-	devlist->nodes_free_list[addr] = true;
+	mark_free(devlist, addr);
 
 	/* Decrease counter */
 	devlist->num_nodes--;
@@ -325,23 +513,17 @@ bool ls_devlist_is_full(ls_gate_devices_t *devlist) {
 }
 
 ls_gate_node_t *ls_devlist_get_by_nodeid(ls_gate_devices_t *devlist, uint64_t nodeid) {
-	for (uint32_t i = 0; i < LS_GATE_MAX_NODES; i++) {
-		/* Skip free cells */
-		if (devlist->nodes_free_list[i])
-			continue;
-
-		ls_gate_node_t *node = &devlist->nodes[i];
-
-		if (node->node_id == nodeid)
-			return &devlist->nodes[i];
+	int slot = index_find(devlist, nodeid);
+	if (slot < 0) {
+		return NULL;
 	}
 
-	return NULL;
+	return &devlist->nodes[devlist->nodes_index[slot] - 1];
 }
 
 ls_gate_node_t *ls_devlist_get(ls_gate_devices_t *devlist, ls_addr_t addr) {
 	if (addr >= LS_GATE_MAX_NODES)
-		return false;
+		return NULL;
 
 	if (!ls_devlist_is_in_network(devlist, addr))
 			return NULL;
@@ -349,6 +531,75 @@ ls_gate_node_t *ls_devlist_get(ls_gate_devices_t *devlist, ls_addr_t addr) {
 	return &devlist->nodes[addr];
 }
 
+void ls_devlist_touch(ls_gate_devices_t *devlist, ls_gate_node_t *node, uint32_t now) {
+	node->last_seen = now;
+
+	/* Static nodes are never kicked, no need to track them */
+	if (node->is_static) {
+		return;
+	}
+
+	mutex_lock(&devlist->mutex);
+
+	/* Time only goes forward, so appending to the end keeps the list sorted by last_seen */
+	lru_unlink(devlist, node);
+	lru_append(devlist, node);
+
+	mutex_unlock(&devlist->mutex);
+}
+
+ls_gate_node_t *ls_devlist_get_idle(ls_gate_devices_t *devlist, uint32_t now, uint32_t max_idle) {
+	if (devlist->lru_head == LS_GATE_LRU_NONE) {
+		return NULL;
+	}
+
+	ls_gate_node_t *node = &devlist->nodes[devlist->lru_head];
+
+	if ((uint32_t) (now - node->last_seen) < max_idle) {
+		return NULL;
+	}
+
+	return node;
+}
+
+void ls_devlist_derive_keys(ls_gate_devices_t *devlist, ls_gate_node_t *node) {
+	mutex_lock(&devlist->mutex);
+
+	ls_derive_keys(node->last_nonce, node->app_nonce, node->addr, node->mic_key, node->aes_key);
+	mic_cache_fill(devlist, node);
+	aes_cache_fill(devlist, node);
+
+	mutex_unlock(&devlist->mutex);
+}
+
+void ls_devlist_get_mic_state(ls_gate_devices_t *devlist, ls_gate_node_t *node, hmac_sha256_snapshot_t *mic_state) {
+	mutex_lock(&devlist->mutex);
+
+	ls_gate_mic_cache_t *slot = mic_cache_slot(devlist, node->addr);
+	if (slot->addr != node->addr) {
+		/* Evicted by another node sharing the slot */
+		mic_cache_fill(devlist, node);
+	}
+
+	memcpy(mic_state, &slot->mic_state, sizeof(hmac_sha256_snapshot_t));
+
+	mutex_unlock(&devlist->mutex);
+}
+
+void ls_devlist_get_aes_schedule(ls_gate_devices_t *devlist, ls_gate_node_t *node, AES_KEY *aes_schedule) {
+	mutex_lock(&devlist->mutex);
+
+	ls_gate_aes_cache_t *slot = aes_cache_slot(devlist, node->addr);
+	if (slot->addr != node->addr) {
+		/* Evicted by another node sharing the slot */
+		aes_cache_fill(devlist, node);
+	}
+
+	memcpy(aes_schedule, &slot->aes_schedule, sizeof(AES_KEY));
+
+	mutex_unlock(&devlist->mutex);
+}
+
 #ifdef __cplusplus
 }
 #endif
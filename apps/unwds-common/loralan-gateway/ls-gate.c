@@ -37,6 +37,7 @@ extern "C" {
 #include "random.h"
 #include "assert.h"
 #include "thread.h"
+#include "irq.h"
 
 #include "ls-init-device.h"
 #include "ls-mac-types.h"
@@ -46,6 +47,7 @@ extern "C" {
 #include "rtctimers-millis.h"
 
 #include <stdint.h>
+#include <string.h>
 
 #define SX127X_LORA_MSG_QUEUE   (16U)
 #define SX127X_STACKSIZE        (2*THREAD_STACKSIZE_DEFAULT)
@@ -57,19 +59,49 @@ static kernel_pid_t isr_pid;
 #include "debug.h"
 
 static msg_t msg_ping;
-static msg_t msg_rx1_expired;
 
-static void schedule_tx(ls_gate_channel_t *ch) {
-	/* Can send next frame only if channel is doing nothing */
-	if (ch->state != LS_GATE_CHANNEL_STATE_IDLE) {
-		puts("ls-gate: frame enqueued until channel is free");
-		return;
+/**
+ * Wakes up the downlink scheduler. Scheduler serves all free channels in one pass,
+ * so if the message queue is full the frames will be sent on the pending wakeup
+ */
+static void schedule_tx(ls_gate_t *ls) {
+	msg_t msg;
+	msg.content.ptr = (void *) ls;
+
+	msg_try_send(&msg, ls->_internal.uq_thread_pid);
+}
+
+/**
+ * Switches channel state, accounting time spent in the previous one.
+ * Channel becoming free wakes up the scheduler if there are frames waiting for it
+ */
+static void set_channel_state(ls_gate_channel_t *ch, ls_channel_state_t state) {
+	uint32_t now = rtctimers_millis_now();
+
+	unsigned irq = irq_disable();
+	uint32_t elapsed = now - ch->stats.state_since;
+
+	switch (ch->state) {
+		case LS_GATE_CHANNEL_STATE_TX:
+			ch->stats.tx_time += elapsed;
+			break;
+		case LS_GATE_CHANNEL_STATE_RX:
+			ch->stats.rx_time += elapsed;
+			break;
+		default:
+			break;
 	}
 
-	msg_t msg;
-	msg.content.ptr = (void *) ch;
+	ch->stats.state_since = now;
+	ch->state = state;
+	irq_restore(irq);
 
-	msg_try_send(&msg, ((ls_gate_t *)ch->_internal.gate)->_internal.uq_thread_pid);
+	DEBUG("ls-gate: %u Hz state = %s\n", (unsigned) ch->frequency,
+	      (state == LS_GATE_CHANNEL_STATE_TX) ? "TX" : (state == LS_GATE_CHANNEL_STATE_RX) ? "RX" : "IDLE");
+
+	if ((state == LS_GATE_CHANNEL_STATE_IDLE) && !ls_frame_fifo_empty(&ch->_internal.ul_fifo)) {
+		schedule_tx((ls_gate_t *) ch->_internal.gate);
+	}
 }
 
 static void prepare_sx127x(ls_gate_channel_t *ch)
@@ -92,28 +124,31 @@ static int send_frame_f(ls_gate_channel_t *ch, ls_frame_t *frame)
     /* The JOIN_ACK frame must be encrypted with the special join key */
     ls_gate_node_t *node;
 
-    uint8_t mic_key[AES_BLOCK_SIZE];
-    uint8_t aes_key[AES_BLOCK_SIZE];
+    hmac_sha256_snapshot_t mic_state;
+    AES_KEY aes_schedule;
 
     switch (frame->header.type) {
         case LS_DL_JOIN_ACK:
         case LS_DL_INVITE:
         case LS_DL_BROADCAST:
-            ls_encrypt_frame(ls->settings.join_key, ls->settings.join_key, frame, &payload_size);
-            break;
-
-        case LS_DL_ACK:
-            node = ls_devlist_get(&ls->devices, frame->header.dev_addr);
-
-            ls_derive_keys(node->nonce[node->num_nonces - 1], node->app_nonce, node->addr, mic_key, NULL);
-            ls_encrypt_frame(mic_key, mic_key, frame, &payload_size);
+            ls_encrypt_frame_expanded(&ls->_internal.join_mic_state, &ls->_internal.join_key_schedule, frame, &payload_size);
             break;
 
         default:
             node = ls_devlist_get(&ls->devices, frame->header.dev_addr);
+            ls_devlist_get_mic_state(&ls->devices, node, &mic_state);
+
+            if (frame->payload.len > 0) {
+                if (frame->header.type == LS_DL_ACK) {
+                    /* Payload of the ACK frame is encrypted with the MIC key, plain ACKs carry none */
+                    aes_expand_encrypt_key(node->mic_key, AES_KEY_SIZE, &aes_schedule);
+                }
+                else {
+                    ls_devlist_get_aes_schedule(&ls->devices, node, &aes_schedule);
+                }
+            }
 
-            ls_derive_keys(node->nonce[node->num_nonces - 1], node->app_nonce, node->addr, mic_key, aes_key);
-            ls_encrypt_frame(mic_key, aes_key, frame, &payload_size);
+            ls_encrypt_frame_expanded(&mic_state, &aes_schedule, frame, &payload_size);
     }
     
     /* REG_LR_MODEMSTAT doesn't seems to work properly
@@ -133,8 +168,7 @@ static int send_frame_f(ls_gate_channel_t *ch, ls_frame_t *frame)
     /* Capture channel */
     mutex_lock(&ch->_internal.channel_mutex);
 
-    puts("ls-gate: state = TX");
-    ch->state = LS_GATE_CHANNEL_STATE_TX;
+    set_channel_state(ch, LS_GATE_CHANNEL_STATE_TX);
 
     /* Prepare transceiver */
     prepare_sx127x(ch);
@@ -147,6 +181,13 @@ static int send_frame_f(ls_gate_channel_t *ch, ls_frame_t *frame)
     
     if (ch->_internal.device->driver->send(ch->_internal.device, &data) < 0) {
         puts("[LoRa] uq_handler: cannot send, device busy");
+        ch->stats.frames_failed++;
+
+        /* No TX done event will free the channel, the frame is dropped */
+        set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
+    }
+    else {
+        ch->stats.frames_sent++;
     }
     
     DEBUG("ls-gate: frame sent\n");
@@ -156,27 +197,29 @@ static int send_frame_f(ls_gate_channel_t *ch, ls_frame_t *frame)
     return LS_GATE_OK;
 }
 
-static bool enqueue_frame_f(ls_gate_channel_t *ch, ls_frame_t *frame) {
-	bool res = !ls_frame_fifo_push(&ch->_internal.ul_fifo, frame);
+static bool enqueue_frame(ls_gate_channel_t *ch, ls_addr_t to, ls_type_t type, uint8_t *buf, size_t buflen) {
+    /* Assemble frame right in the queue */
+    ls_frame_t *frame = ls_frame_fifo_reserve(&ch->_internal.ul_fifo);
+    bool res = (frame == NULL);
+
+    if (frame != NULL) {
+        ls_assemble_frame(to, type, buf, buflen, frame);
+        ls_frame_fifo_commit(&ch->_internal.ul_fifo);
+    }
 
-	schedule_tx(ch);
+	/* Frame waits in the queue if the channel is busy, it will be sent once the channel is free */
+	if (ch->state == LS_GATE_CHANNEL_STATE_IDLE) {
+		schedule_tx((ls_gate_t *) ch->_internal.gate);
+	}
     
     DEBUG("ls-gate: frame scheduled\n");
 
 	return res;
 }
 
-static bool enqueue_frame(ls_gate_channel_t *ch, ls_addr_t to, ls_type_t type, uint8_t *buf, size_t buflen) {
-    ls_frame_t *frame = &ch->_internal.current_frame;
-    ls_assemble_frame(to, type, buf, buflen, frame);
-
-    return enqueue_frame_f(ch, frame);
-}
-
 static inline void close_rx_windows(ls_gate_channel_t *ch) {
 	xtimer_remove(&ch->_internal.rx_window1);
-    DEBUG("ls-gate: state = IDLE");
-	ch->state = LS_GATE_CHANNEL_STATE_IDLE;
+	set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
     
     DEBUG("ls-gate: RX window closed\n");
 
@@ -186,8 +229,7 @@ static inline void close_rx_windows(ls_gate_channel_t *ch) {
 
 static inline void open_rx_windows(ls_gate_channel_t *ch) {
 	/* Launch RX window timeout timer */
-	msg_rx1_expired.content.ptr = (void *) ch;
-	xtimer_set_msg(&ch->_internal.rx_window1, LS_GATE_RX1_LENGTH, &msg_rx1_expired, ((ls_gate_t *)ch->_internal.gate)->_internal.tim_thread_pid);
+	xtimer_set_msg(&ch->_internal.rx_window1, LS_GATE_RX1_LENGTH, &ch->_internal.rx_window1_msg, ((ls_gate_t *)ch->_internal.gate)->_internal.tim_thread_pid);
 
 	/* Switch transceiver to RX mode */
 	prepare_sx127x(ch);
@@ -196,8 +238,7 @@ static inline void open_rx_windows(ls_gate_channel_t *ch) {
 
     /* Capture channel on RX */
     //mutex_lock(&ch->_internal.channel_mutex);
-    DEBUG("ls-gate: state = RX");
-    ch->state = LS_GATE_CHANNEL_STATE_RX;
+    set_channel_state(ch, LS_GATE_CHANNEL_STATE_RX);
 
 	DEBUG("ls-gate: rx1 window opened\n");
 }
@@ -261,11 +302,14 @@ static void device_join_req(ls_gate_t *ls, ls_gate_channel_t *ch, uint64_t dev_i
     node->node_ch = ch;
 
     /* Update node's last seen time */
-    node->last_seen = ls->_internal.ping_count;
+    ls_devlist_touch(devlist, node, ls->_internal.ping_count);
 
     /* Call join handler which returns an app nonce from the application side */
     node->app_nonce = ls->node_joined_cb(node);
 
+    /* Session keys stay the same until the next join */
+    ls_devlist_derive_keys(devlist, node);
+
     /* Reset last frame ID counter */
     node->last_fid = 0;
 
@@ -274,13 +318,17 @@ static void device_join_req(ls_gate_t *ls, ls_gate_channel_t *ch, uint64_t dev_i
     send_join_ack(ls, ch, dev_id, node->addr, node->app_nonce);
 }
 
-static void app_data_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_gate_node_t *node, ls_frame_t *frame, uint8_t *aes_key)
+static void app_data_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_gate_node_t *node, ls_frame_t *frame)
 {
     DEBUG("ls-gate: app data frame received\n");
 
     /* Decrypt frame payload */
     DEBUG("ls-gate: decrypt frame payload\n");
-    ls_decrypt_frame_payload(aes_key, frame);
+    if (frame->payload.len > 0) {
+        AES_KEY aes_schedule;
+        ls_devlist_get_aes_schedule(&ls->devices, node, &aes_schedule);
+        ls_decrypt_frame_payload_expanded(&aes_schedule, frame);
+    }
 
     /* Call handler callback */
     DEBUG("ls-gate: call handler callback\n");
@@ -302,18 +350,15 @@ static bool frame_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_frame_t *frame)
     	}
     }
 
-    /* Derive cryptographic keys */
-    uint8_t mic_key[AES_BLOCK_SIZE];
-    uint8_t aes_key[AES_BLOCK_SIZE];
-
     if (node) {
         /* Update node's last seen time */
-        node->last_seen = ls->_internal.ping_count;
-        
-        ls_derive_keys(node->nonce[node->num_nonces - 1], node->app_nonce, node->addr, mic_key, aes_key);
+        ls_devlist_touch(&ls->devices, node, ls->_internal.ping_count);
+
+        /* Validate frame MIC with the session key state precomputed at join */
+        hmac_sha256_snapshot_t mic_state;
+        ls_devlist_get_mic_state(&ls->devices, node, &mic_state);
 
-        /* Validate frame MIC */
-        if (!ls_validate_frame_mic(mic_key, frame)) {
+        if (!ls_validate_frame_mic_snapshot(&mic_state, frame)) {
             DEBUG("ls-gate: MIC validation failed\n");
             return false;
         }
@@ -352,7 +397,7 @@ static bool frame_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_frame_t *frame)
                 /*
                  * Process as app. data frame
                  */
-    			app_data_recv(ls, ch, node, frame, aes_key);
+    			app_data_recv(ls, ch, node, frame);
                 DEBUG("ls-gate: data processed\n");
             } else {
             	DEBUG("ls-gate: frame dropped: %d != %d\n", frame->header.fid, (uint8_t) (node->last_fid + 1));
@@ -412,7 +457,7 @@ static bool frame_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_frame_t *frame)
              * Confirmation of data reception will be sent in any case
              */
             if ((uint8_t) frame->header.fid >= (uint8_t) (node->last_fid + 1)) {
-            	app_data_recv(ls, ch, node, frame, aes_key);
+            	app_data_recv(ls, ch, node, frame);
 
             	/* Update frame ID */
             	node->last_fid = frame->header.fid;
@@ -445,7 +490,7 @@ static bool frame_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_frame_t *frame)
 
             DEBUG("ls-gate: uplink data unconfirmed\n");
 
-            app_data_recv(ls, ch, node, frame, aes_key);
+            app_data_recv(ls, ch, node, frame);
 
             return true;
 
@@ -463,12 +508,12 @@ static bool frame_recv(ls_gate_t *ls, ls_gate_channel_t *ch, ls_frame_t *frame)
                 return false;
             }
 
-            if (!ls_validate_frame_mic(ls->settings.join_key, frame)) {
+            if (!ls_validate_frame_mic_snapshot(&ls->_internal.join_mic_state, frame)) {
                 DEBUG("ls-gate: MIC validation failed\n");
                 return false;
             }
 
-            ls_decrypt_frame_payload(ls->settings.join_key, frame);
+            ls_decrypt_frame_payload_expanded(&ls->_internal.join_key_schedule, frame);
             
             DEBUG("ls-gate: frame payload decrypted\n");
 
@@ -549,8 +594,8 @@ static void sx127x_handler(netdev_t *dev, netdev_event_t event, void *arg)
             printf("\n");
 #endif
 
-            DEBUG("ls-gate: state = IDLE\n");
-            ch->state = LS_GATE_CHANNEL_STATE_IDLE;
+            ch->stats.frames_received++;
+            set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
             
             ch->last_rssi = packet_info.rssi;
 
@@ -571,8 +616,7 @@ static void sx127x_handler(netdev_t *dev, netdev_event_t event, void *arg)
 
         case NETDEV_EVENT_CRC_ERROR:
             DEBUG("ls-gate: CRC error\n");
-            DEBUG("ls-gate: state = IDLE\n");
-            ch->state = LS_GATE_CHANNEL_STATE_IDLE;
+            set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
             break;
 
         case NETDEV_EVENT_TX_COMPLETE:
@@ -583,8 +627,7 @@ static void sx127x_handler(netdev_t *dev, netdev_event_t event, void *arg)
 
         case NETDEV_EVENT_RX_TIMEOUT:
             DEBUG("ls-gate: RX timeout\n");
-            DEBUG("ls-gate: state = IDLE\n");
-            ch->state = LS_GATE_CHANNEL_STATE_IDLE;
+            set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
             break;
 
         case NETDEV_EVENT_TX_TIMEOUT:
@@ -593,11 +636,14 @@ static void sx127x_handler(netdev_t *dev, netdev_event_t event, void *arg)
             prepare_sx127x(ch);
             uint8_t state = NETOPT_STATE_RX;
             ch->_internal.device->driver->set(ch->_internal.device, NETOPT_STATE, &state, sizeof(uint8_t));
+
+            /* Channel would be stuck in TX otherwise */
+            set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
             break;
             
         case NETDEV_EVENT_VALID_HEADER:
             DEBUG("ls-gate: header received, switch to RX state");
-            ch->state = LS_GATE_CHANNEL_STATE_RX;
+            set_channel_state(ch, LS_GATE_CHANNEL_STATE_RX);
             break;
 
         default:
@@ -633,45 +679,56 @@ static void *uq_handler(void *arg)
 {
     assert(arg != NULL);
 
-    //ls_gate_t *ls = (ls_gate_t *) arg;
+    ls_gate_t *ls = (ls_gate_t *) arg;
     msg_t msg_queue[LS_UQ_MSG_QUEUE_SIZE] = {};
     msg_init_queue(msg_queue, LS_UQ_MSG_QUEUE_SIZE);
 
     msg_t msg;
 
+    /* Channel to start the next scheduling pass from */
+    size_t next = 0;
+
     puts("ls-gate: uplink frame queue handler thread started"); // XXX: debug
 
     while (1) {
         msg_receive(&msg);
 
-        ls_gate_channel_t *ch = (ls_gate_channel_t *) msg.content.ptr;
-        ls_frame_fifo_t *fifo = &ch->_internal.ul_fifo;
+        /* Give every free channel its next frame. Transceivers work independently,
+         * so a frame on one channel doesn't wait for the RX window on another */
+        for (size_t k = 0; k < ls->num_channels; k++) {
+            ls_gate_channel_t *ch = &ls->channels[(next + k) % ls->num_channels];
+            ls_frame_fifo_t *fifo = &ch->_internal.ul_fifo;
 
-        if (ls_frame_fifo_empty(fifo)) {
-            continue;
-        }
+            if (ch->state != LS_GATE_CHANNEL_STATE_IDLE) {
+                continue;
+            }
 
-        /* Get frame from queue top */
-        ls_frame_t *f;
-        ls_frame_t frame;
-        if (!ls_frame_fifo_pop(fifo, &frame)) {
-            continue;
-        }
+            /* Get frame from queue top, it's encrypted and sent in place */
+            ls_frame_t *f = ls_frame_fifo_peek_ref(fifo);
+            if (f == NULL) {
+                continue;
+            }
 
-        f = &frame;
+            /* Update frame's FID to the last one and advance it */
+            f->header.fid = 0;
 
-		/* Update frame's FID to the last one and advance it */
-		f->header.fid = 0;
+            DEBUG("ls-gate: >mhdr=0x%02X, mic=0x%04X, addr=0x%02X, type=0x%02X, fid=0x%02X [%d left]\n",
+                    (unsigned int) f->header.mhdr,
+                    (unsigned int) f->header.mic, (unsigned int) f->header.dev_addr,
+                    (unsigned int) f->header.type,
+                    (unsigned int) f->header.fid,
+                    ls_frame_fifo_size(fifo));
 
-        DEBUG("ls-gate: >mhdr=0x%02X, mic=0x%04X, addr=0x%02X, type=0x%02X, fid=0x%02X [%d left]\n",
-                (unsigned int) f->header.mhdr,
-                (unsigned int) f->header.mic, (unsigned int) f->header.dev_addr,
-                (unsigned int) f->header.type,
-                (unsigned int) f->header.fid,
-                ls_frame_fifo_size(fifo));
+            /* Send frame into LoRa PHY */
+            send_frame_f(ch, f);
+
+            /* Transceiver has its own copy of the frame now, or the frame
+             * failed and is dropped */
+            ls_frame_fifo_release(fifo);
+        }
 
-        /* Send frame into LoRa PHY */
-        send_frame_f(ch, f);
+        /* Round-robin, so the first channel doesn't always win the CPU */
+        next = (next + 1) % ls->num_channels;
     }
 
     return NULL;
@@ -699,27 +756,23 @@ static void *tim_handler(void *arg)
             case LS_GATE_PING:
                 ls->_internal.ping_count++;
 
-				/* Kick inactive devices */
-				for (int i = 0; i < LS_GATE_MAX_NODES; i++) {
-					if (!ls->devices.nodes_free_list[i]) {
-						ls_gate_node_t *node = &ls->devices.nodes[i];
+				/* Kick inactive devices, idle list is sorted by last activity so only expired nodes are visited */
+				ls->_internal.kicked_last_ping = 0;
 
-						/* Don't kick static nodes */
-						if (node->is_static)
-							continue;
-
-						int diff = ls->_internal.ping_count - node->last_seen;
+				ls_gate_node_t *node;
+				while ((node = ls_devlist_get_idle(&ls->devices, ls->_internal.ping_count, LS_MAX_PING_DIFFERENCE)) != NULL) {
+					/* Kick node */
+					DEBUG("ls-gate: remove node from devlist");
+					if (!ls_devlist_remove_device(&ls->devices, node->addr)) {
+						break;
+					}
 
-						if (diff >= LS_MAX_PING_DIFFERENCE) {
-							/* Kick node */
-                            DEBUG("ls-gate: remove node from devlist");
-							ls_devlist_remove_device(&ls->devices, i);
+					ls->_internal.kicked_last_ping++;
+					ls->_internal.kicked_total++;
 
-							/* Notify application code about kicked node */
-							if (ls->node_kicked_cb != NULL) {
-								ls->node_kicked_cb(node);
-							}
-						}
+					/* Notify application code about kicked node */
+					if (ls->node_kicked_cb != NULL) {
+						ls->node_kicked_cb(node);
 					}
 				}
 
@@ -737,10 +790,10 @@ static void *tim_handler(void *arg)
             	if (!ls_frame_fifo_empty(&ch->_internal.ul_fifo)) {
             		puts("ls-gate: rx1 window expired, sending next frame from queue");
 
+            		/* Scheduler is woken up by the channel becoming free */
             		close_rx_windows(ch);
-            		schedule_tx(ch);
             	} else {
-            		ch->state = LS_GATE_CHANNEL_STATE_IDLE;
+            		set_channel_state(ch, LS_GATE_CHANNEL_STATE_IDLE);
             		puts("ls-gate: rx1 window expired, staying in RX, but IDLE");
             	}
             }
@@ -811,6 +864,16 @@ static bool open_channel(ls_gate_channel_t *ch)
 
     /* Initialize uplink queue */
     ls_frame_fifo_init(&ch->_internal.ul_fifo);
+
+    /* RX window timers of different channels run concurrently, each needs its own message */
+    ch->_internal.rx_window1_msg.type = LS_GATE_RX1_EXPIRED;
+    ch->_internal.rx_window1_msg.content.ptr = (void *) ch;
+
+    /* Start airtime accounting */
+    memset(&ch->stats, 0, sizeof(ch->stats));
+    ch->stats.started = rtctimers_millis_now();
+    ch->stats.state_since = ch->stats.started;
+    ch->state = LS_GATE_CHANNEL_STATE_IDLE;
     
     DEBUG("[LoRa] open_channel: init SX127X\n");
     /* Initialize the transceiver */
@@ -861,7 +924,10 @@ int ls_gate_init(ls_gate_t *ls)
     assert(ls->num_channels > 0);
 
     msg_ping.type = LS_GATE_PING;
-    msg_rx1_expired.type = LS_GATE_RX1_EXPIRED;
+
+    /* Join key doesn't change at runtime, prepare it once */
+    aes_expand_encrypt_key(ls->settings.join_key, AES_KEY_SIZE, &ls->_internal.join_key_schedule);
+    ls_precompute_mic_key(ls->settings.join_key, &ls->_internal.join_mic_state);
     
     if (!create_tim_handler_thread(ls)) {
         return -LS_INIT_E_TIM_THREAD;
@@ -957,6 +1023,45 @@ void ls_gate_sleep(ls_gate_t *ls)
     }
 }
 
+static uint16_t share_permille(uint32_t part, uint32_t total)
+{
+    if (total == 0) {
+        return 0;
+    }
+
+    return (uint16_t) (((uint64_t) part * 1000) / total);
+}
+
+void ls_gate_channel_utilization(ls_gate_channel_t *ch, uint16_t *tx, uint16_t *rx)
+{
+    assert(ch != NULL);
+
+    uint32_t now = rtctimers_millis_now();
+
+    unsigned irq = irq_disable();
+    uint32_t tx_time = ch->stats.tx_time;
+    uint32_t rx_time = ch->stats.rx_time;
+
+    /* Count time spent in the current state too */
+    if (ch->state == LS_GATE_CHANNEL_STATE_TX) {
+        tx_time += now - ch->stats.state_since;
+    }
+    else if (ch->state == LS_GATE_CHANNEL_STATE_RX) {
+        rx_time += now - ch->stats.state_since;
+    }
+    irq_restore(irq);
+
+    uint32_t total = now - ch->stats.started;
+
+    if (tx != NULL) {
+        *tx = share_permille(tx_time, total);
+    }
+
+    if (rx != NULL) {
+        *rx = share_permille(rx_time, total);
+    }
+}
+
 #ifdef __cplusplus
 }
 #endif
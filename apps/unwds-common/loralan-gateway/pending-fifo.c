@@ -44,33 +44,70 @@ extern "C" {
 
 void gc_pending_fifo_init(gc_pending_fifo_t *fifo) {
 	mutex_init(&fifo->mutex);
+	mutex_t locked = MUTEX_INIT_LOCKED;
+	fifo->space = locked;
+	fifo->space_waiting = false;
 	fifo->front = fifo->rear = -1;
 }
 
-bool gc_pending_fifo_pop(gc_pending_fifo_t *fifo, char *buf) {
+/* Wakes up the writer waiting for a free element */
+static void space_freed(gc_pending_fifo_t *fifo) {
+	int c = irq_disable();
+
+	if (fifo->space_waiting) {
+		fifo->space_waiting = false;
+		mutex_unlock(&fifo->space);
+	}
+
+	irq_restore(c);
+}
+
+size_t gc_pending_fifo_pop(gc_pending_fifo_t *fifo, char *buf) {
 	if (gc_pending_fifo_empty(fifo)) {
-		return false;
+		return 0;
 	}
 
 	mutex_lock(&fifo->mutex);
 
-	memcpy(buf, fifo->fifo[fifo->front], GC_MAX_REPLY_LEN);
+	size_t len = fifo->len[fifo->front];
+	memcpy(buf, fifo->fifo[fifo->front], len);
 
 	if (fifo->front == fifo->rear) {
 		fifo->front = fifo->rear = -1;
 
 		mutex_unlock(&fifo->mutex);
-		return true;
+		space_freed(fifo);
+		return len;
 	}
 
 	fifo->front = (fifo->front + 1) % GC_MAX_PENDING;
 
 	mutex_unlock(&fifo->mutex);
-	return true;
+	space_freed(fifo);
+	return len;
+}
+
+void gc_pending_fifo_wait_space(gc_pending_fifo_t *fifo) {
+	int c = irq_disable();
+
+	if (!gc_pending_fifo_full(fifo)) {
+		irq_restore(c);
+		return;
+	}
+
+	/* The flag is set atomically with the check, so the next pop can't miss it */
+	fifo->space_waiting = true;
+	irq_restore(c);
+
+	mutex_lock(&fifo->space);
+}
+
+bool gc_pending_fifo_push(gc_pending_fifo_t *fifo, const char *buf) {
+	return gc_pending_fifo_push_n(fifo, buf, strnlen(buf, GC_MAX_REPLY_LEN));
 }
 
-bool gc_pending_fifo_push(gc_pending_fifo_t *fifo, char buf[GC_MAX_REPLY_LEN]) {
-	if (gc_pending_fifo_full(fifo)) {
+bool gc_pending_fifo_push_n(gc_pending_fifo_t *fifo, const char *buf, size_t len) {
+	if (gc_pending_fifo_full(fifo) || (len == 0) || (len > GC_MAX_REPLY_LEN)) {
 		return false;
 	}
 
@@ -82,7 +119,9 @@ bool gc_pending_fifo_push(gc_pending_fifo_t *fifo, char buf[GC_MAX_REPLY_LEN]) {
 		fifo->rear = (fifo->rear + 1) % GC_MAX_PENDING;
 	}
 
-	memcpy(fifo->fifo[fifo->rear], buf, GC_MAX_REPLY_LEN);
+	/* Copy only the reply itself, callers use short buffers */
+	memcpy(fifo->fifo[fifo->rear], buf, len);
+	fifo->len[fifo->rear] = len;
 
 	irq_restore(c);
 
@@ -32,6 +32,7 @@
 #define LS_CRYPTO_H_
 
 #include "crypto/aes.h"
+#include "hashes/sha256.h"
 #include "ls-mac-types.h"
 
 #define LS_MIC_KEY_LEN AES_KEY_SIZE
@@ -55,6 +56,18 @@ typedef struct {
  */
 ls_mic_t ls_calculate_mic(uint8_t *key, ls_frame_t *frame, uint8_t payload_size);
 
+/**
+ * @brief Calculates Message Integrity Code with precomputed MIC key state
+ *
+ * Takes half of SHA-256 compressions of ls_calculate_mic() for short frames
+ *
+ * @param	[IN]	mic_state	MIC key state from ls_precompute_mic_key()
+ * @param	[IN]	frame		frame for which the MIC will be calculated
+ *
+ * @return MIC for the specified frame
+ */
+ls_mic_t ls_calculate_mic_snapshot(const hmac_sha256_snapshot_t *mic_state, ls_frame_t *frame, uint8_t payload_size);
+
 /**
  * @brief Validates Message Integrity Code for the specified frame
  *
@@ -65,6 +78,16 @@ ls_mic_t ls_calculate_mic(uint8_t *key, ls_frame_t *frame, uint8_t payload_size)
  */
 bool ls_validate_frame_mic(uint8_t *key, ls_frame_t *frame);
 
+/**
+ * @brief Validates Message Integrity Code with precomputed MIC key state
+ *
+ * @param	[IN]	mic_state	MIC key state from ls_precompute_mic_key()
+ * @param	[IN]	frame		frame for which the MIC will be validated
+ *
+ * @return true if MIC is valid, false otherwise
+ */
+bool ls_validate_frame_mic_snapshot(const hmac_sha256_snapshot_t *mic_state, ls_frame_t *frame);
+
 /**
  * @brief Encrypts payload of the specified frame with specified key.
  *
@@ -74,6 +97,17 @@ bool ls_validate_frame_mic(uint8_t *key, ls_frame_t *frame);
  */
 void ls_encrypt_frame_payload(uint8_t *key, ls_frame_t *frame);
 
+/**
+ * @brief Encrypts payload of the specified frame with already expanded AES key schedule.
+ *
+ * Saves AES key expansion when the same key is used for many frames
+ *
+ * @param	[IN]	*schedule	key schedule filled by aes_expand_encrypt_key()
+ * @param	[IN]	*frame		pointer to the frame to encrypt it's payload
+ *
+ */
+void ls_encrypt_frame_payload_expanded(const AES_KEY *schedule, ls_frame_t *frame);
+
 /**
  * @brief Decrypts payload of the specified frame with specified key.
  *
@@ -83,6 +117,15 @@ void ls_encrypt_frame_payload(uint8_t *key, ls_frame_t *frame);
  */
 void ls_decrypt_frame_payload(uint8_t *key, ls_frame_t *frame);
 
+/**
+ * @brief Decrypts payload of the specified frame with already expanded AES key schedule.
+ *
+ * @param	[IN]	*schedule	key schedule filled by aes_expand_encrypt_key()
+ * @param	[IN]	*frame		pointer to the frame to decrypt it's payload
+ *
+ */
+void ls_decrypt_frame_payload_expanded(const AES_KEY *schedule, ls_frame_t *frame);
+
 /**
  * @brief Encrypts frame payload and calculates frame's MIC
  *
@@ -92,6 +135,17 @@ void ls_decrypt_frame_payload(uint8_t *key, ls_frame_t *frame);
  */
 void ls_encrypt_frame(uint8_t *key_mic, uint8_t *key_aes, ls_frame_t *frame, size_t *newsize);
 
+/**
+ * @brief Encrypts frame payload with already expanded AES key schedule and calculates frame's MIC
+ *        with precomputed MIC key state
+ *
+ * @param	[IN]	*mic_state		MIC key state from ls_precompute_mic_key()
+ * @param	[IN]	*aes_schedule	key schedule filled by aes_expand_encrypt_key(), unused for empty payload
+ * @param	[IN]	*frame			the frame to work with
+ * @param	[OUT]	*newsize		new size of payload (resizes after encryption)
+ */
+void ls_encrypt_frame_expanded(const hmac_sha256_snapshot_t *mic_state, const AES_KEY *aes_schedule, ls_frame_t *frame, size_t *newsize);
+
 /**
  * @brief Derives keys from the nonce numbers
  *
@@ -103,4 +157,12 @@ void ls_encrypt_frame(uint8_t *key_mic, uint8_t *key_aes, ls_frame_t *frame, siz
  */
 void ls_derive_keys(uint32_t dev_nonce, uint32_t app_nonce, ls_addr_t addr, uint8_t *key_mic, uint8_t *key_aes);
 
+/**
+ * @brief Precomputes MIC key state, the HMAC key pads are hashed only once per session
+ *
+ * @param	[IN]	*key_mic	key for the MIC calculation
+ * @param	[OUT]	*mic_state	MIC key state for the *_snapshot functions
+ */
+void ls_precompute_mic_key(const uint8_t *key_mic, hmac_sha256_snapshot_t *mic_state);
+
 #endif /* LS_CRYPTO_H_ */
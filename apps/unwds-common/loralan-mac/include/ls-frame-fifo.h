@@ -43,14 +43,18 @@
 
 /**
  * @brief describes the frame queue.
+ *
+ * Frames can be written and read in place: producer reserves a slot, fills it and commits it,
+ * consumer peeks a reference to the oldest frame and releases it when done.
+ * Only one slot can be reserved at a time, other producers wait in ls_frame_fifo_reserve()
  */
 typedef struct {
 	ls_frame_t fifo[LS_MAX_FRAME_FIFO_SIZE];	/**< Queue data */
 
-	int front;	/**< Pointer to the queue's front */
-	int rear;	/**< Pointer to the queue's start */
+	uint8_t head;	/**< Index of the oldest frame */
+	uint8_t count;	/**< Number of committed frames */
 
-	mutex_t mutex; /**< FIFO's mutex */
+	mutex_t mutex; /**< Held by the producer from reserve till commit */
 } ls_frame_fifo_t;
 
 /**
@@ -60,11 +64,54 @@ typedef struct {
  */
 void ls_frame_fifo_init(ls_frame_fifo_t *fifo);
 
+/**
+ * @brief reserves a slot at the start of the queue to fill the frame in place.
+ *
+ * Slot must be passed to ls_frame_fifo_commit() or ls_frame_fifo_cancel()
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ *
+ * @return	pointer to the reserved frame, NULL if queue is full
+ */
+ls_frame_t *ls_frame_fifo_reserve(ls_frame_fifo_t *fifo);
+
+/**
+ * @brief inserts the reserved frame into the queue.
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ */
+void ls_frame_fifo_commit(ls_frame_fifo_t *fifo);
+
+/**
+ * @brief drops the reserved frame.
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ */
+void ls_frame_fifo_cancel(ls_frame_fifo_t *fifo);
+
+/**
+ * @brief gets reference to the element at the end of a queue but doesn't evict it.
+ *
+ * Frame stays valid until ls_frame_fifo_release() and may be modified in place
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ *
+ * @return	pointer to the oldest frame, NULL if queue is empty
+ */
+ls_frame_t *ls_frame_fifo_peek_ref(ls_frame_fifo_t *fifo);
+
+/**
+ * @brief evicts element from the end of a queue without copying it.
+ *
+ * @param	*fifo	pointer to the FIFO structure
+ */
+void ls_frame_fifo_release(ls_frame_fifo_t *fifo);
+
 /**
  * @brief evicts element from the end of a queue.
  *
  * @param	*fifo	pointer to the FIFO structure
- * @param	*frame	pointer to the frame to write the output
+ * @param	*frame	pointer to the frame to write the output, may be NULL
  *
  * @return false if queue is empty
  */
@@ -30,12 +30,12 @@
  */
 
 #include <stdbool.h>
+#include <string.h>
 
 #include "random.h"
 #include "assert.h"
 
 #include "crypto/aes.h"
-#include "crypto/ciphers.h"
 
 #include "hashes/sha256.h"
 #include "include/ls-crypto.h"
@@ -52,11 +52,26 @@ typedef struct  __attribute__((packed)) {
     uint8_t len;
 } lorawan_block_t;
 
+/**
+ * Number of AES blocks of keystream generated at once
+ */
+#ifndef LS_KEYSTREAM_BATCH_BLOCKS
+#define LS_KEYSTREAM_BATCH_BLOCKS 4
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 ls_mic_t ls_calculate_mic(uint8_t *key, ls_frame_t *frame, uint8_t payload_size)
+{
+    hmac_sha256_snapshot_t mic_state;
+    ls_precompute_mic_key(key, &mic_state);
+
+    return ls_calculate_mic_snapshot(&mic_state, frame, payload_size);
+}
+
+ls_mic_t ls_calculate_mic_snapshot(const hmac_sha256_snapshot_t *mic_state, ls_frame_t *frame, uint8_t payload_size)
 {
     /* Get pointer to the frame data after MIC field */
     uint8_t *ptr = ((uint8_t *) frame) + 4; /* Skip 1 byte of MHDR and 3 bytes of MIC */
@@ -67,8 +82,8 @@ ls_mic_t ls_calculate_mic(uint8_t *key, ls_frame_t *frame, uint8_t payload_size)
     /* SHA-256 HMAC result */
     unsigned char hmac[SHA256_DIGEST_LENGTH];
 
-    /* Calculate HMAC */
-    hmac_sha256(key, LS_MIC_KEY_LEN, (unsigned *) ptr, size, hmac);
+    /* Calculate HMAC, key pads are already hashed into the state */
+    hmac_sha256_from_snapshot(mic_state, ptr, size, hmac);
 
     /* Take first 3 bytes of hash as a MIC */
     ls_mic_t mic = (hmac[0] << 16)
@@ -79,77 +94,116 @@ ls_mic_t ls_calculate_mic(uint8_t *key, ls_frame_t *frame, uint8_t payload_size)
 }
 
 bool ls_validate_frame_mic(uint8_t *key, ls_frame_t *frame)
+{
+    hmac_sha256_snapshot_t mic_state;
+    ls_precompute_mic_key(key, &mic_state);
+
+    return ls_validate_frame_mic_snapshot(&mic_state, frame);
+}
+
+bool ls_validate_frame_mic_snapshot(const hmac_sha256_snapshot_t *mic_state, ls_frame_t *frame)
 {
     /* Payload size is zero or matched to the AES block size + AES-CBC IV length */
     uint8_t payload_size = frame->payload.len;
 
     /* Compare MIC from header and actual */
-    ls_mic_t expected_mic = ls_calculate_mic(key, frame, payload_size);
+    ls_mic_t expected_mic = ls_calculate_mic_snapshot(mic_state, frame, payload_size);
     ls_mic_t actual_mic = frame->header.mic;
 
     return actual_mic == expected_mic;
 }
 
 void ls_encrypt_frame(uint8_t *key_mic, uint8_t *key_aes, ls_frame_t *frame, size_t *newsize)
+{
+    AES_KEY schedule;
+    hmac_sha256_snapshot_t mic_state;
+
+    if (frame->payload.len > 0) {
+        aes_expand_encrypt_key(key_aes, AES_KEY_SIZE, &schedule);
+    }
+
+    ls_precompute_mic_key(key_mic, &mic_state);
+
+    ls_encrypt_frame_expanded(&mic_state, &schedule, frame, newsize);
+}
+
+void ls_encrypt_frame_expanded(const hmac_sha256_snapshot_t *mic_state, const AES_KEY *aes_schedule, ls_frame_t *frame, size_t *newsize)
 {
     *newsize = frame->payload.len;
 
     if (frame->payload.len > 0) {
-        ls_encrypt_frame_payload(key_aes, frame);
+        ls_encrypt_frame_payload_expanded(aes_schedule, frame);
     }
     else {
         *newsize = 0;
     }
 
-    frame->header.mic = ls_calculate_mic(key_mic, frame, *newsize);
+    frame->header.mic = ls_calculate_mic_snapshot(mic_state, frame, *newsize);
 }
 
 void ls_encrypt_frame_payload(uint8_t *key, ls_frame_t *frame)
 {
-	uint16_t size = frame->payload.len;
+    if (frame->payload.len == 0) {
+        return; /* Nothing to do with empty payload */
+    }
+
+    /* Expand the key once for all payload blocks */
+    AES_KEY schedule;
+    aes_expand_encrypt_key(key, AES_KEY_SIZE, &schedule);
+
+    ls_encrypt_frame_payload_expanded(&schedule, frame);
+}
+
+void ls_encrypt_frame_payload_expanded(const AES_KEY *schedule, ls_frame_t *frame)
+{
+    uint16_t size = frame->payload.len;
 
     if (size == 0) {
         return; /* Nothing to do with empty payload */
     }
 
-    uint8_t s_block[AES_BLOCK_SIZE] = { 0x00, };
+    /* Keystream batch, word-aligned for XOR */
+    uint32_t keystream[LS_KEYSTREAM_BATCH_BLOCKS * AES_BLOCK_SIZE / sizeof(uint32_t)];
+    uint8_t *s_block = (uint8_t *) keystream;
 
     lorawan_block_t a_block;
-    uint16_t i;
-    uint8_t buf_idx = 0;
     uint16_t ctr = 1;
 
-    cipher_t context;
-
-    cipher_init(&context, CIPHER_AES_128, key, AES_KEY_SIZE);
-
     a_block.fb = 0x1;
     a_block.u8_pad = 0;
+    a_block.u32_pad = 0;
     a_block.dir = frame->header.type;
     a_block.dev_addr = byteorder_btoll(byteorder_htonl(frame->header.dev_addr));
     a_block.fcnt = byteorder_btoll(byteorder_htonl(frame->header.fid));
 
     uint8_t *buffer = frame->payload.data;
 
-    while (size >= AES_BLOCK_SIZE) {
-        a_block.len = ((ctr) & 0xFF);
-        ctr++;
+    while (size > 0) {
+        uint16_t chunk = (size < sizeof(keystream)) ? size : sizeof(keystream);
+        uint16_t i;
+
+        /* Generate keystream for the whole chunk at once */
+        for (i = 0; i < chunk; i += AES_BLOCK_SIZE) {
+            a_block.len = ((ctr) & 0xFF);
+            ctr++;
 
-        cipher_encrypt(&context, (uint8_t *) &a_block, s_block);
-        for (i = 0; i < AES_BLOCK_SIZE; i++) {
-            buffer[buf_idx + i] = buffer[buf_idx + i] ^ s_block[i];
+            aes_encrypt_expanded(schedule, (uint8_t *) &a_block, s_block + i);
         }
 
-        size -= AES_BLOCK_SIZE;
-        buf_idx += AES_BLOCK_SIZE;
-    }
+        /* Payload isn't word-aligned within the frame, so words are moved with memcpy */
+        for (i = 0; i + sizeof(uint32_t) <= chunk; i += sizeof(uint32_t)) {
+            uint32_t word;
+            memcpy(&word, buffer + i, sizeof(uint32_t));
+            word ^= keystream[i / sizeof(uint32_t)];
+            memcpy(buffer + i, &word, sizeof(uint32_t));
+        }
 
-    if (size > 0) {
-        a_block.len = ((ctr) & 0xFF);
-        cipher_encrypt(&context, (uint8_t *) &a_block, s_block);
-        for (i = 0; i < size; i++) {
-            buffer[buf_idx + i] = buffer[buf_idx + i] ^ s_block[i];
+        for (; i < chunk; i++) {
+            buffer[i] ^= s_block[i];
         }
+
+        size -= chunk;
+        buffer += chunk;
     }
 }
 
@@ -158,6 +212,11 @@ inline void ls_decrypt_frame_payload(uint8_t *key, ls_frame_t *frame)
     ls_encrypt_frame_payload(key, frame);
 }
 
+inline void ls_decrypt_frame_payload_expanded(const AES_KEY *schedule, ls_frame_t *frame)
+{
+    ls_encrypt_frame_payload_expanded(schedule, frame);
+}
+
 void ls_derive_keys(ls_nonce_t dev_nonce, uint32_t app_nonce, ls_addr_t addr, uint8_t *key_mic, uint8_t *key_aes)
 {
     assert(key_mic != NULL);
@@ -181,6 +240,11 @@ void ls_derive_keys(ls_nonce_t dev_nonce, uint32_t app_nonce, ls_addr_t addr, ui
     }
 }
 
+void ls_precompute_mic_key(const uint8_t *key_mic, hmac_sha256_snapshot_t *mic_state)
+{
+    hmac_sha256_precompute(mic_state, key_mic, LS_MIC_KEY_LEN);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -45,89 +45,104 @@ extern "C" {
 
 void ls_frame_fifo_init(ls_frame_fifo_t *fifo) {
 	mutex_init(&fifo->mutex);
-	fifo->front = fifo->rear = -1;
+	fifo->head = fifo->count = 0;
 }
 
-bool ls_frame_fifo_pop(ls_frame_fifo_t *fifo, ls_frame_t *frame) {
+ls_frame_t *ls_frame_fifo_reserve(ls_frame_fifo_t *fifo) {
+	mutex_lock(&fifo->mutex);
+
+	if (ls_frame_fifo_full(fifo)) {
+		mutex_unlock(&fifo->mutex);
+		return NULL;
+	}
+
+	/* Slot after the last frame isn't touched by the consumer until commit */
+	return &fifo->fifo[(fifo->head + fifo->count) % LS_MAX_FRAME_FIFO_SIZE];
+}
+
+void ls_frame_fifo_commit(ls_frame_fifo_t *fifo) {
+	int c = irq_disable();
+	fifo->count++;
+	irq_restore(c);
+
+	mutex_unlock(&fifo->mutex);
+}
+
+void ls_frame_fifo_cancel(ls_frame_fifo_t *fifo) {
+	mutex_unlock(&fifo->mutex);
+}
+
+ls_frame_t *ls_frame_fifo_peek_ref(ls_frame_fifo_t *fifo) {
 	if (ls_frame_fifo_empty(fifo)) {
-		return false;
+		return NULL;
 	}
 
-	mutex_lock(&fifo->mutex);
+	return &fifo->fifo[fifo->head];
+}
 
-	if (frame != NULL) {
-		*frame = fifo->fifo[fifo->front];
+void ls_frame_fifo_release(ls_frame_fifo_t *fifo) {
+	int c = irq_disable();
+
+	if (fifo->count > 0) {
+		fifo->head = (fifo->head + 1) % LS_MAX_FRAME_FIFO_SIZE;
+		fifo->count--;
 	}
 
-	if (fifo->front == fifo->rear) {
-		fifo->front = fifo->rear = -1;
+	irq_restore(c);
+}
 
-		mutex_unlock(&fifo->mutex);
-		return true;
+bool ls_frame_fifo_pop(ls_frame_fifo_t *fifo, ls_frame_t *frame) {
+	ls_frame_t *f = ls_frame_fifo_peek_ref(fifo);
+	if (f == NULL) {
+		return false;
 	}
-	fifo->front = (fifo->front + 1) % LS_MAX_FRAME_FIFO_SIZE;
 
-	mutex_unlock(&fifo->mutex);
+	if (frame != NULL) {
+		*frame = *f;
+	}
+
+	ls_frame_fifo_release(fifo);
 	return true;
 }
 
 bool ls_frame_fifo_peek(ls_frame_fifo_t *fifo, ls_frame_t *frame) {
-	if (ls_frame_fifo_empty(fifo)) {
+	ls_frame_t *f = ls_frame_fifo_peek_ref(fifo);
+	if (f == NULL) {
 		return false;
 	}
 
-	mutex_lock(&fifo->mutex);
-	*frame = fifo->fifo[fifo->front];
-	mutex_unlock(&fifo->mutex);
+	*frame = *f;
 
 	return true;
 }
 
 bool ls_frame_fifo_push(ls_frame_fifo_t *fifo, ls_frame_t *frame) {
-	if (ls_frame_fifo_full(fifo)) {
+	ls_frame_t *f = ls_frame_fifo_reserve(fifo);
+	if (f == NULL) {
 		return false;
 	}
 
-	int c = irq_disable();
-
-	if (ls_frame_fifo_empty(fifo)) {
-		fifo->front = fifo->rear = 0;
-	} else {
-		fifo->rear = (fifo->rear + 1) % LS_MAX_FRAME_FIFO_SIZE;
-	}
-
-	fifo->fifo[fifo->rear] = *frame;
-
-	irq_restore(c);
+	*f = *frame;
 
+	ls_frame_fifo_commit(fifo);
 	return true;
 }
 
 bool ls_frame_fifo_full(ls_frame_fifo_t *fifo) {
-	return ((fifo->rear + 1) % LS_MAX_FRAME_FIFO_SIZE) == fifo->front;
+	return fifo->count == LS_MAX_FRAME_FIFO_SIZE;
 }
 
 bool ls_frame_fifo_empty(ls_frame_fifo_t *fifo) {
-	return (fifo->front == -1 && fifo->rear == -1);
+	return fifo->count == 0;
 }
 
 int ls_frame_fifo_size(ls_frame_fifo_t *fifo) {
-	if (ls_frame_fifo_empty(fifo)) {
-		return 0;
-	}
-
-	int size = fifo->rear - fifo->front;
-
-	/* Front may be ahead of rear */
-	if (size < 0)
-		size = -size;
-
-	return size;
+	return fifo->count;
 }
 
 void ls_frame_fifo_clear(ls_frame_fifo_t *fifo) {
 	int c = irq_disable();
-	fifo->front = fifo->rear = -1;
+	fifo->count = 0;
 	irq_restore(c);
 }
 
@@ -85,12 +85,22 @@ uint8_t *allocate_stack_name(uint32_t stack_size, const char* caller_name);
 #define UNWDS_MAX_MODULE_NAME 15
 #define UNWDS_MAX_DATA_LEN 126
 
+/* maximum number of modules with NVRAM storage records */
 #define UNWDS_STORAGE_BLOCKS_MAX 16
 
 #define UNWDS_MODULE_NO_DATA    0
 #define UNWDS_MODULE_HAS_DATA   1
 #define UNWDS_MODULE_NOT_FOUND  255
 
+/**
+ * @brief Allowed lateness of periodic data publishing [ms]
+ *
+ * Lets publishing timers of different modules share one wakeup
+ */
+#ifndef UNWDS_PUBLISH_SLACK_MS
+#define UNWDS_PUBLISH_SLACK_MS (5000)
+#endif
+
 #if defined(UNWDS_BUILD_MINIMAL)
     #define UNWDS_SHELL_COMMANDS_MAX (12)
 #else
@@ -158,7 +168,32 @@ void convert_to_be_sam(void *ptr, size_t size);
 /* converts number to BE, sign-and-magnitude format */
 void convert_from_be_sam(void *ptr, size_t size);
 
+/**
+ * @brief Reads the NVRAM storage record of the specified module
+ *
+ * Storage records are meant for frequently changing module state, e.g.
+ * counters. They are kept in a log at the end of the EEPROM, so updating a
+ * record appends it instead of rewriting a fixed block.
+ *
+ * @param	[in]	module_id	ID of the module
+ * @param	[out]	*data_out	Record data
+ * @param	[in]	size		Size of the record
+ *
+ * @return	true	record of @p size bytes read
+ * @return	false	no such record
+ */
 bool unwds_read_nvram_storage(unwds_module_id_t module_id, uint8_t *data_out, size_t size);
+
+/**
+ * @brief Writes the NVRAM storage record of the specified module
+ *
+ * @param	[in]	module_id	ID of the module
+ * @param	[in]	*data		Record data
+ * @param	[in]	data_size	Size of the record, up to 255 bytes
+ *
+ * @return	true	writing success
+ * @return	false	writing failed
+ */
 bool unwds_write_nvram_storage(unwds_module_id_t module_id, uint8_t *data, size_t data_size);
 
 void blink_led(gpio_t led);
@@ -45,6 +45,8 @@ extern "C" {
 #include "rtctimers-millis.h"
 #include "board.h"
 #include "checksum/fletcher16.h"
+#include "kvlog.h"
+#include "mutex.h"
 
 #include "unwds-common.h"
 #include "umdk-ids.h"
@@ -62,7 +64,6 @@ struct {
     uint32_t eeprom_size;
     uint16_t config_storage_size;
     uint8_t storage_blocks;
-    uint8_t min_clean_blocks;
 } unwds_eeprom_layout;
 
 /**
@@ -76,8 +77,17 @@ static uint32_t enabled_bitmap[8];
 static uint32_t nvram_config_block_size = 0;
 static uint32_t nvram_config_base_addr = 0;
 
-static uint8_t storage_used[UNWDS_STORAGE_BLOCKS_MAX] = { 0 };
-static uint8_t storage_blocks[UNWDS_STORAGE_BLOCKS_MAX];
+/**
+ * NVRAM storage, a log of module records in two banks
+ */
+static kvlog_entry_t storage_index[UNWDS_STORAGE_BLOCKS_MAX];
+static kvlog_t storage = {
+    .driver = &kvlog_eeprom_driver,
+    .index = storage_index,
+    .numof = UNWDS_STORAGE_BLOCKS_MAX,
+};
+static mutex_t storage_lock = MUTEX_INIT;
+static bool storage_valid = false;
 
 void unwds_setup_nvram_config(int base_addr, int block_size) {
 	nvram_config_base_addr = base_addr;
@@ -135,159 +145,48 @@ bool unwds_write_nvram_config(unwds_module_id_t module_id, uint8_t *data, size_t
 }
 
 static bool unwds_storage_init(void) {
-    bool config_valid = unwds_read_nvram_config(UNWDS_CONFIG_MODULE_ID, storage_blocks, sizeof(storage_blocks));
-    
-    if (!config_valid) {
-        DEBUG("Storage block config invalid\n");
-        memset((void*)&storage_blocks, 0, sizeof(storage_blocks));
+    storage.base = unwds_eeprom_layout.config_storage_addr;
+    storage.bank_size = (unwds_eeprom_layout.storage_blocks * unwds_eeprom_layout.config_storage_size) / 2;
+
+    int res = kvlog_init(&storage);
+    if (res < 0) {
+        printf("[unwds-common] Error: NVRAM storage unavailable (%d)\n", res);
         return false;
     }
-    
-    return true;
-}
 
-static bool unwds_storage_cleanup(void) {
-    uint32_t clean_blocks = 0;
-    uint32_t i = 0;
-    uint32_t k = 0;
-    
-    for (i = 0; i < unwds_eeprom_layout.storage_blocks; i++) {
-        if (storage_blocks[i] == 0) {
-            clean_blocks++;
-        }
-    }
-    
-    if (clean_blocks < unwds_eeprom_layout.min_clean_blocks) {
-        for (i = 0; i < unwds_eeprom_layout.storage_blocks; i++) {
-            bool block_in_use = false;
-            
-            for (k = 0; k < unwds_eeprom_layout.storage_blocks; k++) {
-                if (storage_blocks[i] == storage_used[k]) {
-                    block_in_use = true;
-                    DEBUG("Block %lu is in use by module %d\n", i, storage_used[k]);
-                    break;
-                }
-            }
-            
-            if (!block_in_use) {
-                DEBUG("Unused block found, was used by module %d\n", storage_blocks[i]);
-                storage_blocks[i] = 0;
-                clean_blocks++;
-            }
-            
-            if (clean_blocks >= unwds_eeprom_layout.min_clean_blocks) {
-                DEBUG("Cleanup done\n");
-                DEBUG("Writing new storage config\n");
-                unwds_write_nvram_config(UNWDS_CONFIG_MODULE_ID, storage_blocks, sizeof(storage_blocks));
-                return true;
-            }
-        }
-    } else {
-        return true;
-    }
-    
-    DEBUG("Done, but only %lu clean blocks\n", clean_blocks);
-    DEBUG("Writing new storage config\n");
-    unwds_write_nvram_config(UNWDS_CONFIG_MODULE_ID, storage_blocks, sizeof(storage_blocks));
-    
-    return false;
-}
-
-static bool unwds_create_storage_block(unwds_module_id_t module_id) {
-    uint32_t i = 0;
-    for (i = 0; i < unwds_eeprom_layout.storage_blocks; i++) {
-        if (storage_blocks[i] == 0) {
-            DEBUG("Found empty storage block\n");
-            storage_blocks[i] = module_id;
-            
-            DEBUG("Erasing EEPROM\n");
-            /* storage size plus 2 bytes CRC16 */
-            int addr = unwds_eeprom_layout.config_storage_addr + (unwds_eeprom_layout.config_storage_size + 2)*i;
-            eeprom_clear(addr, unwds_eeprom_layout.config_storage_size + 2);
-            
-            DEBUG("Writing new storage config\n");
-            unwds_write_nvram_config(UNWDS_CONFIG_MODULE_ID, storage_blocks, sizeof(storage_blocks));
-            return true;
-        }
-    }
-    
-    printf("[unwds-common] Error: no storage block available for module %d\n", module_id);
-    return false;
+    DEBUG("Storage holds %u records, %u bytes used\n", storage.used, (unsigned)storage.end);
+    storage_valid = true;
+    return true;
 }
 
 bool unwds_read_nvram_storage(unwds_module_id_t module_id, uint8_t *data_out, size_t size) {
-    
-    uint32_t addr = 0;
-    uint32_t i = 0;
-    
-    /* add the module to the list of modules currently using EEPROM storage */
-    for (i = 0; i < unwds_eeprom_layout.storage_blocks; i++) {
-        if (storage_used[i] == 0) {
-            storage_used[i] = module_id;
-            break;
-        }
-    }
-    
-    /* find if this module already has dedicated storage space */
-    for (i = 0; i < unwds_eeprom_layout.storage_blocks; i++) {
-        if (storage_blocks[i] == module_id) {
-            /* storage size plus 2 bytes CRC16 */
-            addr = unwds_eeprom_layout.config_storage_addr + (unwds_eeprom_layout.config_storage_size + 2)*i;
-            break;
-        }
-    }
-    
-    /* No such space exists, initialize it */
-    if (addr == 0) {
-        unwds_create_storage_block(module_id);
+    if (!storage_valid) {
         return false;
     }
 
-    /* Read NVRAM block */
-	if (eeprom_read(addr, data_out, size + 2) != size + 2)
-		return false;
-    
-    uint16_t crc16;
-    memcpy(&crc16, data_out+size, 2);
-    
-    if (fletcher16(data_out, size) != crc16) {
-        return false;
-    }
-    
-    return true;
+    mutex_lock(&storage_lock);
+    int res = kvlog_get(&storage, module_id, data_out, size);
+    mutex_unlock(&storage_lock);
+
+    return (res == (int)size);
 }
 
 bool unwds_write_nvram_storage(unwds_module_id_t module_id, uint8_t *data, size_t data_size) {
-    if (data_size > 128)
-		return false;
-    
-    uint32_t addr = 0;
-    uint32_t i = 0;
-    
-    for (i = 0; i < unwds_eeprom_layout.storage_blocks; i++) {
-        if (storage_blocks[i] == module_id) {
-            /* storage size plus 2 bytes CRC16 */
-            addr = unwds_eeprom_layout.config_storage_addr + (unwds_eeprom_layout.config_storage_size + 2)*i;
-            break;
-        }
-    }
-    
-    if (addr == 0) {
+    if (!storage_valid) {
         return false;
     }
-    
-    uint16_t crc16 = fletcher16(data, data_size);
-    
-    /* Write NVRAM block */
-	if (eeprom_write(addr, data, data_size) != data_size) {
-		return false;
-    }
-    
-    if (eeprom_write(addr + data_size, (void *)&crc16, 2) != 2) {
+
+    /* one record appended, the block is not rewritten */
+    mutex_lock(&storage_lock);
+    int res = kvlog_set(&storage, module_id, data, data_size);
+    mutex_unlock(&storage_lock);
+
+    if (res < 0) {
+        printf("[unwds-common] Error: no NVRAM storage for module %d (%d)\n", module_id, res);
         return false;
     }
 
-	return true;
+    return true;
 }
 
 bool unwds_erase_nvram_config(unwds_module_id_t module_id) {
@@ -330,8 +229,6 @@ void unwds_init_modules(uwnds_cb_t *event_callback)
     	}
         i++;
     }
-    
-    unwds_storage_cleanup();
 }
 
 static unwd_module_t *find_module(unwds_module_id_t modid) {
@@ -550,11 +447,9 @@ void unwds_init(void) {
     if (unwds_eeprom_layout.eeprom_size == 8192) {
         unwds_eeprom_layout.config_storage_size = 256;
         unwds_eeprom_layout.storage_blocks = 16;
-        unwds_eeprom_layout.min_clean_blocks = 4;    
     } else {
         unwds_eeprom_layout.config_storage_size = 128;
         unwds_eeprom_layout.storage_blocks = 4;
-        unwds_eeprom_layout.min_clean_blocks = 1;  
     }
     
     unwds_eeprom_layout.config_storage_addr = unwds_eeprom_layout.eeprom_size -
@@ -13,6 +13,17 @@
  * @ingroup     core
  * @{
  *
+ * With the `core_mutex_priority_inheritance` module the mutex remembers its
+ * owner. While a thread of higher priority waits for the mutex, the owner runs
+ * with the priority of that waiter, so threads of intermediate priority can't
+ * delay it indefinitely (priority inversion). On unlock the owner falls back to
+ * its own priority or to that of the highest thread still waiting for another
+ * mutex it holds, also if the mutex is unlocked by another thread or from
+ * interrupt context.
+ *
+ * Inheritance is not transitive: if the owner itself waits for another mutex,
+ * the owner of that one is not boosted.
+ *
  * @file
  * @brief       RIOT synchronization API
  *
@@ -25,6 +36,7 @@
 #include <stddef.h>
 
 #include "list.h"
+#include "kernel_types.h"
 
 #ifdef __cplusplus
  extern "C" {
@@ -40,18 +52,39 @@ typedef struct {
      * @internal
      */
     list_node_t queue;
+#if defined(MODULE_CORE_MUTEX_PRIORITY_INHERITANCE) || defined(DOXYGEN)
+    /**
+     * @brief   The thread holding the mutex, KERNEL_PID_UNDEF if it was
+     *          locked from interrupt context or statically
+     * @internal
+     */
+    kernel_pid_t owner;
+#endif
 } mutex_t;
 
+#if defined(MODULE_CORE_MUTEX_PRIORITY_INHERITANCE) || defined(DOXYGEN)
+/**
+ * @cond INTERNAL
+ * @brief Owner field of the static initializers
+ */
+#define MUTEX_INIT_OWNER , KERNEL_PID_UNDEF
+/**
+ * @endcond
+ */
+#else
+#define MUTEX_INIT_OWNER
+#endif
+
 /**
  * @brief Static initializer for mutex_t.
  * @details This initializer is preferable to mutex_init().
  */
-#define MUTEX_INIT { { NULL } }
+#define MUTEX_INIT { { NULL } MUTEX_INIT_OWNER }
 
 /**
  * @brief Static initializer for mutex_t with a locked mutex
  */
-#define MUTEX_INIT_LOCKED { { MUTEX_LOCKED } }
+#define MUTEX_INIT_LOCKED { { MUTEX_LOCKED } MUTEX_INIT_OWNER }
 
 /**
  * @cond INTERNAL
@@ -72,6 +105,9 @@ typedef struct {
 static inline void mutex_init(mutex_t *mutex)
 {
     mutex->queue.next = NULL;
+#ifdef MODULE_CORE_MUTEX_PRIORITY_INHERITANCE
+    mutex->owner = KERNEL_PID_UNDEF;
+#endif
 }
 
 /**
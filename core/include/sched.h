@@ -133,6 +133,21 @@ void sched_set_status(thread_t *process, unsigned int status);
  */
 void sched_switch(uint16_t other_prio);
 
+/**
+ * @brief   Change the priority of the given thread
+ *
+ * @details Moves the thread to the runqueue of the new priority if it is
+ *          runnable. Doesn't yield, the caller should call sched_switch()
+ *          or thread_yield_higher() if the active thread may be no longer
+ *          the one of the highest priority. Used by the mutex priority
+ *          inheritance, the position of a thread waiting in a mutex queue is
+ *          not updated.
+ *
+ * @param[in]   thread      Thread to change the priority of
+ * @param[in]   priority    New priority, lower value means higher priority
+ */
+void sched_change_priority(thread_t *thread, uint8_t priority);
+
 /**
  * @brief   Call context switching at thread exit
  */
@@ -175,14 +190,41 @@ extern clist_node_t sched_runqueues[SCHED_PRIO_LEVELS];
 NORETURN void sched_task_exit(void);
 
 #ifdef MODULE_SCHEDSTATISTICS
+#if defined(MODULE_SCHEDSTATISTICS_EXT) || defined(DOXYGEN)
+/**
+ * @brief   Number of buckets of the latency histograms
+ *
+ * The last bucket also counts all longer latencies.
+ */
+#ifndef SCHEDSTAT_LATENCY_BUCKETS
+#define SCHEDSTAT_LATENCY_BUCKETS   (24)
+#endif
+#endif
+
 /**
  *  Scheduler statistics
+ *
+ *  With the `schedstatistics_ext` module the time stamps are taken from the
+ *  DWT cycle counter on Cortex-M3 and above instead of xtimer, see
+ *  @ref sched_statistics_hz. The cycle counter stops while the CPU sleeps,
+ *  so the runtime of the idle thread only covers the time it is awake.
  */
 typedef struct {
     uint32_t laststart;      /**< Time stamp of the last time this thread was
                                   scheduled to run */
     unsigned int schedules;  /**< How often the thread was scheduled to run */
     uint64_t runtime_ticks;  /**< The total runtime of this thread in ticks */
+#if defined(MODULE_SCHEDSTATISTICS_EXT) || defined(DOXYGEN)
+    uint32_t ready;          /**< Time stamp of the last time this thread
+                                  became ready to run */
+    uint32_t max_latency;    /**< Longest time from ready to running */
+    uint32_t max_slice;      /**< Longest time running without a switch */
+    unsigned int preemptions;   /**< How often the thread was switched out
+                                     while it was still ready to run */
+    uint16_t latency[SCHEDSTAT_LATENCY_BUCKETS];    /**< Histogram of the
+                                  times from ready to running, bucket `n`
+                                  counts times in [2^n, 2^(n+1)) ticks */
+#endif
 } schedstat;
 
 /**
@@ -196,6 +238,25 @@ extern schedstat sched_pidlist[KERNEL_PID_LAST + 1];
  *  @param[in] callback The callback functions the will be called
  */
 void sched_register_cb(void (*callback)(uint32_t, uint32_t));
+
+#if defined(MODULE_SCHEDSTATISTICS_EXT) || defined(DOXYGEN)
+/**
+ *  @brief  Frequency of the time stamps in the scheduler statistics in Hz
+ */
+extern const uint32_t sched_statistics_hz;
+
+/**
+ *  @brief  Starts the time stamp counter of the scheduler statistics
+ *
+ *  Called by kernel_init() before the first thread is created.
+ */
+void sched_statistics_init(void);
+
+/**
+ *  @brief  Clears latencies, run slices and preemption counts of all threads
+ */
+void sched_statistics_reset(void);
+#endif
 #endif /* MODULE_SCHEDSTATISTICS */
 
 #ifdef __cplusplus
@@ -83,6 +83,10 @@ void kernel_init(void)
 {
     (void) irq_disable();
 
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+    sched_statistics_init();
+#endif
+
     thread_create(idle_stack, sizeof(idle_stack),
             THREAD_PRIORITY_IDLE,
             THREAD_CREATE_WOUT_YIELD | THREAD_CREATE_STACKTEST,
@@ -32,6 +32,98 @@
 #define ENABLE_DEBUG    (0)
 #include "debug.h"
 
+#ifdef MODULE_CORE_MUTEX_PRIORITY_INHERITANCE
+static inline void _set_owner(mutex_t *mutex, thread_t *owner)
+{
+    mutex->owner = (owner == NULL) ? KERNEL_PID_UNDEF : owner->pid;
+}
+
+static inline thread_t *_get_owner(mutex_t *mutex)
+{
+    if (mutex->owner == KERNEL_PID_UNDEF) {
+        return NULL;
+    }
+
+    return (thread_t *)thread_get(mutex->owner);
+}
+
+/* Lets the owner run with the priority of the waiter */
+static inline void _inherit_priority(mutex_t *mutex, thread_t *waiter)
+{
+    thread_t *owner = _get_owner(mutex);
+
+    waiter->mutex_wait = mutex;
+
+    if ((owner != NULL) && (owner->priority > waiter->priority)) {
+        DEBUG("PID[%" PRIkernel_pid "]: raising priority of owner %"
+              PRIkernel_pid " to %" PRIu8 "\n", waiter->pid, owner->pid,
+              waiter->priority);
+        sched_change_priority(owner, waiter->priority);
+    }
+}
+
+/* Tells if the owner still runs with the priority of a waiter */
+static inline bool _is_boosted(thread_t *owner)
+{
+    return (owner != NULL) && (owner->priority != owner->base_priority);
+}
+
+/* Sets the priority of a former owner to its own one or to that of the
+ * highest thread still waiting for a mutex it holds. Only blocked threads
+ * are looked at, their mutexes are known to be alive. Walks all threads,
+ * so it is only called with IRQs disabled and when the owner may be
+ * boosted. */
+static void _restore_priority(thread_t *owner)
+{
+    if (owner == NULL) {
+        return;
+    }
+
+    uint8_t priority = owner->base_priority;
+
+    for (kernel_pid_t pid = KERNEL_PID_FIRST; pid <= KERNEL_PID_LAST; pid++) {
+        thread_t *waiter = (thread_t *)sched_threads[pid];
+
+        if ((waiter != NULL) && (waiter->status == STATUS_MUTEX_BLOCKED) &&
+            (((mutex_t *)waiter->mutex_wait)->owner == owner->pid) &&
+            (waiter->priority < priority)) {
+            priority = waiter->priority;
+        }
+    }
+
+    sched_change_priority(owner, priority);
+}
+#else
+static inline void _set_owner(mutex_t *mutex, thread_t *owner)
+{
+    (void)mutex;
+    (void)owner;
+}
+
+static inline thread_t *_get_owner(mutex_t *mutex)
+{
+    (void)mutex;
+    return NULL;
+}
+
+static inline void _inherit_priority(mutex_t *mutex, thread_t *waiter)
+{
+    (void)mutex;
+    (void)waiter;
+}
+
+static inline bool _is_boosted(thread_t *owner)
+{
+    (void)owner;
+    return false;
+}
+
+static inline void _restore_priority(thread_t *owner)
+{
+    (void)owner;
+}
+#endif
+
 int _mutex_lock(mutex_t *mutex, int blocking)
 {
     unsigned irqstate = irq_disable();
@@ -41,6 +133,7 @@ int _mutex_lock(mutex_t *mutex, int blocking)
     if (mutex->queue.next == NULL) {
         /* mutex is unlocked. */
         mutex->queue.next = MUTEX_LOCKED;
+        _set_owner(mutex, irq_is_in() ? NULL : (thread_t *)sched_active_thread);
         DEBUG("PID[%" PRIkernel_pid "]: mutex_wait early out.\n",
               sched_active_pid);
         irq_restore(irqstate);
@@ -58,6 +151,7 @@ int _mutex_lock(mutex_t *mutex, int blocking)
         else {
             thread_add_to_list(&mutex->queue, me);
         }
+        _inherit_priority(mutex, me);
         irq_restore(irqstate);
         thread_yield_higher();
         /* We were woken up by scheduler. Waker removed us from queue.
@@ -83,9 +177,19 @@ void mutex_unlock(mutex_t *mutex)
         return;
     }
 
+    thread_t *owner = _get_owner(mutex);
+
     if (mutex->queue.next == MUTEX_LOCKED) {
         mutex->queue.next = NULL;
-        /* the mutex was locked and no thread was waiting for it */
+        _set_owner(mutex, NULL);
+        /* nobody waits for this mutex anymore, but a waiter that timed out
+         * (xtimer_mutex_lock_timeout()) may have left the owner boosted */
+        if (_is_boosted(owner)) {
+            _restore_priority(owner);
+            irq_restore(irqstate);
+            thread_yield_higher();
+            return;
+        }
         irq_restore(irqstate);
         return;
     }
@@ -97,11 +201,15 @@ void mutex_unlock(mutex_t *mutex)
     DEBUG("mutex_unlock: waking up waiting thread %" PRIkernel_pid "\n",
           process->pid);
     sched_set_status(process, STATUS_PENDING);
+    _set_owner(mutex, process);
 
     if (!mutex->queue.next) {
         mutex->queue.next = MUTEX_LOCKED;
     }
 
+    /* the remaining waiters wait for the new owner now */
+    _restore_priority(owner);
+
     uint16_t process_priority = process->priority;
     irq_restore(irqstate);
     sched_switch(process_priority);
@@ -114,8 +222,15 @@ void mutex_unlock_and_sleep(mutex_t *mutex)
     unsigned irqstate = irq_disable();
 
     if (mutex->queue.next) {
+        thread_t *owner = _get_owner(mutex);
+
         if (mutex->queue.next == MUTEX_LOCKED) {
             mutex->queue.next = NULL;
+            _set_owner(mutex, NULL);
+            /* see mutex_unlock() */
+            if (_is_boosted(owner)) {
+                _restore_priority(owner);
+            }
         }
         else {
             list_node_t *next = list_remove_head(&mutex->queue);
@@ -123,9 +238,11 @@ void mutex_unlock_and_sleep(mutex_t *mutex)
                                              rq_entry);
             DEBUG("PID[%" PRIkernel_pid "]: waking up waiter.\n", process->pid);
             sched_set_status(process, STATUS_PENDING);
+            _set_owner(mutex, process);
             if (!mutex->queue.next) {
                 mutex->queue.next = MUTEX_LOCKED;
             }
+            _restore_priority(owner);
         }
     }
 
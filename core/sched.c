@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include "assert.h"
 #include "sched.h"
 #include "clist.h"
 #include "bitarithm.h"
@@ -37,6 +38,11 @@
 #include "xtimer.h"
 #endif
 
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+#include <string.h>
+#include "cpu.h"
+#endif
+
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
@@ -79,6 +85,71 @@ static void (*sched_cb) (uint32_t timestamp, uint32_t value) = NULL;
 schedstat sched_pidlist[KERNEL_PID_LAST + 1];
 #endif
 
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+/* Reading the DWT cycle counter is a single load, xtimer_now() may need a
+ * critical section and a peripheral access on every switch */
+#if defined(DWT) && defined(CLOCK_CORECLOCK)
+const uint32_t sched_statistics_hz = CLOCK_CORECLOCK;
+
+static inline uint32_t _stat_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+void sched_statistics_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+#else
+const uint32_t sched_statistics_hz = XTIMER_HZ;
+
+static inline uint32_t _stat_now(void)
+{
+    return xtimer_now().ticks32;
+}
+
+void sched_statistics_init(void)
+{
+}
+#endif
+
+void sched_statistics_reset(void)
+{
+    unsigned state = irq_disable();
+
+    for (kernel_pid_t i = 0; i <= KERNEL_PID_LAST; i++) {
+        schedstat *stat = &sched_pidlist[i];
+
+        stat->max_latency = 0;
+        stat->max_slice = 0;
+        stat->preemptions = 0;
+        memset(stat->latency, 0, sizeof(stat->latency));
+    }
+
+    irq_restore(state);
+}
+
+static void _stat_run(schedstat *stat, uint32_t now)
+{
+    uint32_t latency = now - stat->ready;
+    unsigned bucket = bitarithm_msb(latency | 1);
+
+    if (bucket >= SCHEDSTAT_LATENCY_BUCKETS) {
+        bucket = SCHEDSTAT_LATENCY_BUCKETS - 1;
+    }
+    if (stat->latency[bucket] < UINT16_MAX) {
+        stat->latency[bucket]++;
+    }
+    if (latency > stat->max_latency) {
+        stat->max_latency = latency;
+    }
+}
+#else
+#define _stat_now()     (xtimer_now().ticks32)
+#endif
+
 int __attribute__((used)) sched_run(void)
 {
     sched_context_switch_request = 0;
@@ -101,12 +172,16 @@ int __attribute__((used)) sched_run(void)
     }
 
 #ifdef MODULE_SCHEDSTATISTICS
-    uint32_t now = xtimer_now().ticks32;
+    uint32_t now = _stat_now();
 #endif
 
     if (active_thread) {
         if (active_thread->status == STATUS_RUNNING) {
             active_thread->status = STATUS_PENDING;
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+            sched_pidlist[active_thread->pid].preemptions++;
+            sched_pidlist[active_thread->pid].ready = now;
+#endif
         }
 
 #ifdef SCHED_TEST_STACK
@@ -118,7 +193,14 @@ int __attribute__((used)) sched_run(void)
 #ifdef MODULE_SCHEDSTATISTICS
         schedstat *active_stat = &sched_pidlist[active_thread->pid];
         if (active_stat->laststart) {
-            active_stat->runtime_ticks += now - active_stat->laststart;
+            uint32_t slice = now - active_stat->laststart;
+
+            active_stat->runtime_ticks += slice;
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+            if (slice > active_stat->max_slice) {
+                active_stat->max_slice = slice;
+            }
+#endif
         }
 #endif
     }
@@ -127,6 +209,9 @@ int __attribute__((used)) sched_run(void)
     schedstat *next_stat = &sched_pidlist[next_thread->pid];
     next_stat->laststart = now;
     next_stat->schedules++;
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+    _stat_run(next_stat, now);
+#endif
     if (sched_cb) {
         sched_cb(now, next_thread->pid);
     }
@@ -166,6 +251,9 @@ void sched_set_status(thread_t *process, unsigned int status)
                   process->pid, process->priority);
             clist_rpush(&sched_runqueues[process->priority], &(process->rq_entry));
             runqueue_bitcache |= 1 << process->priority;
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+            sched_pidlist[process->pid].ready = _stat_now();
+#endif
         }
     }
     else {
@@ -208,6 +296,37 @@ void sched_switch(uint16_t other_prio)
     }
 }
 
+void sched_change_priority(thread_t *thread, uint8_t priority)
+{
+    assert(thread != NULL);
+    assert(priority < SCHED_PRIO_LEVELS);
+
+    unsigned irqstate = irq_disable();
+    uint8_t old_priority = thread->priority;
+
+    if (old_priority == priority) {
+        irq_restore(irqstate);
+        return;
+    }
+
+    DEBUG("sched_change_priority: thread %" PRIkernel_pid " priority %" PRIu8
+          " -> %" PRIu8 "\n", thread->pid, old_priority, priority);
+
+    if (thread->status >= STATUS_ON_RUNQUEUE) {
+        clist_remove(&sched_runqueues[old_priority], &thread->rq_entry);
+        if (!sched_runqueues[old_priority].next) {
+            runqueue_bitcache &= ~(1 << old_priority);
+        }
+
+        clist_rpush(&sched_runqueues[priority], &thread->rq_entry);
+        runqueue_bitcache |= 1 << priority;
+    }
+
+    thread->priority = priority;
+
+    irq_restore(irqstate);
+}
+
 NORETURN void sched_task_exit(void)
 {
     DEBUG("sched_task_exit: ending thread %" PRIkernel_pid "...\n", sched_active_thread->pid);
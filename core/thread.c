@@ -226,6 +226,11 @@ kernel_pid_t thread_create(char *stack, int stacksize, char priority, int flags,
     cb->priority = priority;
     cb->status = 0;
 
+#ifdef MODULE_CORE_MUTEX_PRIORITY_INHERITANCE
+    cb->base_priority = priority;
+    cb->mutex_wait = NULL;
+#endif
+
     cb->rq_entry.next = NULL;
 
 #ifdef MODULE_CORE_MSG
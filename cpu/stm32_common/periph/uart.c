@@ -32,6 +32,27 @@
 #include "periph/gpio.h"
 #include "pm_layered.h"
 
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+#include "irq.h"
+#include "mutex.h"
+#include "tsrb.h"
+
+/**
+ * @brief   Size of the transmit buffer of each UART, must be a power of 2
+ */
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE     (128)
+#endif
+
+#if defined(CPU_FAM_STM32F0) || defined(CPU_FAM_STM32L0) \
+    || defined(CPU_FAM_STM32F3) || defined(CPU_FAM_STM32L4) \
+    || defined(CPU_FAM_STM32F7)
+#define TX_COMPLETE_FLAG    (USART_ISR_TC)
+#else
+#define TX_COMPLETE_FLAG    (USART_SR_TC)
+#endif
+#endif
+
 #define RXENABLE            (USART_CR1_RE | USART_CR1_RXNEIE)
 
 /**
@@ -39,6 +60,27 @@
  */
 static uart_isr_ctx_t isr_ctx[UART_NUMOF];
 
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+/**
+ * @brief   Transmit buffers, drained by the TXE interrupt
+ */
+static tsrb_t tx_rb[UART_NUMOF];
+static char tx_rb_buf[UART_NUMOF][UART_TXBUF_SIZE];
+
+/**
+ * @brief   Serializes threads writing to the same UART
+ */
+static mutex_t tx_lock[UART_NUMOF];
+
+/**
+ * @brief   Writer sleeps on it while the transmit buffer is full
+ */
+static mutex_t tx_space[UART_NUMOF];
+static volatile uint8_t tx_waiting[UART_NUMOF];
+
+static void tx_drain(uart_t uart);
+#endif
+
 static inline USART_TypeDef *dev(uart_t uart)
 {
     return uart_config[uart].dev;
@@ -94,6 +136,16 @@ int uart_init_ext(uart_t uart, uart_params_t *params, uart_rx_cb_t rx_cb, void *
     isr_ctx[uart].rx_cb = rx_cb;
     isr_ctx[uart].arg   = arg;
 
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    /* finish a transmission started before, it holds a PM block */
+    tx_drain(uart);
+    tsrb_init(&tx_rb[uart], tx_rb_buf[uart], UART_TXBUF_SIZE);
+    mutex_init(&tx_lock[uart]);
+    mutex_t locked = MUTEX_INIT_LOCKED;
+    tx_space[uart] = locked;
+    tx_waiting[uart] = 0;
+#endif
+
     /* configure RX and TX pin */
     gpio_init(uart_config[uart].rx_pin, uart_config[uart].rx_mode);
     gpio_init(uart_config[uart].tx_pin, uart_config[uart].tx_mode);
@@ -173,6 +225,10 @@ int uart_init_ext(uart_t uart, uart_params_t *params, uart_rx_cb_t rx_cb, void *
         NVIC_EnableIRQ(uart_config[uart].irqn);
         dev(uart)->CR1 |= RXENABLE;
     }
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    /* transmission is interrupt driven */
+    NVIC_EnableIRQ(uart_config[uart].irqn);
+#endif
 
 #ifdef MODULE_STM32_PERIPH_UART_HW_FC
     if (uart_config[uart].cts_pin != GPIO_UNDEF) {
@@ -218,10 +274,105 @@ static inline void wait_for_tx_complete(uart_t uart)
 #endif
 }
 
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+static inline void tx_start(uart_t uart)
+{
+    uint32_t cr1 = dev(uart)->CR1;
+
+#ifdef STM32_PM_STOP
+    /* UART is not clocked in STOP mode, block it until the last byte is sent */
+    if (!(cr1 & (USART_CR1_TXEIE | USART_CR1_TCIE))) {
+        pm_block(STM32_PM_STOP);
+    }
+#endif
+
+    dev(uart)->CR1 = (cr1 & ~USART_CR1_TCIE) | USART_CR1_TXEIE;
+}
+
+static void write_nonblocking(uart_t uart, const uint8_t *data, size_t len)
+{
+    tsrb_t *rb = &tx_rb[uart];
+
+    if (irq_is_in() || __get_PRIMASK()) {
+        /* TXE interrupt can't be served now (e.g. panic message), so send
+         * whatever is buffered and then the data itself synchronously */
+        unsigned state = irq_disable();
+        int c;
+        while ((c = tsrb_get_one(rb)) >= 0) {
+            send_byte(uart, c);
+        }
+        for (size_t i = 0; i < len; i++) {
+            send_byte(uart, data[i]);
+        }
+        wait_for_tx_complete(uart);
+        irq_restore(state);
+        return;
+    }
+
+    mutex_lock(&tx_lock[uart]);
+
+    while (len > 0) {
+        /* buffer may be written from interrupt context too, see above */
+        unsigned state = irq_disable();
+        size_t n = tsrb_add(rb, (const char *)data, len);
+        if (n > 0) {
+            tx_start(uart);
+        }
+        if (n < len) {
+            tx_waiting[uart] = 1;
+        }
+        irq_restore(state);
+
+        data += n;
+        len -= n;
+
+        if (len > 0) {
+            /* sleep until TXE interrupt frees half of the buffer */
+            mutex_lock(&tx_space[uart]);
+        }
+    }
+
+    mutex_unlock(&tx_lock[uart]);
+}
+
+/* waits until the transmit buffer is sent and the TX interrupts are off */
+static void tx_drain(uart_t uart)
+{
+    if (!irq_is_in() && !__get_PRIMASK()) {
+        /* the interrupt sends the rest and releases the PM block */
+        while (dev(uart)->CR1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) {}
+        return;
+    }
+
+    /* the interrupt can't be served, send the rest synchronously */
+    uint32_t cr1 = dev(uart)->CR1;
+    if (cr1 & (USART_CR1_TXEIE | USART_CR1_TCIE)) {
+        int c;
+        while ((c = tsrb_get_one(&tx_rb[uart])) >= 0) {
+            send_byte(uart, c);
+        }
+        wait_for_tx_complete(uart);
+        dev(uart)->CR1 = cr1 & ~(USART_CR1_TXEIE | USART_CR1_TCIE);
+#ifdef STM32_PM_STOP
+        pm_unblock(STM32_PM_STOP);
+#endif
+    }
+    if (tx_waiting[uart]) {
+        tx_waiting[uart] = 0;
+        mutex_unlock(&tx_space[uart]);
+    }
+}
+#endif
+
 void uart_write(uart_t uart, const uint8_t *data, size_t len)
 {
     assert(uart < UART_NUMOF);
 
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    write_nonblocking(uart, data, len);
+    return;
+#endif
+
 #ifdef MODULE_PERIPH_DMA
     if (!len) {
         return;
@@ -284,6 +435,11 @@ void uart_poweroff(uart_t uart)
 {
     assert(uart < UART_NUMOF);
 
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    /* TX interrupts stop without the clock, don't leave the PM block behind */
+    tx_drain(uart);
+#endif
+
     periph_clk_dis(uart_config[uart].bus, uart_config[uart].rcc_mask);
 #if defined(STM32_PM_STOP) && defined(STM32_PM_BLOCK_UART)
     if (isr_ctx[uart].rx_cb) {
@@ -306,6 +462,14 @@ static inline void irq_handler(uart_t uart)
     if (status & USART_ISR_ORE) {
         dev(uart)->ICR |= USART_ICR_ORECF;    /* simply clear flag on overrun */
     }
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    if ((status & USART_ISR_TXE) && (dev(uart)->CR1 & USART_CR1_TXEIE)) {
+        int c = tsrb_get_one(&tx_rb[uart]);
+        if (c >= 0) {
+            dev(uart)->TDR = (uint8_t)c;
+        }
+    }
+#endif
 
 #else
 
@@ -318,7 +482,34 @@ static inline void irq_handler(uart_t uart)
         /* ORE is cleared by reading SR and DR sequentially */
         dev(uart)->DR;
     }
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    if ((status & USART_SR_TXE) && (dev(uart)->CR1 & USART_CR1_TXEIE)) {
+        int c = tsrb_get_one(&tx_rb[uart]);
+        if (c >= 0) {
+            dev(uart)->DR = (uint8_t)c;
+        }
+    }
+#endif
 
+#endif
+
+#ifdef MODULE_PERIPH_UART_NONBLOCKING
+    tsrb_t *rb = &tx_rb[uart];
+    uint32_t cr1 = dev(uart)->CR1;
+    if ((cr1 & USART_CR1_TXEIE) && tsrb_empty(rb)) {
+        /* wait for the last byte to leave the shift register */
+        dev(uart)->CR1 = (cr1 & ~USART_CR1_TXEIE) | USART_CR1_TCIE;
+    }
+    else if ((cr1 & USART_CR1_TCIE) && (status & TX_COMPLETE_FLAG)) {
+        dev(uart)->CR1 = cr1 & ~USART_CR1_TCIE;
+#ifdef STM32_PM_STOP
+        pm_unblock(STM32_PM_STOP);
+#endif
+    }
+    if (tx_waiting[uart] && (tsrb_free(rb) >= UART_TXBUF_SIZE / 2)) {
+        tx_waiting[uart] = 0;
+        mutex_unlock(&tx_space[uart]);
+    }
 #endif
 
     cortexm_isr_end();
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    drivers_mtd_cache MTD page cache
+ * @ingroup     drivers_storage
+ * @brief       Write-back page cache stacked on another MTD
+ *
+ * Keeps recently used pages of a backing MTD in RAM, so that file systems
+ * reading their metadata in small pieces access the device once per page.
+ * Pages are replaced least recently used first. Writes are merged in the
+ * cached page and written back when the page is replaced, on mtd_flush()
+ * and before powering down the device. Sequential read misses read the
+ * following pages ahead.
+ *
+ * The cache has the write semantics of flash memory: a write clears bits in
+ * the cached page (`page &= data`), so it is meant for devices that are
+ * erased before they are written, like mtd_spi_nor and mtd_native.
+ *
+ * The cache is a MTD itself and is used with the usual mtd functions:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * static uint8_t cache_buf[8 * 256];
+ * static mtd_cache_page_t cache_pages[8];
+ * static mtd_cache_t cache = {
+ *     .base = { .driver = &mtd_cache_driver },
+ *     .parent = MTD_0,
+ *     .buf = cache_buf,
+ *     .pages = cache_pages,
+ *     .numof = 8,
+ *     .readahead = 2,
+ * };
+ *
+ * mtd_init(&cache.base);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @{
+ *
+ * @file
+ * @brief       MTD page cache interface
+ */
+
+#ifndef MTD_CACHE_H
+#define MTD_CACHE_H
+
+#include <stdint.h>
+
+#include "mtd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Page number of unused cache pages
+ */
+#define MTD_CACHE_NONE      (UINT32_MAX)
+
+/**
+ * @brief   Descriptor of a cached page
+ */
+typedef struct {
+    uint32_t page;          /**< page number in the backing device,
+                             *   @ref MTD_CACHE_NONE if unused */
+    uint32_t used;          /**< last access for LRU replacement */
+    uint16_t dirty_start;   /**< first byte not written back */
+    uint16_t dirty_end;     /**< end of bytes not written back, the page
+                             *   is clean if equal to dirty_start */
+} mtd_cache_page_t;
+
+/**
+ * @brief   Cache statistics
+ */
+typedef struct {
+    uint32_t hits;          /**< page accesses served from the cache */
+    uint32_t misses;        /**< page accesses read from the backing device */
+    uint32_t readaheads;    /**< pages read ahead */
+    uint32_t merged;        /**< writes to pages not written back yet */
+    uint32_t writebacks;    /**< pages written to the backing device */
+} mtd_cache_stats_t;
+
+/**
+ * @brief   Device descriptor for mtd_cache device
+ *
+ * This is an extension of the @c mtd_dev_t struct. The geometry of
+ * mtd_cache_t::base is taken from mtd_cache_t::parent on initialization.
+ */
+typedef struct {
+    mtd_dev_t base;             /**< inherit from mtd_dev_t object */
+    mtd_dev_t *parent;          /**< backing device */
+    uint8_t *buf;               /**< page buffers, mtd_cache_t::numof times
+                                 *   the page size of the backing device */
+    mtd_cache_page_t *pages;    /**< page descriptors, mtd_cache_t::numof
+                                 *   entries */
+    uint16_t numof;             /**< number of cached pages */
+    uint16_t readahead;         /**< pages to read ahead on sequential misses,
+                                 *   less than mtd_cache_t::numof */
+    uint32_t tick;              /**< access counter for LRU replacement */
+    uint32_t next_miss;         /**< page that continues the last miss */
+    mtd_cache_stats_t stats;    /**< cache statistics */
+} mtd_cache_t;
+
+/**
+ * @brief   mtd_cache device operations table for mtd
+ */
+extern const mtd_desc_t mtd_cache_driver;
+
+/**
+ * @brief   Drops all cached pages without writing them back
+ *
+ * For when the backing device was changed without the cache
+ *
+ * @param[in,out] cache the cache
+ */
+void mtd_cache_invalidate(mtd_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MTD_CACHE_H */
+/** @} */
@@ -12,6 +12,26 @@
  * @ingroup     drivers_storage
  * @brief       Driver for serial NOR flash memory technology devices attached via SPI
  *
+ * Erasing a sector takes tens to hundreds of milliseconds, and the mtd
+ * functions block the caller and the SPI bus until the flash is done. With
+ * the `mtd_spi_nor_async` module, erase and program operations can also be
+ * submitted without waiting: the driver issues one command at a time and
+ * polls the status register from an event queue, releasing the bus in
+ * between, and calls a callback when the whole operation has completed.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * static void erased(void *arg)
+ * {
+ *     // called from the thread handling queue
+ * }
+ *
+ * mtd_spi_nor_async_init(dev, &queue);
+ * mtd_spi_nor_erase_async(dev, addr, 4 * sector_size, erased, NULL);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * While an operation is pending, the mtd functions of the device return
+ * -EBUSY.
+ *
  * @{
  *
  * @file
@@ -30,6 +50,9 @@
 #include "periph/spi.h"
 #include "periph/gpio.h"
 #include "mtd.h"
+#if defined(MODULE_MTD_SPI_NOR_ASYNC) || defined(DOXYGEN)
+#include "event/timeout.h"
+#endif
 
 #ifdef __cplusplus
 extern "C"
@@ -83,6 +106,46 @@ typedef struct __attribute__((packed)) {
  */
 #define SPI_NOR_F_SECT_32K  (2)
 
+#if defined(MODULE_MTD_SPI_NOR_ASYNC) || defined(DOXYGEN)
+/**
+ * @brief   Status poll interval of asynchronous erase operations in us
+ */
+#ifndef MTD_SPI_NOR_ASYNC_ERASE_POLL_US
+#define MTD_SPI_NOR_ASYNC_ERASE_POLL_US (10U * US_PER_MS)
+#endif
+
+/**
+ * @brief   Status poll interval of asynchronous program operations in us
+ */
+#ifndef MTD_SPI_NOR_ASYNC_WRITE_POLL_US
+#define MTD_SPI_NOR_ASYNC_WRITE_POLL_US (1U * US_PER_MS)
+#endif
+
+/**
+ * @brief   Completion callback of asynchronous operations
+ *
+ * @param[in] arg   argument given on submission
+ */
+typedef void (*mtd_spi_nor_cb_t)(void *arg);
+
+/**
+ * @brief   State of an asynchronous operation
+ *
+ * Managed by the driver, no need to touch outside the driver.
+ */
+typedef struct {
+    event_t event;              /**< status poll, handled in the queue */
+    event_timeout_t timeout;    /**< timer posting the status poll */
+    event_queue_t *queue;       /**< queue handling the status polls */
+    mtd_spi_nor_cb_t cb;        /**< completion callback */
+    void *arg;                  /**< argument of the completion callback */
+    const uint8_t *src;         /**< data left to program */
+    uint32_t addr;              /**< address of the next command */
+    uint32_t left;              /**< bytes left to erase or to program */
+    uint8_t op;                 /**< pending operation */
+} mtd_spi_nor_async_t;
+#endif
+
 /**
  * @brief   Device descriptor for serial flash memory devices
  *
@@ -122,6 +185,9 @@ typedef struct {
      * Computed by mtd_spi_nor_init, no need to touch outside the driver.
      */
     uint8_t sec_addr_shift;
+#if defined(MODULE_MTD_SPI_NOR_ASYNC) || defined(DOXYGEN)
+    mtd_spi_nor_async_t async; /**< state of asynchronous operations */
+#endif
 } mtd_spi_nor_t;
 
 /**
@@ -140,6 +206,65 @@ extern const mtd_desc_t mtd_spi_nor_driver;
  * sensible for default values. */
 extern const mtd_spi_nor_opcode_t mtd_spi_nor_opcode_default;
 
+#if defined(MODULE_MTD_SPI_NOR_ASYNC) || defined(DOXYGEN)
+/**
+ * @brief   Initialize asynchronous operations of a device
+ *
+ * @param[in,out] dev   initialized device
+ * @param[in]     queue event queue polling the device status, its thread
+ *                      runs the completion callbacks
+ */
+void mtd_spi_nor_async_init(mtd_spi_nor_t *dev, event_queue_t *queue);
+
+/**
+ * @brief   Submit an erase of the device without waiting for it
+ *
+ * @p addr and @p size have the same restrictions as with mtd_erase().
+ *
+ * @param[in,out] dev   device
+ * @param[in]     addr  address of the first sector to erase
+ * @param[in]     size  number of bytes to erase
+ * @param[in]     cb    called when the erase has completed, may be NULL
+ * @param[in]     arg   argument of @p cb
+ *
+ * @return 0 if submitted
+ * @return -EBUSY if another operation is pending
+ * @return -EOVERFLOW if @p addr or @p size is not valid
+ */
+int mtd_spi_nor_erase_async(mtd_spi_nor_t *dev, uint32_t addr, uint32_t size,
+                            mtd_spi_nor_cb_t cb, void *arg);
+
+/**
+ * @brief   Submit a program of the device without waiting for it
+ *
+ * Unlike mtd_write(), the data may span several pages, they are programmed
+ * one after the other. @p src must stay valid until the operation completes.
+ *
+ * @param[in,out] dev   device
+ * @param[in]     src   data to program
+ * @param[in]     addr  address to program
+ * @param[in]     size  number of bytes to program
+ * @param[in]     cb    called when the program has completed, may be NULL
+ * @param[in]     arg   argument of @p cb
+ *
+ * @return 0 if submitted
+ * @return -EBUSY if another operation is pending
+ * @return -EOVERFLOW if the data exceeds the device
+ */
+int mtd_spi_nor_write_async(mtd_spi_nor_t *dev, const void *src, uint32_t addr,
+                            uint32_t size, mtd_spi_nor_cb_t cb, void *arg);
+
+/**
+ * @brief   Check whether an asynchronous operation is pending
+ *
+ * @param[in] dev   device
+ *
+ * @return 1 until the completion callback of the operation is called
+ * @return 0 otherwise
+ */
+int mtd_spi_nor_async_busy(const mtd_spi_nor_t *dev);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     drivers_mtd_cache
+ * @{
+ *
+ * @file
+ * @brief       MTD page cache implementation
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "mtd.h"
+#include "mtd_cache.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+static inline uint32_t _size(const mtd_dev_t *dev)
+{
+    return dev->sector_count * dev->pages_per_sector * dev->page_size;
+}
+
+static inline uint8_t *_data(mtd_cache_t *cache, const mtd_cache_page_t *p)
+{
+    return cache->buf + (p - cache->pages) * cache->base.page_size;
+}
+
+static inline int _dirty(const mtd_cache_page_t *p)
+{
+    return p->dirty_start != p->dirty_end;
+}
+
+static mtd_cache_page_t *_find(mtd_cache_t *cache, uint32_t page)
+{
+    for (unsigned i = 0; i < cache->numof; i++) {
+        if (cache->pages[i].page == page) {
+            cache->pages[i].used = ++cache->tick;
+            return &cache->pages[i];
+        }
+    }
+    return NULL;
+}
+
+static int _writeback(mtd_cache_t *cache, mtd_cache_page_t *p)
+{
+    uint32_t addr = p->page * cache->base.page_size + p->dirty_start;
+    uint32_t count = p->dirty_end - p->dirty_start;
+
+    DEBUG("mtd_cache: write back page %" PRIu32 " [%u, %u)\n", p->page,
+          p->dirty_start, p->dirty_end);
+
+    int ret = mtd_write(cache->parent, _data(cache, p) + p->dirty_start,
+                        addr, count);
+    if (ret < 0) {
+        return ret;
+    }
+    if ((uint32_t)ret != count) {
+        return -EIO;
+    }
+    p->dirty_start = p->dirty_end = 0;
+    cache->stats.writebacks++;
+    return 0;
+}
+
+/* unused page or the least recently used one, written back */
+static int _victim(mtd_cache_t *cache, mtd_cache_page_t **victim)
+{
+    mtd_cache_page_t *p = &cache->pages[0];
+
+    for (unsigned i = 0; i < cache->numof; i++) {
+        if (cache->pages[i].page == MTD_CACHE_NONE) {
+            p = &cache->pages[i];
+            break;
+        }
+        if (cache->pages[i].used < p->used) {
+            p = &cache->pages[i];
+        }
+    }
+    if (_dirty(p)) {
+        int ret = _writeback(cache, p);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    p->page = MTD_CACHE_NONE;
+    *victim = p;
+    return 0;
+}
+
+static int _load(mtd_cache_t *cache, uint32_t page, mtd_cache_page_t **loaded)
+{
+    mtd_cache_page_t *p;
+    uint32_t page_size = cache->base.page_size;
+    int ret = _victim(cache, &p);
+
+    if (ret < 0) {
+        return ret;
+    }
+    ret = mtd_read(cache->parent, _data(cache, p), page * page_size, page_size);
+    if (ret < 0) {
+        return ret;
+    }
+    if ((uint32_t)ret != page_size) {
+        return -EIO;
+    }
+    p->page = page;
+    p->used = ++cache->tick;
+    *loaded = p;
+    return 0;
+}
+
+static void _readahead(mtd_cache_t *cache, uint32_t page)
+{
+    uint32_t pages = _size(&cache->base) / cache->base.page_size;
+    mtd_cache_page_t *p;
+
+    for (unsigned i = 0; (i < cache->readahead) && (page < pages); i++, page++) {
+        /* _find() would renew cached pages, they are not used yet */
+        unsigned j;
+
+        for (j = 0; j < cache->numof; j++) {
+            if (cache->pages[j].page == page) {
+                break;
+            }
+        }
+        if ((j == cache->numof) && (_load(cache, page, &p) == 0)) {
+            cache->stats.readaheads++;
+        }
+    }
+    cache->next_miss = page;
+}
+
+void mtd_cache_invalidate(mtd_cache_t *cache)
+{
+    for (unsigned i = 0; i < cache->numof; i++) {
+        cache->pages[i].page = MTD_CACHE_NONE;
+        cache->pages[i].used = 0;
+        cache->pages[i].dirty_start = cache->pages[i].dirty_end = 0;
+    }
+    cache->tick = 0;
+    cache->next_miss = MTD_CACHE_NONE;
+}
+
+static int _flush(mtd_dev_t *dev)
+{
+    mtd_cache_t *cache = (mtd_cache_t *)dev;
+
+    for (unsigned i = 0; i < cache->numof; i++) {
+        if (_dirty(&cache->pages[i])) {
+            int ret = _writeback(cache, &cache->pages[i]);
+            if (ret < 0) {
+                return ret;
+            }
+        }
+    }
+    return 0;
+}
+
+static int _init(mtd_dev_t *dev)
+{
+    mtd_cache_t *cache = (mtd_cache_t *)dev;
+    int ret;
+
+    assert((cache->parent != NULL) && (cache->buf != NULL) &&
+           (cache->pages != NULL) && (cache->numof > 0));
+    assert(cache->readahead < cache->numof);
+
+    ret = mtd_init(cache->parent);
+    if (ret < 0) {
+        return ret;
+    }
+    assert(cache->parent->page_size <= UINT16_MAX);
+
+    if (dev->page_size == cache->parent->page_size) {
+        /* initialized before, e.g. on a second mount */
+        return _flush(dev);
+    }
+    dev->sector_count = cache->parent->sector_count;
+    dev->pages_per_sector = cache->parent->pages_per_sector;
+    dev->page_size = cache->parent->page_size;
+    mtd_cache_invalidate(cache);
+    memset(&cache->stats, 0, sizeof(cache->stats));
+
+    return 0;
+}
+
+static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    mtd_cache_t *cache = (mtd_cache_t *)dev;
+    uint8_t *dst = buff;
+    uint32_t left = size;
+
+    DEBUG("mtd_cache: read from 0x%" PRIx32 " count %" PRIu32 "\n", addr, size);
+
+    if ((addr + size > _size(dev)) || (addr + size < addr)) {
+        return -EOVERFLOW;
+    }
+
+    while (left > 0) {
+        uint32_t page = addr / dev->page_size;
+        uint32_t offset = addr % dev->page_size;
+        uint32_t count = dev->page_size - offset;
+        mtd_cache_page_t *p = _find(cache, page);
+        int sequential = 0;
+
+        if (count > left) {
+            count = left;
+        }
+        if (p != NULL) {
+            cache->stats.hits++;
+        }
+        else {
+            int ret = _load(cache, page, &p);
+
+            if (ret < 0) {
+                return ret;
+            }
+            cache->stats.misses++;
+            sequential = (page == cache->next_miss);
+            cache->next_miss = page + 1;
+        }
+        memcpy(dst, _data(cache, p) + offset, count);
+        if (sequential) {
+            /* may replace p, so only after copying from it */
+            _readahead(cache, page + 1);
+        }
+        dst += count;
+        addr += count;
+        left -= count;
+    }
+
+    return size;
+}
+
+static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr, uint32_t size)
+{
+    mtd_cache_t *cache = (mtd_cache_t *)dev;
+    const uint8_t *src = buff;
+    uint32_t page = addr / dev->page_size;
+    uint32_t offset = addr % dev->page_size;
+    mtd_cache_page_t *p;
+    uint8_t *data;
+
+    DEBUG("mtd_cache: write from 0x%" PRIx32 " count %" PRIu32 "\n", addr, size);
+
+    if ((addr + size > _size(dev)) || (addr + size < addr)) {
+        return -EOVERFLOW;
+    }
+    if ((offset + size) > dev->page_size) {
+        return -EOVERFLOW;
+    }
+
+    if ((p = _find(cache, page)) != NULL) {
+        cache->stats.hits++;
+    }
+    else {
+        int ret = _load(cache, page, &p);
+
+        if (ret < 0) {
+            return ret;
+        }
+        cache->stats.misses++;
+    }
+
+    data = _data(cache, p);
+    for (uint32_t i = 0; i < size; i++) {
+        /* like flash, a write only clears bits */
+        data[offset + i] &= src[i];
+    }
+    if (size > 0) {
+        if (!_dirty(p)) {
+            p->dirty_start = offset;
+            p->dirty_end = offset + size;
+        }
+        else {
+            cache->stats.merged++;
+            if (offset < p->dirty_start) {
+                p->dirty_start = offset;
+            }
+            if ((offset + size) > p->dirty_end) {
+                p->dirty_end = offset + size;
+            }
+        }
+    }
+
+    return size;
+}
+
+static int _erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    mtd_cache_t *cache = (mtd_cache_t *)dev;
+    uint32_t sector_size = dev->pages_per_sector * dev->page_size;
+    uint32_t first = addr / dev->page_size;
+    uint32_t end = (addr + size) / dev->page_size;
+
+    DEBUG("mtd_cache: erase from 0x%" PRIx32 " count %" PRIu32 "\n", addr, size);
+
+    if ((addr + size > _size(dev)) || (addr + size < addr)) {
+        return -EOVERFLOW;
+    }
+    if (((addr % sector_size) != 0) || ((size % sector_size) != 0)) {
+        return -EOVERFLOW;
+    }
+
+    int ret = mtd_erase(cache->parent, addr, size);
+    if (ret < 0) {
+        return ret;
+    }
+
+    /* pending writes are erased as well, cached pages stay valid */
+    for (unsigned i = 0; i < cache->numof; i++) {
+        mtd_cache_page_t *p = &cache->pages[i];
+
+        if ((p->page != MTD_CACHE_NONE) && (p->page >= first) &&
+            (p->page < end)) {
+            memset(_data(cache, p), 0xff, dev->page_size);
+            p->dirty_start = p->dirty_end = 0;
+        }
+    }
+
+    return 0;
+}
+
+static int _power(mtd_dev_t *dev, enum mtd_power_state power)
+{
+    mtd_cache_t *cache = (mtd_cache_t *)dev;
+
+    if (power == MTD_POWER_DOWN) {
+        int ret = _flush(dev);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return mtd_power(cache->parent, power);
+}
+
+const mtd_desc_t mtd_cache_driver = {
+    .init = _init,
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .power = _power,
+    .flush = _flush,
+};
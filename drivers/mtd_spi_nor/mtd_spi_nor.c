@@ -21,6 +21,7 @@
  * @}
  */
 
+#include <assert.h>
 #include <stdint.h>
 #include <errno.h>
 
@@ -33,6 +34,10 @@
 #endif
 #include "byteorder.h"
 #include "mtd_spi_nor.h"
+#ifdef MODULE_MTD_SPI_NOR_ASYNC
+#include "irq.h"
+#include "kernel_defines.h"
+#endif
 
 #define ENABLE_DEBUG    (0)
 #include "debug.h"
@@ -53,6 +58,10 @@
 #define MTD_4K              (4096ul)
 #define MTD_4K_ADDR_MASK    (0xFFF)
 
+#define ASYNC_NONE          (0U)
+#define ASYNC_ERASE         (1U)
+#define ASYNC_WRITE         (2U)
+
 static int mtd_spi_nor_init(mtd_dev_t *mtd);
 static int mtd_spi_nor_read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t size);
 static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uint32_t size);
@@ -274,6 +283,77 @@ static inline void wait_for_write_complete(const mtd_spi_nor_t *dev)
     } while (1);
 }
 
+/* an asynchronous operation may be in progress, only valid with the bus acquired */
+static inline int async_pending(const mtd_spi_nor_t *dev)
+{
+#ifdef MODULE_MTD_SPI_NOR_ASYNC
+    return dev->async.op != ASYNC_NONE;
+#else
+    (void)dev;
+    return 0;
+#endif
+}
+
+static int erase_check(const mtd_spi_nor_t *dev, uint32_t addr, uint32_t size)
+{
+    const mtd_dev_t *mtd = &dev->base;
+    uint32_t sector_size = mtd->page_size * mtd->pages_per_sector;
+    uint32_t total_size = sector_size * mtd->sector_count;
+
+    if (dev->sec_addr_mask &&
+        ((addr & ~dev->sec_addr_mask) != 0)) {
+        /* This is not a requirement in hardware, but it helps in catching
+         * software bugs (the erase-all-your-files kind) */
+        DEBUG("addr = %" PRIx32 " ~dev->erase_addr_mask = %" PRIx32 "", addr, ~dev->sec_addr_mask);
+        DEBUG("mtd_spi_nor_erase: ERR: erase addr not aligned on %" PRIu32 " byte boundary.\n",
+              sector_size);
+        return -EOVERFLOW;
+    }
+    if (addr + size > total_size) {
+        return -EOVERFLOW;
+    }
+    if (size % sector_size != 0) {
+        return -EOVERFLOW;
+    }
+    return 0;
+}
+
+/* issues the largest erase command starting at *addr and advances past it */
+static void erase_step(const mtd_spi_nor_t *dev, uint32_t *addr, uint32_t *size)
+{
+    const mtd_dev_t *mtd = &dev->base;
+    uint32_t sector_size = mtd->page_size * mtd->pages_per_sector;
+    uint32_t total_size = sector_size * mtd->sector_count;
+    be_uint32_t addr_be = byteorder_htonl(*addr);
+
+    /* write enable */
+    mtd_spi_cmd(dev, dev->opcode->wren);
+
+    if (*size == total_size) {
+        mtd_spi_cmd(dev, dev->opcode->chip_erase);
+        *size -= total_size;
+    }
+    else if ((dev->flag & SPI_NOR_F_SECT_32K) && (*size >= MTD_32K) &&
+             ((*addr & MTD_32K_ADDR_MASK) == 0)) {
+        /* 32 KiB blocks can be erased with block erase command */
+        mtd_spi_cmd_addr_write(dev, dev->opcode->block_erase_32k, addr_be, NULL, 0);
+        *addr += MTD_32K;
+        *size -= MTD_32K;
+    }
+    else if ((dev->flag & SPI_NOR_F_SECT_4K) && (*size >= MTD_4K) &&
+             ((*addr & MTD_4K_ADDR_MASK) == 0)) {
+        /* 4 KiB sectors can be erased with sector erase command */
+        mtd_spi_cmd_addr_write(dev, dev->opcode->sector_erase, addr_be, NULL, 0);
+        *addr += MTD_4K;
+        *size -= MTD_4K;
+    }
+    else {
+        mtd_spi_cmd_addr_write(dev, dev->opcode->block_erase, addr_be, NULL, 0);
+        *addr += sector_size;
+        *size -= sector_size;
+    }
+}
+
 static int mtd_spi_nor_init(mtd_dev_t *mtd)
 {
     DEBUG("mtd_spi_nor_init: %p\n", (void *)mtd);
@@ -376,6 +456,10 @@ static int mtd_spi_nor_read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t
     be_uint32_t addr_be = byteorder_htonl(addr);
 
     spi_acquire(dev->spi, dev->cs, dev->mode, dev->clk);
+    if (async_pending(dev)) {
+        spi_release(dev->spi);
+        return -EBUSY;
+    }
     mtd_spi_cmd_addr_read(dev, dev->opcode->read, addr_be, dest, size);
     spi_release(dev->spi);
 
@@ -407,6 +491,10 @@ static int mtd_spi_nor_write(mtd_dev_t *mtd, const void *src, uint32_t addr, uin
     be_uint32_t addr_be = byteorder_htonl(addr);
 
     spi_acquire(dev->spi, dev->cs, dev->mode, dev->clk);
+    if (async_pending(dev)) {
+        spi_release(dev->spi);
+        return -EBUSY;
+    }
     /* write enable */
     mtd_spi_cmd(dev, dev->opcode->wren);
 
@@ -425,54 +513,19 @@ static int mtd_spi_nor_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t size)
     DEBUG("mtd_spi_nor_erase: %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
           (void *)mtd, addr, size);
     mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
-    uint32_t sector_size = mtd->page_size * mtd->pages_per_sector;
-    uint32_t total_size = sector_size * mtd->sector_count;
 
-    if (dev->sec_addr_mask &&
-        ((addr & ~dev->sec_addr_mask) != 0)) {
-        /* This is not a requirement in hardware, but it helps in catching
-         * software bugs (the erase-all-your-files kind) */
-        DEBUG("addr = %" PRIx32 " ~dev->erase_addr_mask = %" PRIx32 "", addr, ~dev->sec_addr_mask);
-        DEBUG("mtd_spi_nor_erase: ERR: erase addr not aligned on %" PRIu32 " byte boundary.\n",
-              sector_size);
-        return -EOVERFLOW;
-    }
-    if (addr + size > total_size) {
-        return -EOVERFLOW;
-    }
-    if (size % sector_size != 0) {
-        return -EOVERFLOW;
+    int res = erase_check(dev, addr, size);
+    if (res < 0) {
+        return res;
     }
 
     spi_acquire(dev->spi, dev->cs, dev->mode, dev->clk);
+    if (async_pending(dev)) {
+        spi_release(dev->spi);
+        return -EBUSY;
+    }
     while (size) {
-        be_uint32_t addr_be = byteorder_htonl(addr);
-        /* write enable */
-        mtd_spi_cmd(dev, dev->opcode->wren);
-
-        if (size == total_size) {
-            mtd_spi_cmd(dev, dev->opcode->chip_erase);
-            size -= total_size;
-        }
-        else if ((dev->flag & SPI_NOR_F_SECT_32K) && (size >= MTD_32K) &&
-                 ((addr & MTD_32K_ADDR_MASK) == 0)) {
-            /* 32 KiB blocks can be erased with block erase command */
-            mtd_spi_cmd_addr_write(dev, dev->opcode->block_erase_32k, addr_be, NULL, 0);
-            addr += MTD_32K;
-            size -= MTD_32K;
-        }
-        else if ((dev->flag & SPI_NOR_F_SECT_4K) && (size >= MTD_4K) &&
-                 ((addr & MTD_4K_ADDR_MASK) == 0)) {
-            /* 4 KiB sectors can be erased with sector erase command */
-            mtd_spi_cmd_addr_write(dev, dev->opcode->sector_erase, addr_be, NULL, 0);
-            addr += MTD_4K;
-            size -= MTD_4K;
-        }
-        else {
-            mtd_spi_cmd_addr_write(dev, dev->opcode->block_erase, addr_be, NULL, 0);
-            addr += sector_size;
-            size -= sector_size;
-        }
+        erase_step(dev, &addr, &size);
 
         /* waiting for the command to complete before continuing */
         wait_for_write_complete(dev);
@@ -487,6 +540,10 @@ static int mtd_spi_nor_power(mtd_dev_t *mtd, enum mtd_power_state power)
     mtd_spi_nor_t *dev = (mtd_spi_nor_t *)mtd;
 
     spi_acquire(dev->spi, dev->cs, dev->mode, dev->clk);
+    if (async_pending(dev)) {
+        spi_release(dev->spi);
+        return -EBUSY;
+    }
     switch (power) {
         case MTD_POWER_UP:
             mtd_spi_cmd(dev, dev->opcode->wake);
@@ -499,3 +556,132 @@ static int mtd_spi_nor_power(mtd_dev_t *mtd, enum mtd_power_state power)
 
     return 0;
 }
+
+#ifdef MODULE_MTD_SPI_NOR_ASYNC
+/* issues the next command of the pending operation, with the bus acquired */
+static void async_step(mtd_spi_nor_t *dev)
+{
+    mtd_spi_nor_async_t *async = &dev->async;
+
+    if (async->op == ASYNC_ERASE) {
+        erase_step(dev, &async->addr, &async->left);
+    }
+    else {
+        uint32_t page_size = dev->base.page_size;
+        uint32_t count = page_size - (async->addr % page_size);
+
+        if (count > async->left) {
+            count = async->left;
+        }
+        mtd_spi_cmd(dev, dev->opcode->wren);
+        mtd_spi_cmd_addr_write(dev, dev->opcode->page_program,
+                               byteorder_htonl(async->addr), async->src, count);
+        async->src += count;
+        async->addr += count;
+        async->left -= count;
+    }
+}
+
+static void async_poll(event_t *event)
+{
+    mtd_spi_nor_t *dev = container_of(event, mtd_spi_nor_t, async.event);
+    mtd_spi_nor_async_t *async = &dev->async;
+    uint8_t status;
+
+    spi_acquire(dev->spi, dev->cs, dev->mode, dev->clk);
+    mtd_spi_cmd_read(dev, dev->opcode->rdsr, &status, sizeof(status));
+    TRACE("mtd_spi_nor: async poll status = 0x%02x\n", (unsigned int)status);
+    if (((status & 1) == 0) && (async->left > 0)) {
+        async_step(dev);
+        status |= 1;
+    }
+    spi_release(dev->spi);
+
+    if (status & 1) {
+        /* the device is busy, the bus is free for others until the next poll */
+        event_timeout_set(&async->timeout, (async->op == ASYNC_ERASE) ?
+                          MTD_SPI_NOR_ASYNC_ERASE_POLL_US :
+                          MTD_SPI_NOR_ASYNC_WRITE_POLL_US);
+        return;
+    }
+
+    DEBUG("mtd_spi_nor: async operation %u done\n", (unsigned int)async->op);
+    mtd_spi_nor_cb_t cb = async->cb;
+    void *arg = async->arg;
+    /* the callback may submit the next operation */
+    async->op = ASYNC_NONE;
+    if (cb) {
+        cb(arg);
+    }
+}
+
+static int async_submit(mtd_spi_nor_t *dev, uint8_t op, const void *src,
+                        uint32_t addr, uint32_t size, mtd_spi_nor_cb_t cb,
+                        void *arg)
+{
+    mtd_spi_nor_async_t *async = &dev->async;
+
+    assert(async->queue != NULL);
+
+    unsigned state = irq_disable();
+    if (async->op != ASYNC_NONE) {
+        irq_restore(state);
+        return -EBUSY;
+    }
+    async->op = op;
+    irq_restore(state);
+
+    async->cb = cb;
+    async->arg = arg;
+    async->src = src;
+    async->addr = addr;
+    async->left = size;
+    /* the first command is issued from the queue like all others */
+    event_post(async->queue, &async->event);
+
+    return 0;
+}
+
+void mtd_spi_nor_async_init(mtd_spi_nor_t *dev, event_queue_t *queue)
+{
+    mtd_spi_nor_async_t *async = &dev->async;
+
+    async->event.handler = async_poll;
+    async->queue = queue;
+    async->op = ASYNC_NONE;
+    event_timeout_init(&async->timeout, queue, &async->event);
+}
+
+int mtd_spi_nor_erase_async(mtd_spi_nor_t *dev, uint32_t addr, uint32_t size,
+                            mtd_spi_nor_cb_t cb, void *arg)
+{
+    DEBUG("mtd_spi_nor_erase_async: %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
+          (void *)dev, addr, size);
+
+    int res = erase_check(dev, addr, size);
+    if (res < 0) {
+        return res;
+    }
+    return async_submit(dev, ASYNC_ERASE, NULL, addr, size, cb, arg);
+}
+
+int mtd_spi_nor_write_async(mtd_spi_nor_t *dev, const void *src, uint32_t addr,
+                            uint32_t size, mtd_spi_nor_cb_t cb, void *arg)
+{
+    const mtd_dev_t *mtd = &dev->base;
+    uint32_t total_size = mtd->page_size * mtd->pages_per_sector * mtd->sector_count;
+
+    DEBUG("mtd_spi_nor_write_async: %p, %p, 0x%" PRIx32 ", 0x%" PRIx32 "\n",
+          (void *)dev, src, addr, size);
+
+    if ((addr + size > total_size) || (addr + size < addr)) {
+        return -EOVERFLOW;
+    }
+    return async_submit(dev, ASYNC_WRITE, src, addr, size, cb, arg);
+}
+
+int mtd_spi_nor_async_busy(const mtd_spi_nor_t *dev)
+{
+    return dev->async.op != ASYNC_NONE;
+}
+#endif /* MODULE_MTD_SPI_NOR_ASYNC */
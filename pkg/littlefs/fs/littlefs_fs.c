@@ -122,9 +122,11 @@ static int _dev_erase(const struct lfs_config *c, lfs_block_t block)
 
 static int _dev_sync(const struct lfs_config *c)
 {
-    (void)c;
+    littlefs_desc_t *fs = c->context;
 
-    return 0;
+    DEBUG("lfs_sync: c=%p\n", (void *)c);
+
+    return mtd_flush(fs->dev);
 }
 
 static int prepare(littlefs_desc_t *fs)
@@ -207,6 +209,9 @@ static int _umount(vfs_mount_t *mountp)
     DEBUG("littlefs: umount: mountp=%p\n", (void *)mountp);
 
     int ret = lfs_unmount(&fs->fs);
+    if (ret == 0) {
+        ret = mtd_flush(fs->dev);
+    }
     mutex_unlock(&fs->lock);
 
     return littlefs_err_to_errno(ret);
@@ -325,6 +330,10 @@ static int _close(vfs_file_t *filp)
     DEBUG("littlefs: close: filp=%p, fp=%p\n", (void *)filp, (void *)fp);
 
     int ret = lfs_file_close(&fs->fs, fp);
+    if (ret == 0) {
+        /* file is committed, make it survive a power loss */
+        ret = mtd_flush(fs->dev);
+    }
     mutex_unlock(&fs->lock);
 
     return littlefs_err_to_errno(ret);
@@ -816,6 +816,14 @@ int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize)
     return CIPHER_INIT_SUCCESS;
 }
 
+static int aes_set_encrypt_key(const unsigned char *userKey, const int bits,
+                               AES_KEY *key);
+
+int aes_expand_encrypt_key(const uint8_t *key, uint8_t keySize, AES_KEY *aeskey)
+{
+    return aes_set_encrypt_key(key, keySize * 8, aeskey);
+}
+
 /**
  * Expand the cipher key into the encryption key schedule.
  */
@@ -1024,13 +1032,22 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
     /* setup AES_KEY */
     int res;
     AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
     res = aes_set_encrypt_key((unsigned char *)context->context,
                                    AES_KEY_SIZE * 8, &aeskey);
     if (res < 0) {
         return res;
     }
 
+    return aes_encrypt_expanded(&aeskey, plainBlock, cipherBlock);
+}
+
+/*
+ * Encrypt a single block with already expanded key schedule
+ * in and out can overlap
+ */
+int aes_encrypt_expanded(const AES_KEY *key, const uint8_t *plainBlock,
+                         uint8_t *cipherBlock)
+{
     const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef FULL_UNROLL
@@ -46,6 +46,7 @@ static off_t constfs_lseek(vfs_file_t *filp, off_t off, int whence);
 static int constfs_open(vfs_file_t *filp, const char *name, int flags, mode_t mode, const char *abs_path);
 static ssize_t constfs_read(vfs_file_t *filp, void *dest, size_t nbytes);
 static ssize_t constfs_write(vfs_file_t *filp, const void *src, size_t nbytes);
+static ssize_t constfs_span(vfs_file_t *filp, off_t off, size_t nbytes, const void **ptr);
 
 /* Directory operations */
 static int constfs_opendir(vfs_DIR *dirp, const char *dirname, const char *abs_path);
@@ -67,6 +68,7 @@ static const vfs_file_ops_t constfs_file_ops = {
     .open  = constfs_open,
     .read  = constfs_read,
     .write = constfs_write,
+    .span  = constfs_span,
 };
 
 static const vfs_dir_ops_t constfs_dir_ops = {
@@ -258,6 +260,23 @@ static ssize_t constfs_write(vfs_file_t *filp, const void *src, size_t nbytes)
     return -EBADF;
 }
 
+static ssize_t constfs_span(vfs_file_t *filp, off_t off, size_t nbytes, const void **ptr)
+{
+    constfs_file_t *fp = filp->private_data.ptr;
+    DEBUG("constfs_span: %p, %ld, %lu\n", (void *)filp, (long)off, (unsigned long)nbytes);
+    if ((size_t)off >= fp->size) {
+        /* Offset is at or beyond end of file */
+        return 0;
+    }
+
+    if (nbytes > (fp->size - off)) {
+        nbytes = fp->size - off;
+    }
+    /* the contents are never changed, hand out the file data itself */
+    *ptr = fp->data + off;
+    return nbytes;
+}
+
 static int constfs_opendir(vfs_DIR *dirp, const char *dirname, const char *abs_path)
 {
     (void) abs_path;
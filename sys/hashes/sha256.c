@@ -354,6 +354,48 @@ const void *hmac_sha256(const void *key, size_t key_length,
     return digest;
 }
 
+void hmac_sha256_snapshot(const hmac_context_t *ctx, hmac_sha256_snapshot_t *snapshot)
+{
+    /* Only the state right after the key pads fits the snapshot */
+    assert(ctx->c_in.count[0] == 0 &&
+           ctx->c_in.count[1] == (SHA256_INTERNAL_BLOCK_SIZE << 3));
+
+    memcpy(snapshot->in_state, ctx->c_in.state, sizeof(snapshot->in_state));
+    memcpy(snapshot->out_state, ctx->c_out.state, sizeof(snapshot->out_state));
+}
+
+void hmac_sha256_init_snapshot(hmac_context_t *ctx, const hmac_sha256_snapshot_t *snapshot)
+{
+    /* Both hashes have processed exactly one block, their buffers are empty */
+    memcpy(ctx->c_in.state, snapshot->in_state, sizeof(snapshot->in_state));
+    ctx->c_in.count[0] = 0;
+    ctx->c_in.count[1] = SHA256_INTERNAL_BLOCK_SIZE << 3;
+
+    memcpy(ctx->c_out.state, snapshot->out_state, sizeof(snapshot->out_state));
+    ctx->c_out.count[0] = 0;
+    ctx->c_out.count[1] = SHA256_INTERNAL_BLOCK_SIZE << 3;
+}
+
+void hmac_sha256_precompute(hmac_sha256_snapshot_t *snapshot, const void *key, size_t key_length)
+{
+    hmac_context_t ctx;
+
+    hmac_sha256_init(&ctx, key, key_length);
+    hmac_sha256_snapshot(&ctx, snapshot);
+}
+
+const void *hmac_sha256_from_snapshot(const hmac_sha256_snapshot_t *snapshot,
+                                      const void *data, size_t len, void *digest)
+{
+    hmac_context_t ctx;
+
+    hmac_sha256_init_snapshot(&ctx, snapshot);
+    hmac_sha256_update(&ctx, data, len);
+    hmac_sha256_final(&ctx, digest);
+
+    return digest;
+}
+
 /**
  * @brief helper to compute sha256 inplace for the given buffer
  *
@@ -109,6 +109,34 @@ int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize);
 int aes_encrypt(const cipher_context_t *context, const uint8_t *plain_block,
                 uint8_t *cipher_block);
 
+/**
+ * @brief   expands the key into the encryption key schedule once, so that
+ *          many blocks can be encrypted with aes_encrypt_expanded() without
+ *          expanding the key for every block as aes_encrypt() does
+ *
+ * @param       key       a pointer to the key
+ * @param       keySize   the size of the key in bytes (16, 24 or 32)
+ * @param       aeskey    the key schedule to fill
+ *
+ * @return  0 on success, negative value if the key can't be expanded
+ */
+int aes_expand_encrypt_key(const uint8_t *key, uint8_t keySize, AES_KEY *aeskey);
+
+/**
+ * @brief   encrypts one plainBlock-block with already expanded key schedule
+ *          and saves the result in cipherBlock
+ *
+ * @param       aeskey        the key schedule filled by aes_expand_encrypt_key()
+ * @param       plain_block   a pointer to the plaintext-block (of size
+ *                            blocksize)
+ * @param       cipher_block  a pointer to the place where the ciphertext will
+ *                            be stored
+ *
+ * @return  1
+ */
+int aes_encrypt_expanded(const AES_KEY *aeskey, const uint8_t *plain_block,
+                         uint8_t *cipher_block);
+
 /**
  * @brief   decrypts one cipher-block and saves the plain-block in plainBlock.
  *          decrypts one blocksize long block of ciphertext pointed to by
@@ -81,6 +81,19 @@ typedef struct {
     sha256_context_t c_out;
 } hmac_context_t;
 
+/**
+ * @brief Inner and outer hash states of HMAC after the key pads were processed
+ *
+ * Depends only on the key, so it can be computed once and reused to skip
+ * hashing of the key pads for every message.
+ */
+typedef struct {
+    /** Inner hash state after the inner key pad */
+    uint32_t in_state[8];
+    /** Outer hash state after the outer key pad */
+    uint32_t out_state[8];
+} hmac_sha256_snapshot_t;
+
 /**
  * @brief sha256-chain indexed element
  */
@@ -153,6 +166,29 @@ void hmac_sha256_update(hmac_context_t *ctx, const void *data, size_t len);
  */
 void hmac_sha256_final(hmac_context_t *ctx, void *digest);
 
+/**
+ * @brief hmac_sha256_snapshot Save the key dependent state of a HMAC calculation
+ * @param[in] ctx hmac_context_t handle right after hmac_sha256_init()
+ * @param[out] snapshot the saved inner and outer hash states
+ */
+void hmac_sha256_snapshot(const hmac_context_t *ctx, hmac_sha256_snapshot_t *snapshot);
+
+/**
+ * @brief hmac_sha256_init_snapshot Initiate calculation of a HMAC from a saved state,
+ *        equivalent to hmac_sha256_init() with the key the snapshot was taken with
+ * @param[in] ctx hmac_context_t handle to use
+ * @param[in] snapshot state saved by hmac_sha256_snapshot()
+ */
+void hmac_sha256_init_snapshot(hmac_context_t *ctx, const hmac_sha256_snapshot_t *snapshot);
+
+/**
+ * @brief hmac_sha256_precompute Compute the key dependent state of a HMAC
+ * @param[out] snapshot the inner and outer hash states for the key
+ * @param[in] key key used in the hmac-sha256 computation
+ * @param[in] key_length the size in bytes of the key
+ */
+void hmac_sha256_precompute(hmac_sha256_snapshot_t *snapshot, const void *key, size_t key_length);
+
 /**
  * @brief function to compute a hmac-sha256 from a given message
  *
@@ -169,6 +205,24 @@ void hmac_sha256_final(hmac_context_t *ctx, void *digest);
 const void *hmac_sha256(const void *key, size_t key_length,
                         const void *data, size_t len, void *digest);
 
+/**
+ * @brief function to compute a hmac-sha256 from a given message with a
+ *        precomputed key state
+ *
+ * Takes two SHA-256 compressions less than hmac_sha256()
+ *
+ * @param[in] snapshot key state from hmac_sha256_precompute()
+ * @param[in] data pointer to the buffer to generate the hmac-sha256
+ * @param[in] len the length of the message in bytes
+ * @param[out] digest the computed hmac-sha256,
+ *             length MUST be SHA256_DIGEST_LENGTH
+ *             if digest == NULL, a static buffer is used
+ * @returns pointer to the resulting digest.
+ *          if result == NULL the pointer points to the static buffer
+ */
+const void *hmac_sha256_from_snapshot(const hmac_sha256_snapshot_t *snapshot,
+                                      const void *data, size_t len, void *digest);
+
 /**
  * @brief function to produce a hash chain statring with a given seed element.
  *        The chain is computed by taking the sha256 from the seed,
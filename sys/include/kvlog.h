@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_kvlog Log-structured key-value store
+ * @ingroup     sys
+ * @brief       Wear-levelled key-value store for EEPROM and flash memory
+ *
+ * Values of up to @ref KVLOG_VALUE_MAX bytes are stored under 8 bit keys in
+ * an append-only log. Setting a value appends one record with a CRC to the
+ * log instead of rewriting a fixed block, so the writes are spread over the
+ * whole storage area. A RAM index keeps the position of the latest record of
+ * every key, it is built by scanning the log once on kvlog_init().
+ *
+ * The storage area is split into two banks of equal size. When the active
+ * bank is full, the latest records are copied to the other bank, which is
+ * erased before and gets its header written after the copy. A power loss at
+ * any time leaves either the old or the new value of a key:
+ *
+ * - a torn record fails its CRC and ends the log on the next scan, the
+ *   garbage behind the last valid record is dropped on the next compaction
+ * - a torn compaction leaves the new bank without a valid header, so the old
+ *   bank is used again
+ *
+ * The storage is accessed through a @ref kvlog_driver_t. Records are written
+ * in multiples of @ref KVLOG_ALIGN bytes from aligned buffers and never
+ * overwritten before an erase, which suits EEPROM as well as flash pages.
+ * Drivers for the EEPROM and raw flash page peripherals are provided as
+ * @ref kvlog_eeprom_driver and @ref kvlog_flashpage_driver.
+ *
+ * The store is not thread-safe, users sharing it between threads have to
+ * serialize the calls.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Log-structured key-value store interface
+ */
+
+#ifndef KVLOG_H
+#define KVLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Write unit of the storage in bytes
+ *
+ * Records start at and are padded to multiples of this size.
+ */
+#ifndef KVLOG_ALIGN
+#define KVLOG_ALIGN         (4U)
+#endif
+
+/**
+ * @brief   Maximum size of a value in bytes
+ */
+#define KVLOG_VALUE_MAX     (255U)
+
+/**
+ * @brief   Largest key
+ *
+ * A record of key 255 could not be told from erased flash.
+ */
+#define KVLOG_KEY_MAX       (254U)
+
+/**
+ * @brief   Storage operations
+ *
+ * Addresses are absolute, i.e. include kvlog_t::base. All functions return
+ * 0 on success and a negative errno on failure.
+ */
+typedef struct {
+    int (*read)(uint32_t addr, void *buf, size_t len);          /**< read */
+    int (*write)(uint32_t addr, const void *buf, size_t len);   /**< program
+                                                                 *   erased memory */
+    int (*erase)(uint32_t addr, size_t len);                    /**< erase */
+    uint8_t erased;                         /**< value of erased bytes */
+} kvlog_driver_t;
+
+/**
+ * @brief   Index entry of a key
+ */
+typedef struct {
+    uint16_t offset;        /**< latest record of the key in the active bank */
+    uint8_t key;            /**< key */
+    uint8_t len;            /**< size of the value */
+} kvlog_entry_t;
+
+/**
+ * @brief   Store statistics
+ */
+typedef struct {
+    uint32_t appends;       /**< records written */
+    uint32_t skipped;       /**< writes skipped because the value was stored */
+    uint32_t compactions;   /**< bank switches */
+} kvlog_stats_t;
+
+/**
+ * @brief   Key-value store descriptor
+ *
+ * kvlog_t::driver, kvlog_t::base, kvlog_t::bank_size, kvlog_t::index and
+ * kvlog_t::numof are set by the user, the rest by kvlog_init().
+ */
+typedef struct {
+    const kvlog_driver_t *driver;   /**< storage operations */
+    uint32_t base;                  /**< address of the first bank */
+    uint32_t bank_size;             /**< size of each of the two banks, a
+                                     *   multiple of the erase unit and at
+                                     *   most 64 KiB */
+    kvlog_entry_t *index;           /**< index, kvlog_t::numof entries */
+    uint16_t numof;                 /**< maximum number of keys */
+    uint16_t used;                  /**< keys in the index */
+    uint32_t end;                   /**< end of the log in the active bank */
+    uint16_t seq;                   /**< sequence number of the active bank */
+    uint8_t bank;                   /**< active bank */
+    kvlog_stats_t stats;            /**< statistics */
+} kvlog_t;
+
+#if defined(MODULE_PERIPH_EEPROM) || defined(DOXYGEN)
+/**
+ * @brief   Storage operations for the EEPROM peripheral
+ *
+ * Addresses are EEPROM positions.
+ */
+extern const kvlog_driver_t kvlog_eeprom_driver;
+#endif
+
+#if defined(MODULE_PERIPH_FLASHPAGE_RAW) || defined(DOXYGEN)
+/**
+ * @brief   Storage operations for the raw flash page peripheral
+ *
+ * Addresses are CPU addresses, kvlog_t::base and kvlog_t::bank_size have to
+ * be aligned to flash pages.
+ */
+extern const kvlog_driver_t kvlog_flashpage_driver;
+#endif
+
+/**
+ * @brief   Initialize a store
+ *
+ * Scans the log of the active bank and builds the index. A storage without
+ * a valid bank is formatted.
+ *
+ * @param[in,out] kv    store descriptor
+ *
+ * @return 0 on success
+ * @return -ENOMEM if the log holds more keys than the index
+ * @return other negative errno on storage errors
+ */
+int kvlog_init(kvlog_t *kv);
+
+/**
+ * @brief   Read a value
+ *
+ * @param[in]  kv       store
+ * @param[in]  key      key
+ * @param[out] buf      buffer for the value
+ * @param[in]  size     size of @p buf, larger values are truncated
+ *
+ * @return size of the stored value
+ * @return -ENOENT if @p key is not set
+ * @return other negative errno on storage errors
+ */
+int kvlog_get(kvlog_t *kv, uint8_t key, void *buf, size_t size);
+
+/**
+ * @brief   Store a value
+ *
+ * Nothing is written if the value is already stored.
+ *
+ * @param[in,out] kv    store
+ * @param[in]     key   key, up to @ref KVLOG_KEY_MAX
+ * @param[in]     data  value
+ * @param[in]     len   size of the value, 1 to @ref KVLOG_VALUE_MAX
+ *
+ * @return 0 on success
+ * @return -EINVAL if @p key or @p len is out of range
+ * @return -ENOMEM if the index is full
+ * @return -ENOSPC if the values do not fit in a bank
+ * @return other negative errno on storage errors
+ */
+int kvlog_set(kvlog_t *kv, uint8_t key, const void *data, size_t len);
+
+/**
+ * @brief   Remove a value
+ *
+ * @param[in,out] kv    store
+ * @param[in]     key   key
+ *
+ * @return 0 on success
+ * @return -ENOENT if @p key is not set
+ * @return other negative errno on storage errors
+ */
+int kvlog_delete(kvlog_t *kv, uint8_t key);
+
+/**
+ * @brief   Copy the latest records to the other bank
+ *
+ * Happens by itself when the active bank is full.
+ *
+ * @param[in,out] kv    store
+ *
+ * @return 0 on success
+ * @return negative errno on storage errors
+ */
+int kvlog_compact(kvlog_t *kv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KVLOG_H */
+/** @} */
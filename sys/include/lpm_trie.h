@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_lpm_trie Longest prefix match trie
+ * @ingroup     sys
+ * @brief       Path-compressed binary trie for longest prefix match lookups
+ *
+ * Maps bit prefixes of up to 255 bits (e.g. IPv6 prefixes) to values. A
+ * lookup walks at most one node per distinct prefix length on the path to
+ * the address, instead of comparing the address to every prefix in a table.
+ *
+ * The trie does not copy keys: the memory passed to lpm_trie_add() must stay
+ * valid and unchanged until the prefix is removed with lpm_trie_remove(). Bits
+ * of a key beyond its prefix length are ignored.
+ *
+ * Nodes are taken from a caller-provided array, a trie holding `n` prefixes
+ * needs at most @ref LPM_TRIE_NODES_NUMOF(n) nodes.
+ *
+ * The trie is not thread-safe, users protect it with their own lock.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Longest prefix match trie API
+ */
+
+#ifndef LPM_TRIE_H
+#define LPM_TRIE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of nodes needed to store @p prefixes prefixes
+ *
+ * Every prefix takes one node, and every prefix may add one branching node
+ */
+#define LPM_TRIE_NODES_NUMOF(prefixes)  (2 * (prefixes))
+
+/**
+ * @brief   Trie node
+ */
+typedef struct lpm_trie_node {
+    struct lpm_trie_node *child[2]; /**< subtrees continuing with a 0 and 1 bit */
+    const uint8_t *key;             /**< prefix of the node, borrowed from a
+                                     *   prefix stored in the subtree */
+    void *value;                    /**< value, NULL for branching nodes */
+    uint8_t len;                    /**< prefix length in bits */
+} lpm_trie_node_t;
+
+/**
+ * @brief   Trie
+ */
+typedef struct {
+    lpm_trie_node_t *root;          /**< root node */
+    lpm_trie_node_t *free;          /**< unused nodes, chained with child[0] */
+} lpm_trie_t;
+
+/**
+ * @brief   Initializes an empty trie
+ *
+ * @param[out] trie     trie to initialize
+ * @param[in] nodes     node storage
+ * @param[in] numof     number of nodes in @p nodes
+ */
+void lpm_trie_init(lpm_trie_t *trie, lpm_trie_node_t *nodes, unsigned numof);
+
+/**
+ * @brief   Adds node storage to a trie
+ *
+ * For users keeping the nodes in several places, e.g. next to the values
+ *
+ * @param[in,out] trie  trie
+ * @param[in] nodes     node storage
+ * @param[in] numof     number of nodes in @p nodes
+ */
+void lpm_trie_add_nodes(lpm_trie_t *trie, lpm_trie_node_t *nodes, unsigned numof);
+
+/**
+ * @brief   Adds a prefix
+ *
+ * @param[in,out] trie  trie
+ * @param[in] key       prefix, must stay valid until it is removed
+ * @param[in] len       prefix length in bits
+ * @param[in] value     value to return for addresses matching the prefix,
+ *                      must not be NULL
+ *
+ * @return  0 on success
+ * @return  -EEXIST, if the prefix is already in the trie
+ * @return  -ENOMEM, if no node is left
+ */
+int lpm_trie_add(lpm_trie_t *trie, const uint8_t *key, uint8_t len, void *value);
+
+/**
+ * @brief   Removes a prefix
+ *
+ * @param[in,out] trie  trie
+ * @param[in] key       prefix
+ * @param[in] len       prefix length in bits
+ *
+ * @return  value of the removed prefix
+ * @return  NULL, if the prefix is not in the trie
+ */
+void *lpm_trie_remove(lpm_trie_t *trie, const uint8_t *key, uint8_t len);
+
+/**
+ * @brief   Gets the value of exactly this prefix
+ *
+ * @param[in] trie      trie
+ * @param[in] key       prefix
+ * @param[in] len       prefix length in bits
+ *
+ * @return  value of the prefix
+ * @return  NULL, if the prefix is not in the trie
+ */
+void *lpm_trie_get(const lpm_trie_t *trie, const uint8_t *key, uint8_t len);
+
+/**
+ * @brief   Finds the longest prefix matching an address
+ *
+ * @param[in] trie      trie
+ * @param[in] addr      address
+ * @param[in] len       address length in bits
+ * @param[out] pfx_len  length of the matching prefix, may be NULL
+ *
+ * @return  value of the longest prefix of @p addr
+ * @return  NULL, if no prefix matches
+ */
+void *lpm_trie_match(const lpm_trie_t *trie, const uint8_t *addr, uint8_t len,
+                     uint8_t *pfx_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPM_TRIE_H */
+/** @} */
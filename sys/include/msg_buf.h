@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_msg_buf Pooled message buffers
+ * @ingroup     sys
+ * @brief       Zero-copy passing of large payloads between threads
+ *
+ * A @ref msg_t carries only a type and a pointer or a 32 bit value. This
+ * module adds fixed-size buffers taken from a @ref sys_memarray pool, which
+ * are handed over with a regular message. The sender gives up its reference
+ * when the buffer is sent successfully, the receiver owns it from then on and
+ * releases it when done, so a payload can pass several threads without being
+ * copied.
+ *
+ * Buffers are reference counted, msg_buf_hold() lets more than one thread
+ * read the same buffer. The last msg_buf_release() returns the block to the
+ * pool.
+ *
+ * Backpressure comes from two places: msg_buf_alloc_wait() blocks the producer
+ * until a buffer is released, and msg_buf_send() blocks on a full message
+ * queue of the receiver like msg_send() does. In interrupt context neither
+ * blocks, msg_buf_alloc() returns NULL and msg_buf_send() fails instead.
+ *
+ * All functions are safe to use from interrupt context except
+ * msg_buf_alloc_wait().
+ *
+ * @{
+ *
+ * @file
+ * @brief       Pooled message buffers API
+ */
+
+#ifndef MSG_BUF_H
+#define MSG_BUF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "memarray.h"
+#include "msg.h"
+#include "sema.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Buffer pool
+ */
+typedef struct {
+    memarray_t mem;             /**< free blocks */
+    sema_t avail;               /**< posted on release for waiting allocators */
+    uint16_t waiting;           /**< number of threads in msg_buf_alloc_wait() */
+    uint16_t used;              /**< number of allocated buffers */
+    uint16_t used_max;          /**< high-water mark of allocated buffers */
+    uint16_t alloc_failed;      /**< number of failed msg_buf_alloc() calls */
+} msg_buf_pool_t;
+
+/**
+ * @brief   Buffer, the payload follows the header in the same block
+ */
+typedef struct {
+    msg_buf_pool_t *pool;       /**< pool the buffer belongs to */
+    uint16_t refs;              /**< reference counter */
+    uint16_t len;               /**< length of the payload, up to the user */
+    uint8_t data[];             /**< payload */
+} msg_buf_t;
+
+/**
+ * @brief   Size of a pool block holding @p payload bytes, rounded up to the
+ *          pointer alignment
+ */
+#define MSG_BUF_BLOCK_SIZE(payload) \
+    ((sizeof(msg_buf_t) + (payload) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+/**
+ * @brief   Declares storage for @p num buffers of @p payload bytes
+ *
+ * Use with msg_buf_pool_init():
+ *
+ *     MSG_BUF_POOL_DATA(frames_data, 64, 8);
+ *     msg_buf_pool_init(&frames, frames_data, 64, 8);
+ */
+#define MSG_BUF_POOL_DATA(name, payload, num) \
+    void *name[(MSG_BUF_BLOCK_SIZE(payload) * (num)) / sizeof(void *)]
+
+/**
+ * @brief   Initializes the buffer pool
+ *
+ * @pre `pool != NULL`
+ * @pre `data != NULL`
+ * @pre `num != 0`
+ *
+ * @param[out]  pool        pool to initialize
+ * @param[in]   data        storage declared with MSG_BUF_POOL_DATA()
+ * @param[in]   payload     payload size of a single buffer
+ * @param[in]   num         number of buffers
+ */
+void msg_buf_pool_init(msg_buf_pool_t *pool, void *data, size_t payload, size_t num);
+
+/**
+ * @brief   Payload size of the pool buffers
+ *
+ * @param[in]   pool    buffer pool
+ *
+ * @return  size of msg_buf_t::data
+ */
+static inline size_t msg_buf_pool_payload(const msg_buf_pool_t *pool)
+{
+    return pool->mem.size - sizeof(msg_buf_t);
+}
+
+/**
+ * @brief   Takes a buffer from the pool
+ *
+ * The buffer has one reference, owned by the caller, and zero length.
+ *
+ * @param[in,out]   pool    buffer pool
+ *
+ * @return  the buffer
+ * @return  NULL, if the pool is exhausted
+ */
+msg_buf_t *msg_buf_alloc(msg_buf_pool_t *pool);
+
+/**
+ * @brief   Takes a buffer from the pool, blocks until one is released if the
+ *          pool is exhausted
+ *
+ * @pre Not called from interrupt context
+ *
+ * @param[in,out]   pool    buffer pool
+ *
+ * @return  the buffer
+ */
+msg_buf_t *msg_buf_alloc_wait(msg_buf_pool_t *pool);
+
+/**
+ * @brief   Adds a reference to the buffer
+ *
+ * @param[in,out]   buf     buffer
+ */
+void msg_buf_hold(msg_buf_t *buf);
+
+/**
+ * @brief   Drops a reference to the buffer, returns it to the pool when it
+ *          was the last one
+ *
+ * @param[in,out]   buf     buffer
+ */
+void msg_buf_release(msg_buf_t *buf);
+
+/**
+ * @brief   Sends the buffer to another thread, transferring the reference of
+ *          the caller
+ *
+ * Blocks like msg_send() if the message queue of the receiver is full and the
+ * function is not called from interrupt context.
+ *
+ * @param[in]   buf         buffer
+ * @param[in]   type        msg_t::type of the message
+ * @param[in]   target_pid  receiver
+ *
+ * @return  1, if the buffer was delivered, the caller must not touch it
+ *          anymore
+ * @return  0, if called from interrupt context and the receiver can't take
+ *          the message, the caller still owns the buffer
+ * @return  -1, on invalid PID, the caller still owns the buffer
+ */
+int msg_buf_send(msg_buf_t *buf, uint16_t type, kernel_pid_t target_pid);
+
+/**
+ * @brief   Same as msg_buf_send() but never blocks
+ *
+ * @param[in]   buf         buffer
+ * @param[in]   type        msg_t::type of the message
+ * @param[in]   target_pid  receiver
+ *
+ * @return  1, if the buffer was delivered, the caller must not touch it
+ *          anymore
+ * @return  0, if the receiver can't take the message, the caller still owns
+ *          the buffer
+ * @return  -1, on invalid PID, the caller still owns the buffer
+ */
+int msg_buf_try_send(msg_buf_t *buf, uint16_t type, kernel_pid_t target_pid);
+
+/**
+ * @brief   Gets the buffer from a message received from msg_buf_send()
+ *
+ * The receiver owns the reference and must release it.
+ *
+ * @param[in]   m   received message
+ *
+ * @return  the buffer
+ */
+static inline msg_buf_t *msg_buf_get(const msg_t *m)
+{
+    return (msg_buf_t *)m->content.ptr;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MSG_BUF_H */
+/** @} */
@@ -87,6 +87,17 @@ typedef struct {
  */
 #define FIB_FLAG_NET_PREFIX_MASK (0xffUL << FIB_FLAG_NET_PREFIX_SHIFT)
 
+/**
+ * @brief size of the destination addresses indexed by the `fib_lpm` module
+ *
+ * Next hop lookups for destinations of this size take time proportional to the
+ * address length instead of the table size. Other destinations are searched
+ * in the whole table.
+ */
+#ifndef FIB_LPM_ADDR_SIZE
+#define FIB_LPM_ADDR_SIZE (16)
+#endif
+
 /**
  * @brief initializes all FIB entries with 0
  *
@@ -24,6 +24,9 @@
 #include "kernel_types.h"
 #include "universal_address.h"
 #include "mutex.h"
+#ifdef MODULE_FIB_LPM
+#include "lpm_trie.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +54,10 @@ typedef struct {
     uint32_t next_hop_flags;
     /** Pointer to the shared generic address */
     universal_address_container_t *next_hop;
+#if defined(MODULE_FIB_LPM) || defined(DOXYGEN)
+    /** Nodes of this entry in the longest prefix match index */
+    lpm_trie_node_t lpm_nodes[2];
+#endif
 } fib_entry_t;
 
 /**
@@ -133,6 +140,10 @@ typedef struct {
     *   e.g. when the unreachable destination is covered by the prefix
     */
     universal_address_container_t* prefix_rp[FIB_MAX_REGISTERED_RP];
+#if defined(MODULE_FIB_LPM) || defined(DOXYGEN)
+    /** Longest prefix match index of the single hop entries */
+    lpm_trie_t lpm;
+#endif
 } fib_table_t;
 
 #ifdef __cplusplus
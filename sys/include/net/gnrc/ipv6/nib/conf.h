@@ -72,6 +72,14 @@ extern "C" {
 #define GNRC_IPV6_NIB_CONF_DNS          (1)
 #endif
 
+#ifdef MODULE_GNRC_IPV6_NIB_LPM
+#define GNRC_IPV6_NIB_CONF_LPM          (1)
+#endif
+
+#ifdef MODULE_GNRC_IPV6_NIB_NC_HASH
+#define GNRC_IPV6_NIB_CONF_NC_HASH      (1)
+#endif
+
 /**
  * @name    Compile flags
  * @brief   Compile flags to (de-)activate certain features for NIB
@@ -184,6 +192,28 @@ extern "C" {
 #define GNRC_IPV6_NIB_CONF_DNS          (0)
 #endif
 
+/**
+ * @brief   Index off-link entries in a longest prefix match trie
+ *
+ * Route lookups take time proportional to the prefix length instead of
+ * @ref GNRC_IPV6_NIB_OFFL_NUMOF, at the cost of two trie nodes per off-link
+ * entry. Use the `gnrc_ipv6_nib_lpm` pseudo-module to enable.
+ */
+#ifndef GNRC_IPV6_NIB_CONF_LPM
+#define GNRC_IPV6_NIB_CONF_LPM          (0)
+#endif
+
+/**
+ * @brief   Index on-link entries in a hash table over their IPv6 address
+ *
+ * Neighbor lookups take constant time instead of a pass over all
+ * @ref GNRC_IPV6_NIB_NUMOF entries, at the cost of one pointer per entry and
+ * per bucket. Use the `gnrc_ipv6_nib_nc_hash` pseudo-module to enable.
+ */
+#ifndef GNRC_IPV6_NIB_CONF_NC_HASH
+#define GNRC_IPV6_NIB_CONF_NC_HASH      (0)
+#endif
+
 /**
  * @brief   Multihop prefix and 6LoWPAN context distribution
  *
@@ -262,6 +292,17 @@ extern "C" {
 #define GNRC_IPV6_NIB_OFFL_NUMOF            (8)
 #endif
 
+#if GNRC_IPV6_NIB_CONF_NC_HASH || defined(DOXYGEN)
+/**
+ * @brief   Number of buckets of the on-link entry hash table
+ *
+ * @note    Only available if @ref GNRC_IPV6_NIB_CONF_NC_HASH != 0.
+ */
+#ifndef GNRC_IPV6_NIB_NC_HASH_NUMOF
+#define GNRC_IPV6_NIB_NC_HASH_NUMOF         (GNRC_IPV6_NIB_NUMOF)
+#endif
+#endif
+
 #if GNRC_IPV6_NIB_CONF_MULTIHOP_P6C || defined(DOXYGEN)
 /**
  * @brief   Number of authoritative border router entries in NIB
@@ -18,6 +18,12 @@
  *          this *will* lead to alignment problems and can potentially result
  *          in segmentation/hard faults and other unexpected behaviour.
  *
+ * The static packet buffer (`gnrc_pktbuf_static`) keeps its free chunks in an
+ * address-ordered list and allocates first-fit. With the
+ * `gnrc_pktbuf_static_seg` pseudo-module it keeps them in segregated lists by
+ * size class instead: allocation and release take constant time, and mixed
+ * sizes, e.g. of 6LoWPAN fragments, fragment the buffer less.
+ *
  * @{
  *
  * @file
@@ -275,13 +281,41 @@ gnrc_pktsnip_t *gnrc_pktbuf_replace_snip(gnrc_pktsnip_t *pkt, gnrc_pktsnip_t *ol
  */
 gnrc_pktsnip_t *gnrc_pktbuf_duplicate_upto(gnrc_pktsnip_t *pkt, gnrc_nettype_t type);
 
+#if defined(MODULE_GNRC_PKTBUF_STATIC) || defined(DOXYGEN)
+/**
+ * @brief   Usage statistics of the static packet buffer
+ */
+typedef struct {
+    size_t used;            /**< number of bytes allocated */
+    size_t max_used;        /**< maximum number of bytes allocated at once */
+    size_t largest_free;    /**< size of the largest free chunk */
+    unsigned frag_fails;    /**< number of allocations that failed although
+                             *   enough bytes were free, but not in one chunk */
+} gnrc_pktbuf_usage_t;
+
+/**
+ * @brief   Gets usage statistics of the static packet buffer
+ *
+ * The gap between the free bytes (@ref GNRC_PKTBUF_SIZE -
+ * gnrc_pktbuf_usage_t::used) and gnrc_pktbuf_usage_t::largest_free shows
+ * how fragmented the packet buffer is.
+ *
+ * @note    Only available with `gnrc_pktbuf_static`.
+ *
+ * @param[out] usage    usage statistics
+ */
+void gnrc_pktbuf_get_usage(gnrc_pktbuf_usage_t *usage);
+#endif
+
 #ifdef DEVELHELP
 /**
  * @brief   Prints some statistics about the packet buffer to stdout.
  *
  * @note    Only available with DEVELHELP defined.
  *
- * @details Statistics include maximum number of reserved bytes.
+ * @details Statistics include maximum number of reserved bytes and, with
+ *          `gnrc_pktbuf_static`, the usage statistics of
+ *          gnrc_pktbuf_get_usage().
  */
 void gnrc_pktbuf_stats(void);
 #endif
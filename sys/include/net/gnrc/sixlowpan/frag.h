@@ -133,6 +133,46 @@ void gnrc_sixlowpan_frag_recv(gnrc_pktsnip_t *pkt, void *ctx, unsigned page);
  */
 void gnrc_sixlowpan_frag_gc_rbuf(void);
 
+/**
+ * @brief   Generates a new datagram tag for sending a fragmented datagram
+ *
+ * @return  The new datagram tag
+ */
+uint16_t gnrc_sixlowpan_frag_next_tag(void);
+
+#if defined(MODULE_GNRC_SIXLOWPAN_FRAG_VRB) || defined(DOXYGEN)
+/**
+ * @brief   Statistics of the virtual reassembly buffer
+ *
+ * With module `gnrc_sixlowpan_frag_vrb` a router forwards the fragments of a
+ * datagram that is not addressed to itself as they arrive instead of
+ * reassembling and re-fragmenting it. The first fragment creates an entry in
+ * the virtual reassembly buffer (VRB) that maps the datagram tag of the
+ * previous hop to the next hop and a new datagram tag, subsequent fragments
+ * are relabeled and sent on with this entry.
+ */
+typedef struct {
+    uint32_t datagrams;     /**< datagrams forwarded without reassembly */
+    uint32_t fragments;     /**< fragments forwarded */
+    uint32_t duplicates;    /**< fragments dropped since they overlap
+                             *   forwarded ones */
+    uint32_t fallbacks;     /**< datagrams for other nodes that were
+                             *   reassembled as their first fragment could
+                             *   not be forwarded */
+    uint32_t evictions;     /**< entries removed for a new datagram since the
+                             *   buffer was full */
+    uint32_t timeouts;      /**< entries that timed out before all fragments
+                             *   were forwarded */
+} gnrc_sixlowpan_frag_vrb_stats_t;
+
+/**
+ * @brief   Gets the statistics of the virtual reassembly buffer
+ *
+ * @param[out] stats    The statistics
+ */
+void gnrc_sixlowpan_frag_vrb_get_stats(gnrc_sixlowpan_frag_vrb_stats_t *stats);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,19 @@ extern "C" {
  */
 void ps(void);
 
+#if defined(MODULE_SCHEDSTATISTICS_EXT) || defined(DOXYGEN)
+/**
+ * @brief Print the scheduling statistics of all active threads to stdout
+ *
+ * For every thread: how often it was preempted, its longest run without a
+ * context switch, its longest and the histogram of its times from becoming
+ * ready to running.
+ *
+ * @note Only available with the `schedstatistics_ext` module.
+ */
+void ps_sched(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,11 +40,21 @@ typedef struct rtctimers_millis {
 
 	uint32_t target;
     uint32_t long_target;
+    uint32_t slack;             /**< allowed lateness [ms] */
 
 	rtctimers_millis_cb_t callback;
 	void *arg;
 } rtctimers_millis_t;
 
+/**
+ * @brief Wakeup statistics
+ */
+typedef struct {
+    uint32_t wakeups;           /**< number of RTC alarms handled */
+    uint32_t fired;             /**< number of timers fired from the RTC alarm */
+    uint32_t saved;             /**< number of alarms avoided by coalescing timers within their slack */
+} rtctimers_millis_stats_t;
+
 void rtctimers_millis_init(void);
 void rtctimers_millis_set(rtctimers_millis_t *timer, uint32_t offset);
 void rtctimers_millis_remove(rtctimers_millis_t *timer);
@@ -52,6 +62,21 @@ void rtctimers_millis_sleep(uint32_t sleep_millis);
 void rtctimers_millis_set_msg(rtctimers_millis_t *timer, uint32_t offset, msg_t *msg, kernel_pid_t target_pid);
 uint32_t rtctimers_millis_now(void);
 
+/**
+ * @brief Sets timer which may fire up to @p slack milliseconds late
+ *
+ * Timers expiring within the slack window of each other are fired by the same
+ * RTC alarm, so the MCU wakes up once for all of them. Timer never fires
+ * earlier than @p offset.
+ */
+void rtctimers_millis_set_slack(rtctimers_millis_t *timer, uint32_t offset, uint32_t slack);
+void rtctimers_millis_set_msg_slack(rtctimers_millis_t *timer, uint32_t offset, uint32_t slack, msg_t *msg, kernel_pid_t target_pid);
+
+/**
+ * @brief Returns wakeup statistics since rtctimers_millis_init()
+ */
+void rtctimers_millis_get_stats(rtctimers_millis_stats_t *stats);
+
 /**
  * @brief Returns time in milliseconds since 00:00:00 Sunday
  */
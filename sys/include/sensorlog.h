@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_sensorlog Sensor data logger
+ * @ingroup     sys
+ * @brief       Persistent time-series log on a file system
+ *
+ * Records of a timestamp, a source id and up to @ref SENSORLOG_DATA_MAX
+ * bytes of data are collected in a RAM buffer and appended to a file of the
+ * log directory when the buffer is full. Sizing the buffer to the flash page
+ * turns many small writes into one file system commit per page.
+ *
+ * The log files are numbered. A file that reached sensorlog_t::file_size is
+ * closed and the next one started, at most sensorlog_t::files files are kept
+ * and the oldest one is removed when a new one would exceed that number.
+ *
+ * sensorlog_replay() hands the records to a callback from the oldest on, e.g.
+ * to send them once a link is up again. Consumed files are removed and the
+ * position in the oldest file is saved in the file `cursor` of the log
+ * directory, so a log survives reboots. Records still in the RAM buffer are
+ * lost on a reset unless sensorlog_flush() is called.
+ *
+ * Files are only appended to as a whole buffer, so a file system that
+ * commits a write atomically like littlefs never holds partial records.
+ *
+ * @{
+ *
+ * @file
+ * @brief       Sensor data logger interface
+ */
+
+#ifndef SENSORLOG_H
+#define SENSORLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mutex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Size of a record header on the storage
+ */
+#define SENSORLOG_HDR_SIZE  (6U)
+
+/**
+ * @brief   Maximum size of the data of a record
+ */
+#define SENSORLOG_DATA_MAX  (255U)
+
+/**
+ * @brief   Size of the path buffers
+ *
+ * Has to hold the log directory, a slash and an 8 character file name.
+ */
+#ifndef SENSORLOG_PATH_MAX
+#define SENSORLOG_PATH_MAX  (48U)
+#endif
+
+/**
+ * @brief   Record header
+ */
+typedef struct {
+    uint32_t time;          /**< timestamp, e.g. seconds since the epoch */
+    uint8_t id;             /**< source of the record */
+    uint8_t len;            /**< size of the data */
+} sensorlog_record_t;
+
+/**
+ * @brief   Replay callback
+ *
+ * Called with the log locked, so it must not call other sensorlog functions
+ * on the same log.
+ *
+ * @param[in] arg       argument given to sensorlog_replay()
+ * @param[in] rec       record header
+ * @param[in] data      record data, sensorlog_record_t::len bytes
+ *
+ * @return 0 if the record is consumed
+ * @return negative value to stop the replay before this record
+ */
+typedef int (*sensorlog_cb_t)(void *arg, const sensorlog_record_t *rec,
+                              const uint8_t *data);
+
+/**
+ * @brief   Logger statistics
+ */
+typedef struct {
+    uint32_t records;       /**< records written */
+    uint32_t flushes;       /**< appends to a file */
+    uint32_t rotations;     /**< files started */
+    uint32_t dropped;       /**< files removed before they were replayed */
+    uint32_t replayed;      /**< records consumed by replays */
+} sensorlog_stats_t;
+
+/**
+ * @brief   Logger descriptor
+ *
+ * sensorlog_t::dir, sensorlog_t::buf, sensorlog_t::buf_size,
+ * sensorlog_t::file_size and sensorlog_t::files are set by the user, the rest
+ * by sensorlog_init().
+ */
+typedef struct {
+    const char *dir;            /**< log directory on a mounted file system */
+    uint8_t *buf;               /**< batch buffer */
+    size_t buf_size;            /**< size of the batch buffer, at least one
+                                 *   record */
+    uint32_t file_size;         /**< size at which a file is rotated */
+    uint16_t files;             /**< maximum number of files, at least 1 */
+    mutex_t lock;               /**< lock */
+    size_t fill;                /**< bytes in the batch buffer */
+    uint32_t first;             /**< oldest file */
+    uint32_t last;              /**< file being appended to */
+    uint32_t last_size;         /**< size of the last file */
+    uint32_t offset;            /**< replay position in the oldest file */
+    sensorlog_stats_t stats;    /**< statistics */
+} sensorlog_t;
+
+/**
+ * @brief   Initialize a logger
+ *
+ * Creates the log directory if needed and picks up the files and the replay
+ * position found there.
+ *
+ * @param[in,out] log   logger descriptor
+ *
+ * @return 0 on success
+ * @return -EINVAL if the descriptor is invalid
+ * @return -ENAMETOOLONG if the paths of the log exceed @ref SENSORLOG_PATH_MAX
+ * @return other negative errno on file system errors
+ */
+int sensorlog_init(sensorlog_t *log);
+
+/**
+ * @brief   Add a record
+ *
+ * The record is buffered, the buffer is written to the log if the record
+ * does not fit anymore.
+ *
+ * @param[in,out] log   logger
+ * @param[in]     time  timestamp
+ * @param[in]     id    source of the record
+ * @param[in]     data  data
+ * @param[in]     len   size of @p data, up to @ref SENSORLOG_DATA_MAX
+ *
+ * @return 0 on success
+ * @return -EINVAL if the record does not fit in the batch buffer
+ * @return other negative errno on file system errors, the record is not added
+ */
+int sensorlog_write(sensorlog_t *log, uint32_t time, uint8_t id,
+                    const void *data, size_t len);
+
+/**
+ * @brief   Write the buffered records to the log
+ *
+ * @param[in,out] log   logger
+ *
+ * @return 0 on success
+ * @return negative errno on file system errors
+ */
+int sensorlog_flush(sensorlog_t *log);
+
+/**
+ * @brief   Hand the oldest records to a callback
+ *
+ * Flushes the buffer first. Stops after @p max records, at the end of the
+ * log or when @p cb refuses a record, which is then handed over again on
+ * the next replay.
+ *
+ * @param[in,out] log   logger
+ * @param[in]     cb    callback
+ * @param[in]     arg   argument of @p cb
+ * @param[in]     max   maximum number of records to consume
+ *
+ * @return number of consumed records
+ * @return negative errno on file system errors
+ */
+int sensorlog_replay(sensorlog_t *log, sensorlog_cb_t cb, void *arg,
+                     unsigned max);
+
+/**
+ * @brief   Check whether all records have been replayed
+ *
+ * @param[in] log       logger
+ *
+ * @return true if there is nothing to replay
+ */
+bool sensorlog_empty(sensorlog_t *log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSORLOG_H */
+/** @} */
@@ -41,8 +41,10 @@
  * driver knows how to use, which can be used to keep driver parameters in order
  * to allow dynamic handling of multiple devices.
  *
- * @todo VFS layer reference counting and locking for open files and
- *       simultaneous access.
+ * Calls on the same open file are serialized by a lock of the file, calls on
+ * different files only wait for each other where the file system driver
+ * locks. Free file descriptors are tracked in a bitmap and the mounts of
+ * recently used mount points are cached, see @ref VFS_MOUNT_CACHE_SIZE.
  *
  * @{
  * @file
@@ -70,6 +72,7 @@ using std::atomic_int;
 
 #include "kernel_types.h"
 #include "clist.h"
+#include "mutex.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -83,11 +86,22 @@ extern "C" {
 
 #ifndef VFS_MAX_OPEN_FILES
 /**
- * @brief Maximum number of simultaneous open files
+ * @brief Maximum number of simultaneous open files, at most 32
  */
 #define VFS_MAX_OPEN_FILES (16)
 #endif
 
+#ifndef VFS_MOUNT_CACHE_SIZE
+/**
+ * @brief Number of mounts remembered for the path look up
+ *
+ * A path starting with the mount point of a recently used mount is resolved
+ * without walking the list of mounts. Mounts with other mounts below their
+ * mount point are not cached. 0 disables the cache.
+ */
+#define VFS_MOUNT_CACHE_SIZE (2)
+#endif
+
 #ifndef VFS_DIR_BUFFER_SIZE
 /**
  * @brief Size of buffer space in vfs_DIR
@@ -212,6 +226,7 @@ typedef struct {
     int flags;                  /**< File flags */
     off_t pos;                  /**< Current position in the file */
     kernel_pid_t pid;           /**< PID of the process that opened the file */
+    mutex_t lock;               /**< Serializes the calls on the file */
     union {
         void *ptr;              /**< pointer to private data */
         int value;              /**< alternatively, you can use private_data as an int */
@@ -370,6 +385,23 @@ struct vfs_file_ops {
      * @return <0 on error
      */
     ssize_t (*write) (vfs_file_t *filp, const void *src, size_t nbytes);
+
+    /**
+     * @brief Get a pointer to the contents of an open file
+     *
+     * Only for file systems keeping the file contents in addressable memory,
+     * e.g. in memory mapped flash. The data must stay valid and unchanged
+     * until the file is closed. The file position is not changed.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  off      offset in the file
+     * @param[in]  nbytes   maximum number of bytes to map
+     * @param[out] ptr      pointer to the data at @p off
+     *
+     * @return number of bytes available at @p ptr, 0 at or beyond end of file
+     * @return <0 on error
+     */
+    ssize_t (*span) (vfs_file_t *filp, off_t off, size_t nbytes, const void **ptr);
 };
 
 /**
@@ -660,6 +692,28 @@ ssize_t vfs_read(int fd, void *dest, size_t count);
  */
 ssize_t vfs_write(int fd, const void *src, size_t count);
 
+/**
+ * @brief Get a read-only pointer to the contents of an open file
+ *
+ * Gives access to up to @p count bytes at offset @p off without copying them,
+ * similar to a read-only mmap. It is supported by file systems keeping the
+ * contents in addressable memory like constfs, other file systems return
+ * -ENOTSUP and the data has to be read with vfs_read(). Like pread, the
+ * file position is not changed.
+ *
+ * The data stays valid until the file is closed and must not be written to.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  off      offset in the file
+ * @param[in]  count    maximum number of bytes to map
+ * @param[out] ptr      pointer to the data at @p off
+ *
+ * @return number of bytes available at @p ptr, 0 at or beyond end of file
+ * @return -ENOTSUP if the file system does not support it
+ * @return <0 on other errors
+ */
+ssize_t vfs_span(int fd, off_t off, size_t count, const void **ptr);
+
 /**
  * @brief Open a directory for reading with readdir
  *
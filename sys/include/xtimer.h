@@ -74,6 +74,10 @@ typedef struct xtimer {
     xtimer_callback_t callback;  /**< callback function to call when timer
                                      expires */
     void *arg;                   /**< argument to pass to callback function */
+#if defined(MODULE_XTIMER_WHEEL) || defined(DOXYGEN)
+    uint16_t wheel_list;         /**< timing wheel slot or list the timer is
+                                     in (xtimer_wheel only) */
+#endif
 } xtimer_t;
 
 /**
@@ -541,6 +545,31 @@ void xtimer_set_timeout_flag(xtimer_t *t, uint32_t timeout);
 #define XTIMER_PERIODIC_RELATIVE (512)
 #endif
 
+#if defined(MODULE_XTIMER_WHEEL) || defined(DOXYGEN)
+#ifndef XTIMER_WHEEL_SHIFT
+/**
+ * @brief   Width of a level 0 timing wheel slot as power of two of ticks
+ *          (xtimer_wheel only)
+ *
+ * Timers expiring within the next two slots are kept in a sorted list, so
+ * narrow slots make setting such timers cheaper, wide slots make the wheel
+ * cover more time with the same number of levels.
+ */
+#define XTIMER_WHEEL_SHIFT (10)
+#endif
+
+#ifndef XTIMER_WHEEL_LEVELS
+/**
+ * @brief   Number of timing wheel levels of 32 slots each (xtimer_wheel only)
+ *
+ * The wheel covers 2^(XTIMER_WHEEL_SHIFT + 5 * XTIMER_WHEEL_LEVELS) ticks,
+ * about 18 minutes at 1 MHz with the defaults. Timers set further ahead are
+ * kept in an unsorted list until they come into range.
+ */
+#define XTIMER_WHEEL_LEVELS (4)
+#endif
+#endif
+
 /*
  * Default xtimer configuration
  */
@@ -0,0 +1,474 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_kvlog
+ * @{
+ *
+ * @file
+ * @brief       Log-structured key-value store implementation
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "checksum/crc16_ccitt.h"
+#include "kvlog.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+#define KVLOG_MAGIC     (0x4b564c31UL)  /* "KVL1" */
+
+#define ALIGN_UP(x)     (((x) + KVLOG_ALIGN - 1) & ~(KVLOG_ALIGN - 1))
+#define CHUNK_SIZE      ((KVLOG_ALIGN > 16) ? KVLOG_ALIGN : 16)
+
+/* header at the start of a bank, written last when switching to the bank */
+typedef struct {
+    uint32_t magic;
+    uint16_t seq;
+    uint16_t crc;
+} bank_hdr_t;
+
+/* header of a record, written after its value */
+typedef struct {
+    uint8_t key;
+    uint8_t len;        /* 0 removes the key */
+    uint16_t crc;       /* over key, len and value */
+} rec_hdr_t;
+
+#define BANK_HDR_SIZE   ALIGN_UP(sizeof(bank_hdr_t))
+#define REC_HDR_SIZE    ALIGN_UP(sizeof(rec_hdr_t))
+
+/* aligned buffer for the storage accesses */
+typedef union {
+    uint32_t align;
+    uint8_t u8[CHUNK_SIZE];
+} chunk_t;
+
+static inline uint32_t _addr(const kvlog_t *kv, unsigned bank, uint32_t offset)
+{
+    return kv->base + bank * kv->bank_size + offset;
+}
+
+static inline uint32_t _rec_size(unsigned len)
+{
+    return REC_HDR_SIZE + ALIGN_UP(len);
+}
+
+static inline size_t _chunk(size_t left)
+{
+    return (left < CHUNK_SIZE) ? left : CHUNK_SIZE;
+}
+
+static kvlog_entry_t *_find(kvlog_t *kv, uint8_t key)
+{
+    for (unsigned i = 0; i < kv->used; i++) {
+        if (kv->index[i].key == key) {
+            return &kv->index[i];
+        }
+    }
+    return NULL;
+}
+
+static int _update(kvlog_t *kv, uint8_t key, uint32_t offset, uint8_t len)
+{
+    kvlog_entry_t *e = _find(kv, key);
+
+    if (len == 0) {
+        if (e != NULL) {
+            *e = kv->index[--kv->used];
+        }
+        return 0;
+    }
+    if (e == NULL) {
+        if (kv->used == kv->numof) {
+            return -ENOMEM;
+        }
+        e = &kv->index[kv->used++];
+        e->key = key;
+    }
+    e->offset = offset;
+    e->len = len;
+    return 0;
+}
+
+static uint16_t _bank_crc(const bank_hdr_t *hdr)
+{
+    return crc16_ccitt_calc((const unsigned char *)hdr,
+                            offsetof(bank_hdr_t, crc));
+}
+
+static int _read_bank(kvlog_t *kv, unsigned bank, uint16_t *seq)
+{
+    bank_hdr_t hdr;
+    int res = kv->driver->read(_addr(kv, bank, 0), &hdr, sizeof(hdr));
+
+    if (res < 0) {
+        return res;
+    }
+    if ((hdr.magic != KVLOG_MAGIC) || (hdr.crc != _bank_crc(&hdr))) {
+        return -ENOENT;
+    }
+    *seq = hdr.seq;
+    return 0;
+}
+
+static int _write_bank(kvlog_t *kv, unsigned bank, uint16_t seq)
+{
+    bank_hdr_t hdr = { .magic = KVLOG_MAGIC, .seq = seq };
+    chunk_t buf;
+
+    hdr.crc = _bank_crc(&hdr);
+    memset(buf.u8, kv->driver->erased, BANK_HDR_SIZE);
+    memcpy(buf.u8, &hdr, sizeof(hdr));
+    return kv->driver->write(_addr(kv, bank, 0), buf.u8, BANK_HDR_SIZE);
+}
+
+static int _crc(kvlog_t *kv, uint32_t addr, size_t len, uint16_t *crc)
+{
+    chunk_t buf;
+
+    while (len > 0) {
+        size_t n = _chunk(len);
+        int res = kv->driver->read(addr, buf.u8, n);
+
+        if (res < 0) {
+            return res;
+        }
+        *crc = crc16_ccitt_update(*crc, buf.u8, n);
+        addr += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* 1 if the storage holds data, 0 if it differs, negative on errors */
+static int _equal(kvlog_t *kv, uint32_t addr, const uint8_t *data, size_t len)
+{
+    chunk_t buf;
+
+    while (len > 0) {
+        size_t n = _chunk(len);
+        int res = kv->driver->read(addr, buf.u8, n);
+
+        if (res < 0) {
+            return res;
+        }
+        if (memcmp(buf.u8, data, n) != 0) {
+            return 0;
+        }
+        addr += n;
+        data += n;
+        len -= n;
+    }
+    return 1;
+}
+
+/* 1 if the storage is erased, 0 if not, negative on errors */
+static int _erased(kvlog_t *kv, uint32_t addr, size_t len)
+{
+    chunk_t buf;
+
+    while (len > 0) {
+        size_t n = _chunk(len);
+        int res = kv->driver->read(addr, buf.u8, n);
+
+        if (res < 0) {
+            return res;
+        }
+        for (unsigned i = 0; i < n; i++) {
+            if (buf.u8[i] != kv->driver->erased) {
+                return 0;
+            }
+        }
+        addr += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static int _copy(kvlog_t *kv, uint32_t from, uint32_t to, size_t len)
+{
+    chunk_t buf;
+
+    while (len > 0) {
+        size_t n = _chunk(len);
+        int res = kv->driver->read(from, buf.u8, n);
+
+        if (res < 0) {
+            return res;
+        }
+        res = kv->driver->write(to, buf.u8, n);
+        if (res < 0) {
+            return res;
+        }
+        from += n;
+        to += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int _format(kvlog_t *kv)
+{
+    DEBUG("kvlog: format\n");
+
+    int res = kv->driver->erase(_addr(kv, 0, 0), kv->bank_size);
+    if (res < 0) {
+        return res;
+    }
+    res = _write_bank(kv, 0, 0);
+    if (res < 0) {
+        return res;
+    }
+    kv->bank = 0;
+    kv->seq = 0;
+    kv->used = 0;
+    kv->end = BANK_HDR_SIZE;
+    return 0;
+}
+
+static int _scan(kvlog_t *kv)
+{
+    uint32_t offset = BANK_HDR_SIZE;
+    int res;
+
+    kv->used = 0;
+    while (offset + REC_HDR_SIZE <= kv->bank_size) {
+        uint32_t addr = _addr(kv, kv->bank, offset);
+        rec_hdr_t hdr;
+        uint16_t crc;
+
+        res = _erased(kv, addr, sizeof(hdr));
+        if (res != 0) {
+            if (res < 0) {
+                return res;
+            }
+            break;
+        }
+        res = kv->driver->read(addr, &hdr, sizeof(hdr));
+        if (res < 0) {
+            return res;
+        }
+        if (offset + _rec_size(hdr.len) > kv->bank_size) {
+            break;
+        }
+        crc = crc16_ccitt_calc((const unsigned char *)&hdr,
+                               offsetof(rec_hdr_t, crc));
+        res = _crc(kv, addr + REC_HDR_SIZE, hdr.len, &crc);
+        if (res < 0) {
+            return res;
+        }
+        if (crc != hdr.crc) {
+            DEBUG("kvlog: invalid record at 0x%" PRIx32 "\n", offset);
+            break;
+        }
+        res = _update(kv, hdr.key, offset, hdr.len);
+        if (res < 0) {
+            return res;
+        }
+        offset += _rec_size(hdr.len);
+    }
+    kv->end = offset;
+
+    /* an interrupted append may have left data behind the log, which can
+     * only be written again after the next compaction */
+    res = _erased(kv, _addr(kv, kv->bank, offset), kv->bank_size - offset);
+    if (res < 0) {
+        return res;
+    }
+    if (res == 0) {
+        DEBUG("kvlog: garbage behind 0x%" PRIx32 "\n", offset);
+        kv->end = kv->bank_size;
+    }
+    return 0;
+}
+
+static int _append(kvlog_t *kv, uint8_t key, const uint8_t *data, uint8_t len)
+{
+    uint32_t size = _rec_size(len);
+    rec_hdr_t hdr = { .key = key, .len = len };
+    chunk_t buf;
+    int res;
+
+    if (kv->end + size > kv->bank_size) {
+        res = kvlog_compact(kv);
+        if (res < 0) {
+            return res;
+        }
+        if (kv->end + size > kv->bank_size) {
+            return -ENOSPC;
+        }
+    }
+
+    uint32_t offset = kv->end;
+    uint32_t addr = _addr(kv, kv->bank, offset);
+
+    hdr.crc = crc16_ccitt_calc((const unsigned char *)&hdr,
+                               offsetof(rec_hdr_t, crc));
+    hdr.crc = crc16_ccitt_update(hdr.crc, data, len);
+
+    /* the value first, a record is complete once its header is written */
+    for (unsigned done = 0; done < len;) {
+        size_t n = _chunk(len - done);
+
+        memset(buf.u8, kv->driver->erased, sizeof(buf.u8));
+        memcpy(buf.u8, data + done, n);
+        res = kv->driver->write(addr + REC_HDR_SIZE + done, buf.u8, ALIGN_UP(n));
+        if (res < 0) {
+            goto fail;
+        }
+        done += n;
+    }
+    memset(buf.u8, kv->driver->erased, REC_HDR_SIZE);
+    memcpy(buf.u8, &hdr, sizeof(hdr));
+    res = kv->driver->write(addr, buf.u8, REC_HDR_SIZE);
+    if (res < 0) {
+        goto fail;
+    }
+
+    kv->end += size;
+    kv->stats.appends++;
+    return _update(kv, key, offset, len);
+
+fail:
+    /* written parts of the record are dropped on the next compaction */
+    kv->end = kv->bank_size;
+    return res;
+}
+
+int kvlog_init(kvlog_t *kv)
+{
+    uint16_t seq[2];
+    int valid[2];
+
+    assert((kv->driver != NULL) && (kv->index != NULL) && (kv->numof > 0));
+    assert((kv->bank_size > BANK_HDR_SIZE) && (kv->bank_size <= UINT16_MAX + 1));
+
+    memset(&kv->stats, 0, sizeof(kv->stats));
+    for (unsigned bank = 0; bank < 2; bank++) {
+        int res = _read_bank(kv, bank, &seq[bank]);
+
+        if ((res < 0) && (res != -ENOENT)) {
+            return res;
+        }
+        valid[bank] = (res == 0);
+    }
+
+    if (!valid[0] && !valid[1]) {
+        return _format(kv);
+    }
+    if (valid[0] && valid[1]) {
+        /* both are valid if a compaction was not followed by another one */
+        kv->bank = ((int16_t)(seq[1] - seq[0]) > 0) ? 1 : 0;
+    }
+    else {
+        kv->bank = valid[1] ? 1 : 0;
+    }
+    kv->seq = seq[kv->bank];
+
+    DEBUG("kvlog: bank %u, sequence %u\n", kv->bank, kv->seq);
+
+    return _scan(kv);
+}
+
+int kvlog_get(kvlog_t *kv, uint8_t key, void *buf, size_t size)
+{
+    kvlog_entry_t *e = _find(kv, key);
+
+    if (e == NULL) {
+        return -ENOENT;
+    }
+    if (size > e->len) {
+        size = e->len;
+    }
+
+    int res = kv->driver->read(_addr(kv, kv->bank, e->offset + REC_HDR_SIZE),
+                               buf, size);
+    return (res < 0) ? res : e->len;
+}
+
+int kvlog_set(kvlog_t *kv, uint8_t key, const void *data, size_t len)
+{
+    kvlog_entry_t *e = _find(kv, key);
+
+    if ((key > KVLOG_KEY_MAX) || (len == 0) || (len > KVLOG_VALUE_MAX)) {
+        return -EINVAL;
+    }
+    if (e == NULL) {
+        if (kv->used == kv->numof) {
+            return -ENOMEM;
+        }
+    }
+    else if (e->len == len) {
+        int res = _equal(kv, _addr(kv, kv->bank, e->offset + REC_HDR_SIZE),
+                         data, len);
+        if (res < 0) {
+            return res;
+        }
+        if (res) {
+            kv->stats.skipped++;
+            return 0;
+        }
+    }
+
+    return _append(kv, key, data, len);
+}
+
+int kvlog_delete(kvlog_t *kv, uint8_t key)
+{
+    if (_find(kv, key) == NULL) {
+        return -ENOENT;
+    }
+    return _append(kv, key, NULL, 0);
+}
+
+int kvlog_compact(kvlog_t *kv)
+{
+    unsigned to = kv->bank ^ 1;
+    uint32_t end = BANK_HDR_SIZE;
+
+    DEBUG("kvlog: compact %u keys to bank %u\n", kv->used, to);
+
+    int res = kv->driver->erase(_addr(kv, to, 0), kv->bank_size);
+    if (res < 0) {
+        return res;
+    }
+    for (unsigned i = 0; i < kv->used; i++) {
+        uint32_t size = _rec_size(kv->index[i].len);
+
+        res = _copy(kv, _addr(kv, kv->bank, kv->index[i].offset),
+                    _addr(kv, to, end), size);
+        if (res < 0) {
+            return res;
+        }
+        end += size;
+    }
+    /* the old bank stays valid until the new one has its header */
+    res = _write_bank(kv, to, kv->seq + 1);
+    if (res < 0) {
+        return res;
+    }
+
+    end = BANK_HDR_SIZE;
+    for (unsigned i = 0; i < kv->used; i++) {
+        kv->index[i].offset = end;
+        end += _rec_size(kv->index[i].len);
+    }
+    kv->bank = to;
+    kv->seq++;
+    kv->end = end;
+    kv->stats.compactions++;
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_kvlog
+ * @{
+ *
+ * @file
+ * @brief       kvlog storage operations for the EEPROM peripheral
+ *
+ * @}
+ */
+
+#ifdef MODULE_PERIPH_EEPROM
+
+#include <errno.h>
+
+#include "kvlog.h"
+#include "periph/eeprom.h"
+
+static int _read(uint32_t addr, void *buf, size_t len)
+{
+    return (eeprom_read(addr, buf, len) == len) ? 0 : -EIO;
+}
+
+static int _write(uint32_t addr, const void *buf, size_t len)
+{
+    return (eeprom_write(addr, buf, len) == len) ? 0 : -EIO;
+}
+
+static int _erase(uint32_t addr, size_t len)
+{
+    return (eeprom_clear(addr, len) == len) ? 0 : -EIO;
+}
+
+const kvlog_driver_t kvlog_eeprom_driver = {
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .erased = 0x00,
+};
+
+#else
+typedef int dont_be_pedantic;
+#endif /* MODULE_PERIPH_EEPROM */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_kvlog
+ * @{
+ *
+ * @file
+ * @brief       kvlog storage operations for the raw flash page peripheral
+ *
+ * @}
+ */
+
+#ifdef MODULE_PERIPH_FLASHPAGE_RAW
+
+#include <assert.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "kvlog.h"
+#include "periph/flashpage.h"
+
+static int _read(uint32_t addr, void *buf, size_t len)
+{
+    memcpy(buf, (const void *)addr, len);
+    return 0;
+}
+
+static int _write(uint32_t addr, const void *buf, size_t len)
+{
+    flashpage_write_raw((void *)addr, buf, len);
+    return 0;
+}
+
+static int _erase(uint32_t addr, size_t len)
+{
+    assert((addr % FLASHPAGE_SIZE) == 0 && (len % FLASHPAGE_SIZE) == 0);
+
+    for (int page = flashpage_page((void *)addr);
+         len > 0; page++, len -= FLASHPAGE_SIZE) {
+        flashpage_write(page, NULL);
+    }
+    return 0;
+}
+
+const kvlog_driver_t kvlog_flashpage_driver = {
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+#if defined(CPU_FAM_STM32L0) || defined(CPU_FAM_STM32L1)
+    .erased = 0x00,
+#else
+    .erased = 0xff,
+#endif
+};
+
+#else
+typedef int dont_be_pedantic;
+#endif /* MODULE_PERIPH_FLASHPAGE_RAW */
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_lpm_trie
+ * @{
+ *
+ * @file
+ * @brief       Longest prefix match trie implementation
+ *
+ * Every node stores a prefix, children extend the prefix of their parent and
+ * are selected by the first bit after it. Nodes without a value exist only
+ * where two prefixes diverge and always have two children.
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include "bitarithm.h"
+#include "lpm_trie.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+static inline unsigned _bit(const uint8_t *key, unsigned pos)
+{
+    return (key[pos >> 3] >> (7 - (pos & 7))) & 1;
+}
+
+/* first bit in [from, to) where a and b differ, to if there is none */
+static unsigned _first_diff(const uint8_t *a, const uint8_t *b,
+                            unsigned from, unsigned to)
+{
+    unsigned pos = from;
+
+    while (pos < to) {
+        unsigned byte = pos >> 3;
+        uint8_t diff = (a[byte] ^ b[byte]) & (0xff >> (pos & 7));
+
+        if (diff) {
+            pos = (byte << 3) + (7 - bitarithm_msb(diff));
+            return (pos < to) ? pos : to;
+        }
+        pos = (byte + 1) << 3;
+    }
+
+    return to;
+}
+
+static lpm_trie_node_t *_alloc(lpm_trie_t *trie)
+{
+    lpm_trie_node_t *node = trie->free;
+
+    if (node != NULL) {
+        trie->free = node->child[0];
+        node->child[0] = NULL;
+        node->child[1] = NULL;
+        node->value = NULL;
+    }
+    return node;
+}
+
+static void _free(lpm_trie_t *trie, lpm_trie_node_t *node)
+{
+    node->child[0] = trie->free;
+    trie->free = node;
+}
+
+/* slot pointing to the node storing exactly this prefix, NULL if none */
+static lpm_trie_node_t **_find(const lpm_trie_t *trie, const uint8_t *key,
+                               uint8_t len, lpm_trie_node_t ***parent)
+{
+    lpm_trie_node_t **slot = (lpm_trie_node_t **)&trie->root;
+    lpm_trie_node_t **up = NULL;
+    unsigned from = 0;
+
+    while (*slot != NULL) {
+        lpm_trie_node_t *node = *slot;
+
+        if ((node->len > len) ||
+            (_first_diff(node->key, key, from, node->len) < node->len)) {
+            break;
+        }
+        if (node->len == len) {
+            if (parent != NULL) {
+                *parent = up;
+            }
+            return slot;
+        }
+        from = node->len;
+        up = slot;
+        slot = &node->child[_bit(key, node->len)];
+    }
+
+    return NULL;
+}
+
+void lpm_trie_init(lpm_trie_t *trie, lpm_trie_node_t *nodes, unsigned numof)
+{
+    assert((trie != NULL) && ((nodes != NULL) || (numof == 0)));
+
+    trie->root = NULL;
+    trie->free = NULL;
+    lpm_trie_add_nodes(trie, nodes, numof);
+}
+
+void lpm_trie_add_nodes(lpm_trie_t *trie, lpm_trie_node_t *nodes, unsigned numof)
+{
+    for (unsigned i = 0; i < numof; i++) {
+        _free(trie, &nodes[i]);
+    }
+}
+
+int lpm_trie_add(lpm_trie_t *trie, const uint8_t *key, uint8_t len, void *value)
+{
+    lpm_trie_node_t **slot = &trie->root;
+    lpm_trie_node_t *node;
+    unsigned from = 0;
+    unsigned diff = 0;
+
+    assert((key != NULL) && (value != NULL));
+
+    while ((node = *slot) != NULL) {
+        unsigned end = (node->len < len) ? node->len : len;
+
+        diff = _first_diff(node->key, key, from, end);
+        if (diff < node->len) {
+            break;
+        }
+        if (node->len == len) {
+            if (node->value != NULL) {
+                return -EEXIST;
+            }
+            /* branching node becomes the node of this prefix */
+            node->key = key;
+            node->value = value;
+            return 0;
+        }
+        from = node->len;
+        slot = &node->child[_bit(key, node->len)];
+    }
+
+    if (node == NULL) {
+        /* new leaf */
+        if ((node = _alloc(trie)) == NULL) {
+            return -ENOMEM;
+        }
+        node->key = key;
+        node->len = len;
+        node->value = value;
+        *slot = node;
+        return 0;
+    }
+
+    lpm_trie_node_t *leaf = _alloc(trie);
+
+    if (leaf == NULL) {
+        return -ENOMEM;
+    }
+    leaf->key = key;
+    leaf->len = len;
+    leaf->value = value;
+
+    if (diff == len) {
+        /* new prefix is a prefix of the node, insert it above */
+        leaf->child[_bit(node->key, len)] = node;
+        *slot = leaf;
+        return 0;
+    }
+
+    /* prefixes diverge at diff, both hang off a new branching node */
+    lpm_trie_node_t *branch = _alloc(trie);
+
+    if (branch == NULL) {
+        _free(trie, leaf);
+        return -ENOMEM;
+    }
+    branch->key = key;
+    branch->len = diff;
+    branch->child[_bit(key, diff)] = leaf;
+    branch->child[_bit(node->key, diff)] = node;
+    *slot = branch;
+
+    return 0;
+}
+
+void *lpm_trie_remove(lpm_trie_t *trie, const uint8_t *key, uint8_t len)
+{
+    lpm_trie_node_t **parent;
+    lpm_trie_node_t **slot = _find(trie, key, len, &parent);
+
+    if ((slot == NULL) || ((*slot)->value == NULL)) {
+        return NULL;
+    }
+
+    lpm_trie_node_t *node = *slot;
+    const uint8_t *removed = node->key;
+    void *value = node->value;
+
+    node->value = NULL;
+    if ((node->child[0] != NULL) && (node->child[1] != NULL)) {
+        /* node stays as branching node */
+        node->key = node->child[0]->key;
+    }
+    else if ((node->child[0] != NULL) || (node->child[1] != NULL)) {
+        *slot = (node->child[0] != NULL) ? node->child[0] : node->child[1];
+        _free(trie, node);
+    }
+    else {
+        *slot = NULL;
+        _free(trie, node);
+
+        /* branching parent is left with a single child */
+        if ((parent != NULL) && ((*parent)->value == NULL)) {
+            lpm_trie_node_t *up = *parent;
+
+            *parent = (up->child[0] != NULL) ? up->child[0] : up->child[1];
+            _free(trie, up);
+        }
+    }
+
+    /* branching nodes above may borrow the removed key, they have two
+     * children and the one off the path of the key never refers to it */
+    for (node = trie->root; (node != NULL) && (node->len < len);
+         node = node->child[_bit(key, node->len)]) {
+        if (node->key == removed) {
+            node->key = node->child[!_bit(key, node->len)]->key;
+        }
+    }
+
+    return value;
+}
+
+void *lpm_trie_get(const lpm_trie_t *trie, const uint8_t *key, uint8_t len)
+{
+    lpm_trie_node_t **slot = _find(trie, key, len, NULL);
+
+    return (slot != NULL) ? (*slot)->value : NULL;
+}
+
+void *lpm_trie_match(const lpm_trie_t *trie, const uint8_t *addr, uint8_t len,
+                     uint8_t *pfx_len)
+{
+    const lpm_trie_node_t *node = trie->root;
+    const lpm_trie_node_t *best = NULL;
+    unsigned from = 0;
+
+    while ((node != NULL) && (node->len <= len) &&
+           (_first_diff(node->key, addr, from, node->len) == node->len)) {
+        if (node->value != NULL) {
+            best = node;
+        }
+        if (node->len == len) {
+            break;
+        }
+        from = node->len;
+        node = node->child[_bit(addr, node->len)];
+    }
+
+    if (best == NULL) {
+        return NULL;
+    }
+    if (pfx_len != NULL) {
+        *pfx_len = best->len;
+    }
+    return best->value;
+}
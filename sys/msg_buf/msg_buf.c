@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_msg_buf
+ * @{
+ *
+ * @file
+ * @brief       Pooled message buffers implementation
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "irq.h"
+#include "msg_buf.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+void msg_buf_pool_init(msg_buf_pool_t *pool, void *data, size_t payload, size_t num)
+{
+    assert((pool != NULL) && (data != NULL) && (num != 0));
+
+    memarray_init(&pool->mem, data, MSG_BUF_BLOCK_SIZE(payload), num);
+    sema_create(&pool->avail, 0);
+    pool->waiting = 0;
+    pool->used = 0;
+    pool->used_max = 0;
+    pool->alloc_failed = 0;
+}
+
+msg_buf_t *msg_buf_alloc(msg_buf_pool_t *pool)
+{
+    assert(pool != NULL);
+
+    unsigned state = irq_disable();
+    msg_buf_t *buf = memarray_alloc(&pool->mem);
+
+    if (buf == NULL) {
+        pool->alloc_failed++;
+        irq_restore(state);
+        DEBUG("msg_buf: pool %p exhausted\n", (void *)pool);
+        return NULL;
+    }
+
+    if (++pool->used > pool->used_max) {
+        pool->used_max = pool->used;
+    }
+    irq_restore(state);
+
+    buf->pool = pool;
+    buf->refs = 1;
+    buf->len = 0;
+
+    return buf;
+}
+
+msg_buf_t *msg_buf_alloc_wait(msg_buf_pool_t *pool)
+{
+    assert(pool != NULL);
+    assert(!irq_is_in());
+
+    while (1) {
+        unsigned state = irq_disable();
+        msg_buf_t *buf = memarray_alloc(&pool->mem);
+
+        if (buf != NULL) {
+            if (++pool->used > pool->used_max) {
+                pool->used_max = pool->used;
+            }
+            irq_restore(state);
+
+            buf->pool = pool;
+            buf->refs = 1;
+            buf->len = 0;
+
+            return buf;
+        }
+
+        pool->waiting++;
+        irq_restore(state);
+
+        /* every release while we're counted in waiting posts the semaphore,
+         * so a release between irq_restore() and here is not lost */
+        sema_wait(&pool->avail);
+    }
+}
+
+void msg_buf_hold(msg_buf_t *buf)
+{
+    assert((buf != NULL) && (buf->refs > 0));
+
+    unsigned state = irq_disable();
+    buf->refs++;
+    irq_restore(state);
+}
+
+void msg_buf_release(msg_buf_t *buf)
+{
+    assert((buf != NULL) && (buf->refs > 0));
+
+    msg_buf_pool_t *pool = buf->pool;
+    bool wake = false;
+
+    unsigned state = irq_disable();
+    if (--buf->refs > 0) {
+        irq_restore(state);
+        return;
+    }
+
+    memarray_free(&pool->mem, buf);
+    pool->used--;
+
+    if (pool->waiting > 0) {
+        pool->waiting--;
+        wake = true;
+    }
+    irq_restore(state);
+
+    if (wake) {
+        sema_post(&pool->avail);
+    }
+}
+
+int msg_buf_send(msg_buf_t *buf, uint16_t type, kernel_pid_t target_pid)
+{
+    msg_t m;
+
+    assert(buf != NULL);
+
+    m.type = type;
+    m.content.ptr = buf;
+
+    return msg_send(&m, target_pid);
+}
+
+int msg_buf_try_send(msg_buf_t *buf, uint16_t type, kernel_pid_t target_pid)
+{
+    msg_t m;
+
+    assert(buf != NULL);
+
+    m.type = type;
+    m.content.ptr = buf;
+
+    return msg_try_send(&m, target_pid);
+}
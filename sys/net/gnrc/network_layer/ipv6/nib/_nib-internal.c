@@ -23,6 +23,9 @@
 #include "net/gnrc/ipv6/nib.h"
 #include "net/gnrc/netif/internal.h"
 #include "random.h"
+#if GNRC_IPV6_NIB_CONF_LPM
+#include "lpm_trie.h"
+#endif
 
 #include "_nib-internal.h"
 #include "_nib-router.h"
@@ -38,6 +41,17 @@ static _nib_onl_entry_t _nodes[GNRC_IPV6_NIB_NUMOF];
 static _nib_offl_entry_t _dsts[GNRC_IPV6_NIB_OFFL_NUMOF];
 static _nib_dr_entry_t _def_routers[GNRC_IPV6_NIB_DEFAULT_ROUTER_NUMOF];
 
+#if GNRC_IPV6_NIB_CONF_LPM
+/* longest prefix match index of _dsts */
+static lpm_trie_t _dsts_lpm;
+static lpm_trie_node_t _dsts_lpm_nodes[LPM_TRIE_NODES_NUMOF(GNRC_IPV6_NIB_OFFL_NUMOF)];
+#endif
+
+#if GNRC_IPV6_NIB_CONF_NC_HASH
+/* _nodes by IPv6 address, every bucket is in the order of _nodes */
+static _nib_onl_entry_t *_nodes_hash[GNRC_IPV6_NIB_NC_HASH_NUMOF];
+#endif
+
 #if GNRC_IPV6_NIB_CONF_MULTIHOP_P6C
 static _nib_abr_entry_t _abrs[GNRC_IPV6_NIB_ABR_NUMOF];
 #endif  /* GNRC_IPV6_NIB_CONF_MULTIHOP_P6C */
@@ -50,6 +64,22 @@ evtimer_msg_t _nib_evtimer;
 static void _override_node(const ipv6_addr_t *addr, unsigned iface,
                            _nib_onl_entry_t *node);
 static inline bool _node_unreachable(_nib_onl_entry_t *node);
+#if GNRC_IPV6_NIB_CONF_LPM
+static void _offl_index(_nib_offl_entry_t *dst);
+static void _offl_unindex(_nib_offl_entry_t *dst);
+#else
+#define _offl_index(dst)        (void)dst
+#define _offl_unindex(dst)      (void)dst
+#endif
+#if GNRC_IPV6_NIB_CONF_NC_HASH
+static void _onl_hash(_nib_onl_entry_t *node);
+static _nib_onl_entry_t *_onl_hash_alloc(const ipv6_addr_t *addr,
+                                         unsigned iface);
+static _nib_onl_entry_t *_onl_hash_get(const ipv6_addr_t *addr,
+                                       unsigned iface);
+#else
+#define _onl_hash(node)         (void)node
+#endif
 
 void _nib_init(void)
 {
@@ -59,10 +89,17 @@ void _nib_init(void)
     memset(_nodes, 0, sizeof(_nodes));
     memset(_def_routers, 0, sizeof(_def_routers));
     memset(_dsts, 0, sizeof(_dsts));
+#if GNRC_IPV6_NIB_CONF_NC_HASH
+    memset(_nodes_hash, 0, sizeof(_nodes_hash));
+#endif
 #if GNRC_IPV6_NIB_CONF_MULTIHOP_P6C
     memset(_abrs, 0, sizeof(_abrs));
 #endif  /* GNRC_IPV6_NIB_CONF_MULTIHOP_P6C */
 #endif  /* TEST_SUITES */
+#if GNRC_IPV6_NIB_CONF_LPM
+    lpm_trie_init(&_dsts_lpm, _dsts_lpm_nodes,
+                  LPM_TRIE_NODES_NUMOF(GNRC_IPV6_NIB_OFFL_NUMOF));
+#endif
     evtimer_init_msg(&_nib_evtimer);
     /* TODO: load ABR information from persistent memory */
 }
@@ -74,13 +111,11 @@ static inline bool _addr_equals(const ipv6_addr_t *addr,
            (ipv6_addr_equal(addr, &node->ipv6));
 }
 
-_nib_onl_entry_t *_nib_onl_alloc(const ipv6_addr_t *addr, unsigned iface)
+static _nib_onl_entry_t *_onl_scan_alloc(const ipv6_addr_t *addr,
+                                         unsigned iface)
 {
     _nib_onl_entry_t *node = NULL;
 
-    DEBUG("nib: Allocating on-link node entry (addr = %s, iface = %u)\n",
-          (addr == NULL) ? "NULL" : ipv6_addr_to_str(addr_str, addr,
-                                                     sizeof(addr_str)), iface);
     for (unsigned i = 0; i < GNRC_IPV6_NIB_NUMOF; i++) {
         _nib_onl_entry_t *tmp = &_nodes[i];
 
@@ -95,6 +130,27 @@ _nib_onl_entry_t *_nib_onl_alloc(const ipv6_addr_t *addr, unsigned iface)
             node = tmp;
         }
     }
+    return node;
+}
+
+_nib_onl_entry_t *_nib_onl_alloc(const ipv6_addr_t *addr, unsigned iface)
+{
+    _nib_onl_entry_t *node;
+
+    DEBUG("nib: Allocating on-link node entry (addr = %s, iface = %u)\n",
+          (addr == NULL) ? "NULL" : ipv6_addr_to_str(addr_str, addr,
+                                                     sizeof(addr_str)), iface);
+#if GNRC_IPV6_NIB_CONF_NC_HASH
+    /* without an address any entry on the interface matches */
+    if ((addr != NULL) && !ipv6_addr_is_unspecified(addr)) {
+        node = _onl_hash_alloc(addr, iface);
+    }
+    else {
+        node = _onl_scan_alloc(addr, iface);
+    }
+#else   /* GNRC_IPV6_NIB_CONF_NC_HASH */
+    node = _onl_scan_alloc(addr, iface);
+#endif  /* GNRC_IPV6_NIB_CONF_NC_HASH */
     if (node != NULL) {
         _override_node(addr, iface, node);
     }
@@ -203,6 +259,9 @@ _nib_onl_entry_t *_nib_onl_get(const ipv6_addr_t *addr, unsigned iface)
     assert(addr != NULL);
     DEBUG("nib: Getting on-link node entry (addr = %s, iface = %u)\n",
           ipv6_addr_to_str(addr_str, addr, sizeof(addr_str)), iface);
+#if GNRC_IPV6_NIB_CONF_NC_HASH
+    return _onl_hash_get(addr, iface);
+#else   /* GNRC_IPV6_NIB_CONF_NC_HASH */
     for (unsigned i = 0; i < GNRC_IPV6_NIB_NUMOF; i++) {
         _nib_onl_entry_t *node = &_nodes[i];
 
@@ -218,6 +277,7 @@ _nib_onl_entry_t *_nib_onl_get(const ipv6_addr_t *addr, unsigned iface)
     }
     DEBUG("  No suitable entry found\n");
     return NULL;
+#endif  /* GNRC_IPV6_NIB_CONF_NC_HASH */
 }
 
 void _nib_nc_set_reachable(_nib_onl_entry_t *node)
@@ -462,8 +522,13 @@ _nib_offl_entry_t *_nib_offl_alloc(const ipv6_addr_t *next_hop, unsigned iface,
             (ipv6_addr_match_prefix(&tmp->pfx, pfx) >= pfx_len)) {  /* the prefix matches */
             /* exact match (or next hop address was previously unset) */
             DEBUG("  %p is an exact match\n", (void *)tmp);
-            if (next_hop != NULL) {
+            if ((next_hop != NULL) &&
+                !ipv6_addr_equal(next_hop, &tmp_node->ipv6)) {
+                /* the node is hashed by its address, move it to the new
+                 * bucket */
+                _nib_onl_unhash(tmp_node);
                 memcpy(&tmp_node->ipv6, next_hop, sizeof(tmp_node->ipv6));
+                _onl_hash(tmp_node);
             }
             tmp->next_hop->mode |= _DST;
             return tmp;
@@ -484,10 +549,45 @@ _nib_offl_entry_t *_nib_offl_alloc(const ipv6_addr_t *next_hop, unsigned iface,
         dst->next_hop->mode |= _DST;
         ipv6_addr_init_prefix(&dst->pfx, pfx, pfx_len);
         dst->pfx_len = pfx_len;
+        _offl_index(dst);
     }
     return dst;
 }
 
+#if GNRC_IPV6_NIB_CONF_LPM
+/* Entries with the same prefix share one trie node, which points to the first
+ * of them like the linear search would find it */
+static void _offl_index(_nib_offl_entry_t *dst)
+{
+    _nib_offl_entry_t *first = lpm_trie_get(&_dsts_lpm, dst->pfx.u8,
+                                            dst->pfx_len);
+
+    if (first != NULL) {
+        if (first < dst) {
+            return;
+        }
+        lpm_trie_remove(&_dsts_lpm, first->pfx.u8, first->pfx_len);
+    }
+    lpm_trie_add(&_dsts_lpm, dst->pfx.u8, dst->pfx_len, dst);
+}
+
+static void _offl_unindex(_nib_offl_entry_t *dst)
+{
+    if (lpm_trie_get(&_dsts_lpm, dst->pfx.u8, dst->pfx_len) != dst) {
+        return;
+    }
+    lpm_trie_remove(&_dsts_lpm, dst->pfx.u8, dst->pfx_len);
+    /* hand the prefix over to the next entry with it */
+    for (_nib_offl_entry_t *ptr = dst + 1; ptr < (_dsts + GNRC_IPV6_NIB_OFFL_NUMOF); ptr++) {
+        if ((ptr->next_hop != NULL) && (ptr->pfx_len == dst->pfx_len) &&
+            (ipv6_addr_match_prefix(&ptr->pfx, &dst->pfx) >= dst->pfx_len)) {
+            lpm_trie_add(&_dsts_lpm, ptr->pfx.u8, ptr->pfx_len, ptr);
+            break;
+        }
+    }
+}
+#endif  /* GNRC_IPV6_NIB_CONF_LPM */
+
 static inline bool _in_dsts(const _nib_offl_entry_t *dst)
 {
     return (dst < (_dsts + GNRC_IPV6_NIB_OFFL_NUMOF));
@@ -515,6 +615,7 @@ void _nib_offl_clear(_nib_offl_entry_t *dst)
             dst->next_hop->mode &= ~(_DST);
             _nib_onl_clear(dst->next_hop);
         }
+        _offl_unindex(dst);
         memset(dst, 0, sizeof(_nib_offl_entry_t));
     }
 }
@@ -545,6 +646,15 @@ static _nib_offl_entry_t *_nib_offl_get_match(const ipv6_addr_t *dst)
 
     DEBUG("nib: get match for destination %s from NIB\n",
           ipv6_addr_to_str(addr_str, dst, sizeof(addr_str)));
+#if GNRC_IPV6_NIB_CONF_LPM
+    res = lpm_trie_match(&_dsts_lpm, dst->u8, IPV6_ADDR_BIT_LEN, NULL);
+    /* entries are indexed on allocation, before they are added to a view */
+    if ((res == NULL) || (res->mode != _EMPTY)) {
+        DEBUG("nib: best match %p from trie\n", (void *)res);
+        return res;
+    }
+    res = NULL;
+#endif
     for (_nib_offl_entry_t *entry = _dsts; _in_dsts(entry); entry++) {
         if (entry->mode != _EMPTY) {
             uint8_t match = ipv6_addr_match_prefix(&entry->pfx, dst);
@@ -790,12 +900,109 @@ _nib_offl_entry_t *_nib_pl_add(unsigned iface,
 static void _override_node(const ipv6_addr_t *addr, unsigned iface,
                            _nib_onl_entry_t *node)
 {
+    _nib_onl_unhash(node);
     _nib_onl_clear(node);
     if (addr != NULL) {
         memcpy(&node->ipv6, addr, sizeof(node->ipv6));
     }
     _nib_onl_set_if(node, iface);
+    _onl_hash(node);
+}
+
+#if GNRC_IPV6_NIB_CONF_NC_HASH
+static inline _nib_onl_entry_t **_onl_bucket(const ipv6_addr_t *addr)
+{
+    /* neighbors mostly differ in the interface identifier */
+    uint32_t hash = addr->u32[0].u32 ^ addr->u32[1].u32 ^
+                    addr->u32[2].u32 ^ addr->u32[3].u32;
+
+    hash *= 0x9e3779b1;
+    return &_nodes_hash[(hash >> 16) % GNRC_IPV6_NIB_NC_HASH_NUMOF];
+}
+
+/* Every entry that went through _override_node() is in the hash table until
+ * it is cleared, only untouched empty entries are not */
+static void _onl_hash(_nib_onl_entry_t *node)
+{
+    _nib_onl_entry_t **ptr = _onl_bucket(&node->ipv6);
+
+    while ((*ptr != NULL) && (*ptr < node)) {
+        ptr = &(*ptr)->hash_next;
+    }
+    node->hash_next = *ptr;
+    *ptr = node;
+}
+
+void _nib_onl_unhash(_nib_onl_entry_t *node)
+{
+    for (_nib_onl_entry_t **ptr = _onl_bucket(&node->ipv6); *ptr != NULL;
+         ptr = &(*ptr)->hash_next) {
+        if (*ptr == node) {
+            *ptr = node->hash_next;
+            node->hash_next = NULL;
+            return;
+        }
+    }
+}
+
+/* buckets are ordered like _nodes, so the first match in a bucket is the first
+ * match of a scan */
+static _nib_onl_entry_t *_onl_hash_exact(const ipv6_addr_t *addr,
+                                         unsigned iface)
+{
+    for (_nib_onl_entry_t *node = *_onl_bucket(addr); node != NULL;
+         node = node->hash_next) {
+        if ((_nib_onl_get_if(node) == iface) &&
+            ipv6_addr_equal(&node->ipv6, addr)) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/* Finds the same entry as _onl_scan_alloc() */
+static _nib_onl_entry_t *_onl_hash_alloc(const ipv6_addr_t *addr,
+                                         unsigned iface)
+{
+    _nib_onl_entry_t *node = _onl_hash_exact(addr, iface);
+    /* entries without address, e.g. of prefix list entries, match as well */
+    _nib_onl_entry_t *noaddr = _onl_hash_exact(&ipv6_addr_unspecified, iface);
+
+    if ((noaddr != NULL) && ((node == NULL) || (noaddr < node))) {
+        node = noaddr;
+    }
+    if (node != NULL) {
+        DEBUG("  %p is an exact match\n", (void *)node);
+        return node;
+    }
+    for (unsigned i = 0; i < GNRC_IPV6_NIB_NUMOF; i++) {
+        if (_nodes[i].mode == _EMPTY) {
+            DEBUG("  using %p\n", (void *)&_nodes[i]);
+            return &_nodes[i];
+        }
+    }
+    return NULL;
+}
+
+static _nib_onl_entry_t *_onl_hash_get(const ipv6_addr_t *addr,
+                                       unsigned iface)
+{
+    for (_nib_onl_entry_t *node = *_onl_bucket(addr); node != NULL;
+         node = node->hash_next) {
+        if ((node->mode != _EMPTY) &&
+            /* either requested or current interface undefined or
+             * interfaces equal */
+            ((_nib_onl_get_if(node) == 0) || (iface == 0) ||
+             (_nib_onl_get_if(node) == iface)) &&
+            ipv6_addr_equal(&node->ipv6, addr)) {
+            DEBUG("  Found %p\n", (void *)node);
+            return node;
+        }
+    }
+    DEBUG("  No suitable entry found\n");
+    return NULL;
 }
+#endif  /* GNRC_IPV6_NIB_CONF_NC_HASH */
 
 static inline bool _node_unreachable(_nib_onl_entry_t *node)
 {
@@ -90,6 +90,14 @@ extern "C" {
  */
 typedef struct _nib_onl_entry {
     struct _nib_onl_entry *next;        /**< next removable entry */
+#if GNRC_IPV6_NIB_CONF_NC_HASH || defined(DOXYGEN)
+    /**
+     * @brief   next entry in the same bucket of the address hash table
+     *
+     * @note    Only available if @ref GNRC_IPV6_NIB_CONF_NC_HASH != 0.
+     */
+    struct _nib_onl_entry *hash_next;
+#endif
 #if GNRC_IPV6_NIB_CONF_QUEUE_PKT || defined(DOXYGEN)
     /**
      * @brief   queue for packets currently in address resolution
@@ -303,6 +311,22 @@ static inline void _nib_onl_set_if(_nib_onl_entry_t *node, unsigned iface)
  */
 _nib_onl_entry_t *_nib_onl_alloc(const ipv6_addr_t *addr, unsigned iface);
 
+#if GNRC_IPV6_NIB_CONF_NC_HASH || defined(DOXYGEN)
+/**
+ * @brief   Removes an on-link entry from the address hash table
+ *
+ * Must be called before _nib_onl_entry_t::ipv6 or the interface of the entry
+ * change.
+ *
+ * @note    Only available if @ref GNRC_IPV6_NIB_CONF_NC_HASH != 0.
+ *
+ * @param[in,out] node  An entry.
+ */
+void _nib_onl_unhash(_nib_onl_entry_t *node);
+#else
+#define _nib_onl_unhash(node)   (void)node
+#endif
+
 /**
  * @brief   Clears out a NIB entry (on-link version)
  *
@@ -314,6 +338,7 @@ _nib_onl_entry_t *_nib_onl_alloc(const ipv6_addr_t *addr, unsigned iface);
 static inline bool _nib_onl_clear(_nib_onl_entry_t *node)
 {
     if (node->mode == _EMPTY) {
+        _nib_onl_unhash(node);
         memset(node, 0, sizeof(_nib_onl_entry_t));
         return true;
     }
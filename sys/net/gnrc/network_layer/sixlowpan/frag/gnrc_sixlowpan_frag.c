@@ -27,6 +27,9 @@
 #include "utlist.h"
 
 #include "rbuf.h"
+#ifdef MODULE_GNRC_SIXLOWPAN_FRAG_VRB
+#include "vrb.h"
+#endif
 
 #define ENABLE_DEBUG    (0)
 #include "debug.h"
@@ -246,7 +249,7 @@ void gnrc_sixlowpan_frag_send(gnrc_pktsnip_t *pkt, void *ctx, unsigned page)
     /* Check weater to send the first or an Nth fragment */
     if (fragment_msg->offset == 0) {
         /* increment tag for successive, fragmented datagrams */
-        _tag++;
+        gnrc_sixlowpan_frag_next_tag();
         if ((res = _send_1st_fragment(iface, fragment_msg->pkt, payload_len, fragment_msg->datagram_size)) == 0) {
             /* error sending first fragment */
             DEBUG("6lo frag: error sending 1st fragment\n");
@@ -315,6 +318,13 @@ void gnrc_sixlowpan_frag_recv(gnrc_pktsnip_t *pkt, void *ctx, unsigned page)
             return;
     }
 
+#ifdef MODULE_GNRC_SIXLOWPAN_FRAG_VRB
+    if (vrb_forward(hdr, pkt, frag_size, offset)) {
+        /* fragment of a datagram for another node was sent on */
+        return;
+    }
+#endif
+
     rbuf_add(hdr, pkt, frag_size, offset);
 
     gnrc_pktbuf_release(pkt);
@@ -323,6 +333,14 @@ void gnrc_sixlowpan_frag_recv(gnrc_pktsnip_t *pkt, void *ctx, unsigned page)
 void gnrc_sixlowpan_frag_gc_rbuf(void)
 {
     rbuf_gc();
+#ifdef MODULE_GNRC_SIXLOWPAN_FRAG_VRB
+    vrb_gc();
+#endif
+}
+
+uint16_t gnrc_sixlowpan_frag_next_tag(void)
+{
+    return ++_tag;
 }
 
 /** @} */
@@ -29,23 +29,26 @@
 #define ENABLE_DEBUG    (0)
 #include "debug.h"
 
-/* estimated fragment payload size to determinate RBUF_INT_SIZE, default to
- * MAC payload size - fragment header. */
-#ifndef GNRC_SIXLOWPAN_FRAG_SIZE
-/* assuming 64-bit source/destination address, source PAN ID omitted */
-#define GNRC_SIXLOWPAN_FRAG_SIZE (104 - 5)
-#endif
+#define RBUF_NONE       (UINT8_MAX)
 
-#ifndef RBUF_INT_SIZE
-/* same as ((int) ceil((double) N / D)) */
-#define DIV_CEIL(N, D) (((N) + (D) - 1) / (D))
-#define RBUF_INT_SIZE (DIV_CEIL(IPV6_MIN_MTU, GNRC_SIXLOWPAN_FRAG_SIZE) * RBUF_SIZE)
+/* entries and buckets are referenced by uint8_t indices, RBUF_NONE excluded */
+#if RBUF_SIZE >= RBUF_NONE
+#error "RBUF_SIZE must be less than 255"
+#endif
+#if RBUF_HASH_NUMOF > (RBUF_NONE + 1)
+#error "RBUF_HASH_NUMOF must not exceed 256"
 #endif
-
-static rbuf_int_t rbuf_int[RBUF_INT_SIZE];
 
 static rbuf_t rbuf[RBUF_SIZE];
 
+/* heads of the hash buckets, chained with rbuf_t::next */
+static uint8_t _rbuf_buckets[RBUF_HASH_NUMOF];
+/* unused entries, chained with rbuf_t::next */
+static uint8_t _rbuf_free;
+/* binary min-heap of the used entries by arrival, oldest entry first */
+static uint8_t _rbuf_heap[RBUF_SIZE];
+static unsigned _rbuf_heap_len;
+
 static char l2addr_str[3 * IEEE802154_LONG_ADDRESS_LEN];
 
 static xtimer_t _gc_timer;
@@ -54,14 +57,20 @@ static msg_t _gc_timer_msg = { .type = GNRC_SIXLOWPAN_MSG_FRAG_GC_RBUF };
 /* ------------------------------------
  * internal function definitions
  * ------------------------------------*/
-/* checks whether start and end overlaps, but not identical to, given interval i */
-static inline bool _rbuf_int_overlap_partially(rbuf_int_t *i, uint16_t start, uint16_t end);
-/* gets a free entry from interval buffer */
-static rbuf_int_t *_rbuf_int_get_free(void);
+/* initializes free list and hash table on first use */
+static void _rbuf_init(void);
+/* checks whether the fragment overlaps, but is not identical to, received
+ * fragments and whether it was received already */
+static bool _rbuf_overlap_partially(rbuf_t *entry, uint16_t offset,
+                                    size_t frag_size, bool *dup);
 /* remove entry from reassembly buffer */
 static void _rbuf_rem(rbuf_t *entry);
-/* update interval buffer of entry */
-static bool _rbuf_update_ints(rbuf_t *entry, uint16_t offset, size_t frag_size);
+/* update received units of entry */
+static void _rbuf_update_ints(rbuf_t *entry, uint16_t offset, size_t frag_size);
+/* finds an entry identified by its tupel in its hash bucket */
+static rbuf_t *_rbuf_find(unsigned bucket, const void *src, size_t src_len,
+                          const void *dst, size_t dst_len,
+                          size_t size, uint16_t tag);
 /* gets an entry identified by its tupel */
 static rbuf_t *_rbuf_get(const void *src, size_t src_len,
                          const void *dst, size_t dst_len,
@@ -76,7 +85,7 @@ void rbuf_add(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
     unsigned int data_offset = 0;
     size_t original_size = frag_size;
     sixlowpan_frag_t *frag = pkt->data;
-    rbuf_int_t *ptr;
+    bool dup;
     uint8_t *data = ((uint8_t *)pkt->data) + sizeof(sixlowpan_frag_t);
 
     rbuf_gc();
@@ -90,8 +99,6 @@ void rbuf_add(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
         return;
     }
 
-    ptr = entry->ints;
-
     /* dispatches in the first fragment are ignored */
     if (offset == 0) {
         if (data[0] == SIXLOWPAN_UNCOMP) {
@@ -134,24 +141,21 @@ void rbuf_add(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
     /* If the fragment overlaps another fragment and differs in either the size
      * or the offset of the overlapped fragment, discards the datagram
      * https://tools.ietf.org/html/rfc4944#section-5.3 */
-    while (ptr != NULL) {
-        if (_rbuf_int_overlap_partially(ptr, offset, offset + frag_size - 1)) {
-            DEBUG("6lo rfrag: overlapping intervals, discarding datagram\n");
-            gnrc_pktbuf_release(entry->super.pkt);
-            _rbuf_rem(entry);
-
-            /* "A fresh reassembly may be commenced with the most recently
-             * received link fragment"
-             * https://tools.ietf.org/html/rfc4944#section-5.3 */
-            rbuf_add(netif_hdr, pkt, original_size, offset);
+    if (_rbuf_overlap_partially(entry, offset, frag_size, &dup)) {
+        DEBUG("6lo rfrag: overlapping intervals, discarding datagram\n");
+        gnrc_pktbuf_release(entry->super.pkt);
+        _rbuf_rem(entry);
 
-            return;
-        }
+        /* "A fresh reassembly may be commenced with the most recently
+         * received link fragment"
+         * https://tools.ietf.org/html/rfc4944#section-5.3 */
+        rbuf_add(netif_hdr, pkt, original_size, offset);
 
-        ptr = ptr->next;
+        return;
     }
 
-    if (_rbuf_update_ints(entry, offset, frag_size)) {
+    if (!dup) {
+        _rbuf_update_ints(entry, offset, frag_size);
         DEBUG("6lo rbuf: add fragment data\n");
         entry->super.current_size += (uint16_t)frag_size;
         memcpy(((uint8_t *)entry->super.pkt->data) + offset + data_offset, data,
@@ -186,89 +190,198 @@ void rbuf_add(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
     }
 }
 
-static inline bool _rbuf_int_overlap_partially(rbuf_int_t *i, uint16_t start, uint16_t end)
+static inline bool _rbuf_older(const rbuf_t *a, const rbuf_t *b)
 {
-    /* start and ends are both inclusive, so using <= for both */
-    return ((i->start <= end) && (start <= i->end)) && /* overlaps */
-        ((start != i->start) || (end != i->end)); /* not identical */
+    /* note that xtimer_now will overflow in ~1.2 hours */
+    return (b->arrival - a->arrival) < (UINT32_MAX / 2);
 }
 
-static rbuf_int_t *_rbuf_int_get_free(void)
+static void _rbuf_heap_set(unsigned pos, uint8_t idx)
 {
-    for (unsigned int i = 0; i < RBUF_INT_SIZE; i++) {
-        if (rbuf_int[i].end == 0) { /* start must be smaller than end anyways*/
-            return rbuf_int + i;
-        }
+    _rbuf_heap[pos] = idx;
+    rbuf[idx].heap_pos = pos;
+}
+
+/* restores the heap order around pos after the arrival of its entry changed */
+static void _rbuf_heap_fix(unsigned pos)
+{
+    uint8_t idx = _rbuf_heap[pos];
+
+    while ((pos > 0) &&
+           !_rbuf_older(&rbuf[_rbuf_heap[(pos - 1) / 2]], &rbuf[idx])) {
+        _rbuf_heap_set(pos, _rbuf_heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
     }
+    while ((2 * pos + 1) < _rbuf_heap_len) {
+        unsigned child = 2 * pos + 1;
 
-    return NULL;
+        if (((child + 1) < _rbuf_heap_len) &&
+            _rbuf_older(&rbuf[_rbuf_heap[child + 1]], &rbuf[_rbuf_heap[child]])) {
+            child++;
+        }
+        if (_rbuf_older(&rbuf[idx], &rbuf[_rbuf_heap[child]])) {
+            break;
+        }
+        _rbuf_heap_set(pos, _rbuf_heap[child]);
+        pos = child;
+    }
+    _rbuf_heap_set(pos, idx);
 }
 
-static void _rbuf_rem(rbuf_t *entry)
+static unsigned _rbuf_hash(const void *src, size_t src_len,
+                           const void *dst, size_t dst_len,
+                           size_t size, uint16_t tag)
 {
-    while (entry->ints != NULL) {
-        rbuf_int_t *next = entry->ints->next;
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    const uint8_t *addr = src;
 
-        entry->ints->start = 0;
-        entry->ints->end = 0;
-        entry->ints->next = NULL;
-        entry->ints = next;
+    for (unsigned i = 0; i < src_len; i++) {
+        hash = (hash ^ addr[i]) * 16777619U;
     }
+    addr = dst;
+    for (unsigned i = 0; i < dst_len; i++) {
+        hash = (hash ^ addr[i]) * 16777619U;
+    }
+    hash = (hash ^ (tag & 0xff)) * 16777619U;
+    hash = (hash ^ (tag >> 8)) * 16777619U;
+    hash = (hash ^ (size & 0xff)) * 16777619U;
+    hash = (hash ^ (size >> 8)) * 16777619U;
 
-    entry->super.pkt = NULL;
+    return hash % RBUF_HASH_NUMOF;
+}
+
+bool rbuf_exists(gnrc_netif_hdr_t *netif_hdr, size_t size, uint16_t tag)
+{
+    const uint8_t *src = gnrc_netif_hdr_get_src_addr(netif_hdr);
+    const uint8_t *dst = gnrc_netif_hdr_get_dst_addr(netif_hdr);
+    unsigned bucket = _rbuf_hash(src, netif_hdr->src_l2addr_len,
+                                 dst, netif_hdr->dst_l2addr_len, size, tag);
+
+    /* timed out entries must not keep a datagram from being forwarded */
+    rbuf_gc();
+    return _rbuf_find(bucket, src, netif_hdr->src_l2addr_len,
+                      dst, netif_hdr->dst_l2addr_len, size, tag) != NULL;
 }
 
-static bool _rbuf_update_ints(rbuf_t *entry, uint16_t offset, size_t frag_size)
+static void _rbuf_init(void)
 {
-    rbuf_int_t *new;
-    uint16_t end = (uint16_t)(offset + frag_size - 1);
+    static bool initialized;
 
-    new = _rbuf_int_get_free();
+    if (initialized) {
+        return;
+    }
+    memset(_rbuf_buckets, RBUF_NONE, sizeof(_rbuf_buckets));
+    for (unsigned i = 0; i < RBUF_SIZE; i++) {
+        rbuf[i].next = (i + 1 < RBUF_SIZE) ? (i + 1) : RBUF_NONE;
+    }
+    _rbuf_free = 0;
+    _rbuf_heap_len = 0;
+    initialized = true;
+}
 
-    if (new == NULL) {
-        DEBUG("6lo rfrag: no space left in rbuf interval buffer.\n");
+static bool _rbuf_overlap_partially(rbuf_t *entry, uint16_t offset,
+                                    size_t frag_size, bool *dup)
+{
+    unsigned first = offset / 8;
+    unsigned last = (offset + frag_size - 1) / 8;
+    unsigned received = 0, starts = 0;
+
+    if (frag_size == 0) {
+        /* nothing to add */
+        *dup = true;
         return false;
     }
+    for (unsigned unit = first; unit <= last; unit++) {
+        if (bf_isset(entry->received, unit)) {
+            received++;
+        }
+        if ((unit > first) && bf_isset(entry->starts, unit)) {
+            starts++;
+        }
+    }
 
-    new->start = offset;
-    new->end = end;
+    *dup = false;
+    if (received == 0) {
+        return false;
+    }
+    /* identical if a fragment starts here, covers all units without another
+     * fragment starting in between and ends in the last unit, i.e. the unit
+     * after is not received or starts another fragment */
+    last++;
+    if (bf_isset(entry->starts, first) && (received == (last - first)) &&
+        (starts == 0) &&
+        ((last >= RBUF_UNITS) || !bf_isset(entry->received, last) ||
+         bf_isset(entry->starts, last))) {
+        DEBUG("6lo rfrag: fragment received already\n");
+        *dup = true;
+        return false;
+    }
+    return true;
+}
 
-    DEBUG("6lo rfrag: add interval (%" PRIu16 ", %" PRIu16 ") to entry (%s, ",
-          new->start, new->end, gnrc_netif_addr_to_str(entry->super.src,
-                                                       entry->super.src_len,
-                                                       l2addr_str));
+static void _rbuf_rem(rbuf_t *entry)
+{
+    uint8_t idx = entry - rbuf;
+    uint8_t *ptr = &_rbuf_buckets[entry->bucket];
+    unsigned pos = entry->heap_pos;
+
+    while (*ptr != idx) {
+        assert(*ptr != RBUF_NONE);
+        ptr = &rbuf[*ptr].next;
+    }
+    *ptr = entry->next;
+
+    _rbuf_heap_len--;
+    if (pos < _rbuf_heap_len) {
+        _rbuf_heap_set(pos, _rbuf_heap[_rbuf_heap_len]);
+        _rbuf_heap_fix(pos);
+    }
+
+    entry->next = _rbuf_free;
+    _rbuf_free = idx;
+    entry->super.pkt = NULL;
+}
+
+static void _rbuf_update_ints(rbuf_t *entry, uint16_t offset, size_t frag_size)
+{
+    unsigned last = (offset + frag_size - 1) / 8;
+
+    for (unsigned unit = offset / 8; unit <= last; unit++) {
+        bf_set(entry->received, unit);
+    }
+    bf_set(entry->starts, offset / 8);
+
+    DEBUG("6lo rfrag: add interval (%" PRIu16 ", %u) to entry (%s, ",
+          offset, (unsigned)(offset + frag_size - 1),
+          gnrc_netif_addr_to_str(entry->super.src, entry->super.src_len,
+                                 l2addr_str));
     DEBUG("%s, %u, %u)\n", gnrc_netif_addr_to_str(entry->super.dst,
                                                   entry->super.dst_len,
                                                   l2addr_str),
           (unsigned)entry->super.pkt->size, entry->super.tag);
-
-    LL_PREPEND(entry->ints, new);
-
-    return true;
 }
 
 void rbuf_gc(void)
 {
     uint32_t now_usec = xtimer_now_usec();
-    unsigned int i;
 
-    for (i = 0; i < RBUF_SIZE; i++) {
-        /* since pkt occupies pktbuf, aggressivly collect garbage */
-        if ((rbuf[i].super.pkt != NULL) &&
-              ((now_usec - rbuf[i].arrival) > RBUF_TIMEOUT)) {
-            DEBUG("6lo rfrag: entry (%s, ",
-                  gnrc_netif_addr_to_str(rbuf[i].super.src,
-                                         rbuf[i].super.src_len,
-                                         l2addr_str));
-            DEBUG("%s, %u, %u) timed out\n",
-                  gnrc_netif_addr_to_str(rbuf[i].super.dst,
-                                         rbuf[i].super.dst_len,
-                                         l2addr_str),
-                  (unsigned)rbuf[i].super.pkt->size, rbuf[i].super.tag);
+    _rbuf_init();
+    /* since pkt occupies pktbuf, aggressivly collect garbage */
+    while ((_rbuf_heap_len > 0) &&
+           ((now_usec - rbuf[_rbuf_heap[0]].arrival) > RBUF_TIMEOUT)) {
+        rbuf_t *entry = &rbuf[_rbuf_heap[0]];
 
-            gnrc_pktbuf_release(rbuf[i].super.pkt);
-            _rbuf_rem(&(rbuf[i]));
-        }
+        DEBUG("6lo rfrag: entry (%s, ",
+              gnrc_netif_addr_to_str(entry->super.src, entry->super.src_len,
+                                     l2addr_str));
+        DEBUG("%s, %u, %u) timed out\n",
+              gnrc_netif_addr_to_str(entry->super.dst, entry->super.dst_len,
+                                     l2addr_str),
+              (unsigned)entry->super.pkt->size, entry->super.tag);
+
+        gnrc_pktbuf_release(entry->super.pkt);
+        _rbuf_rem(entry);
     }
 }
 
@@ -277,16 +390,12 @@ static inline void _set_rbuf_timeout(void)
     xtimer_set_msg(&_gc_timer, RBUF_TIMEOUT, &_gc_timer_msg, sched_active_pid);
 }
 
-static rbuf_t *_rbuf_get(const void *src, size_t src_len,
-                         const void *dst, size_t dst_len,
-                         size_t size, uint16_t tag)
+static rbuf_t *_rbuf_find(unsigned bucket, const void *src, size_t src_len,
+                          const void *dst, size_t dst_len,
+                          size_t size, uint16_t tag)
 {
-    rbuf_t *res = NULL, *oldest = NULL;
-    uint32_t now_usec = xtimer_now_usec();
-
-    for (unsigned int i = 0; i < RBUF_SIZE; i++) {
-        /* check first if entry already available */
-        if ((rbuf[i].super.pkt != NULL) && (rbuf[i].super.pkt->size == size) &&
+    for (uint8_t i = _rbuf_buckets[bucket]; i != RBUF_NONE; i = rbuf[i].next) {
+        if ((rbuf[i].super.pkt->size == size) &&
             (rbuf[i].super.tag == tag) && (rbuf[i].super.src_len == src_len) &&
             (rbuf[i].super.dst_len == dst_len) &&
             (memcmp(rbuf[i].super.src, src, src_len) == 0) &&
@@ -300,36 +409,41 @@ static rbuf_t *_rbuf_get(const void *src, size_t src_len,
                                          rbuf[i].super.dst_len,
                                          l2addr_str),
                   (unsigned)rbuf[i].super.pkt->size, rbuf[i].super.tag);
-            rbuf[i].arrival = now_usec;
-            _set_rbuf_timeout();
             return &(rbuf[i]);
         }
+    }
+    return NULL;
+}
 
-        /* if there is a free spot: remember it */
-        if ((res == NULL) && (rbuf[i].super.pkt == NULL)) {
-            res = &(rbuf[i]);
-        }
+static rbuf_t *_rbuf_get(const void *src, size_t src_len,
+                         const void *dst, size_t dst_len,
+                         size_t size, uint16_t tag)
+{
+    rbuf_t *res;
+    unsigned bucket = _rbuf_hash(src, src_len, dst, dst_len, size, tag);
+    uint32_t now_usec = xtimer_now_usec();
 
-        /* remember oldest slot */
-        /* note that xtimer_now will overflow in ~1.2 hours */
-        if ((oldest == NULL) || (oldest->arrival - rbuf[i].arrival < UINT32_MAX / 2)) {
-            oldest = &(rbuf[i]);
-        }
+    /* check first if entry already available */
+    if ((res = _rbuf_find(bucket, src, src_len, dst, dst_len,
+                          size, tag)) != NULL) {
+        res->arrival = now_usec;
+        _rbuf_heap_fix(res->heap_pos);
+        _set_rbuf_timeout();
+        return res;
     }
 
     /* entry not in buffer and no empty spot found */
-    if (res == NULL) {
-        assert(oldest != NULL);
-        /* if oldest->pkt == NULL, res must not be NULL */
-        assert(oldest->super.pkt != NULL);
+    if (_rbuf_free == RBUF_NONE) {
+        /* the oldest entry is the root of the heap */
+        rbuf_t *oldest = &rbuf[_rbuf_heap[0]];
+
         DEBUG("6lo rfrag: reassembly buffer full, remove oldest entry\n");
         gnrc_pktbuf_release(oldest->super.pkt);
         _rbuf_rem(oldest);
-        res = oldest;
     }
 
     /* now we have an empty spot */
-
+    res = &rbuf[_rbuf_free];
     res->super.pkt = gnrc_pktbuf_add(NULL, NULL, size, GNRC_NETTYPE_IPV6);
     if (res->super.pkt == NULL) {
         DEBUG("6lo rfrag: can not allocate reassembly buffer space.\n");
@@ -345,6 +459,15 @@ static rbuf_t *_rbuf_get(const void *src, size_t src_len,
     res->super.dst_len = dst_len;
     res->super.tag = tag;
     res->super.current_size = 0;
+    memset(res->received, 0, sizeof(res->received));
+    memset(res->starts, 0, sizeof(res->starts));
+
+    _rbuf_free = res->next;
+    res->bucket = bucket;
+    res->next = _rbuf_buckets[bucket];
+    _rbuf_buckets[bucket] = res - rbuf;
+    _rbuf_heap_set(_rbuf_heap_len++, res - rbuf);
+    _rbuf_heap_fix(res->heap_pos);
 
     DEBUG("6lo rfrag: entry %p (%s, ", (void *)res,
           gnrc_netif_addr_to_str(res->super.src, res->super.src_len,
@@ -20,51 +20,65 @@
 #define RBUF_H
 
 #include <inttypes.h>
+#include <stdbool.h>
 
+#include "bitfield.h"
 #include "net/gnrc/netif/hdr.h"
 #include "net/gnrc/pkt.h"
 
 #include "net/gnrc/sixlowpan/frag.h"
-#ifdef __cplusplus
+#include "net/sixlowpan.h"
 
+#ifdef __cplusplus
 extern "C" {
 #endif
 
-#define RBUF_SIZE           (4U)               /**< size of the reassembly buffer */
+#ifndef RBUF_SIZE
+#define RBUF_SIZE           (4U)               /**< size of the reassembly buffer, < 255 */
+#endif
 #define RBUF_TIMEOUT        (3U * US_PER_SEC) /**< timeout for reassembly in microseconds */
 
 /**
- * @brief   Fragment intervals to identify limits of fragments.
- *
- * @note    Fragments MUST NOT overlap and overlapping fragments are to be
- *          discarded
- *
- * @see <a href="https://tools.ietf.org/html/rfc4944#section-5.3">
- *          RFC 4944, section 5.3
- *      </a>
- *
- * @internal
+ * @brief   Number of buckets of the hash table to look up reassembly buffer
+ *          entries
+ */
+#ifndef RBUF_HASH_NUMOF
+#define RBUF_HASH_NUMOF     (RBUF_SIZE)
+#endif
+
+/**
+ * @brief   Number of 8-octet units of the largest datagram
  */
-typedef struct rbuf_int {
-    struct rbuf_int *next;  /**< next element in interval list */
-    uint16_t start;         /**< start byte of interval */
-    uint16_t end;           /**< end byte of interval */
-} rbuf_int_t;
+#define RBUF_UNITS          ((SIXLOWPAN_FRAG_MAX_LEN + 7) / 8)
 
 /**
  * @brief   Internal representation of the 6LoWPAN reassembly buffer.
  *
  * Additional members help with correct reassembly of the buffer.
  *
+ * Received fragments are tracked in 8-octet units, the unit of fragment
+ * offsets. Fragments MUST NOT overlap and overlapping fragments are to be
+ * discarded, a fragment is identical to a received one if it starts where
+ * the received one starts and covers all of its units.
+ *
+ * @see <a href="https://tools.ietf.org/html/rfc4944#section-5.3">
+ *          RFC 4944, section 5.3
+ *      </a>
+ *
  * @internal
  *
  * @extends gnrc_sixlowpan_rbuf_t
  */
 typedef struct {
     gnrc_sixlowpan_rbuf_t super;        /**< exposed part of the reassembly buffer */
-    rbuf_int_t *ints;                   /**< intervals of the fragment */
     uint32_t arrival;                   /**< time in microseconds of arrival of
                                          *   last received fragment */
+    BITFIELD(received, RBUF_UNITS);     /**< units received */
+    BITFIELD(starts, RBUF_UNITS);       /**< units a received fragment starts in */
+    uint8_t next;                       /**< next entry in hash bucket or in
+                                         *   free list */
+    uint8_t bucket;                     /**< hash bucket */
+    uint8_t heap_pos;                   /**< position in expiry heap */
 } rbuf_t;
 
 /**
@@ -84,6 +98,22 @@ typedef struct {
 void rbuf_add(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *frag,
               size_t frag_size, size_t offset);
 
+/**
+ * @brief   Checks whether fragments of a datagram are being reassembled
+ *
+ * @param[in] netif_hdr     The interface header of a fragment of the
+ *                          datagram, with its source and destination address
+ *                          set.
+ * @param[in] size          The datagram's size.
+ * @param[in] tag           The datagram's tag.
+ *
+ * @return  true, if the reassembly buffer has an entry for the datagram.
+ * @return  false, if it has none.
+ *
+ * @internal
+ */
+bool rbuf_exists(gnrc_netif_hdr_t *netif_hdr, size_t size, uint16_t tag);
+
 /**
  * @brief   Checks timeouts and removes entries if necessary
  */
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+
+#ifdef MODULE_GNRC_SIXLOWPAN_FRAG_VRB
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "vrb.h"
+#include "net/ipv6/addr.h"
+#include "net/ipv6/hdr.h"
+#include "net/gnrc/ipv6/nib.h"
+#include "net/gnrc/netif/internal.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/sixlowpan/frag.h"
+#include "net/gnrc/sixlowpan/internal.h"
+#include "net/gnrc/sixlowpan/iphc.h"
+#include "net/sixlowpan.h"
+#include "net/udp.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+static vrb_t vrb[VRB_SIZE];
+static gnrc_sixlowpan_frag_vrb_stats_t _stats;
+
+static char l2addr_str[3 * IEEE802154_LONG_ADDRESS_LEN];
+
+/* ------------------------------------
+ * internal function definitions
+ * ------------------------------------*/
+/* gets the entry of a datagram, NULL if there is none */
+static vrb_t *_vrb_get(const uint8_t *src, size_t src_len,
+                       uint16_t datagram_size, uint16_t tag);
+/* adds an entry, replaces the oldest one if the buffer is full */
+static vrb_t *_vrb_add(gnrc_netif_hdr_t *netif_hdr,
+                       uint16_t datagram_size, uint16_t tag,
+                       gnrc_netif_t *out_netif,
+                       const gnrc_ipv6_nib_nc_t *next_hop);
+/* checks whether the fragment overlaps forwarded fragments */
+static bool _vrb_overlap(vrb_t *entry, uint16_t offset, size_t frag_size);
+/* accounts forwarded units, removes the entry with the last of them */
+static void _vrb_sent(vrb_t *entry, uint16_t offset, size_t frag_size);
+/* sends a first fragment on with a header compressed for the next hop */
+static bool _forward_first(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
+                           size_t frag_size, uint16_t datagram_size,
+                           uint16_t tag);
+/* sends a subsequent fragment on */
+static void _forward_nth(vrb_t *entry, gnrc_pktsnip_t *pkt, size_t frag_size,
+                         uint16_t offset);
+
+bool vrb_forward(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
+                 size_t frag_size, uint16_t offset)
+{
+    sixlowpan_frag_t *frag = pkt->data;
+    uint16_t datagram_size = byteorder_ntohs(frag->disp_size) &
+                             SIXLOWPAN_FRAG_SIZE_MASK;
+    uint16_t tag = byteorder_ntohs(frag->tag);
+    vrb_t *entry;
+
+    vrb_gc();
+    entry = _vrb_get(gnrc_netif_hdr_get_src_addr(netif_hdr),
+                     netif_hdr->src_l2addr_len, datagram_size, tag);
+    if (entry == NULL) {
+        if (offset != 0) {
+            /* only the first fragment can tell where the datagram goes */
+            return false;
+        }
+        if (rbuf_exists(netif_hdr, datagram_size, tag)) {
+            DEBUG("6lo vrb: subsequent fragments came first, reassemble "
+                  "datagram\n");
+            return false;
+        }
+        return _forward_first(netif_hdr, pkt, frag_size, datagram_size, tag);
+    }
+    if (offset == 0) {
+        DEBUG("6lo vrb: first fragment was forwarded already\n");
+        gnrc_pktbuf_release(pkt);
+        _stats.duplicates++;
+        return true;
+    }
+    _forward_nth(entry, pkt, frag_size, offset);
+    return true;
+}
+
+void vrb_gc(void)
+{
+    uint32_t now_usec = xtimer_now_usec();
+
+    for (unsigned i = 0; i < VRB_SIZE; i++) {
+        if ((vrb[i].datagram_size != 0) &&
+            ((now_usec - vrb[i].arrival) > VRB_TIMEOUT)) {
+            DEBUG("6lo vrb: entry (%s, %u, %u) timed out\n",
+                  gnrc_netif_addr_to_str(vrb[i].src, vrb[i].src_len,
+                                         l2addr_str),
+                  vrb[i].datagram_size, vrb[i].tag);
+            vrb[i].datagram_size = 0;
+            _stats.timeouts++;
+        }
+    }
+}
+
+void gnrc_sixlowpan_frag_vrb_get_stats(gnrc_sixlowpan_frag_vrb_stats_t *stats)
+{
+    *stats = _stats;
+}
+
+static vrb_t *_vrb_get(const uint8_t *src, size_t src_len,
+                       uint16_t datagram_size, uint16_t tag)
+{
+    for (unsigned i = 0; i < VRB_SIZE; i++) {
+        if ((vrb[i].datagram_size == datagram_size) &&
+            (vrb[i].tag == tag) && (vrb[i].src_len == src_len) &&
+            (memcmp(vrb[i].src, src, src_len) == 0)) {
+            return &vrb[i];
+        }
+    }
+    return NULL;
+}
+
+static vrb_t *_vrb_add(gnrc_netif_hdr_t *netif_hdr,
+                       uint16_t datagram_size, uint16_t tag,
+                       gnrc_netif_t *out_netif,
+                       const gnrc_ipv6_nib_nc_t *next_hop)
+{
+    vrb_t *entry = NULL;
+
+    for (unsigned i = 0; i < VRB_SIZE; i++) {
+        if (vrb[i].datagram_size == 0) {
+            entry = &vrb[i];
+            break;
+        }
+        if ((entry == NULL) ||
+            ((int32_t)(vrb[i].arrival - entry->arrival) < 0)) {
+            entry = &vrb[i];
+        }
+    }
+    if (entry->datagram_size != 0) {
+        DEBUG("6lo vrb: buffer full, remove oldest entry\n");
+        _stats.evictions++;
+    }
+
+    memcpy(entry->src, gnrc_netif_hdr_get_src_addr(netif_hdr),
+           netif_hdr->src_l2addr_len);
+    entry->src_len = netif_hdr->src_l2addr_len;
+    memcpy(entry->out_dst, next_hop->l2addr, next_hop->l2addr_len);
+    entry->out_dst_len = next_hop->l2addr_len;
+    entry->out_netif = out_netif;
+    entry->arrival = xtimer_now_usec();
+    entry->datagram_size = datagram_size;
+    entry->tag = tag;
+    entry->out_tag = gnrc_sixlowpan_frag_next_tag();
+    entry->remaining = datagram_size;
+    memset(entry->forwarded, 0, sizeof(entry->forwarded));
+
+    return entry;
+}
+
+static bool _vrb_overlap(vrb_t *entry, uint16_t offset, size_t frag_size)
+{
+    unsigned last = (offset + frag_size - 1) / 8;
+
+    for (unsigned unit = offset / 8; unit <= last; unit++) {
+        if (bf_isset(entry->forwarded, unit)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _vrb_sent(vrb_t *entry, uint16_t offset, size_t frag_size)
+{
+    unsigned last = (offset + frag_size - 1) / 8;
+
+    for (unsigned unit = offset / 8; unit <= last; unit++) {
+        bf_set(entry->forwarded, unit);
+    }
+    entry->arrival = xtimer_now_usec();
+    if (frag_size >= entry->remaining) {
+        DEBUG("6lo vrb: datagram (%s, %u, %u) forwarded\n",
+              gnrc_netif_addr_to_str(entry->src, entry->src_len, l2addr_str),
+              entry->datagram_size, entry->tag);
+        entry->datagram_size = 0;
+    }
+    else {
+        entry->remaining -= frag_size;
+    }
+    _stats.fragments++;
+}
+
+static gnrc_pktsnip_t *_build_netif_hdr(gnrc_netif_t *netif,
+                                        uint8_t *dst, size_t dst_len)
+{
+    gnrc_pktsnip_t *netif_snip = gnrc_netif_hdr_build(NULL, 0, dst, dst_len);
+
+    if (netif_snip != NULL) {
+        ((gnrc_netif_hdr_t *)netif_snip->data)->if_pid = netif->pid;
+    }
+    return netif_snip;
+}
+
+static bool _forward_first(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
+                           size_t frag_size, uint16_t datagram_size,
+                           uint16_t tag)
+{
+    uint8_t *data = ((uint8_t *)pkt->data) + sizeof(sixlowpan_frag_t);
+    gnrc_netif_t *in_netif = gnrc_netif_get_by_pid(netif_hdr->if_pid);
+    gnrc_netif_t *out_netif;
+    gnrc_pktsnip_t *ipv6, *payload, *netif, *frag;
+    gnrc_ipv6_nib_nc_t nce;
+    ipv6_hdr_t *ipv6_hdr;
+    sixlowpan_frag_t *frag_hdr;
+    size_t iphc_len, nh_len = 0, payload_len;
+    vrb_t *entry;
+
+    if ((in_netif == NULL) || !gnrc_netif_is_rtr(in_netif) ||
+        !sixlowpan_iphc_is(data)) {
+        return false;
+    }
+
+    /* large enough for the IPv6 header and a compressed UDP header */
+    ipv6 = gnrc_pktbuf_add(NULL, NULL, sizeof(ipv6_hdr_t) + sizeof(udp_hdr_t),
+                           GNRC_NETTYPE_IPV6);
+    if (ipv6 == NULL) {
+        DEBUG("6lo vrb: can not allocate IPv6 header\n");
+        return false;
+    }
+    memset(ipv6->data, 0, ipv6->size);
+    iphc_len = gnrc_sixlowpan_iphc_decode(&ipv6, pkt, datagram_size,
+                                          sizeof(sixlowpan_frag_t), &nh_len);
+    if ((iphc_len == 0) || (iphc_len > frag_size)) {
+        gnrc_pktbuf_release(ipv6);
+        return false;
+    }
+    ipv6_hdr = ipv6->data;
+    if (ipv6_addr_is_multicast(&ipv6_hdr->dst) ||
+        ipv6_addr_is_link_local(&ipv6_hdr->dst) || (ipv6_hdr->hl <= 1) ||
+        (gnrc_netif_get_by_ipv6_addr(&ipv6_hdr->dst) != NULL)) {
+        /* datagram is for this node or needs the IPv6 layer */
+        gnrc_pktbuf_release(ipv6);
+        return false;
+    }
+    if ((gnrc_ipv6_nib_get_next_hop_l2addr(&ipv6_hdr->dst, NULL, NULL,
+                                           &nce) < 0) ||
+        ((out_netif = gnrc_netif_get_by_pid(gnrc_ipv6_nib_nc_get_iface(&nce))) == NULL) ||
+        !gnrc_netif_is_6ln(out_netif) || (out_netif->sixlo.max_frag_size == 0)) {
+        DEBUG("6lo vrb: no 6LoWPAN next hop, reassemble datagram\n");
+        gnrc_pktbuf_release(ipv6);
+        _stats.fallbacks++;
+        return false;
+    }
+
+    /* decoded next header goes in front of the payload and is compressed
+     * again with the IPv6 header */
+    payload_len = frag_size - iphc_len;
+    if ((nh_len + payload_len) == 0) {
+        gnrc_pktbuf_release(ipv6);
+        return false;
+    }
+    payload = gnrc_pktbuf_add(NULL, NULL, nh_len + payload_len,
+                              GNRC_NETTYPE_UNDEF);
+    if (payload == NULL) {
+        DEBUG("6lo vrb: can not allocate payload\n");
+        gnrc_pktbuf_release(ipv6);
+        return false;
+    }
+    memcpy(payload->data, ipv6_hdr + 1, nh_len);
+    memcpy(((uint8_t *)payload->data) + nh_len, data + iphc_len, payload_len);
+    gnrc_pktbuf_realloc_data(ipv6, sizeof(ipv6_hdr_t));
+    ipv6_hdr = ipv6->data;
+    ipv6_hdr->hl--;
+    ipv6->next = payload;
+
+    if ((netif = _build_netif_hdr(out_netif, nce.l2addr,
+                                  nce.l2addr_len)) == NULL) {
+        DEBUG("6lo vrb: can not allocate netif header\n");
+        gnrc_pktbuf_release(ipv6);
+        return false;
+    }
+    netif->next = ipv6;
+    if (!gnrc_sixlowpan_iphc_encode(netif)) {
+        gnrc_pktbuf_release(netif);
+        return false;
+    }
+    if ((sizeof(sixlowpan_frag_t) + gnrc_pkt_len(netif->next)) >
+        out_netif->sixlo.max_frag_size) {
+        DEBUG("6lo vrb: first fragment grew too big, reassemble datagram\n");
+        gnrc_pktbuf_release(netif);
+        _stats.fallbacks++;
+        return false;
+    }
+    frag = gnrc_pktbuf_add(netif->next, NULL, sizeof(sixlowpan_frag_t),
+                           GNRC_NETTYPE_SIXLOWPAN);
+    if (frag == NULL) {
+        DEBUG("6lo vrb: can not allocate fragment header\n");
+        gnrc_pktbuf_release(netif);
+        return false;
+    }
+    netif->next = frag;
+
+    entry = _vrb_add(netif_hdr, datagram_size, tag, out_netif, &nce);
+    frag_hdr = frag->data;
+    frag_hdr->disp_size = byteorder_htons(datagram_size);
+    frag_hdr->disp_size.u8[0] |= SIXLOWPAN_FRAG_1_DISP;
+    frag_hdr->tag = byteorder_htons(entry->out_tag);
+
+    DEBUG("6lo vrb: forward datagram (%s, %u, %u) ",
+          gnrc_netif_addr_to_str(entry->src, entry->src_len, l2addr_str),
+          datagram_size, tag);
+    DEBUG("to %s with tag %u\n",
+          gnrc_netif_addr_to_str(entry->out_dst, entry->out_dst_len,
+                                 l2addr_str), entry->out_tag);
+    _stats.datagrams++;
+    /* first fragment covers the uncompressed headers */
+    _vrb_sent(entry, 0, sizeof(ipv6_hdr_t) + nh_len + payload_len);
+    gnrc_sixlowpan_dispatch_send(netif, NULL, 0);
+    gnrc_pktbuf_release(pkt);
+
+    return true;
+}
+
+static void _forward_nth(vrb_t *entry, gnrc_pktsnip_t *pkt, size_t frag_size,
+                         uint16_t offset)
+{
+    gnrc_netif_t *out_netif = entry->out_netif;
+    gnrc_pktsnip_t *netif, *frag;
+    sixlowpan_frag_n_t *frag_hdr;
+
+    if ((frag_size == 0) || ((offset + frag_size) > entry->datagram_size)) {
+        DEBUG("6lo vrb: fragment outside of datagram\n");
+        gnrc_pktbuf_release(pkt);
+        return;
+    }
+    if (_vrb_overlap(entry, offset, frag_size)) {
+        DEBUG("6lo vrb: fragment (%u, %u) forwarded already\n",
+              offset, (unsigned)frag_size);
+        gnrc_pktbuf_release(pkt);
+        _stats.duplicates++;
+        return;
+    }
+    if (pkt->size > out_netif->sixlo.max_frag_size) {
+        DEBUG("6lo vrb: fragment too big for next hop\n");
+        gnrc_pktbuf_release(pkt);
+        return;
+    }
+    if ((netif = _build_netif_hdr(out_netif, entry->out_dst,
+                                  entry->out_dst_len)) == NULL) {
+        DEBUG("6lo vrb: can not allocate netif header\n");
+        gnrc_pktbuf_release(pkt);
+        return;
+    }
+    /* the fragment is sent as is, only with the netif header and tag of the
+     * next hop */
+    frag = gnrc_pktbuf_start_write(pkt);
+    if (frag == NULL) {
+        DEBUG("6lo vrb: can not get write access on fragment\n");
+        gnrc_pktbuf_release(netif);
+        gnrc_pktbuf_release(pkt);
+        return;
+    }
+    pkt = gnrc_pktbuf_remove_snip(frag, frag->next);
+    frag_hdr = pkt->data;
+    frag_hdr->tag = byteorder_htons(entry->out_tag);
+    netif->next = pkt;
+
+    _vrb_sent(entry, offset, frag_size);
+    gnrc_sixlowpan_dispatch_send(netif, NULL, 0);
+}
+
+#else  /* MODULE_GNRC_SIXLOWPAN_FRAG_VRB */
+typedef int dont_be_pedantic;
+#endif /* MODULE_GNRC_SIXLOWPAN_FRAG_VRB */
+
+/** @} */
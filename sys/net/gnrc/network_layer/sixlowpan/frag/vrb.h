@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_gnrc_sixlowpan_frag
+ * @{
+ *
+ * @file
+ * @internal
+ * @brief   6LoWPAN virtual reassembly buffer for fragment forwarding
+ *
+ * @see <a href="https://tools.ietf.org/html/draft-ietf-lwig-6lowpan-virtual-reassembly-00">
+ *          draft-ietf-lwig-6lowpan-virtual-reassembly-00
+ *      </a>
+ */
+#ifndef VRB_H
+#define VRB_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "net/gnrc/netif.h"
+#include "net/gnrc/netif/hdr.h"
+#include "net/gnrc/pkt.h"
+#include "net/ieee802154.h"
+
+#include "rbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef VRB_SIZE
+#define VRB_SIZE            (16U)           /**< size of the virtual reassembly buffer */
+#endif
+#define VRB_TIMEOUT         (RBUF_TIMEOUT)  /**< timeout for forwarding in microseconds */
+
+/**
+ * @brief   Entry of the virtual reassembly buffer
+ *
+ * A datagram is identified by the link-layer source address of the previous
+ * hop, its datagram size and its datagram tag. The destination address is
+ * always this node.
+ *
+ * Forwarded fragments are tracked in 8-octet units like in the reassembly
+ * buffer, so duplicates are dropped instead of being counted twice.
+ *
+ * @internal
+ */
+typedef struct {
+    uint8_t src[IEEE802154_LONG_ADDRESS_LEN];       /**< source address of
+                                                     *   the previous hop */
+    uint8_t out_dst[IEEE802154_LONG_ADDRESS_LEN];   /**< address of the
+                                                     *   next hop */
+    gnrc_netif_t *out_netif;                        /**< interface to the
+                                                     *   next hop */
+    uint32_t arrival;               /**< time in microseconds of arrival of
+                                     *   last forwarded fragment */
+    BITFIELD(forwarded, RBUF_UNITS);    /**< units forwarded */
+    uint16_t datagram_size;         /**< the datagram's size, 0 if unused */
+    uint16_t tag;                   /**< the datagram's tag from the previous
+                                     *   hop */
+    uint16_t out_tag;               /**< the datagram's tag towards the next
+                                     *   hop */
+    uint16_t remaining;             /**< bytes of the datagram that were not
+                                     *   forwarded yet */
+    uint8_t src_len;                /**< length of vrb_t::src */
+    uint8_t out_dst_len;            /**< length of vrb_t::out_dst */
+} vrb_t;
+
+/**
+ * @brief   Forwards a fragment if it belongs to a datagram for another node
+ *
+ * A first fragment creates a new entry if the datagram can be routed over a
+ * 6LoWPAN interface and its first fragment still fits into a frame after
+ * compressing the header for the next hop. Subsequent fragments are
+ * forwarded if an entry for their datagram exists, so a datagram whose
+ * subsequent fragments arrived first stays in the reassembly buffer.
+ *
+ * @param[in] netif_hdr     The interface header of the fragment.
+ * @param[in] pkt           The fragment, released if it was forwarded.
+ * @param[in] frag_size     The fragment's size.
+ * @param[in] offset        The fragment's offset.
+ *
+ * @return  true, if the fragment was forwarded.
+ * @return  false, if the fragment has to be reassembled.
+ *
+ * @internal
+ */
+bool vrb_forward(gnrc_netif_hdr_t *netif_hdr, gnrc_pktsnip_t *pkt,
+                 size_t frag_size, uint16_t offset);
+
+/**
+ * @brief   Removes timed out entries
+ */
+void vrb_gc(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VRB_H */
+/** @} */
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <sys/types.h>
 
+#include "bitarithm.h"
 #include "mutex.h"
 #include "od.h"
 #include "utlist.h"
@@ -42,7 +43,48 @@ typedef struct _unused {
 
 static mutex_t _mutex = MUTEX_INIT;
 static uint8_t _pktbuf[GNRC_PKTBUF_SIZE];
+
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+/*
+ * Segregated free lists: the buffer is managed in granules of
+ * sizeof(_unused_t) bytes. A free chunk carries a _seg_chunk_t header in its
+ * first granule and its size in the last two bytes of its last granule,
+ * allocated chunks carry nothing. Free chunks are listed by size class, four
+ * classes per power of two, and bitmaps mark the non-empty classes, so a
+ * fitting chunk is found in constant time. _seg_edge marks the first and the
+ * last granule of every free chunk, so a freed chunk finds free neighbors to
+ * merge with in constant time as well.
+ */
+#define _SEG_GRANULES       (GNRC_PKTBUF_SIZE / sizeof(_unused_t))
+#define _SEG_NONE           (UINT16_MAX)
+#define _SEG_SL_BITS        (2U)
+#define _SEG_SL_NUMOF       (1U << _SEG_SL_BITS)
+#define _SEG_FL_NUMOF       (16U)
+
+typedef struct {
+    uint16_t next;          /* next free chunk in the class */
+    uint16_t prev;          /* previous free chunk in the class */
+    uint16_t size;          /* size in granules */
+} _seg_chunk_t;
+
+/* granule indices fit 16 bit, header and footer of a free chunk one granule */
+static_assert((_SEG_GRANULES < _SEG_NONE) &&
+              ((sizeof(_seg_chunk_t) + sizeof(uint16_t)) <= sizeof(_unused_t)),
+              "GNRC_PKTBUF_SIZE too large for gnrc_pktbuf_static_seg");
+
+static uint16_t _seg_heads[_SEG_FL_NUMOF][_SEG_SL_NUMOF];
+static uint16_t _seg_fl_map;
+static uint8_t _seg_sl_map[_SEG_FL_NUMOF];
+static uint8_t _seg_edge[(_SEG_GRANULES + 7) / 8];
+#else
 static _unused_t *_first_unused;
+#endif
+
+/* number of bytes allocated now and at most */
+static size_t _used_bytes;
+static size_t _max_used_bytes;
+/* allocations that failed although enough bytes were free */
+static unsigned _frag_fails;
 
 #ifdef DEVELHELP
 /* maximum number of bytes allocated */
@@ -54,6 +96,10 @@ static gnrc_pktsnip_t *_create_snip(gnrc_pktsnip_t *next, const void *data, size
                                     gnrc_nettype_t type);
 static void *_pktbuf_alloc(size_t size);
 static void _pktbuf_free(void *data, size_t size);
+static size_t _largest_free(void);
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+static void _seg_init(void);
+#endif
 
 static inline bool _pktbuf_contains(void *ptr)
 {
@@ -66,6 +112,50 @@ static inline size_t _align(size_t size)
     return (size + _ALIGNMENT_MASK) & ~(_ALIGNMENT_MASK);
 }
 
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+static inline _seg_chunk_t *_seg_chunk(unsigned idx)
+{
+    return (_seg_chunk_t *)&_pktbuf[idx * sizeof(_unused_t)];
+}
+
+/* size field in the last granule of the chunk ending before granule end */
+static inline uint16_t *_seg_footer(unsigned end)
+{
+    return (uint16_t *)&_pktbuf[(end * sizeof(_unused_t)) - sizeof(uint16_t)];
+}
+
+static inline bool _seg_is_edge(unsigned idx)
+{
+    return (_seg_edge[idx >> 3] & (1U << (idx & 7))) != 0;
+}
+
+static inline void _seg_set_edge(unsigned idx)
+{
+    _seg_edge[idx >> 3] |= (1U << (idx & 7));
+}
+
+static inline void _seg_clear_edge(unsigned idx)
+{
+    _seg_edge[idx >> 3] &= ~(1U << (idx & 7));
+}
+
+/* sizes below _SEG_SL_NUMOF granules have a class of their own, larger ones
+ * share one of _SEG_SL_NUMOF classes per power of two */
+static inline void _seg_class(unsigned size, unsigned *fl, unsigned *sl)
+{
+    if (size < _SEG_SL_NUMOF) {
+        *fl = 0;
+        *sl = size;
+    }
+    else {
+        unsigned msb = bitarithm_msb(size);
+
+        *fl = msb - _SEG_SL_BITS + 1;
+        *sl = (size >> (msb - _SEG_SL_BITS)) & (_SEG_SL_NUMOF - 1);
+    }
+}
+#endif
+
 static inline void _set_pktsnip(gnrc_pktsnip_t *pkt, gnrc_pktsnip_t *next,
                                 void *data, size_t size, gnrc_nettype_t type)
 {
@@ -79,12 +169,42 @@ static inline void _set_pktsnip(gnrc_pktsnip_t *pkt, gnrc_pktsnip_t *next,
 #endif
 }
 
+static inline void _account_alloc(void *data, size_t size)
+{
+    _used_bytes += size;
+    if (_used_bytes > _max_used_bytes) {
+        _max_used_bytes = _used_bytes;
+    }
+#ifdef DEVELHELP
+    uint16_t last_byte = (uint16_t)((((uint8_t *)data) + size) - &(_pktbuf[0]));
+    if (last_byte > max_byte_count) {
+        max_byte_count = last_byte;
+    }
+#else
+    (void)data;
+#endif
+}
+
+static inline void _account_fail(size_t size)
+{
+    if (size <= (sizeof(_pktbuf) - _used_bytes)) {
+        _frag_fails++;
+    }
+}
+
 void gnrc_pktbuf_init(void)
 {
     mutex_lock(&_mutex);
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+    _seg_init();
+#else
     _first_unused = (_unused_t *)_pktbuf;
     _first_unused->next = NULL;
     _first_unused->size = sizeof(_pktbuf);
+#endif
+    _used_bytes = 0;
+    _max_used_bytes = 0;
+    _frag_fails = 0;
     mutex_unlock(&_mutex);
 }
 
@@ -275,23 +395,56 @@ static inline void _print_chunk(void *chunk, size_t size, int num)
     od_hex_dump(chunk, size, OD_WIDTH_DEFAULT);
 }
 
+#ifndef MODULE_GNRC_PKTBUF_STATIC_SEG
 static inline void _print_unused(_unused_t *ptr)
 {
     printf("~ unused: %p (next: %p, size: %4u) ~\n", (void *)ptr,
            (void *)ptr->next, ptr->size);
 }
 #endif
+#endif
 
 void gnrc_pktbuf_stats(void)
 {
+    gnrc_pktbuf_usage_t usage;
+
+    gnrc_pktbuf_get_usage(&usage);
+    printf("packet buffer: used: %u, max. used: %u, largest free chunk: %u, "
+           "failed due to fragmentation: %u\n", (unsigned)usage.used,
+           (unsigned)usage.max_used, (unsigned)usage.largest_free,
+           usage.frag_fails);
 #ifdef MODULE_OD
-    _unused_t *ptr = _first_unused;
     uint8_t *chunk = &_pktbuf[0];
     int count = 0;
 
     printf("packet buffer: first byte: %p, last byte: %p (size: %u)\n",
            (void *)&_pktbuf[0], (void *)&_pktbuf[GNRC_PKTBUF_SIZE], GNRC_PKTBUF_SIZE);
     printf("  position of last byte used: %" PRIu16 "\n", max_byte_count);
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+    for (unsigned idx = 0; idx < _SEG_GRANULES;) {
+        if (_seg_is_edge(idx)) {
+            uint8_t *ptr = &_pktbuf[idx * sizeof(_unused_t)];
+            unsigned size = _seg_chunk(idx)->size;
+
+            if (ptr > chunk) {
+                _print_chunk(chunk, ptr - chunk, count++);
+            }
+            printf("~ unused: %p (size: %4u) ~\n", (void *)ptr,
+                   (unsigned)(size * sizeof(_unused_t)));
+            idx += size;
+            chunk = &_pktbuf[idx * sizeof(_unused_t)];
+        }
+        else {
+            idx++;
+        }
+    }
+    if (chunk < &_pktbuf[_SEG_GRANULES * sizeof(_unused_t)]) {
+        _print_chunk(chunk, &_pktbuf[_SEG_GRANULES * sizeof(_unused_t)] - chunk,
+                     count);
+    }
+#else
+    _unused_t *ptr = _first_unused;
+
     if (ptr == NULL) {  /* packet buffer is completely full */
         _print_chunk(chunk, GNRC_PKTBUF_SIZE, count++);
     }
@@ -318,13 +471,96 @@ void gnrc_pktbuf_stats(void)
     if (chunk <= &_pktbuf[GNRC_PKTBUF_SIZE - 1]) {
         _print_chunk(chunk, &_pktbuf[GNRC_PKTBUF_SIZE] - chunk, count);
     }
+#endif
 #else
     DEBUG("pktbuf: needs od module\n");
 #endif
 }
 #endif
 
+void gnrc_pktbuf_get_usage(gnrc_pktbuf_usage_t *usage)
+{
+    mutex_lock(&_mutex);
+    usage->used = _used_bytes;
+    usage->max_used = _max_used_bytes;
+    usage->largest_free = _largest_free();
+    usage->frag_fails = _frag_fails;
+    mutex_unlock(&_mutex);
+}
+
 #ifdef TEST_SUITES
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+bool gnrc_pktbuf_is_empty(void)
+{
+    return _seg_is_edge(0) && (_seg_chunk(0)->size == _SEG_GRANULES);
+}
+
+bool gnrc_pktbuf_is_sane(void)
+{
+    unsigned chunks = 0;
+    bool prev_free = false;
+
+    /* Invariants of this implementation:
+     *  - edges of free chunks are marked, footers match headers
+     *  - free chunks are never adjacent to each other
+     *  - every free chunk is in the list of its size class, and only there
+     *  - a class is marked in the bitmaps if and only if its list is not empty
+     */
+    for (unsigned idx = 0; idx < _SEG_GRANULES;) {
+        if (!_seg_is_edge(idx)) {
+            prev_free = false;
+            idx++;
+            continue;
+        }
+
+        unsigned size = _seg_chunk(idx)->size;
+
+        if (prev_free || (size == 0) || ((idx + size) > _SEG_GRANULES) ||
+            (*_seg_footer(idx + size) != size) ||
+            !_seg_is_edge(idx + size - 1)) {
+            return false;
+        }
+        for (unsigned i = idx + 1; i < (idx + size - 1); i++) {
+            if (_seg_is_edge(i)) {
+                return false;
+            }
+        }
+        chunks++;
+        prev_free = true;
+        idx += size;
+    }
+
+    for (unsigned fl = 0; fl < _SEG_FL_NUMOF; fl++) {
+        if (((_seg_fl_map & (1U << fl)) != 0) != (_seg_sl_map[fl] != 0)) {
+            return false;
+        }
+        for (unsigned sl = 0; sl < _SEG_SL_NUMOF; sl++) {
+            uint16_t prev = _SEG_NONE;
+
+            if (((_seg_sl_map[fl] & (1U << sl)) != 0) !=
+                (_seg_heads[fl][sl] != _SEG_NONE)) {
+                return false;
+            }
+            for (uint16_t idx = _seg_heads[fl][sl]; idx != _SEG_NONE;
+                 idx = _seg_chunk(idx)->next) {
+                _seg_chunk_t *chunk = _seg_chunk(idx);
+                unsigned cfl, csl;
+
+                _seg_class(chunk->size, &cfl, &csl);
+                if ((chunks == 0) || (idx >= _SEG_GRANULES) ||
+                    !_seg_is_edge(idx) || (chunk->prev != prev) ||
+                    (cfl != fl) || (csl != sl)) {
+                    return false;
+                }
+                chunks--;
+                prev = idx;
+            }
+        }
+    }
+
+    return (chunks == 0);
+}
+#else
 bool gnrc_pktbuf_is_empty(void)
 {
     return (_first_unused == (_unused_t *)_pktbuf) &&
@@ -362,6 +598,7 @@ bool gnrc_pktbuf_is_sane(void)
     return true;
 }
 #endif
+#endif
 
 static gnrc_pktsnip_t *_create_snip(gnrc_pktsnip_t *next, const void *data, size_t size,
                                     gnrc_nettype_t type)
@@ -388,6 +625,168 @@ static gnrc_pktsnip_t *_create_snip(gnrc_pktsnip_t *next, const void *data, size
     return pkt;
 }
 
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+static void _seg_insert(unsigned idx, unsigned size)
+{
+    _seg_chunk_t *chunk = _seg_chunk(idx);
+    unsigned fl, sl;
+
+    _seg_class(size, &fl, &sl);
+    chunk->size = size;
+    chunk->prev = _SEG_NONE;
+    chunk->next = _seg_heads[fl][sl];
+    if (chunk->next != _SEG_NONE) {
+        _seg_chunk(chunk->next)->prev = idx;
+    }
+    _seg_heads[fl][sl] = idx;
+    _seg_fl_map |= (1U << fl);
+    _seg_sl_map[fl] |= (1U << sl);
+    *_seg_footer(idx + size) = size;
+    _seg_set_edge(idx);
+    _seg_set_edge(idx + size - 1);
+}
+
+static void _seg_remove(unsigned idx)
+{
+    _seg_chunk_t *chunk = _seg_chunk(idx);
+    unsigned fl, sl;
+
+    _seg_class(chunk->size, &fl, &sl);
+    if (chunk->prev != _SEG_NONE) {
+        _seg_chunk(chunk->prev)->next = chunk->next;
+    }
+    else {
+        _seg_heads[fl][sl] = chunk->next;
+        if (chunk->next == _SEG_NONE) {
+            _seg_sl_map[fl] &= ~(1U << sl);
+            if (_seg_sl_map[fl] == 0) {
+                _seg_fl_map &= ~(1U << fl);
+            }
+        }
+    }
+    if (chunk->next != _SEG_NONE) {
+        _seg_chunk(chunk->next)->prev = chunk->prev;
+    }
+    _seg_clear_edge(idx);
+    _seg_clear_edge(idx + chunk->size - 1);
+}
+
+static void _seg_init(void)
+{
+    memset(_seg_heads, 0xff, sizeof(_seg_heads));
+    memset(_seg_sl_map, 0, sizeof(_seg_sl_map));
+    memset(_seg_edge, 0, sizeof(_seg_edge));
+    _seg_fl_map = 0;
+    _seg_insert(0, _SEG_GRANULES);
+}
+
+/* first chunk of the lowest non-empty class at or above fl/sl */
+static uint16_t _seg_find(unsigned fl, unsigned sl)
+{
+    unsigned map = _seg_sl_map[fl] & (~0U << sl);
+
+    if (map == 0) {
+        unsigned fl_map = _seg_fl_map & (~0U << (fl + 1));
+
+        if (fl_map == 0) {
+            return _SEG_NONE;
+        }
+        fl = bitarithm_lsb(fl_map);
+        map = _seg_sl_map[fl];
+    }
+    return _seg_heads[fl][bitarithm_lsb(map)];
+}
+
+static void *_pktbuf_alloc(size_t size)
+{
+    unsigned granules = _align(size) / sizeof(_unused_t);
+    unsigned search = granules;
+    unsigned fl, sl, avail;
+    uint16_t idx = _SEG_NONE;
+
+    if (granules == 0) {
+        granules = search = 1;
+    }
+    if (granules <= _SEG_GRANULES) {
+        /* round up to the next class, any chunk there fits */
+        if (search >= _SEG_SL_NUMOF) {
+            search += (1U << (bitarithm_msb(search) - _SEG_SL_BITS)) - 1;
+        }
+        _seg_class(search, &fl, &sl);
+        idx = _seg_find(fl, sl);
+        if (idx == _SEG_NONE) {
+            /* best fit among the chunks of the size's own class */
+            _seg_class(granules, &fl, &sl);
+            for (uint16_t tmp = _seg_heads[fl][sl]; tmp != _SEG_NONE;
+                 tmp = _seg_chunk(tmp)->next) {
+                unsigned tmp_size = _seg_chunk(tmp)->size;
+
+                if ((tmp_size >= granules) &&
+                    ((idx == _SEG_NONE) || (tmp_size < _seg_chunk(idx)->size))) {
+                    idx = tmp;
+                }
+            }
+        }
+    }
+    if (idx == _SEG_NONE) {
+        DEBUG("pktbuf: no space left in packet buffer\n");
+        _account_fail(granules * sizeof(_unused_t));
+        return NULL;
+    }
+    avail = _seg_chunk(idx)->size;
+    _seg_remove(idx);
+    if (avail > granules) {
+        _seg_insert(idx + granules, avail - granules);
+    }
+    _account_alloc(_seg_chunk(idx), granules * sizeof(_unused_t));
+    return _seg_chunk(idx);
+}
+
+static void _pktbuf_free(void *data, size_t size)
+{
+    unsigned idx, granules = _align(size) / sizeof(_unused_t);
+
+    if (!_pktbuf_contains(data) || (granules == 0)) {
+        return;
+    }
+    idx = ((uint8_t *)data - _pktbuf) / sizeof(_unused_t);
+    _used_bytes -= granules * sizeof(_unused_t);
+    /* an edge right before the chunk is the end of a free chunk, one right
+     * after it the start of a free chunk */
+    if ((idx > 0) && _seg_is_edge(idx - 1)) {
+        unsigned prev_size = *_seg_footer(idx);
+
+        idx -= prev_size;
+        granules += prev_size;
+        _seg_remove(idx);
+    }
+    if (((idx + granules) < _SEG_GRANULES) && _seg_is_edge(idx + granules)) {
+        unsigned next_size = _seg_chunk(idx + granules)->size;
+
+        _seg_remove(idx + granules);
+        granules += next_size;
+    }
+    _seg_insert(idx, granules);
+}
+
+static size_t _largest_free(void)
+{
+    size_t largest = 0;
+
+    if (_seg_fl_map != 0) {
+        unsigned fl = bitarithm_msb(_seg_fl_map);
+        unsigned sl = bitarithm_msb(_seg_sl_map[fl]);
+
+        for (uint16_t idx = _seg_heads[fl][sl]; idx != _SEG_NONE;
+             idx = _seg_chunk(idx)->next) {
+            if (_seg_chunk(idx)->size > largest) {
+                largest = _seg_chunk(idx)->size;
+            }
+        }
+    }
+    return largest * sizeof(_unused_t);
+}
+#else
 static void *_pktbuf_alloc(size_t size)
 {
     _unused_t *prev = NULL, *ptr = _first_unused;
@@ -399,6 +798,7 @@ static void *_pktbuf_alloc(size_t size)
     }
     if (ptr == NULL) {
         DEBUG("pktbuf: no space left in packet buffer\n");
+        _account_fail(size);
         return NULL;
     }
     /* _unused_t struct would fit => add new space at ptr */
@@ -426,12 +826,7 @@ static void *_pktbuf_alloc(size_t size)
         new->next = ptr->next;
         new->size = ptr->size - size;
     }
-#ifdef DEVELHELP
-    uint16_t last_byte = (uint16_t)((((uint8_t *)ptr) + size) - &(_pktbuf[0]));
-    if (last_byte > max_byte_count) {
-        max_byte_count = last_byte;
-    }
-#endif
+    _account_alloc(ptr, size);
     return (void *)ptr;
 }
 
@@ -457,6 +852,7 @@ static void _pktbuf_free(void *data, size_t size)
     if (!_pktbuf_contains(data)) {
         return;
     }
+    _used_bytes -= _align(size);
     while (ptr && (((void *)ptr) < data)) {
         prev = ptr;
         ptr = ptr->next;
@@ -486,6 +882,19 @@ static void _pktbuf_free(void *data, size_t size)
 }
 
 
+static size_t _largest_free(void)
+{
+    size_t largest = 0;
+
+    for (_unused_t *ptr = _first_unused; ptr != NULL; ptr = ptr->next) {
+        if (ptr->size > largest) {
+            largest = ptr->size;
+        }
+    }
+    return largest;
+}
+#endif
+
 gnrc_pktsnip_t *gnrc_pktbuf_duplicate_upto(gnrc_pktsnip_t *pkt, gnrc_nettype_t type)
 {
     mutex_lock(&_mutex);
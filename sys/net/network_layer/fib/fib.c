@@ -55,6 +55,95 @@ static char addr_str[IPV6_ADDR_MAX_STR_LEN];
 #define FIB_ADDR_PRINT_LENS2(X)     FIB_ADDR_PRINT_LENS1(X)
 #define FIB_ADDR_PRINT_LENS         FIB_ADDR_PRINT_LENS2(FIB_ADDR_PRINT_LEN)
 
+#ifdef MODULE_FIB_LPM
+#if (FIB_LPM_ADDR_SIZE > UNIVERSAL_ADDRESS_SIZE) || (FIB_LPM_ADDR_SIZE > 31)
+    #error "FIB_LPM_ADDR_SIZE MUST NOT exceed UNIVERSAL_ADDRESS_SIZE and 31 bytes"
+#endif
+
+/**
+ * @brief returns the prefix length of the entry in the index
+ *
+ * An all zero address is the default route, an entry without
+ * FIB_FLAG_NET_PREFIX_MASK is a host route.
+ *
+ * @return the prefix length in bits, -1 if the entry is not indexed
+ */
+static int fib_lpm_len(fib_entry_t *entry)
+{
+    if ((entry->global == NULL) || (entry->global->address_size != FIB_LPM_ADDR_SIZE)) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < FIB_LPM_ADDR_SIZE; ++i) {
+        if (entry->global->address[i] != 0) {
+            if (entry->global_flags & FIB_FLAG_NET_PREFIX_MASK) {
+                return (entry->global_flags & FIB_FLAG_NET_PREFIX_MASK) >> FIB_FLAG_NET_PREFIX_SHIFT;
+            }
+            return FIB_LPM_ADDR_SIZE << 3;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief adds the entry to the index, unless an entry with the same prefix is
+ *        already there
+ */
+static void fib_lpm_add(fib_table_t *table, fib_entry_t *entry)
+{
+    int len = fib_lpm_len(entry);
+
+    if (len >= 0) {
+        lpm_trie_add(&table->lpm, entry->global->address, len, entry);
+    }
+}
+
+/**
+ * @brief removes the entry from the index and indexes the next entry with the
+ *        same prefix instead, must be called before the address is released
+ */
+static void fib_lpm_remove(fib_table_t *table, fib_entry_t *entry)
+{
+    int len = fib_lpm_len(entry);
+
+    if ((len < 0) || (lpm_trie_get(&table->lpm, entry->global->address, len) != entry)) {
+        return;
+    }
+
+    lpm_trie_remove(&table->lpm, entry->global->address, len);
+
+    for (size_t i = 0; i < table->size; ++i) {
+        fib_entry_t *other = &table->data.entries[i];
+
+        /* entries with another prefix are indexed already, so only one with
+         * the same prefix can be added */
+        if ((other != entry) && (other->lifetime != 0) && (fib_lpm_len(other) == len) &&
+            (lpm_trie_add(&table->lpm, other->global->address, len, other) == 0)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief rebuilds the empty index
+ */
+static void fib_lpm_init(fib_table_t *table)
+{
+    lpm_trie_init(&table->lpm, NULL, 0);
+
+    if (table->table_type == FIB_TABLE_TYPE_SH) {
+        for (size_t i = 0; i < table->size; ++i) {
+            lpm_trie_add_nodes(&table->lpm, table->data.entries[i].lpm_nodes, 2);
+        }
+    }
+}
+#else
+#define fib_lpm_add(table, entry)       (void)(table)
+#define fib_lpm_remove(table, entry)    (void)(table)
+#define fib_lpm_init(table)             (void)(table)
+#endif
+
 /**
  * @brief convert an offset given in ms to abolute time in time in us
  * @param[in]  ms       the milliseconds to be converted
@@ -112,6 +201,7 @@ static int fib_find_entry(fib_table_t *table, uint8_t *dst, size_t dst_size,
             /* check if the lifetime expired */
             if (table->data.entries[i].lifetime < now) {
                 /* remove this entry if its lifetime expired */
+                fib_lpm_remove(table, &table->data.entries[i]);
                 table->data.entries[i].lifetime = 0;
                 table->data.entries[i].global_flags = 0;
                 table->data.entries[i].next_hop_flags = 0;
@@ -268,6 +358,7 @@ static int fib_create_entry(fib_table_t *table, kernel_pid_t iface_id,
                     table->data.entries[i].lifetime = FIB_LIFETIME_NO_EXPIRE;
                 }
 
+                fib_lpm_add(table, &table->data.entries[i]);
                 return 0;
             }
         }
@@ -279,12 +370,15 @@ static int fib_create_entry(fib_table_t *table, kernel_pid_t iface_id,
 /**
  * @brief removes the given entry
  *
+ * @param[in] table the FIB table holding the entry
  * @param[in] entry the entry to be removed
  *
  * @return 0 on success
  */
-static int fib_remove(fib_entry_t *entry)
+static int fib_remove(fib_table_t *table, fib_entry_t *entry)
 {
+    fib_lpm_remove(table, entry);
+
     if (entry->global != NULL) {
         universal_address_rem(entry->global);
     }
@@ -304,6 +398,39 @@ static int fib_remove(fib_entry_t *entry)
     return 0;
 }
 
+/**
+ * @brief returns pointer to the entry to forward to the given destination
+ *
+ * Same as fib_find_entry(), but uses the longest prefix match index if
+ * the module `fib_lpm` is used and the destination has the indexed size.
+ */
+static int fib_lookup_entry(fib_table_t *table, uint8_t *dst, size_t dst_size,
+                            fib_entry_t **entry_arr, size_t *entry_arr_size)
+{
+#ifdef MODULE_FIB_LPM
+    if ((dst_size == FIB_LPM_ADDR_SIZE) && (table->table_type == FIB_TABLE_TYPE_SH)) {
+        uint64_t now = xtimer_now_usec64();
+        fib_entry_t *entry;
+        uint8_t len;
+
+        while ((entry = lpm_trie_match(&table->lpm, dst, FIB_LPM_ADDR_SIZE << 3, &len)) != NULL) {
+            if ((entry->lifetime == FIB_LIFETIME_NO_EXPIRE) || (entry->lifetime >= now)) {
+                entry_arr[0] = entry;
+                *entry_arr_size = 1;
+                return (len == (FIB_LPM_ADDR_SIZE << 3)) ? 1 : 0;
+            }
+            /* remove this entry if its lifetime expired, and look again */
+            fib_remove(table, entry);
+        }
+
+        *entry_arr_size = 0;
+        return -EHOSTUNREACH;
+    }
+#endif
+
+    return fib_find_entry(table, dst, dst_size, entry_arr, entry_arr_size);
+}
+
 /**
  * @brief signals (sends a message to) all registered routing protocols
  *        registered with a matching prefix (usually this should be only one).
@@ -457,7 +584,7 @@ void fib_remove_entry(fib_table_t *table, uint8_t *dst, size_t dst_size)
 
     if (ret == 1) {
         /* we must take the according entry and update the values */
-        fib_remove(entry[0]);
+        fib_remove(table, entry[0]);
     }
     else {
         /* we have ambiguous entries, i.e. count > 1
@@ -477,7 +604,7 @@ void fib_flush(fib_table_t *table, kernel_pid_t interface)
     for (size_t i = 0; i < table->size; ++i) {
         if ((interface == KERNEL_PID_UNDEF) ||
             (interface == table->data.entries[i].iface_id)) {
-            fib_remove(&table->data.entries[i]);
+            fib_remove(table, &table->data.entries[i]);
         }
     }
 
@@ -506,14 +633,14 @@ int fib_get_next_hop(fib_table_t *table, kernel_pid_t *iface_id,
         return -EFAULT;
     }
 
-    int ret = fib_find_entry(table, dst, dst_size, &(entry[0]), &count);
+    int ret = fib_lookup_entry(table, dst, dst_size, &(entry[0]), &count);
     if (!(ret == 0 || ret == 1)) {
         /* notify all responsible RPs for unknown  next-hop for the destination address */
         if (fib_signal_rp(table, FIB_MSG_RP_SIGNAL_UNREACHABLE_DESTINATION,
                           dst, dst_size, dst_flags) == 0) {
             count = 1;
             /* now lets see if the RRPs have found a valid next-hop */
-            ret = fib_find_entry(table, dst, dst_size, &(entry[0]), &count);
+            ret = fib_lookup_entry(table, dst, dst_size, &(entry[0]), &count);
         }
     }
 
@@ -597,6 +724,7 @@ void fib_init(fib_table_t *table)
     else {
         memset(table->data.entries, 0, (table->size * sizeof(fib_entry_t)));
     }
+    fib_lpm_init(table);
     universal_address_init();
     mutex_unlock(&(table->mtx_access));
 }
@@ -622,6 +750,7 @@ void fib_deinit(fib_table_t *table)
     else {
         memset(table->data.entries, 0, (table->size * sizeof(fib_entry_t)));
     }
+    fib_lpm_init(table);
     universal_address_reset();
     mutex_unlock(&(table->mtx_access));
 }
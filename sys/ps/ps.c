@@ -16,7 +16,9 @@
  */
 
 #include <stdio.h>
+#include <inttypes.h>
 
+#include "irq.h"
 #include "thread.h"
 #include "sched.h"
 #include "thread.h"
@@ -154,3 +156,58 @@ void ps(void)
 #   endif
 #endif
 }
+
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+static unsigned _ticks_to_us(uint32_t ticks)
+{
+    return ((uint64_t)ticks * US_PER_SEC) / sched_statistics_hz;
+}
+
+/**
+ * @brief Prints preemptions, run slices and latency histograms of all threads
+ */
+void ps_sched(void)
+{
+    printf("\tlatency bucket n counts [2^n, 2^(n+1)) ticks of %" PRIu32 " Hz\n",
+           sched_statistics_hz);
+    printf("\tpid | "
+#ifdef DEVELHELP
+           "%-21s| "
+#endif
+           "preempt | max run us | max lat us | latency n:count\n"
+#ifdef DEVELHELP
+           , "name"
+#endif
+          );
+
+    for (kernel_pid_t i = KERNEL_PID_FIRST; i <= KERNEL_PID_LAST; i++) {
+        thread_t *p = (thread_t *)sched_threads[i];
+
+        if (p != NULL) {
+            /* copy, the scheduler updates the statistics of other threads
+             * while printing */
+            unsigned state = irq_disable();
+            schedstat stat = sched_pidlist[i];
+            irq_restore(state);
+
+            printf("\t%3" PRIkernel_pid
+#ifdef DEVELHELP
+                   " | %-20s"
+#endif
+                   " | %7u | %10u | %10u |",
+                   p->pid,
+#ifdef DEVELHELP
+                   p->name,
+#endif
+                   stat.preemptions, _ticks_to_us(stat.max_slice),
+                   _ticks_to_us(stat.max_latency));
+            for (unsigned n = 0; n < SCHEDSTAT_LATENCY_BUCKETS; n++) {
+                if (stat.latency[n]) {
+                    printf(" %u:%u", n, (unsigned)stat.latency[n]);
+                }
+            }
+            puts("");
+        }
+    }
+}
+#endif
@@ -39,6 +39,11 @@ static rtctimers_millis_t *timer_list_head = NULL;
 static rtctimers_millis_t *overflow_list_head = NULL;
 static rtctimers_millis_t *long_list_head = NULL;
 
+/* currently armed RTC alarm */
+static uint32_t _alarm = RTCTIMERS_MILLIS_OVERFLOW_VALUE;
+
+static rtctimers_millis_stats_t _stats;
+
 static int _rtctimers_millis_set_absolute(rtctimers_millis_t *timer, uint32_t target);
 static void _add_timer_to_list(rtctimers_millis_t **list_head, rtctimers_millis_t *timer);
 static void _add_timer_to_long_list(rtctimers_millis_t **list_head, rtctimers_millis_t *timer);
@@ -46,6 +51,8 @@ static uint32_t _rtctimers_millis_lltimer_maximum(uint32_t target);
 static void _shoot(rtctimers_millis_t *timer);
 static void _remove(rtctimers_millis_t *timer);
 static inline void _lltimer_set(uint32_t target);
+static uint32_t _next_alarm(void);
+static void _update_alarm(void);
 static uint32_t _time_left(uint32_t target, uint32_t reference);
 
 static void _timer_callback(void);
@@ -79,13 +86,19 @@ void rtctimers_millis_init(void)
 
 void rtctimers_millis_set(rtctimers_millis_t *timer, uint32_t offset)
 {
-    DEBUG("timer_set(): offset=%" PRIu32 " now=%" PRIu32 "\n", offset, rtctimers_millis_now());
+    rtctimers_millis_set_slack(timer, offset, 0);
+}
+
+void rtctimers_millis_set_slack(rtctimers_millis_t *timer, uint32_t offset, uint32_t slack)
+{
+    DEBUG("timer_set(): offset=%" PRIu32 " slack=%" PRIu32 " now=%" PRIu32 "\n", offset, slack, rtctimers_millis_now());
     if (!timer->callback) {
         DEBUG("timer_set(): timer has no callback.\n");
         return;
     }
 
     rtctimers_millis_remove(timer);
+    timer->slack = slack;
 
     if (offset < RTCTIMERS_MILLIS_BACKOFF) {
         _shoot(timer);
@@ -116,7 +129,8 @@ static inline void _lltimer_set(uint32_t target)
         return;
     }
     DEBUG("_lltimer_set(): setting %" PRIu32 ", now is %" PRIu32 "\n", _rtctimers_millis_lltimer_maximum(target), rtctimers_millis_now());
-    
+
+    _alarm = target;
     rtc_millis_set_alarm(_rtctimers_millis_lltimer_maximum(target), _periph_timer_callback, NULL);
 }
 
@@ -156,14 +170,12 @@ int _rtctimers_millis_set_absolute(rtctimers_millis_t *timer, uint32_t target)
         else {
             DEBUG("timer_set_absolute(): timer will expire in this timer period.\n");
             _add_timer_to_list(&timer_list_head, timer);
-
-            if (timer_list_head == timer) {
-                DEBUG("timer_set_absolute(): timer is new list head. updating lltimer.\n");
-                _lltimer_set(target - RTCTIMERS_MILLIS_OVERHEAD);
-            }
         }
     }
 
+    /* timer may have been removed from or added to the current period */
+    _update_alarm();
+
     irq_restore(state);
 
     return res;
@@ -206,24 +218,53 @@ static int _remove_timer_from_list(rtctimers_millis_t **list_head, rtctimers_mil
 
 static void _remove(rtctimers_millis_t *timer)
 {
-    if (timer_list_head == timer) {
-        uint32_t next;
-        timer_list_head = timer->next;
-        if (timer_list_head) {
-            /* schedule callback on next timer target time */
-            next = timer_list_head->target - RTCTIMERS_MILLIS_OVERHEAD;
-        }
-        else {
-            next = RTCTIMERS_MILLIS_OVERFLOW_VALUE;
+    if (!_remove_timer_from_list(&timer_list_head, timer)) {
+        if (!_remove_timer_from_list(&overflow_list_head, timer)) {
+            _remove_timer_from_list(&long_list_head, timer);
         }
-        _lltimer_set(next);
     }
-    else {
-        if (!_remove_timer_from_list(&timer_list_head, timer)) {
-            if (!_remove_timer_from_list(&overflow_list_head, timer)) {
-                _remove_timer_from_list(&long_list_head, timer);
+}
+
+/**
+ * @brief find the earliest slack deadline of the current timer period
+ *
+ * Alarm is set to the deadline, every timer with target before it fires
+ * on the same wakeup.
+ */
+static uint32_t _next_alarm(void)
+{
+    uint32_t alarm = RTCTIMERS_MILLIS_OVERFLOW_VALUE;
+
+    /* list is sorted by target, and deadline is never before target */
+    for (rtctimers_millis_t *t = timer_list_head; t && (t->target < alarm); t = t->next) {
+        uint32_t deadline = t->target + t->slack;
+
+        /* slack doesn't extend past the end of the period */
+        if ((deadline < t->target) || (deadline > RTCTIMERS_MILLIS_OVERFLOW_VALUE - RTCTIMERS_MILLIS_ISR_BACKOFF)) {
+            deadline = RTCTIMERS_MILLIS_OVERFLOW_VALUE - RTCTIMERS_MILLIS_ISR_BACKOFF;
+            if (deadline < t->target) {
+                deadline = t->target;
             }
         }
+
+        if (deadline < alarm) {
+            alarm = deadline;
+        }
+    }
+
+    if (alarm != RTCTIMERS_MILLIS_OVERFLOW_VALUE) {
+        alarm -= RTCTIMERS_MILLIS_OVERHEAD;
+    }
+
+    return alarm;
+}
+
+static void _update_alarm(void)
+{
+    uint32_t next = _next_alarm();
+
+    if (next != _alarm) {
+        _lltimer_set(next);
     }
 }
 
@@ -232,10 +273,18 @@ void rtctimers_millis_remove(rtctimers_millis_t *timer)
     int state = irq_disable();
     if (_is_set(timer)) {
         _remove(timer);
+        _update_alarm();
     }
     irq_restore(state);
 }
 
+void rtctimers_millis_get_stats(rtctimers_millis_stats_t *stats)
+{
+    unsigned state = irq_disable();
+    *stats = _stats;
+    irq_restore(state);
+}
+
 static uint32_t _time_left(uint32_t target, uint32_t reference)
 {
     uint32_t now = rtctimers_millis_now();
@@ -369,8 +418,11 @@ static void _timer_callback(void)
 {
     uint32_t next_target;
     uint32_t reference;
+    uint32_t last_fired = 0;
+    int fired = 0;
 
     _in_handler = 1;
+    _stats.wakeups++;
 
     DEBUG("_timer_callback() now=%" PRIu32 " pleft=%" PRIu32 "\n", 
             rtctimers_millis_now(), RTCTIMERS_MILLIS_OVERFLOW_VALUE - rtctimers_millis_now());
@@ -410,6 +462,14 @@ overflow:
         /* advance list */
         timer_list_head = timer->next;
 
+        /* without slack this timer would have needed an alarm of its own */
+        if (fired && (timer->target > last_fired + RTCTIMERS_MILLIS_ISR_BACKOFF)) {
+            _stats.saved++;
+        }
+        last_fired = timer->target;
+        fired = 1;
+        _stats.fired++;
+
         /* make sure timer is recognized as being already fired */
         timer->target = 0;
         timer->long_target = 0;
@@ -430,8 +490,8 @@ overflow:
     }
 
     if (timer_list_head) {
-        /* schedule callback on next timer target time */
-        next_target = timer_list_head->target - RTCTIMERS_MILLIS_OVERHEAD;
+        /* schedule callback on the earliest slack deadline */
+        next_target = _next_alarm();
 
         /* make sure we're not setting a time in the past */
         if (next_target < (rtctimers_millis_now() + RTCTIMERS_MILLIS_ISR_BACKOFF)) {
@@ -527,11 +587,6 @@ void rtctimers_millis_set_timebase(struct tm *new_time) {
 	rtc_set_time(new_time);
 
 	if (timer_list_head) {
-		/* Shift hardware alarm to new time base */
-		int diff = timer_list_head->target - prev_ts;
-		DEBUG("[RTC] Head timer is %d seconds far\n", diff);
-		_lltimer_set(new_ts + diff);
-
 		/* Shift currently running timers to the new time base */
 		DEBUG("[RTC] Shifting timers to the new time base\n");
 		rtctimers_millis_t *timer = timer_list_head;
@@ -545,5 +600,8 @@ void rtctimers_millis_set_timebase(struct tm *new_time) {
 			/* Advance in list */
 			timer = timer->next;
 		}
+
+		/* Shift hardware alarm to new time base */
+		_lltimer_set(_next_alarm());
 	}
 }
@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_sensorlog
+ * @{
+ *
+ * @file
+ * @brief       Sensor data logger implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sensorlog.h"
+#include "vfs.h"
+
+#define ENABLE_DEBUG    (0)
+#include "debug.h"
+
+/* log files are named by their number in 8 hex digits */
+#define FILE_DIGITS     (8U)
+#define CURSOR_NAME     "cursor"
+#define CURSOR_SIZE     (8U)
+
+static void _put_u32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+    buf[2] = (uint8_t)(val >> 16);
+    buf[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t _get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static void _path(const sensorlog_t *log, uint32_t file, char *buf)
+{
+    sprintf(buf, "%s/%08" PRIx32, log->dir, file);
+}
+
+static void _cursor_path(const sensorlog_t *log, char *buf)
+{
+    sprintf(buf, "%s/" CURSOR_NAME, log->dir);
+}
+
+/* parses a log file name, returns 0 if it is one */
+static int _parse(const char *name, uint32_t *file)
+{
+    uint32_t val = 0;
+
+    if (strlen(name) != FILE_DIGITS) {
+        return -1;
+    }
+    for (unsigned i = 0; i < FILE_DIGITS; i++) {
+        char c = name[i];
+        unsigned digit;
+        if ((c >= '0') && (c <= '9')) {
+            digit = c - '0';
+        }
+        else if ((c >= 'a') && (c <= 'f')) {
+            digit = c - 'a' + 10;
+        }
+        else {
+            return -1;
+        }
+        val = (val << 4) | digit;
+    }
+    *file = val;
+    return 0;
+}
+
+static int _save_cursor(sensorlog_t *log)
+{
+    char path[SENSORLOG_PATH_MAX];
+    uint8_t buf[CURSOR_SIZE];
+
+    _cursor_path(log, path);
+    _put_u32(buf, log->first);
+    _put_u32(buf + 4, log->offset);
+
+    int fd = vfs_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (fd < 0) {
+        return fd;
+    }
+    ssize_t res = vfs_write(fd, buf, sizeof(buf));
+    int res_close = vfs_close(fd);
+    if (res < 0) {
+        return res;
+    }
+    if (res != sizeof(buf)) {
+        return -EIO;
+    }
+    return res_close;
+}
+
+static void _load_cursor(sensorlog_t *log)
+{
+    char path[SENSORLOG_PATH_MAX];
+    uint8_t buf[CURSOR_SIZE];
+
+    _cursor_path(log, path);
+    int fd = vfs_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return;
+    }
+    ssize_t res = vfs_read(fd, buf, sizeof(buf));
+    vfs_close(fd);
+
+    /* a cursor of a removed file is left from a replay interrupted before
+     * it was saved, that file has been consumed completely */
+    if ((res == sizeof(buf)) && (_get_u32(buf) == log->first)) {
+        log->offset = _get_u32(buf + 4);
+    }
+}
+
+/* removes the oldest file, the replay continues with the next one */
+static int _remove_first(sensorlog_t *log)
+{
+    char path[SENSORLOG_PATH_MAX];
+
+    _path(log, log->first, path);
+    int res = vfs_unlink(path);
+    if ((res < 0) && (res != -ENOENT)) {
+        return res;
+    }
+    log->first++;
+    log->offset = 0;
+    return 0;
+}
+
+static int _flush(sensorlog_t *log)
+{
+    char path[SENSORLOG_PATH_MAX];
+
+    if (log->fill == 0) {
+        return 0;
+    }
+
+    if ((log->last_size > 0) && (log->last_size + log->fill > log->file_size)) {
+        DEBUG("sensorlog: rotate %08" PRIx32 " at %" PRIu32 " bytes\n",
+              log->last, log->last_size);
+        if (log->last - log->first + 1 >= log->files) {
+            int res = _remove_first(log);
+            if (res < 0) {
+                return res;
+            }
+            log->stats.dropped++;
+        }
+        log->last++;
+        log->last_size = 0;
+        log->stats.rotations++;
+    }
+
+    _path(log, log->last, path);
+    int fd = vfs_open(path, O_WRONLY | O_CREAT | O_APPEND, 0);
+    if (fd < 0) {
+        return fd;
+    }
+    ssize_t res = vfs_write(fd, log->buf, log->fill);
+    int res_close = vfs_close(fd);
+    if (res < 0) {
+        return res;
+    }
+    if ((size_t)res != log->fill) {
+        return -ENOSPC;
+    }
+    if (res_close < 0) {
+        return res_close;
+    }
+
+    log->last_size += log->fill;
+    log->fill = 0;
+    log->stats.flushes++;
+    return 0;
+}
+
+static bool _empty(const sensorlog_t *log)
+{
+    return (log->fill == 0) && (log->first == log->last) &&
+           (log->offset >= log->last_size);
+}
+
+int sensorlog_init(sensorlog_t *log)
+{
+    char path[SENSORLOG_PATH_MAX];
+    vfs_DIR dir;
+    vfs_dirent_t entry;
+    bool found = false;
+
+    if ((log->buf == NULL) || (log->buf_size < SENSORLOG_HDR_SIZE + 1) ||
+        (log->files == 0) || (log->file_size == 0)) {
+        return -EINVAL;
+    }
+    if (strlen(log->dir) + 1 + FILE_DIGITS >= SENSORLOG_PATH_MAX) {
+        return -ENAMETOOLONG;
+    }
+
+    mutex_init(&log->lock);
+    log->fill = 0;
+    log->first = 0;
+    log->last = 0;
+    log->last_size = 0;
+    log->offset = 0;
+    memset(&log->stats, 0, sizeof(log->stats));
+
+    int res = vfs_mkdir(log->dir, 0);
+    if ((res < 0) && (res != -EEXIST)) {
+        return res;
+    }
+
+    res = vfs_opendir(&dir, log->dir);
+    if (res < 0) {
+        return res;
+    }
+    while (vfs_readdir(&dir, &entry) > 0) {
+        uint32_t file;
+        if (_parse(entry.d_name, &file) < 0) {
+            continue;
+        }
+        if (!found || (file < log->first)) {
+            log->first = file;
+        }
+        if (!found || (file > log->last)) {
+            log->last = file;
+        }
+        found = true;
+    }
+    vfs_closedir(&dir);
+
+    if (found) {
+        struct stat st;
+        _path(log, log->last, path);
+        res = vfs_stat(path, &st);
+        if (res < 0) {
+            return res;
+        }
+        log->last_size = st.st_size;
+        _load_cursor(log);
+    }
+
+    DEBUG("sensorlog: files %08" PRIx32 "..%08" PRIx32 ", offset %" PRIu32 "\n",
+          log->first, log->last, log->offset);
+
+    return 0;
+}
+
+int sensorlog_write(sensorlog_t *log, uint32_t time, uint8_t id,
+                    const void *data, size_t len)
+{
+    size_t size = SENSORLOG_HDR_SIZE + len;
+
+    if ((len > SENSORLOG_DATA_MAX) || (size > log->buf_size)) {
+        return -EINVAL;
+    }
+
+    mutex_lock(&log->lock);
+
+    if (log->fill + size > log->buf_size) {
+        int res = _flush(log);
+        if (res < 0) {
+            mutex_unlock(&log->lock);
+            return res;
+        }
+    }
+
+    uint8_t *rec = log->buf + log->fill;
+    _put_u32(rec, time);
+    rec[4] = id;
+    rec[5] = (uint8_t)len;
+    memcpy(rec + SENSORLOG_HDR_SIZE, data, len);
+    log->fill += size;
+    log->stats.records++;
+
+    mutex_unlock(&log->lock);
+    return 0;
+}
+
+int sensorlog_flush(sensorlog_t *log)
+{
+    mutex_lock(&log->lock);
+    int res = _flush(log);
+    mutex_unlock(&log->lock);
+    return res;
+}
+
+int sensorlog_replay(sensorlog_t *log, sensorlog_cb_t cb, void *arg,
+                     unsigned max)
+{
+    char path[SENSORLOG_PATH_MAX];
+    uint8_t hdr[SENSORLOG_HDR_SIZE];
+    uint8_t data[SENSORLOG_DATA_MAX];
+    unsigned count = 0;
+    int fd = -1;
+    int res;
+
+    mutex_lock(&log->lock);
+
+    uint32_t first = log->first;
+    uint32_t offset = log->offset;
+
+    res = _flush(log);
+    if (res < 0) {
+        goto out;
+    }
+
+    while (count < max) {
+        if (fd < 0) {
+            if (_empty(log)) {
+                break;
+            }
+            _path(log, log->first, path);
+            fd = vfs_open(path, O_RDONLY, 0);
+            if ((fd < 0) && (fd != -ENOENT)) {
+                res = fd;
+                goto out;
+            }
+            if ((fd >= 0) && (log->offset > 0) &&
+                (vfs_lseek(fd, log->offset, SEEK_SET) < 0)) {
+                vfs_close(fd);
+                fd = -1;
+                res = -EIO;
+                goto out;
+            }
+        }
+
+        sensorlog_record_t rec;
+        bool end = true;
+        if (fd >= 0) {
+            res = vfs_read(fd, hdr, sizeof(hdr));
+            if (res == sizeof(hdr)) {
+                rec.time = _get_u32(hdr);
+                rec.id = hdr[4];
+                rec.len = hdr[5];
+                res = vfs_read(fd, data, rec.len);
+                end = (res != rec.len);
+            }
+            if (res < 0) {
+                goto out;
+            }
+        }
+
+        if (end) {
+            /* the file of the records being appended stays */
+            if (log->first == log->last) {
+                break;
+            }
+            if (fd >= 0) {
+                vfs_close(fd);
+                fd = -1;
+            }
+            res = _remove_first(log);
+            if (res < 0) {
+                goto out;
+            }
+            continue;
+        }
+
+        if (cb(arg, &rec, data) < 0) {
+            break;
+        }
+        log->offset += SENSORLOG_HDR_SIZE + rec.len;
+        log->stats.replayed++;
+        count++;
+    }
+    res = 0;
+
+out:
+    if (fd >= 0) {
+        vfs_close(fd);
+    }
+
+    /* start over with a new file once everything has been consumed */
+    if ((res == 0) && (log->last_size > 0) && _empty(log)) {
+        _path(log, log->last, path);
+        res = vfs_unlink(path);
+        if (res == 0) {
+            log->first = ++log->last;
+            log->last_size = 0;
+            log->offset = 0;
+        }
+    }
+
+    if ((log->first != first) || (log->offset != offset)) {
+        int res_cursor = _save_cursor(log);
+        if (res == 0) {
+            res = res_cursor;
+        }
+    }
+
+    mutex_unlock(&log->lock);
+
+    return (res < 0) ? res : (int)count;
+}
+
+bool sensorlog_empty(sensorlog_t *log)
+{
+    mutex_lock(&log->lock);
+    bool empty = _empty(log);
+    mutex_unlock(&log->lock);
+    return empty;
+}
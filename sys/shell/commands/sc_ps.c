@@ -18,12 +18,32 @@
  * @}
  */
 
+#include <stdio.h>
+#include <string.h>
+
 #include "ps.h"
+#include "sched.h"
 
 int _ps_handler(int argc, char **argv)
 {
+#ifdef MODULE_SCHEDSTATISTICS_EXT
+    if ((argc > 1) && (strcmp(argv[1], "sched") == 0)) {
+        if ((argc > 2) && (strcmp(argv[2], "reset") == 0)) {
+            sched_statistics_reset();
+        }
+        else {
+            ps_sched();
+        }
+        return 0;
+    }
+    if (argc > 1) {
+        printf("usage: %s [sched [reset]]\n", argv[0]);
+        return 1;
+    }
+#else
     (void) argc;
     (void) argv;
+#endif
 
     ps();
 
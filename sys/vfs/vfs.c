@@ -15,6 +15,7 @@
  */
 
 #include <errno.h> /* for error codes */
+#include <stdbool.h> /* for bool */
 #include <string.h> /* for strncmp */
 #include <stddef.h> /* for NULL */
 #include <sys/types.h> /* for off_t etc */
@@ -24,6 +25,8 @@
 #include <unistd.h> /* for STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO */
 
 #include "vfs.h"
+#include "bitarithm.h"
+#include "irq.h"
 #include "mutex.h"
 #include "thread.h"
 #include "kernel_types.h"
@@ -40,6 +43,15 @@
 #define DEBUG_NOT_STDOUT(...)
 #endif
 
+#if VFS_MAX_OPEN_FILES > 32
+#error "VFS_MAX_OPEN_FILES is limited to 32 by the bitmap of used fds"
+#endif
+
+/* all fd numbers */
+#define _ALL_FDS    (UINT32_MAX >> (32 - VFS_MAX_OPEN_FILES))
+/* fd numbers of stdio, not given out for VFS_ANY_FD */
+#define _STDIO_FDS  ((1UL << STDIN_FILENO) | (1UL << STDOUT_FILENO) | (1UL << STDERR_FILENO))
+
 /**
  * @internal
  * @brief Array of all currently open files
@@ -50,6 +62,14 @@
  */
 static vfs_file_t _vfs_open_files[VFS_MAX_OPEN_FILES];
 
+/**
+ * @internal
+ * @brief Bitmap of the used entries in the _vfs_open_files array
+ *
+ * Modified with interrupts disabled.
+ */
+static uint32_t _vfs_used_fds;
+
 /**
  * @internal
  * @brief List handle for list of all currently mounted file systems
@@ -59,6 +79,24 @@ static vfs_file_t _vfs_open_files[VFS_MAX_OPEN_FILES];
  */
 static clist_node_t _vfs_mounts_list;
 
+#if VFS_MOUNT_CACHE_SIZE > 0
+/**
+ * @internal
+ * @brief Cache of recently found mounts
+ *
+ * Only mounts without other mounts below their mount point are cached, so a
+ * cached mount point which is a prefix of a path is its longest match. The
+ * cache is protected by _mount_mutex and cleared by vfs_mount and vfs_umount.
+ */
+static vfs_mount_t *_vfs_mount_cache[VFS_MOUNT_CACHE_SIZE];
+
+/**
+ * @internal
+ * @brief Next entry of _vfs_mount_cache to replace
+ */
+static unsigned _vfs_mount_cache_next;
+#endif
+
 /**
  * @internal
  * @brief Find an unused entry in the _vfs_open_files array and mark it as used
@@ -129,13 +167,43 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
  */
 static inline int _fd_is_valid(int fd);
 
+/**
+ * @internal
+ * @brief Check that a given fd number is valid and lock the file
+ *
+ * Calls on the same file are serialized, calls on different files may run
+ * concurrently. The lock is not taken in interrupt context, where stdio may
+ * be written to.
+ *
+ * @param[in]  fd    fd to lock
+ *
+ * @return 0 if the fd is valid and the file locked
+ * @return <0 if the fd is not valid
+ */
+static inline int _fd_lock(int fd);
+
+/**
+ * @internal
+ * @brief Unlock a file locked by _fd_lock
+ *
+ * @param[in]  fd    fd to unlock
+ */
+static inline void _fd_unlock(int fd);
+
+/**
+ * @internal
+ * @brief Clear the cache of found mounts
+ *
+ * Called with _mount_mutex locked.
+ */
+static inline void _mount_cache_clear(void);
+
 static mutex_t _mount_mutex = MUTEX_INIT;
-static mutex_t _open_mutex = MUTEX_INIT;
 
 int vfs_close(int fd)
 {
     DEBUG("vfs_close: %d\n", fd);
-    int res = _fd_is_valid(fd);
+    int res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
@@ -146,32 +214,34 @@ int vfs_close(int fd)
         res = filp->f_op->close(filp);
     }
     _free_fd(fd);
+    _fd_unlock(fd);
     return res;
 }
 
 int vfs_fcntl(int fd, int cmd, int arg)
 {
     DEBUG("vfs_fcntl: %d, %d, %d\n", fd, cmd, arg);
-    int res = _fd_is_valid(fd);
+    int res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
     /* The default fcntl implementation below only allows querying flags,
      * any other command requires insight into the file system driver */
-    switch (cmd) {
-        case F_GETFL:
-            /* Get file flags */
-            DEBUG("vfs_fcntl: GETFL: %d\n", filp->flags);
-            return filp->flags;
-        default:
-            break;
+    if (cmd == F_GETFL) {
+        /* Get file flags */
+        DEBUG("vfs_fcntl: GETFL: %d\n", filp->flags);
+        res = filp->flags;
     }
-    /* pass on to file system driver */
-    if (filp->f_op->fcntl != NULL) {
-        return filp->f_op->fcntl(filp, cmd, arg);
+    else if (filp->f_op->fcntl != NULL) {
+        /* pass on to file system driver */
+        res = filp->f_op->fcntl(filp, cmd, arg);
     }
-    return -EINVAL;
+    else {
+        res = -EINVAL;
+    }
+    _fd_unlock(fd);
+    return res;
 }
 
 int vfs_fstat(int fd, struct stat *buf)
@@ -180,16 +250,20 @@ int vfs_fstat(int fd, struct stat *buf)
     if (buf == NULL) {
         return -EFAULT;
     }
-    int res = _fd_is_valid(fd);
+    int res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
     if (filp->f_op->fstat == NULL) {
         /* driver does not implement fstat() */
-        return -EINVAL;
+        res = -EINVAL;
     }
-    return filp->f_op->fstat(filp, buf);
+    else {
+        res = filp->f_op->fstat(filp, buf);
+    }
+    _fd_unlock(fd);
+    return res;
 }
 
 int vfs_fstatvfs(int fd, struct statvfs *buf)
@@ -198,55 +272,63 @@ int vfs_fstatvfs(int fd, struct statvfs *buf)
     if (buf == NULL) {
         return -EFAULT;
     }
-    int res = _fd_is_valid(fd);
+    int res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
-    if (filp->mp->fs->fs_op->fstatvfs == NULL) {
-        /* file system driver does not implement fstatvfs() */
-        if (filp->mp->fs->fs_op->statvfs != NULL) {
-            /* Fall back to statvfs */
-            return filp->mp->fs->fs_op->statvfs(filp->mp, "/", buf);
-        }
-        return -EINVAL;
+    if (filp->mp->fs->fs_op->fstatvfs != NULL) {
+        res = filp->mp->fs->fs_op->fstatvfs(filp->mp, filp, buf);
+    }
+    else if (filp->mp->fs->fs_op->statvfs != NULL) {
+        /* file system driver does not implement fstatvfs(), fall back to
+         * statvfs */
+        res = filp->mp->fs->fs_op->statvfs(filp->mp, "/", buf);
+    }
+    else {
+        res = -EINVAL;
     }
-    return filp->mp->fs->fs_op->fstatvfs(filp->mp, filp, buf);
+    _fd_unlock(fd);
+    return res;
 }
 
 off_t vfs_lseek(int fd, off_t off, int whence)
 {
     DEBUG("vfs_lseek: %d, %ld, %d\n", fd, (long)off, whence);
-    int res = _fd_is_valid(fd);
+    int res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
-    if (filp->f_op->lseek == NULL) {
-        /* driver does not implement lseek() */
-        /* default seek functionality is naive */
-        switch (whence) {
-            case SEEK_SET:
-                break;
-            case SEEK_CUR:
-                off += filp->pos;
-                break;
-            case SEEK_END:
-                /* we could use fstat here, but most file system drivers will
-                 * likely already implement lseek in a more efficient fashion */
-                return -EINVAL;
-            default:
-                return -EINVAL;
-        }
-        if (off < 0) {
-            /* the resulting file offset would be negative */
-            return -EINVAL;
-        }
-        filp->pos = off;
-
+    if (filp->f_op->lseek != NULL) {
+        off = filp->f_op->lseek(filp, off, whence);
+        _fd_unlock(fd);
         return off;
     }
-    return filp->f_op->lseek(filp, off, whence);
+    /* driver does not implement lseek() */
+    /* default seek functionality is naive */
+    switch (whence) {
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            off += filp->pos;
+            break;
+        case SEEK_END:
+            /* we could use fstat here, but most file system drivers will
+             * likely already implement lseek in a more efficient fashion */
+        default:
+            off = -1;
+            break;
+    }
+    if (off < 0) {
+        /* unsupported whence or the resulting file offset would be negative */
+        off = -EINVAL;
+    }
+    else {
+        filp->pos = off;
+    }
+    _fd_unlock(fd);
+    return off;
 }
 
 int vfs_open(const char *name, int flags, mode_t mode)
@@ -264,9 +346,7 @@ int vfs_open(const char *name, int flags, mode_t mode)
         DEBUG("vfs_open: no matching mount\n");
         return res;
     }
-    mutex_lock(&_open_mutex);
     int fd = _init_fd(VFS_ANY_FD, mountp->fs->f_op, mountp, flags, NULL);
-    mutex_unlock(&_open_mutex);
     if (fd < 0) {
         DEBUG("vfs_open: _init_fd: ERR %d!\n", fd);
         /* remember to decrement the open_files count */
@@ -275,14 +355,18 @@ int vfs_open(const char *name, int flags, mode_t mode)
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
     if (filp->f_op->open != NULL) {
+        /* keep other users of the new fd out until the file is opened */
+        _fd_lock(fd);
         res = filp->f_op->open(filp, rel_path, flags, mode, name);
         if (res < 0) {
             /* something went wrong during open */
             DEBUG("vfs_open: open: ERR %d!\n", res);
             /* clean up */
             _free_fd(fd);
+            _fd_unlock(fd);
             return res;
         }
+        _fd_unlock(fd);
     }
     DEBUG("vfs_open: opened %d\n", fd);
     return fd;
@@ -294,20 +378,24 @@ ssize_t vfs_read(int fd, void *dest, size_t count)
     if (dest == NULL) {
         return -EFAULT;
     }
-    int res = _fd_is_valid(fd);
+    ssize_t res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
     if (((filp->flags & O_ACCMODE) != O_RDONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
         /* File not open for reading */
-        return -EBADF;
+        res = -EBADF;
     }
-    if (filp->f_op->read == NULL) {
+    else if (filp->f_op->read == NULL) {
         /* driver does not implement read() */
-        return -EINVAL;
+        res = -EINVAL;
     }
-    return filp->f_op->read(filp, dest, count);
+    else {
+        res = filp->f_op->read(filp, dest, count);
+    }
+    _fd_unlock(fd);
+    return res;
 }
 
 
@@ -317,20 +405,53 @@ ssize_t vfs_write(int fd, const void *src, size_t count)
     if (src == NULL) {
         return -EFAULT;
     }
-    int res = _fd_is_valid(fd);
+    ssize_t res = _fd_lock(fd);
     if (res < 0) {
         return res;
     }
     vfs_file_t *filp = &_vfs_open_files[fd];
     if (((filp->flags & O_ACCMODE) != O_WRONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
         /* File not open for writing */
-        return -EBADF;
+        res = -EBADF;
     }
-    if (filp->f_op->write == NULL) {
+    else if (filp->f_op->write == NULL) {
         /* driver does not implement write() */
+        res = -EINVAL;
+    }
+    else {
+        res = filp->f_op->write(filp, src, count);
+    }
+    _fd_unlock(fd);
+    return res;
+}
+
+ssize_t vfs_span(int fd, off_t off, size_t count, const void **ptr)
+{
+    DEBUG("vfs_span: %d, %ld, %lu, %p\n", fd, (long)off, (unsigned long)count, (void *)ptr);
+    if (ptr == NULL) {
+        return -EFAULT;
+    }
+    if (off < 0) {
         return -EINVAL;
     }
-    return filp->f_op->write(filp, src, count);
+    ssize_t res = _fd_lock(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (((filp->flags & O_ACCMODE) != O_RDONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for reading */
+        res = -EBADF;
+    }
+    else if (filp->f_op->span == NULL) {
+        /* driver does not keep its files in addressable memory */
+        res = -ENOTSUP;
+    }
+    else {
+        res = filp->f_op->span(filp, off, count, ptr);
+    }
+    _fd_unlock(fd);
+    return res;
 }
 
 int vfs_opendir(vfs_DIR *dirp, const char *dirname)
@@ -483,6 +604,8 @@ int vfs_mount(vfs_mount_t *mountp)
     }
     /* insert last in list */
     clist_rpush(&_vfs_mounts_list, &mountp->list_entry);
+    /* the new mount may be below a cached one */
+    _mount_cache_clear();
     mutex_unlock(&_mount_mutex);
     DEBUG("vfs_mount: mount done\n");
     return 0;
@@ -529,6 +652,7 @@ int vfs_umount(vfs_mount_t *mountp)
         mutex_unlock(&_mount_mutex);
         return -EINVAL;
     }
+    _mount_cache_clear();
     mutex_unlock(&_mount_mutex);
     return 0;
 }
@@ -766,9 +890,7 @@ int vfs_bind(int fd, int flags, const vfs_file_ops_t *f_op, void *private_data)
     if (f_op == NULL) {
         return -EINVAL;
     }
-    mutex_lock(&_open_mutex);
     fd = _init_fd(fd, f_op, NULL, flags, private_data);
-    mutex_unlock(&_open_mutex);
     if (fd < 0) {
         DEBUG("vfs_bind: _init_fd: ERR %d!\n", fd);
         return fd;
@@ -864,30 +986,44 @@ const vfs_mount_t *vfs_iterate_mounts(const vfs_mount_t *cur)
     return container_of(node, vfs_mount_t, list_entry);
 }
 
+static inline unsigned _lsb(uint32_t v)
+{
+    /* bitarithm_lsb() takes an unsigned, which has only 16 bits on some
+     * platforms */
+    if ((uint16_t)v == 0) {
+        return 16 + bitarithm_lsb((unsigned)(v >> 16));
+    }
+    return bitarithm_lsb((uint16_t)v);
+}
+
 static inline int _allocate_fd(int fd)
 {
+    unsigned state = irq_disable();
     if (fd < 0) {
-        for (fd = 0; fd < VFS_MAX_OPEN_FILES; ++fd) {
-            if ((fd == STDIN_FILENO) || (fd == STDOUT_FILENO) || (fd == STDERR_FILENO)) {
-                /* Do not auto-allocate the stdio file descriptor numbers to
-                 * avoid conflicts between normal file system users and stdio
-                 * drivers such as uart_stdio, rtt_stdio which need to be able
-                 * to bind to these specific file descriptor numbers. */
-                continue;
-            }
-            if (_vfs_open_files[fd].pid == KERNEL_PID_UNDEF) {
-                break;
-            }
+        /* Do not auto-allocate the stdio file descriptor numbers to avoid
+         * conflicts between normal file system users and stdio drivers such
+         * as uart_stdio, rtt_stdio which need to be able to bind to these
+         * specific file descriptor numbers. */
+        uint32_t free = ~_vfs_used_fds & _ALL_FDS & ~_STDIO_FDS;
+        if (free == 0) {
+            /* The _vfs_open_files array is full */
+            irq_restore(state);
+            return -ENFILE;
         }
+        fd = _lsb(free);
     }
-    if (fd >= VFS_MAX_OPEN_FILES) {
-        /* The _vfs_open_files array is full */
+    else if (fd >= VFS_MAX_OPEN_FILES) {
+        irq_restore(state);
         return -ENFILE;
     }
-    else if (_vfs_open_files[fd].pid != KERNEL_PID_UNDEF) {
+    else if (_vfs_used_fds & (1UL << fd)) {
         /* The desired fd is already in use */
+        irq_restore(state);
         return -EEXIST;
     }
+    _vfs_used_fds |= (1UL << fd);
+    irq_restore(state);
+
     kernel_pid_t pid = thread_getpid();
     if (pid == KERNEL_PID_UNDEF) {
         /* This happens when calling vfs_bind during boot, before threads have
@@ -905,6 +1041,9 @@ static inline void _free_fd(int fd)
         atomic_fetch_sub(&_vfs_open_files[fd].mp->open_files, 1);
     }
     _vfs_open_files[fd].pid = KERNEL_PID_UNDEF;
+    unsigned state = irq_disable();
+    _vfs_used_fds &= ~(1UL << fd);
+    irq_restore(state);
 }
 
 static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *mountp, int flags, void *private_data)
@@ -922,44 +1061,79 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
     return fd;
 }
 
-static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path)
+/* checks whether the mount point of mountp is a path prefix of name */
+static inline bool _is_mount_prefix(const vfs_mount_t *mountp, const char *name)
 {
-    size_t longest_match = 0;
-    size_t name_len = strlen(name);
-    mutex_lock(&_mount_mutex);
+    size_t len = mountp->mount_point_len;
+    if (strncmp(name, mountp->mount_point, len) != 0) {
+        return false;
+    }
+    /* special case for mount_point == "/", otherwise name needs to have a
+     * directory separator where the mount point name ends */
+    return (len == 1) || (name[len] == '/') || (name[len] == '\0');
+}
 
+#if VFS_MOUNT_CACHE_SIZE > 0
+/* checks whether another mount is below the mount point of mountp */
+static bool _has_submounts(const vfs_mount_t *mountp)
+{
     clist_node_t *node = _vfs_mounts_list.next;
-    if (node == NULL) {
-        /* list empty */
-        mutex_unlock(&_mount_mutex);
-        return -ENOENT;
-    }
-    vfs_mount_t *mountp = NULL;
     do {
         node = node->next;
         vfs_mount_t *it = container_of(node, vfs_mount_t, list_entry);
-        size_t len = it->mount_point_len;
-        if (len < longest_match) {
-            /* Already found a longer prefix */
-            continue;
-        }
-        if (len > name_len) {
-            /* path name is shorter than the mount point name */
-            continue;
+        if ((it != mountp) && (it->mount_point_len > mountp->mount_point_len) &&
+            _is_mount_prefix(mountp, it->mount_point)) {
+            return true;
         }
-        if ((len > 1) && (name[len] != '/') && (name[len] != '\0')) {
-            /* name does not have a directory separator where mount point name ends */
-            continue;
+    } while (node != _vfs_mounts_list.next);
+    return false;
+}
+#endif
+
+static inline void _mount_cache_clear(void)
+{
+#if VFS_MOUNT_CACHE_SIZE > 0
+    memset(_vfs_mount_cache, 0, sizeof(_vfs_mount_cache));
+#endif
+}
+
+static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path)
+{
+    vfs_mount_t *mountp = NULL;
+    mutex_lock(&_mount_mutex);
+
+#if VFS_MOUNT_CACHE_SIZE > 0
+    for (unsigned i = 0; i < VFS_MOUNT_CACHE_SIZE; i++) {
+        if ((_vfs_mount_cache[i] != NULL) && _is_mount_prefix(_vfs_mount_cache[i], name)) {
+            mountp = _vfs_mount_cache[i];
+            break;
         }
-        if (strncmp(name, it->mount_point, len) == 0) {
-            /* mount_point is a prefix of name */
-            /* special check for mount_point == "/" */
-            if (len > 1) {
-                longest_match = len;
+    }
+#endif
+
+    clist_node_t *node = _vfs_mounts_list.next;
+    if ((mountp == NULL) && (node != NULL)) {
+        size_t longest_match = 0;
+        do {
+            node = node->next;
+            vfs_mount_t *it = container_of(node, vfs_mount_t, list_entry);
+            if ((mountp != NULL) && (it->mount_point_len < longest_match)) {
+                /* Already found a longer prefix */
+                continue;
+            }
+            if (_is_mount_prefix(it, name)) {
+                longest_match = it->mount_point_len;
+                mountp = it;
             }
-            mountp = it;
+        } while (node != _vfs_mounts_list.next);
+
+#if VFS_MOUNT_CACHE_SIZE > 0
+        if ((mountp != NULL) && !_has_submounts(mountp)) {
+            _vfs_mount_cache[_vfs_mount_cache_next] = mountp;
+            _vfs_mount_cache_next = (_vfs_mount_cache_next + 1) % VFS_MOUNT_CACHE_SIZE;
         }
-    } while (node != _vfs_mounts_list.next);
+#endif
+    }
     if (mountp == NULL) {
         /* not found */
         mutex_unlock(&_mount_mutex);
@@ -970,7 +1144,8 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
     mutex_unlock(&_mount_mutex);
     *mountpp = mountp;
     if (rel_path != NULL) {
-        *rel_path = name + longest_match;
+        /* the relative path of a file on the root mount keeps its slash */
+        *rel_path = name + ((mountp->mount_point_len > 1) ? mountp->mount_point_len : 0);
     }
     return 0;
 }
@@ -980,14 +1155,36 @@ static inline int _fd_is_valid(int fd)
     if ((unsigned int)fd >= VFS_MAX_OPEN_FILES) {
         return -EBADF;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
-    if (filp->pid == KERNEL_PID_UNDEF) {
+    if (!(_vfs_used_fds & (1UL << fd))) {
         return -EBADF;
     }
+    vfs_file_t *filp = &_vfs_open_files[fd];
     if (filp->f_op == NULL) {
         return -EBADF;
     }
     return 0;
 }
 
+static inline int _fd_lock(int fd)
+{
+    int res = _fd_is_valid(fd);
+    if ((res < 0) || irq_is_in()) {
+        return res;
+    }
+    mutex_lock(&_vfs_open_files[fd].lock);
+    /* the file may have been closed while waiting for the lock */
+    res = _fd_is_valid(fd);
+    if (res < 0) {
+        mutex_unlock(&_vfs_open_files[fd].lock);
+    }
+    return res;
+}
+
+static inline void _fd_unlock(int fd)
+{
+    if (!irq_is_in()) {
+        mutex_unlock(&_vfs_open_files[fd].lock);
+    }
+}
+
 /** @} */
@@ -0,0 +1,532 @@
+/**
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup sys_xtimer
+ *
+ * @{
+ * @file
+ * @brief xtimer core functionality, hierarchical timing wheel backend
+ *
+ * Used instead of xtimer_core.c with the xtimer_wheel module.
+ *
+ * Timers are hashed by their 64 bit target into XTIMER_WHEEL_LEVELS levels of
+ * 32 slots. A level 0 slot is 2^XTIMER_WHEEL_SHIFT ticks wide, a slot of every
+ * next level is 32 times wider. When the wheel reaches a slot of a higher
+ * level, its timers are cascaded into the lower levels. Level 0 slots are
+ * moved into the sorted list of due timers one slot ahead of time, so timers
+ * still fire exactly at their target. Timers beyond the range of the top level
+ * wait in an unsorted list, which is rehashed every time the top level wraps.
+ *
+ * Setting a timer is O(1) unless it expires within the next two level 0
+ * slots, removing it scans only the slot it is hashed to.
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "board.h"
+#include "periph/timer.h"
+#include "periph_conf.h"
+
+#include "xtimer.h"
+#include "irq.h"
+
+#define ENABLE_DEBUG 0
+#include "debug.h"
+
+#define WHEEL_BITS      (5U)
+#define WHEEL_SLOTS     (1U << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SLOTS - 1)
+
+/* Range of the wheel in level 0 slots */
+#define WHEEL_RANGE     ((uint64_t)1 << (WHEEL_BITS * XTIMER_WHEEL_LEVELS))
+
+/* Values of xtimer_t::wheel_list besides the wheel slots */
+#define LIST_DUE        (XTIMER_WHEEL_LEVELS * WHEEL_SLOTS)
+#define LIST_FAR        (LIST_DUE + 1)
+#define LIST_NUMOF      (LIST_FAR + 1)
+
+/* Length of the low-level timer period in ticks */
+#define PERIOD_TICKS    ((uint64_t)1 << XTIMER_WIDTH)
+
+static volatile int _in_handler = 0;
+
+#if XTIMER_MASK
+volatile uint32_t _xtimer_high_cnt = 0;
+#endif
+
+/* Wheel slots level by level, then the due and the far lists */
+static xtimer_t *_lists[LIST_NUMOF];
+/* Non-empty slots of every level */
+static uint32_t _occupied[XTIMER_WHEEL_LEVELS];
+/* Next level 0 slot to process, timers of earlier slots are due */
+static uint64_t _tick = 0;
+
+/* 64 bit time of the start of the current low-level timer period */
+static uint64_t _period_start = 0;
+/* Low-level timer value seen last time, to notice its wrap */
+static uint32_t _last_lltimer = 0;
+/* Time the low-level timer is set to */
+static uint64_t _alarm;
+
+static void _timer_callback(void);
+static void _periph_timer_callback(void *arg, int chan);
+
+static inline int _is_set(xtimer_t *timer)
+{
+    return (timer->target || timer->long_target);
+}
+
+static inline uint64_t _target(const xtimer_t *timer)
+{
+    return ((uint64_t)timer->long_target << 32) | timer->target;
+}
+
+static inline unsigned _lsb(uint32_t v)
+{
+    return __builtin_ctzl((unsigned long)v);
+}
+
+static inline void xtimer_spin_until(uint32_t target) {
+#if XTIMER_MASK
+    target = _xtimer_lltimer_mask(target);
+#endif
+    while (_xtimer_lltimer_now() > target);
+    while (_xtimer_lltimer_now() < target);
+}
+
+static inline void _lltimer_set(uint32_t target)
+{
+    if (_in_handler) {
+        return;
+    }
+    DEBUG("_lltimer_set(): setting %" PRIu32 "\n", _xtimer_lltimer_mask(target));
+    timer_set_absolute(XTIMER_DEV, XTIMER_CHAN, _xtimer_lltimer_mask(target));
+}
+
+static void _next_period(void)
+{
+    _period_start += PERIOD_TICKS;
+#if XTIMER_MASK
+    _xtimer_high_cnt = (uint32_t)_period_start & XTIMER_MASK;
+#endif
+}
+
+/**
+ * @brief 64 bit time, must be called with interrupts disabled
+ *
+ * The low-level timer fires at least once per period, so a lower value than
+ * the one seen last time means it wrapped exactly once.
+ */
+static uint64_t _now64(void)
+{
+    uint32_t now = _xtimer_lltimer_now();
+
+    if (now < _last_lltimer) {
+        _next_period();
+    }
+    _last_lltimer = now;
+
+    return _period_start + now;
+}
+
+static void _push(unsigned list, xtimer_t *timer)
+{
+    timer->next = _lists[list];
+    timer->wheel_list = list;
+    _lists[list] = timer;
+
+    if (list < LIST_DUE) {
+        _occupied[list / WHEEL_SLOTS] |= 1UL << (list % WHEEL_SLOTS);
+    }
+}
+
+static void _push_due(xtimer_t *timer)
+{
+    xtimer_t **pos = &_lists[LIST_DUE];
+    uint64_t target = _target(timer);
+
+    while (*pos && (_target(*pos) <= target)) {
+        pos = &((*pos)->next);
+    }
+
+    timer->next = *pos;
+    timer->wheel_list = LIST_DUE;
+    *pos = timer;
+}
+
+static void _add(xtimer_t *timer)
+{
+    uint64_t slot = _target(timer) >> XTIMER_WHEEL_SHIFT;
+
+    if (slot < _tick) {
+        _push_due(timer);
+        return;
+    }
+
+    uint64_t delta = slot - _tick;
+
+    for (unsigned level = 0; level < XTIMER_WHEEL_LEVELS; level++) {
+        unsigned shift = WHEEL_BITS * level;
+
+        if ((delta >> shift) < WHEEL_SLOTS) {
+            _push(level * WHEEL_SLOTS + ((slot >> shift) & WHEEL_MASK), timer);
+            return;
+        }
+    }
+
+    _push(LIST_FAR, timer);
+}
+
+static xtimer_t *_take(unsigned list)
+{
+    xtimer_t *head = _lists[list];
+
+    _lists[list] = NULL;
+    if (list < LIST_DUE) {
+        _occupied[list / WHEEL_SLOTS] &= ~(1UL << (list % WHEEL_SLOTS));
+    }
+
+    return head;
+}
+
+static void _rehash(xtimer_t *list)
+{
+    while (list) {
+        xtimer_t *timer = list;
+        list = list->next;
+        _add(timer);
+    }
+}
+
+static void _remove(xtimer_t *timer)
+{
+    unsigned list = timer->wheel_list;
+
+    /* timer was never set, or its fields are garbage */
+    if (list >= LIST_NUMOF) {
+        return;
+    }
+
+    xtimer_t **pos = &_lists[list];
+    while (*pos && (*pos != timer)) {
+        pos = &((*pos)->next);
+    }
+
+    if (*pos == NULL) {
+        return;
+    }
+
+    *pos = timer->next;
+    if ((list < LIST_DUE) && (_lists[list] == NULL)) {
+        _occupied[list / WHEEL_SLOTS] &= ~(1UL << (list % WHEEL_SLOTS));
+    }
+
+    timer->target = 0;
+    timer->long_target = 0;
+}
+
+/**
+ * @brief first level 0 slot from _tick on that has to be processed, either
+ *        to cascade a higher level slot or to move timers to the due list
+ */
+static uint64_t _next_tick(void)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (unsigned level = 0; level < XTIMER_WHEEL_LEVELS; level++) {
+        uint32_t occupied = _occupied[level];
+
+        if (!occupied) {
+            continue;
+        }
+
+        unsigned shift = WHEEL_BITS * level;
+        uint64_t rotation = _tick & ~(((uint64_t)1 << (shift + WHEEL_BITS)) - 1);
+        /* first slot of this rotation that is not processed yet */
+        uint64_t first = ((_tick - rotation) + ((uint64_t)1 << shift) - 1) >> shift;
+        uint32_t ahead = (first < WHEEL_SLOTS) ? (occupied & (0xFFFFFFFFUL << first)) : 0;
+        uint64_t slot = ahead ? _lsb(ahead) : (WHEEL_SLOTS + _lsb(occupied));
+        uint64_t tick = rotation + (slot << shift);
+
+        if (tick < next) {
+            next = tick;
+        }
+    }
+
+    if (_lists[LIST_FAR]) {
+        uint64_t tick = (_tick + WHEEL_RANGE - 1) & ~(WHEEL_RANGE - 1);
+
+        if (tick < next) {
+            next = tick;
+        }
+    }
+
+    return next;
+}
+
+static void _process_tick(void)
+{
+    /* far timers may come into range when the top level wraps */
+    if (!(_tick & (WHEEL_RANGE - 1))) {
+        _rehash(_take(LIST_FAR));
+    }
+
+    /* cascade higher level slots starting here */
+    for (unsigned level = 1; level < XTIMER_WHEEL_LEVELS; level++) {
+        unsigned shift = WHEEL_BITS * level;
+
+        if (_tick & (((uint64_t)1 << shift) - 1)) {
+            break;
+        }
+        _rehash(_take(level * WHEEL_SLOTS + ((_tick >> shift) & WHEEL_MASK)));
+    }
+
+    xtimer_t *list = _take(_tick & WHEEL_MASK);
+    while (list) {
+        xtimer_t *timer = list;
+        list = list->next;
+        _push_due(timer);
+    }
+}
+
+/**
+ * @brief process all level 0 slots up to and including @p until
+ */
+static void _advance(uint64_t until)
+{
+    while (_tick <= until) {
+        uint64_t next = _next_tick();
+
+        if (next > until) {
+            /* nothing to do in between */
+            _tick = until + 1;
+            break;
+        }
+
+        _tick = next;
+        _process_tick();
+        _tick++;
+    }
+}
+
+static uint64_t _next_deadline(void)
+{
+    /* fire at least once per period to notice the wrap */
+    uint64_t next = _period_start + PERIOD_TICKS - 1;
+    xtimer_t *due = _lists[LIST_DUE];
+
+    if (due) {
+        uint64_t target = _target(due);
+        target = (target > XTIMER_OVERHEAD) ? (target - XTIMER_OVERHEAD) : 0;
+        if (target < next) {
+            next = target;
+        }
+    }
+
+    uint64_t tick = _next_tick();
+    if (tick != UINT64_MAX) {
+        /* pick up the slot one slot ahead of time */
+        uint64_t start = (tick > 0) ? ((tick - 1) << XTIMER_WHEEL_SHIFT) : 0;
+        if (start < next) {
+            next = start;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * @brief sets the low-level timer earlier if the new timer needs it
+ */
+static void _update_alarm(uint64_t now)
+{
+    if (_in_handler) {
+        return;
+    }
+
+    uint64_t next = _next_deadline();
+    if (next >= _alarm) {
+        return;
+    }
+
+    if (next < now + XTIMER_ISR_BACKOFF) {
+        next = now + XTIMER_ISR_BACKOFF;
+    }
+
+    _alarm = next;
+    _lltimer_set((uint32_t)next);
+}
+
+static void _insert(xtimer_t *timer, uint64_t target, uint64_t now)
+{
+    timer->target = (uint32_t)target;
+    timer->long_target = (uint32_t)(target >> 32);
+
+    _add(timer);
+    _update_alarm(now);
+}
+
+void xtimer_init(void)
+{
+    /* initialize low-level timer */
+    timer_init(XTIMER_DEV, XTIMER_HZ, _periph_timer_callback, NULL);
+
+    /* register initial overflow tick */
+    _alarm = _period_start + PERIOD_TICKS - 1;
+    _lltimer_set(0xFFFFFFFF);
+}
+
+uint64_t _xtimer_now64(void)
+{
+    unsigned state = irq_disable();
+    uint64_t now = _now64();
+    irq_restore(state);
+
+    return now;
+}
+
+void _xtimer_set64(xtimer_t *timer, uint32_t offset, uint32_t long_offset)
+{
+    DEBUG(" _xtimer_set64() offset=%" PRIu32 " long_offset=%" PRIu32 "\n", offset, long_offset);
+    if (!long_offset) {
+        /* timer fits into the short timer */
+        _xtimer_set(timer, (uint32_t) offset);
+        return;
+    }
+
+    unsigned state = irq_disable();
+    if (_is_set(timer)) {
+        _remove(timer);
+    }
+
+    uint64_t now = _now64();
+    _insert(timer, now + (((uint64_t)long_offset << 32) | offset), now);
+    irq_restore(state);
+}
+
+void _xtimer_set(xtimer_t *timer, uint32_t offset)
+{
+    DEBUG("timer_set(): offset=%" PRIu32 "\n", offset);
+    if (!timer->callback) {
+        DEBUG("timer_set(): timer has no callback.\n");
+        return;
+    }
+
+    xtimer_remove(timer);
+
+    if (offset < XTIMER_BACKOFF) {
+        _xtimer_spin(offset);
+        timer->callback(timer->arg);
+        return;
+    }
+
+    unsigned state = irq_disable();
+    uint64_t now = _now64();
+    _insert(timer, now + offset, now);
+    irq_restore(state);
+}
+
+int _xtimer_set_absolute(xtimer_t *timer, uint32_t target)
+{
+    uint32_t now = _xtimer_now();
+
+    DEBUG("timer_set_absolute(): now=%" PRIu32 " target=%" PRIu32 "\n", now, target);
+
+    timer->next = NULL;
+    if ((target >= now) && ((target - XTIMER_BACKOFF) < now)) {
+        /* backoff */
+        xtimer_spin_until(target + XTIMER_BACKOFF);
+        timer->callback(timer->arg);
+        return 0;
+    }
+
+    unsigned state = irq_disable();
+    if (_is_set(timer)) {
+        _remove(timer);
+    }
+
+    uint64_t now64 = _now64();
+    uint64_t target64 = (now64 & 0xFFFFFFFF00000000ULL) | target;
+    if (target < (uint32_t)now64) {
+        /* target is in the next 32 bit period */
+        target64 += 0x100000000ULL;
+    }
+
+    _insert(timer, target64, now64);
+    irq_restore(state);
+
+    return 0;
+}
+
+void xtimer_remove(xtimer_t *timer)
+{
+    unsigned state = irq_disable();
+    if (_is_set(timer)) {
+        _remove(timer);
+    }
+    irq_restore(state);
+}
+
+static void _periph_timer_callback(void *arg, int chan)
+{
+    (void)arg;
+    (void)chan;
+    _timer_callback();
+}
+
+/**
+ * @brief main xtimer callback function
+ */
+static void _timer_callback(void)
+{
+    uint64_t next;
+
+    _in_handler = 1;
+
+    while (1) {
+        uint64_t now = _now64();
+
+        /* due list gets the timers of this and the next slot */
+        _advance((now >> XTIMER_WHEEL_SHIFT) + 1);
+
+        xtimer_t *timer;
+        while ((timer = _lists[LIST_DUE]) && (_target(timer) <= now + XTIMER_ISR_BACKOFF)) {
+            /* make sure we don't fire too early */
+            while (_now64() < _target(timer)) {}
+
+            _lists[LIST_DUE] = timer->next;
+
+            /* make sure timer is recognized as being already fired */
+            timer->target = 0;
+            timer->long_target = 0;
+
+            timer->callback(timer->arg);
+        }
+
+        next = _next_deadline();
+        now = _now64();
+
+        if (next >= now + XTIMER_ISR_BACKOFF) {
+            break;
+        }
+
+        uint64_t period_end = _period_start + PERIOD_TICKS - 1;
+        if (next == period_end) {
+            /* end of this period is very soon, spin until the wrap */
+            while (_now64() <= period_end) {}
+        }
+    }
+
+    _in_handler = 0;
+
+    /* set low level timer */
+    _alarm = next;
+    _lltimer_set((uint32_t)next);
+}
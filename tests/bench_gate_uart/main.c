@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       LoRaLAN gateway device list dump over simulated UART
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "irq.h"
+#include "mutex.h"
+#include "thread.h"
+#include "tsrb.h"
+#include "xtimer.h"
+
+#include "pending-fifo.h"
+
+#ifndef BENCH_NODES
+#define BENCH_NODES     (1000U)
+#endif
+
+#define BAUDRATE        (115200UL)
+
+/* 8N1 */
+#define BITS_PER_BYTE   (10U)
+
+/* Line credit is in us * bit/s, one byte costs this much */
+#define BYTE_CREDIT     ((uint64_t)BITS_PER_BYTE * US_PER_SEC)
+
+#define LINE_TICK_US    (1000U)
+
+typedef void (*write_fn_t)(const char *data, size_t len);
+
+static gc_pending_fifo_t fifo;
+
+/* Simulated UART: transmit buffer is drained at the baudrate, a model of the
+ * TXE interrupt of the periph_uart_nonblocking driver */
+static tsrb_t tx_rb;
+static char tx_rb_buf[UART_TXBUF_SIZE];
+static mutex_t tx_space = MUTEX_INIT_LOCKED;
+static volatile bool tx_waiting;
+
+static xtimer_t line_timer;
+static volatile bool line_busy;
+static uint32_t line_last;
+static uint64_t line_credit;
+
+static volatile uint32_t idle_loops;
+static char idle_stack[THREAD_STACKSIZE_DEFAULT];
+
+static void line_tick(void *arg)
+{
+    (void)arg;
+
+    uint32_t now = xtimer_now_usec();
+    line_credit += (uint64_t)(now - line_last) * BAUDRATE;
+    line_last = now;
+
+    while ((line_credit >= BYTE_CREDIT) && (tsrb_get_one(&tx_rb) >= 0)) {
+        line_credit -= BYTE_CREDIT;
+    }
+
+    if (tx_waiting && (tsrb_free(&tx_rb) >= UART_TXBUF_SIZE / 2)) {
+        tx_waiting = false;
+        mutex_unlock(&tx_space);
+    }
+
+    if (tsrb_empty(&tx_rb)) {
+        line_busy = false;
+    }
+    else {
+        xtimer_set(&line_timer, LINE_TICK_US);
+    }
+}
+
+static void line_start(void)
+{
+    if (!line_busy) {
+        line_busy = true;
+        line_last = xtimer_now_usec();
+        line_credit = 0;
+        xtimer_set(&line_timer, LINE_TICK_US);
+    }
+}
+
+/* Former uart_write(): send_byte() spins on TXE for every byte */
+static void write_blocking(const char *data, size_t len)
+{
+    (void)data;
+
+    uint32_t airtime = (uint32_t)((len * BYTE_CREDIT) / BAUDRATE);
+    uint32_t start = xtimer_now_usec();
+
+    while (xtimer_now_usec() - start < airtime) {}
+}
+
+/* Model of write_nonblocking() of the stm32 UART driver: same ring buffer and
+ * wake up at half free, the driver itself can't run on native */
+static void write_buffered(const char *data, size_t len)
+{
+    while (len > 0) {
+        unsigned state = irq_disable();
+        size_t n = tsrb_add(&tx_rb, data, len);
+        if (n > 0) {
+            line_start();
+        }
+        if (n < len) {
+            tx_waiting = true;
+        }
+        irq_restore(state);
+
+        data += n;
+        len -= n;
+
+        if (len > 0) {
+            mutex_lock(&tx_space);
+        }
+    }
+}
+
+/* Gateway writer thread body */
+static void drain(write_fn_t write)
+{
+    char buf[GC_MAX_REPLY_LEN];
+    size_t len;
+
+    while ((len = gc_pending_fifo_pop(&fifo, buf)) > 0) {
+        write(buf, len);
+    }
+}
+
+/* CMD_DEVLIST reply in text mode */
+static size_t dump(write_fn_t write)
+{
+    size_t bytes = 0;
+
+    for (unsigned i = 0; i < BENCH_NODES; i++) {
+        char reply[GC_MAX_REPLY_LEN];
+        uint64_t node_id = 0x80A1B2C300000000ULL | i;
+        uint64_t app_id = 0x0000000100000000ULL | (i % 16);
+
+        size_t len = sprintf(reply, "%c%08X%08X%08X%08X%04X%04X\n", 'L',
+                             (unsigned int) (node_id >> 32), (unsigned int) (node_id & 0xFFFFFFFF),
+                             (unsigned int) (app_id >> 32), (unsigned int) (app_id & 0xFFFFFFFF),
+                             (unsigned int) (i * 3), (unsigned int) (i % 3));
+
+        while (!gc_pending_fifo_push_n(&fifo, reply, len)) {
+            drain(write);
+        }
+
+        bytes += len;
+    }
+
+    drain(write);
+
+    return bytes;
+}
+
+static void *idle_loop(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        idle_loops++;
+    }
+
+    return NULL;
+}
+
+static void bench(const char *mode, write_fn_t write, uint64_t loops_per_sec)
+{
+    uint32_t loops = idle_loops;
+    uint32_t start = xtimer_now_usec();
+
+    size_t bytes = dump(write);
+
+    /* Wait for the last byte to leave the line */
+    while (line_busy) {
+        xtimer_usleep(LINE_TICK_US);
+    }
+
+    uint32_t elapsed = xtimer_now_usec() - start;
+    loops = idle_loops - loops;
+
+    /* Share of CPU left for other threads during the dump */
+    uint64_t expected = (loops_per_sec * elapsed) / US_PER_SEC;
+    unsigned cpu_free = (expected > 0) ? (unsigned)(((uint64_t)loops * 100) / expected) : 0;
+    if (cpu_free > 100) {
+        cpu_free = 100;
+    }
+
+    printf("{ \"mode\" : \"%s\", \"nodes\" : %u, \"bytes\" : %u, \"dump_ms\" : %" PRIu32 ", \"cpu_free\" : %u }\n",
+           mode, BENCH_NODES, (unsigned)bytes, elapsed / US_PER_MS, cpu_free);
+}
+
+int main(void)
+{
+    puts("LoRaLAN gateway device list dump benchmark");
+
+    gc_pending_fifo_init(&fifo);
+    tsrb_init(&tx_rb, tx_rb_buf, UART_TXBUF_SIZE);
+    line_timer.callback = line_tick;
+
+    thread_create(idle_stack, sizeof(idle_stack), THREAD_PRIORITY_MAIN + 1,
+                  0, idle_loop, NULL, "idle loop");
+
+    /* Calibrate the idle loop while nothing else runs */
+    uint32_t loops = idle_loops;
+    xtimer_usleep(500 * US_PER_MS);
+    uint64_t loops_per_sec = (uint64_t)(idle_loops - loops) * 2;
+
+    bench("blocking", write_blocking, loops_per_sec);
+    bench("buffered", write_buffered, loops_per_sec);
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
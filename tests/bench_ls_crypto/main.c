@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       LoRaLAN frame encryption and MIC benchmark
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "xtimer.h"
+
+#include "crypto/aes.h"
+#include "crypto/ciphers.h"
+#include "hashes/sha256.h"
+
+#include "ls-crypto.h"
+
+#ifndef BENCH_FRAMES
+#define BENCH_FRAMES    (20000U)
+#endif
+
+static const unsigned payload_sizes[] = { 16, 64, 128 };
+
+static const ls_nonce_t dev_nonce = 0x1234ABCD;
+static const uint32_t app_nonce = 0x55AA0110;
+static const ls_addr_t dev_addr = 0x0000002A;
+
+static ls_frame_t frame;
+
+/* Same layout as in ls-crypto.c */
+typedef struct  __attribute__((packed)) {
+    uint8_t fb;
+    uint32_t u8_pad;
+    uint8_t dir;
+    le_uint32_t dev_addr;
+    le_uint32_t fcnt;
+    uint8_t u32_pad;
+    uint8_t len;
+} lorawan_block_t;
+
+/* Former payload encryption, cipher_encrypt() expands the key for every block */
+static void legacy_encrypt_frame_payload(uint8_t *key, ls_frame_t *frame)
+{
+    uint16_t size = frame->payload.len;
+    uint8_t s_block[AES_BLOCK_SIZE];
+    lorawan_block_t a_block;
+    uint16_t buf_idx = 0;
+    uint16_t ctr = 1;
+
+    cipher_t context;
+    cipher_init(&context, CIPHER_AES_128, key, AES_KEY_SIZE);
+
+    a_block.fb = 0x1;
+    a_block.u8_pad = 0;
+    a_block.u32_pad = 0;
+    a_block.dir = frame->header.type;
+    a_block.dev_addr = byteorder_btoll(byteorder_htonl(frame->header.dev_addr));
+    a_block.fcnt = byteorder_btoll(byteorder_htonl(frame->header.fid));
+
+    uint8_t *buffer = frame->payload.data;
+
+    while (size > 0) {
+        uint16_t chunk = (size < AES_BLOCK_SIZE) ? size : AES_BLOCK_SIZE;
+
+        a_block.len = ((ctr) & 0xFF);
+        ctr++;
+
+        cipher_encrypt(&context, (uint8_t *) &a_block, s_block);
+        for (uint16_t i = 0; i < chunk; i++) {
+            buffer[buf_idx + i] ^= s_block[i];
+        }
+
+        size -= chunk;
+        buf_idx += chunk;
+    }
+}
+
+/* Former MIC calculation, hashes the HMAC key pads for every frame */
+static ls_mic_t legacy_calculate_mic(uint8_t *key, ls_frame_t *frame, uint8_t payload_size)
+{
+    uint8_t *ptr = ((uint8_t *) frame) + 4;
+    uint8_t size = sizeof(ls_header_t) - 4 + sizeof(ls_payload_len_t) + payload_size;
+    unsigned char hmac[SHA256_DIGEST_LENGTH];
+
+    hmac_sha256(key, LS_MIC_KEY_LEN, ptr, size, hmac);
+
+    return (hmac[0] << 16) | (hmac[1] << 8) | (hmac[2]);
+}
+
+static void fill_frame(unsigned payload)
+{
+    frame.header.type = LS_DL;
+    frame.header.dev_addr = dev_addr;
+    frame.header.fid = 1;
+    frame.payload.len = payload;
+
+    for (unsigned i = 0; i < payload; i++) {
+        frame.payload.data[i] = i;
+    }
+}
+
+static uint32_t to_fps(uint32_t elapsed)
+{
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+
+    return (uint32_t)(((uint64_t)BENCH_FRAMES * US_PER_SEC) / elapsed);
+}
+
+static uint32_t bench_legacy(unsigned payload)
+{
+    uint8_t mic_key[AES_BLOCK_SIZE];
+    uint8_t aes_key[AES_BLOCK_SIZE];
+
+    fill_frame(payload);
+
+    uint32_t start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_FRAMES; i++) {
+        ls_derive_keys(dev_nonce, app_nonce, dev_addr, mic_key, aes_key);
+        legacy_encrypt_frame_payload(aes_key, &frame);
+        frame.header.mic = legacy_calculate_mic(mic_key, &frame, frame.payload.len);
+    }
+
+    return to_fps(xtimer_now_usec() - start);
+}
+
+static uint32_t bench_cached(unsigned payload)
+{
+    uint8_t mic_key[AES_BLOCK_SIZE];
+    uint8_t aes_key[AES_BLOCK_SIZE];
+    hmac_sha256_snapshot_t mic_state;
+    AES_KEY schedule;
+    size_t size;
+
+    /* Done once per join */
+    ls_derive_keys(dev_nonce, app_nonce, dev_addr, mic_key, aes_key);
+    ls_precompute_mic_key(mic_key, &mic_state);
+    aes_expand_encrypt_key(aes_key, AES_KEY_SIZE, &schedule);
+
+    fill_frame(payload);
+
+    uint32_t start = xtimer_now_usec();
+    for (unsigned i = 0; i < BENCH_FRAMES; i++) {
+        ls_encrypt_frame_expanded(&mic_state, &schedule, &frame, &size);
+    }
+
+    return to_fps(xtimer_now_usec() - start);
+}
+
+static bool check_same_output(unsigned payload)
+{
+    uint8_t mic_key[AES_BLOCK_SIZE];
+    uint8_t aes_key[AES_BLOCK_SIZE];
+    ls_frame_t legacy;
+    size_t size;
+
+    ls_derive_keys(dev_nonce, app_nonce, dev_addr, mic_key, aes_key);
+
+    fill_frame(payload);
+    legacy = frame;
+
+    legacy_encrypt_frame_payload(aes_key, &legacy);
+    legacy.header.mic = legacy_calculate_mic(mic_key, &legacy, legacy.payload.len);
+
+    ls_encrypt_frame(mic_key, aes_key, &frame, &size);
+
+    return (frame.header.mic == legacy.header.mic) &&
+           (memcmp(frame.payload.data, legacy.payload.data, payload) == 0);
+}
+
+int main(void)
+{
+    puts("LoRaLAN frame crypto benchmark");
+
+    for (unsigned i = 0; i < sizeof(payload_sizes) / sizeof(payload_sizes[0]); i++) {
+        unsigned payload = payload_sizes[i];
+
+        if (!check_same_output(payload)) {
+            printf("[FAILED] ciphertext mismatch for %u bytes payload\n", payload);
+            return 1;
+        }
+
+        uint32_t legacy_fps = bench_legacy(payload);
+        uint32_t cached_fps = bench_cached(payload);
+
+        printf("{ \"payload\" : %u, \"legacy_fps\" : %" PRIu32 ", \"cached_fps\" : %" PRIu32 " }\n",
+               payload, legacy_fps, cached_fps);
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
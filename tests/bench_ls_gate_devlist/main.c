@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       LoRaLAN gateway device list lookup benchmark
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "random.h"
+#include "xtimer.h"
+
+#include "ls-gate-device-list.h"
+
+#ifndef BENCH_LOOKUP_ROUNDS
+#define BENCH_LOOKUP_ROUNDS     (10U)
+#endif
+
+static const unsigned fleet_sizes[] = { 100, 1000, 10000 };
+
+static uint64_t node_ids[LS_GATE_MAX_NODES];
+
+static ls_gate_devices_t devlist;
+
+/* Former device list layout, scanned linearly up to its capacity */
+static ls_gate_node_t legacy_nodes[LS_GATE_MAX_NODES];
+static bool legacy_free_list[LS_GATE_MAX_NODES];
+
+static ls_gate_node_t *legacy_get_by_nodeid(unsigned capacity, uint64_t nodeid)
+{
+    for (uint32_t i = 0; i < capacity; i++) {
+        /* Skip free cells */
+        if (legacy_free_list[i]) {
+            continue;
+        }
+
+        if (legacy_nodes[i].node_id == nodeid) {
+            return &legacy_nodes[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void legacy_fill(unsigned capacity)
+{
+    for (unsigned i = 0; i < capacity; i++) {
+        legacy_free_list[i] = false;
+        legacy_nodes[i].node_id = node_ids[i];
+        legacy_nodes[i].addr = i;
+    }
+}
+
+static uint32_t bench_linear(unsigned nodes)
+{
+    unsigned found = 0;
+    legacy_fill(nodes);
+
+    uint32_t start = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_LOOKUP_ROUNDS; r++) {
+        for (unsigned i = 0; i < nodes; i++) {
+            found += (legacy_get_by_nodeid(nodes, node_ids[i]) != NULL);
+        }
+    }
+    uint32_t elapsed = xtimer_now_usec() - start;
+
+    if (found != nodes * BENCH_LOOKUP_ROUNDS) {
+        puts("[FAILED] linear lookup missed a node");
+    }
+
+    return (uint32_t)(((uint64_t)elapsed * 1000) / (nodes * BENCH_LOOKUP_ROUNDS));
+}
+
+static uint32_t bench_hashed(unsigned nodes)
+{
+    unsigned found = 0;
+    ls_devlist_init(&devlist);
+
+    for (unsigned i = 0; i < nodes; i++) {
+        if (ls_devlist_add(&devlist, node_ids[i], 0, i + 1, NULL) == NULL) {
+            puts("[FAILED] unable to add node");
+            return 0;
+        }
+    }
+
+    uint32_t start = xtimer_now_usec();
+    for (unsigned r = 0; r < BENCH_LOOKUP_ROUNDS; r++) {
+        for (unsigned i = 0; i < nodes; i++) {
+            found += (ls_devlist_get_by_nodeid(&devlist, node_ids[i]) != NULL);
+        }
+    }
+    uint32_t elapsed = xtimer_now_usec() - start;
+
+    if (found != nodes * BENCH_LOOKUP_ROUNDS) {
+        puts("[FAILED] hashed lookup missed a node");
+    }
+
+    return (uint32_t)(((uint64_t)elapsed * 1000) / (nodes * BENCH_LOOKUP_ROUNDS));
+}
+
+int main(void)
+{
+    puts("LoRaLAN gateway device list benchmark");
+
+    for (unsigned i = 0; i < LS_GATE_MAX_NODES; i++) {
+        node_ids[i] = ((uint64_t)random_uint32() << 32) | random_uint32();
+    }
+
+    for (unsigned i = 0; i < sizeof(fleet_sizes) / sizeof(fleet_sizes[0]); i++) {
+        unsigned nodes = fleet_sizes[i];
+
+        uint32_t linear_ns = bench_linear(nodes);
+        uint32_t hashed_ns = bench_hashed(nodes);
+
+        printf("{ \"nodes\" : %u, \"linear_ns\" : %" PRIu32 ", \"hashed_ns\" : %" PRIu32 " }\n",
+               nodes, linear_ns, hashed_ns);
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
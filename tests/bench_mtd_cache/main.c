@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       littlefs file operations with and without the MTD page cache
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <inttypes.h>
+
+#include "board.h"
+#include "fs/littlefs_fs.h"
+#include "mtd.h"
+#include "mtd_cache.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define FS_SECTORS      (64U)
+
+#define FILES           (8U)
+#define RECORDS         (32U)
+#define RECORD_SIZE     (24U)
+#define STAT_ROUNDS     (4U)
+
+#define CACHE_PAGES     (16U)
+#define CACHE_READAHEAD (2U)
+
+/* stacked MTD counting the accesses to the device below */
+typedef struct {
+    mtd_dev_t base;
+    mtd_dev_t *parent;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t erases;
+} counter_t;
+
+static int _counter_init(mtd_dev_t *dev)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    dev->sector_count = counter->parent->sector_count;
+    dev->pages_per_sector = counter->parent->pages_per_sector;
+    dev->page_size = counter->parent->page_size;
+    return mtd_init(counter->parent);
+}
+
+static int _counter_read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    counter->reads++;
+    return mtd_read(counter->parent, buff, addr, size);
+}
+
+static int _counter_write(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                          uint32_t size)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    counter->writes++;
+    return mtd_write(counter->parent, buff, addr, size);
+}
+
+static int _counter_erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    counter->erases++;
+    return mtd_erase(counter->parent, addr, size);
+}
+
+static const mtd_desc_t counter_driver = {
+    .init = _counter_init,
+    .read = _counter_read,
+    .write = _counter_write,
+    .erase = _counter_erase,
+};
+
+static counter_t counter = {
+    .base = { .driver = &counter_driver },
+};
+
+static uint8_t cache_buf[CACHE_PAGES * MTD_PAGE_SIZE];
+static mtd_cache_page_t cache_pages[CACHE_PAGES];
+static mtd_cache_t cache = {
+    .base = { .driver = &mtd_cache_driver },
+    .parent = &counter.base,
+    .buf = cache_buf,
+    .pages = cache_pages,
+    .numof = CACHE_PAGES,
+    .readahead = CACHE_READAHEAD,
+};
+
+static littlefs_desc_t fs_desc;
+static vfs_mount_t fs_mount = {
+    .fs = &littlefs_file_system,
+    .mount_point = "/lfs",
+    .private_data = &fs_desc,
+};
+
+static void record(unsigned file, unsigned i, uint8_t *buf)
+{
+    for (unsigned j = 0; j < RECORD_SIZE; j++) {
+        buf[j] = (uint8_t)(file * 31 + i * 7 + j);
+    }
+}
+
+static void path(unsigned file, char *buf)
+{
+    sprintf(buf, "/lfs/log%u", file);
+}
+
+static int write_files(void)
+{
+    uint8_t buf[RECORD_SIZE];
+    char name[16];
+
+    for (unsigned f = 0; f < FILES; f++) {
+        path(f, name);
+        int fd = vfs_open(name, O_CREAT | O_WRONLY | O_APPEND, 0);
+        if (fd < 0) {
+            return fd;
+        }
+        for (unsigned i = 0; i < RECORDS; i++) {
+            record(f, i, buf);
+            if (vfs_write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+                vfs_close(fd);
+                return -1;
+            }
+        }
+        if (vfs_close(fd) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int read_files(void)
+{
+    uint8_t buf[RECORD_SIZE], expected[RECORD_SIZE];
+    char name[16];
+
+    for (unsigned f = 0; f < FILES; f++) {
+        path(f, name);
+        int fd = vfs_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            return fd;
+        }
+        for (unsigned i = 0; i < RECORDS; i++) {
+            record(f, i, expected);
+            if ((vfs_read(fd, buf, sizeof(buf)) != sizeof(buf)) ||
+                (memcmp(buf, expected, sizeof(buf)) != 0)) {
+                vfs_close(fd);
+                return -1;
+            }
+        }
+        vfs_close(fd);
+    }
+    return 0;
+}
+
+static int stat_files(void)
+{
+    struct stat st;
+    char name[16];
+    vfs_DIR dir;
+    vfs_dirent_t entry;
+    unsigned entries = 0;
+
+    for (unsigned n = 0; n < STAT_ROUNDS; n++) {
+        for (unsigned f = 0; f < FILES; f++) {
+            path(f, name);
+            if ((vfs_stat(name, &st) < 0) ||
+                (st.st_size != (RECORDS * RECORD_SIZE))) {
+                return -1;
+            }
+        }
+    }
+    if (vfs_opendir(&dir, "/lfs") < 0) {
+        return -1;
+    }
+    while (vfs_readdir(&dir, &entry) > 0) {
+        entries++;
+    }
+    vfs_closedir(&dir);
+
+    /* ".", ".." and the files */
+    return (entries == FILES + 2) ? 0 : -1;
+}
+
+static int bench(const char *device, mtd_dev_t *dev)
+{
+    uint32_t start, time;
+
+    fs_desc.dev = dev;
+    fs_desc.config.block_count = FS_SECTORS;
+    counter.reads = counter.writes = counter.erases = 0;
+    memset(&cache.stats, 0, sizeof(cache.stats));
+
+    start = xtimer_now_usec();
+    if ((vfs_format(&fs_mount) < 0) || (vfs_mount(&fs_mount) < 0)) {
+        puts("mount failed");
+        return -1;
+    }
+    if ((write_files() < 0) || (read_files() < 0) || (stat_files() < 0)) {
+        puts("file operation failed");
+        vfs_umount(&fs_mount);
+        return -1;
+    }
+    if (vfs_umount(&fs_mount) < 0) {
+        puts("umount failed");
+        return -1;
+    }
+    time = xtimer_now_usec() - start;
+
+    printf("{ \"device\" : \"%s\", \"time_us\" : %" PRIu32 ", \"reads\" : %" PRIu32
+           ", \"writes\" : %" PRIu32 ", \"erases\" : %" PRIu32 ", \"hits\" : %" PRIu32
+           ", \"misses\" : %" PRIu32 " }\n",
+           device, time, counter.reads, counter.writes, counter.erases,
+           cache.stats.hits, cache.stats.misses);
+
+    return 0;
+}
+
+int main(void)
+{
+    puts("MTD cache littlefs benchmark");
+
+    counter.parent = MTD_0;
+
+    if ((bench("mtd", &counter.base) != 0) ||
+        (bench("cache", &cache.base) != 0)) {
+        puts("[FAILED]");
+        return 1;
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+
+
+def testfunc(child):
+    for device in ("mtd", "cache"):
+        child.expect(r"{ \"device\" : \"%s\", \"time_us\" : \d+, \"reads\" : \d+, "
+                     r"\"writes\" : \d+, \"erases\" : \d+, \"hits\" : \d+, "
+                     r"\"misses\" : \d+ }" % device)
+    child.expect_exact("[SUCCESS]")
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTTOOLS'], 'testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc, timeout=300))
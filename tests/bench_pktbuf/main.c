@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Static packet buffer under 6LoWPAN fragmentation traffic
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "random.h"
+#include "xtimer.h"
+#include "net/gnrc/netif/hdr.h"
+#include "net/gnrc/pktbuf.h"
+
+#ifdef MODULE_GNRC_PKTBUF_STATIC_SEG
+#define ALLOCATOR       "seg"
+#else
+#define ALLOCATOR       "first_fit"
+#endif
+
+#define STEPS           (50000U)
+#define SEED            (0x6c6f7770)
+
+#define FLOWS_MAX       (12U)
+
+/* netif header with two long link layer addresses */
+#define NETIF_HDR_SIZE  (sizeof(gnrc_netif_hdr_t) + 16)
+/* FRAG1/FRAGN header */
+#define FRAG_HDR_SIZE   (4U)
+/* 6LoWPAN payload of a full 802.15.4 frame */
+#define FRAG_PAYLOAD    (96U)
+
+#define IPV6_HDR_SIZE   (40U)
+#define UDP_HDR_SIZE    (8U)
+
+typedef struct {
+    gnrc_pktsnip_t *pkt;    /* reassembly buffer or datagram to send */
+    gnrc_pktsnip_t *frag;   /* fragment in the send queue */
+    size_t size;            /* datagram size */
+    size_t done;            /* bytes received or sent */
+    bool tx;
+} flow_t;
+
+static const unsigned flow_counts[] = { 2, 4, 8, 12 };
+
+static flow_t flows[FLOWS_MAX];
+static uint8_t frame_buf[FRAG_HDR_SIZE + FRAG_PAYLOAD];
+static unsigned ops;
+static unsigned drops;
+
+/* short sensor readings, medium sized messages and full IPv6 MTU packets */
+static size_t datagram_size(void)
+{
+    uint32_t r = random_uint32_range(0, 10);
+
+    if (r < 4) {
+        return random_uint32_range(60, 200);
+    }
+    if (r < 8) {
+        return random_uint32_range(200, 600);
+    }
+    return 1280;
+}
+
+static gnrc_pktsnip_t *add(gnrc_pktsnip_t *next, size_t size, gnrc_nettype_t type)
+{
+    ops++;
+    return gnrc_pktbuf_add(next, NULL, size, type);
+}
+
+static void release(gnrc_pktsnip_t *pkt)
+{
+    if (pkt != NULL) {
+        ops++;
+        gnrc_pktbuf_release(pkt);
+    }
+}
+
+static void flow_start(flow_t *flow)
+{
+    flow->pkt = NULL;
+    flow->frag = NULL;
+    flow->size = datagram_size();
+    flow->done = 0;
+    flow->tx = (random_uint32() & 1);
+}
+
+static void flow_drop(flow_t *flow)
+{
+    release(flow->frag);
+    release(flow->pkt);
+    drops++;
+    flow_start(flow);
+}
+
+/* Frame arrives from the radio, its payload goes to the reassembly buffer */
+static int flow_rx(flow_t *flow)
+{
+    size_t len = flow->size - flow->done;
+    gnrc_pktsnip_t *netif, *frame;
+
+    if (len > FRAG_PAYLOAD) {
+        len = FRAG_PAYLOAD;
+    }
+    if ((netif = add(NULL, NETIF_HDR_SIZE, GNRC_NETTYPE_NETIF)) == NULL) {
+        return -1;
+    }
+    if ((frame = add(netif, FRAG_HDR_SIZE + len, GNRC_NETTYPE_UNDEF)) == NULL) {
+        release(netif);
+        return -1;
+    }
+    memcpy(frame->data, frame_buf, frame->size);
+    ops++;
+    /* 6LoWPAN header is marked off like gnrc_sixlowpan does it */
+    if (gnrc_pktbuf_mark(frame, FRAG_HDR_SIZE, GNRC_NETTYPE_UNDEF) == NULL) {
+        release(frame);
+        return -1;
+    }
+    if ((flow->pkt == NULL) &&
+        ((flow->pkt = add(NULL, flow->size, GNRC_NETTYPE_UNDEF)) == NULL)) {
+        release(frame);
+        return -1;
+    }
+    memcpy((uint8_t *)flow->pkt->data + flow->done, frame->data, len);
+    release(frame);
+    flow->done += len;
+
+    return 0;
+}
+
+/* Next fragment goes out, the previous one has left the send queue */
+static int flow_tx(flow_t *flow)
+{
+    size_t len = flow->size - flow->done;
+    gnrc_pktsnip_t *frag;
+
+    if (flow->pkt == NULL) {
+        static const size_t hdr_sizes[] = { UDP_HDR_SIZE, IPV6_HDR_SIZE };
+        gnrc_pktsnip_t *pkt;
+
+        if ((flow->pkt = add(NULL, flow->size - IPV6_HDR_SIZE - UDP_HDR_SIZE,
+                             GNRC_NETTYPE_UNDEF)) == NULL) {
+            return -1;
+        }
+        for (unsigned i = 0; i < sizeof(hdr_sizes) / sizeof(hdr_sizes[0]); i++) {
+            if ((pkt = add(flow->pkt, hdr_sizes[i], GNRC_NETTYPE_UNDEF)) == NULL) {
+                return -1;
+            }
+            flow->pkt = pkt;
+        }
+    }
+    release(flow->frag);
+    flow->frag = NULL;
+
+    if (len > FRAG_PAYLOAD) {
+        len = FRAG_PAYLOAD;
+    }
+    if ((frag = add(NULL, FRAG_HDR_SIZE + len, GNRC_NETTYPE_UNDEF)) == NULL) {
+        return -1;
+    }
+    if ((flow->frag = add(frag, NETIF_HDR_SIZE, GNRC_NETTYPE_NETIF)) == NULL) {
+        flow->frag = frag;
+        return -1;
+    }
+    flow->done += len;
+
+    return 0;
+}
+
+static void flow_step(flow_t *flow)
+{
+    if (flow->done == flow->size) {
+        /* datagram delivered or sent completely */
+        release(flow->frag);
+        release(flow->pkt);
+        flow_start(flow);
+    }
+    if ((flow->tx ? flow_tx(flow) : flow_rx(flow)) != 0) {
+        flow_drop(flow);
+    }
+}
+
+static int bench(unsigned numof)
+{
+    gnrc_pktbuf_usage_t usage;
+    uint32_t start, time;
+
+    random_init(SEED);
+    gnrc_pktbuf_init();
+    ops = 0;
+    drops = 0;
+
+    for (unsigned i = 0; i < numof; i++) {
+        flow_start(&flows[i]);
+    }
+
+    start = xtimer_now_usec();
+    for (unsigned n = 0; n < STEPS; n++) {
+        flow_step(&flows[random_uint32_range(0, numof)]);
+    }
+    time = xtimer_now_usec() - start;
+
+    for (unsigned i = 0; i < numof; i++) {
+        release(flows[i].frag);
+        release(flows[i].pkt);
+    }
+
+    gnrc_pktbuf_get_usage(&usage);
+    if (usage.used != 0) {
+        printf("%u bytes left in packet buffer\n", (unsigned)usage.used);
+        return -1;
+    }
+
+    printf("{ \"allocator\" : \"%s\", \"flows\" : %u, \"ops\" : %u, \"op_ns\" : %" PRIu32
+           ", \"drops\" : %u, \"frag_fails\" : %u, \"max_used\" : %u }\n",
+           ALLOCATOR, numof, ops, (uint32_t)(((uint64_t)time * NS_PER_US) / ops),
+           drops, usage.frag_fails, (unsigned)usage.max_used);
+
+    return 0;
+}
+
+int main(void)
+{
+    puts("Packet buffer fragmentation benchmark");
+
+    for (unsigned i = 0; i < sizeof(frame_buf); i++) {
+        frame_buf[i] = i;
+    }
+
+    for (unsigned i = 0; i < sizeof(flow_counts) / sizeof(flow_counts[0]); i++) {
+        if (bench(flow_counts[i]) != 0) {
+            puts("[FAILED]");
+            return 1;
+        }
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
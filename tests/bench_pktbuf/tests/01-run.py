@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+
+
+def testfunc(child):
+    for flows in (2, 4, 8, 12):
+        child.expect(r"{ \"allocator\" : \"\w+\", \"flows\" : %d, \"ops\" : \d+, "
+                     r"\"op_ns\" : \d+, \"drops\" : \d+, \"frag_fails\" : \d+, "
+                     r"\"max_used\" : \d+ }" % flows)
+    child.expect_exact("[SUCCESS]")
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTTOOLS'], 'testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc, timeout=120))
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       FIB and NIB forwarding table lookup cost with many routes
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "random.h"
+#include "xtimer.h"
+#include "net/fib.h"
+#include "net/gnrc/ipv6/nib.h"
+#include "net/gnrc/ipv6/nib/ft.h"
+
+#if defined(MODULE_FIB_LPM) && defined(MODULE_GNRC_IPV6_NIB_LPM)
+#define INDEX           "lpm"
+#else
+#define INDEX           "linear"
+#endif
+
+#define ROUTES_MAX      (GNRC_IPV6_NIB_OFFL_NUMOF)
+#define LOOKUPS         (20000U)
+
+#define IFACE           (7)
+#define NEXT_HOPS       (8U)
+
+static const unsigned populations[] = { 10, 100, 500, 1000 };
+
+static fib_entry_t fib_entries[ROUTES_MAX];
+static fib_table_t fib_table = { .data.entries = fib_entries,
+                                 .table_type = FIB_TABLE_TYPE_SH,
+                                 .size = ROUTES_MAX,
+                                 .mtx_access = MUTEX_INIT,
+                                 .notify_rp_pos = 0 };
+
+static ipv6_addr_t dsts[ROUTES_MAX];
+static ipv6_addr_t next_hops[NEXT_HOPS];
+
+/* Every eighth route is the /64 prefix 2001:db8:0:<i>::, the routes in
+ * between are /128 host routes inside that prefix, 2001:db8:0:<i & ~7>::<i> */
+static unsigned route_len(unsigned i)
+{
+    return (i % 8) ? 128 : 64;
+}
+
+static void route_init(unsigned i)
+{
+    ipv6_addr_from_str(&dsts[i], "2001:db8::");
+    dsts[i].u16[3] = byteorder_htons(i & ~7U);
+    if (route_len(i) == 128) {
+        dsts[i].u16[7] = byteorder_htons(i);
+    }
+}
+
+/* Destination to look up for route i, prefix routes are hit with an address
+ * that matches no host route */
+static void route_dst(unsigned i, ipv6_addr_t *addr)
+{
+    *addr = dsts[i];
+    if (route_len(i) == 64) {
+        addr->u16[6] = byteorder_htons(0xffff);
+    }
+}
+
+static const ipv6_addr_t *route_next_hop(unsigned i)
+{
+    return &next_hops[i % NEXT_HOPS];
+}
+
+static int route_add(unsigned i)
+{
+    uint32_t flags = 0;
+
+    if (route_len(i) < 128) {
+        flags = (uint32_t)route_len(i) << FIB_FLAG_NET_PREFIX_SHIFT;
+    }
+
+    if (fib_add_entry(&fib_table, IFACE, dsts[i].u8, sizeof(ipv6_addr_t),
+                      flags, (uint8_t *)route_next_hop(i), sizeof(ipv6_addr_t),
+                      0, (uint32_t)FIB_LIFETIME_NO_EXPIRE) != 0) {
+        return -1;
+    }
+    if (gnrc_ipv6_nib_ft_add(&dsts[i], route_len(i), route_next_hop(i),
+                             IFACE, 0) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int fib_lookup(unsigned i)
+{
+    ipv6_addr_t dst, next_hop;
+    kernel_pid_t iface = KERNEL_PID_UNDEF;
+    size_t next_hop_size = sizeof(next_hop);
+    uint32_t next_hop_flags;
+
+    route_dst(i, &dst);
+    if (fib_get_next_hop(&fib_table, &iface, next_hop.u8, &next_hop_size,
+                         &next_hop_flags, dst.u8, sizeof(dst), 0) != 0) {
+        return -1;
+    }
+
+    return ipv6_addr_equal(&next_hop, route_next_hop(i)) ? 0 : -1;
+}
+
+static int nib_lookup(unsigned i)
+{
+    ipv6_addr_t dst;
+    gnrc_ipv6_nib_ft_t fte;
+
+    route_dst(i, &dst);
+    if (gnrc_ipv6_nib_ft_get(&dst, NULL, &fte) != 0) {
+        return -1;
+    }
+
+    return ipv6_addr_equal(&fte.next_hop, route_next_hop(i)) ? 0 : -1;
+}
+
+static int bench(int (*lookup)(unsigned), unsigned routes, uint32_t *ns)
+{
+    uint32_t start = xtimer_now_usec();
+
+    for (unsigned n = 0; n < LOOKUPS; n++) {
+        if (lookup(random_uint32_range(0, routes)) != 0) {
+            return -1;
+        }
+    }
+
+    *ns = (uint32_t)(((uint64_t)(xtimer_now_usec() - start) * NS_PER_US) / LOOKUPS);
+
+    return 0;
+}
+
+int main(void)
+{
+    unsigned routes = 0;
+
+    puts("Forwarding table lookup benchmark");
+
+    for (unsigned i = 0; i < NEXT_HOPS; i++) {
+        ipv6_addr_from_str(&next_hops[i], "fe80::1");
+        next_hops[i].u8[15] = i + 1;
+    }
+    for (unsigned i = 0; i < ROUTES_MAX; i++) {
+        route_init(i);
+    }
+
+    fib_init(&fib_table);
+    gnrc_ipv6_nib_init();
+
+    for (unsigned p = 0; p < sizeof(populations) / sizeof(populations[0]); p++) {
+        uint32_t fib_ns, nib_ns;
+
+        for (; routes < populations[p]; routes++) {
+            if (route_add(routes) != 0) {
+                printf("adding route %u failed\n", routes);
+                puts("[FAILED]");
+                return 1;
+            }
+        }
+
+        if ((bench(fib_lookup, routes, &fib_ns) != 0) ||
+            (bench(nib_lookup, routes, &nib_ns) != 0)) {
+            puts("wrong next hop");
+            puts("[FAILED]");
+            return 1;
+        }
+
+        printf("{ \"index\" : \"%s\", \"routes\" : %u, \"fib_ns\" : %" PRIu32 ", \"nib_ns\" : %" PRIu32 " }\n",
+               INDEX, routes, fib_ns, nib_ns);
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Sensor data logger throughput on littlefs
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "board.h"
+#include "fs/littlefs_fs.h"
+#include "mtd.h"
+#include "sensorlog.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define FS_SECTORS      (64U)
+
+#define RECORDS         (512U)
+#define DATA_SIZE       (16U)
+#define RECORD_SIZE     (SENSORLOG_HDR_SIZE + DATA_SIZE)
+
+#define FILE_SIZE       (4096U)
+#define FILES           (8U)
+
+/* one record, one flash page and four flash pages */
+static const size_t batches[] = { RECORD_SIZE, MTD_PAGE_SIZE, 4 * MTD_PAGE_SIZE };
+
+/* stacked MTD counting the accesses to the device below */
+typedef struct {
+    mtd_dev_t base;
+    mtd_dev_t *parent;
+    uint32_t writes;
+    uint32_t erases;
+} counter_t;
+
+static int _counter_init(mtd_dev_t *dev)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    dev->sector_count = counter->parent->sector_count;
+    dev->pages_per_sector = counter->parent->pages_per_sector;
+    dev->page_size = counter->parent->page_size;
+    return mtd_init(counter->parent);
+}
+
+static int _counter_read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    return mtd_read(counter->parent, buff, addr, size);
+}
+
+static int _counter_write(mtd_dev_t *dev, const void *buff, uint32_t addr,
+                          uint32_t size)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    counter->writes++;
+    return mtd_write(counter->parent, buff, addr, size);
+}
+
+static int _counter_erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    counter_t *counter = (counter_t *)dev;
+
+    counter->erases++;
+    return mtd_erase(counter->parent, addr, size);
+}
+
+static const mtd_desc_t counter_driver = {
+    .init = _counter_init,
+    .read = _counter_read,
+    .write = _counter_write,
+    .erase = _counter_erase,
+};
+
+static counter_t counter = {
+    .base = { .driver = &counter_driver },
+};
+
+static littlefs_desc_t fs_desc;
+static vfs_mount_t fs_mount = {
+    .fs = &littlefs_file_system,
+    .mount_point = "/lfs",
+    .private_data = &fs_desc,
+};
+
+static uint8_t buf[4 * MTD_PAGE_SIZE];
+static sensorlog_t log_desc;
+static uint32_t replayed;
+
+static void record(uint32_t n, uint8_t *data)
+{
+    for (unsigned j = 0; j < DATA_SIZE; j++) {
+        data[j] = (uint8_t)(n * 7 + j);
+    }
+}
+
+static int check(void *arg, const sensorlog_record_t *rec, const uint8_t *data)
+{
+    uint8_t expected[DATA_SIZE];
+
+    (void)arg;
+    record(replayed, expected);
+    if ((rec->time != replayed) || (rec->len != DATA_SIZE) ||
+        (memcmp(data, expected, DATA_SIZE) != 0)) {
+        return -1;
+    }
+    replayed++;
+    return 0;
+}
+
+static int bench(size_t batch)
+{
+    uint8_t data[DATA_SIZE];
+    uint32_t start, write_time, replay_time;
+
+    fs_desc.dev = &counter.base;
+    fs_desc.config.block_count = FS_SECTORS;
+    if ((vfs_format(&fs_mount) < 0) || (vfs_mount(&fs_mount) < 0)) {
+        puts("mount failed");
+        return -1;
+    }
+
+    memset(&log_desc, 0, sizeof(log_desc));
+    log_desc.dir = "/lfs/log";
+    log_desc.buf = buf;
+    log_desc.buf_size = batch;
+    log_desc.file_size = FILE_SIZE;
+    log_desc.files = FILES;
+    if (sensorlog_init(&log_desc) < 0) {
+        puts("init failed");
+        vfs_umount(&fs_mount);
+        return -1;
+    }
+    counter.writes = counter.erases = 0;
+
+    start = xtimer_now_usec();
+    for (uint32_t n = 0; n < RECORDS; n++) {
+        record(n, data);
+        if (sensorlog_write(&log_desc, n, 1, data, sizeof(data)) < 0) {
+            puts("write failed");
+            vfs_umount(&fs_mount);
+            return -1;
+        }
+    }
+    if (sensorlog_flush(&log_desc) < 0) {
+        puts("flush failed");
+        vfs_umount(&fs_mount);
+        return -1;
+    }
+    write_time = xtimer_now_usec() - start;
+
+    replayed = 0;
+    start = xtimer_now_usec();
+    int res = sensorlog_replay(&log_desc, check, NULL, RECORDS);
+    replay_time = xtimer_now_usec() - start;
+    vfs_umount(&fs_mount);
+    if ((res != RECORDS) || !sensorlog_empty(&log_desc)) {
+        puts("replay failed");
+        return -1;
+    }
+
+    printf("{ \"batch\" : %u, \"records\" : %u, \"write_us\" : %" PRIu32
+           ", \"records_per_s\" : %" PRIu32 ", \"replay_us\" : %" PRIu32
+           ", \"writes\" : %" PRIu32 ", \"erases\" : %" PRIu32 " }\n",
+           (unsigned)batch, RECORDS, write_time,
+           (uint32_t)((uint64_t)RECORDS * US_PER_SEC / write_time), replay_time,
+           counter.writes, counter.erases);
+
+    return 0;
+}
+
+int main(void)
+{
+    puts("Sensor data logger benchmark");
+
+    counter.parent = MTD_0;
+
+    for (unsigned i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        if (bench(batches[i]) != 0) {
+            puts("[FAILED]");
+            return 1;
+        }
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
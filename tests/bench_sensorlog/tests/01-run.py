@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+
+
+def testfunc(child):
+    for batch in (22, 256, 1024):
+        child.expect(r"{ \"batch\" : %d, \"records\" : \d+, \"write_us\" : \d+, "
+                     r"\"records_per_s\" : \d+, \"replay_us\" : \d+, "
+                     r"\"writes\" : \d+, \"erases\" : \d+ }" % batch)
+    child.expect_exact("[SUCCESS]")
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTTOOLS'], 'testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc, timeout=300))
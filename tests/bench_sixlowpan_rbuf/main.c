@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       6LoWPAN reassembly buffer under a fragment storm
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "byteorder.h"
+#include "random.h"
+#include "xtimer.h"
+#include "net/gnrc/netif/hdr.h"
+#include "net/gnrc/netreg.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/gnrc/sixlowpan/frag.h"
+#include "net/sixlowpan.h"
+
+#define FRAGMENTS       (50000U)
+#define SEED            (0x72627566)
+
+#define SENDERS_MAX     (64U)
+
+#define L2ADDR_LEN      (8U)
+/* payload of FRAG1 after the uncompressed dispatch and of FRAGN, multiples
+ * of 8 that fit into an 802.15.4 frame */
+#define FRAG1_PAYLOAD   (88U)
+#define FRAGN_PAYLOAD   (96U)
+
+/* per mille */
+#define LOSS            (20U)
+#define DUPLICATES      (20U)
+
+typedef struct {
+    uint8_t addr[L2ADDR_LEN];
+    uint16_t tag;
+    uint16_t size;          /* datagram size */
+    uint16_t offset;        /* offset of the next fragment */
+} sender_t;
+
+static const unsigned sender_counts[] = { 4, 16, 64 };
+
+static sender_t senders[SENDERS_MAX];
+static const uint8_t dst[L2ADDR_LEN] = { 0x02, 0, 0, 0, 0, 0, 0, 0x01 };
+static uint8_t payload[FRAGN_PAYLOAD];
+static unsigned reassembled;
+
+static void _receive(uint16_t cmd, gnrc_pktsnip_t *pkt, void *ctx)
+{
+    (void)cmd;
+    (void)ctx;
+    reassembled++;
+    gnrc_pktbuf_release(pkt);
+}
+
+static gnrc_netreg_entry_cbd_t cbd = { .cb = _receive };
+static gnrc_netreg_entry_t entry;
+
+/* short sensor readings, medium sized messages and full IPv6 MTU packets */
+static uint16_t datagram_size(void)
+{
+    uint32_t r = random_uint32_range(0, 10);
+
+    if (r < 4) {
+        return random_uint32_range(60, 200);
+    }
+    if (r < 8) {
+        return random_uint32_range(200, 600);
+    }
+    return 1280;
+}
+
+static void sender_start(sender_t *sender)
+{
+    sender->tag++;
+    sender->size = datagram_size();
+    sender->offset = 0;
+}
+
+static int fragment_recv(const sender_t *sender, uint16_t offset, size_t len)
+{
+    gnrc_pktsnip_t *netif, *frag;
+    size_t hdr_len = (offset == 0) ? sizeof(sixlowpan_frag_t) + 1
+                                   : sizeof(sixlowpan_frag_n_t);
+    sixlowpan_frag_t *hdr;
+
+    netif = gnrc_netif_hdr_build((uint8_t *)sender->addr, L2ADDR_LEN,
+                                 (uint8_t *)dst, L2ADDR_LEN);
+    if (netif == NULL) {
+        return -1;
+    }
+    frag = gnrc_pktbuf_add(netif, NULL, hdr_len + len, GNRC_NETTYPE_SIXLOWPAN);
+    if (frag == NULL) {
+        gnrc_pktbuf_release(netif);
+        return -1;
+    }
+
+    hdr = frag->data;
+    hdr->disp_size = byteorder_htons(sender->size);
+    hdr->tag = byteorder_htons(sender->tag);
+    if (offset == 0) {
+        hdr->disp_size.u8[0] |= SIXLOWPAN_FRAG_1_DISP;
+        ((uint8_t *)frag->data)[sizeof(sixlowpan_frag_t)] = SIXLOWPAN_UNCOMP;
+    }
+    else {
+        hdr->disp_size.u8[0] |= SIXLOWPAN_FRAG_N_DISP;
+        ((sixlowpan_frag_n_t *)hdr)->offset = offset / 8;
+    }
+    memcpy((uint8_t *)frag->data + hdr_len, payload, len);
+
+    gnrc_sixlowpan_frag_recv(frag, NULL, 0);
+
+    return 0;
+}
+
+/* sends the next fragment of the sender, returns 1 after the last one */
+static int sender_step(sender_t *sender)
+{
+    size_t len = sender->size - sender->offset;
+    size_t max = (sender->offset == 0) ? FRAG1_PAYLOAD : FRAGN_PAYLOAD;
+    unsigned r = random_uint32_range(0, 1000);
+
+    if (len > max) {
+        len = max;
+    }
+    if (r >= LOSS) {
+        if (fragment_recv(sender, sender->offset, len) != 0) {
+            return -1;
+        }
+        if ((r < LOSS + DUPLICATES) &&
+            (fragment_recv(sender, sender->offset, len) != 0)) {
+            return -1;
+        }
+    }
+    sender->offset += len;
+
+    if (sender->offset == sender->size) {
+        sender_start(sender);
+        return 1;
+    }
+    return 0;
+}
+
+static int bench(unsigned numof)
+{
+    unsigned sent = 0;
+    uint32_t start, time;
+
+    random_init(SEED);
+    reassembled = 0;
+    for (unsigned i = 0; i < numof; i++) {
+        sender_start(&senders[i]);
+    }
+
+    start = xtimer_now_usec();
+    for (unsigned n = 0; n < FRAGMENTS; n++) {
+        int res = sender_step(&senders[random_uint32_range(0, numof)]);
+
+        if (res < 0) {
+            puts("packet buffer full");
+            return -1;
+        }
+        sent += res;
+    }
+    time = xtimer_now_usec() - start;
+
+    /* let the remaining entries time out before the next run */
+    xtimer_usleep(3500U * US_PER_MS);
+    gnrc_sixlowpan_frag_gc_rbuf();
+
+    printf("{ \"senders\" : %u, \"datagrams\" : %u, \"reassembled\" : %u, "
+           "\"dgram_per_sec\" : %" PRIu32 ", \"drop_pct\" : %u }\n",
+           numof, sent, reassembled,
+           (uint32_t)(((uint64_t)reassembled * US_PER_SEC) / time),
+           (sent - reassembled) * 100 / sent);
+
+    return 0;
+}
+
+int main(void)
+{
+    puts("6LoWPAN reassembly buffer benchmark");
+
+    for (unsigned i = 0; i < SENDERS_MAX; i++) {
+        senders[i].addr[0] = 0x02;
+        senders[i].addr[7] = i + 2;
+    }
+    for (unsigned i = 0; i < sizeof(payload); i++) {
+        payload[i] = i;
+    }
+
+    gnrc_netreg_entry_init_cb(&entry, GNRC_NETREG_DEMUX_CTX_ALL, &cbd);
+    gnrc_netreg_register(GNRC_NETTYPE_IPV6, &entry);
+
+    for (unsigned i = 0; i < sizeof(sender_counts) / sizeof(sender_counts[0]); i++) {
+        if (bench(sender_counts[i]) != 0) {
+            puts("[FAILED]");
+            return 1;
+        }
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
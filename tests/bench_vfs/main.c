@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Concurrent VFS access from several threads and mounts
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+
+#include "board.h"
+#include "fs/constfs.h"
+#include "fs/littlefs_fs.h"
+#include "msg.h"
+#include "mtd.h"
+#include "thread.h"
+#include "vfs.h"
+#include "xtimer.h"
+
+#define FS_SECTORS      (64U)
+
+#define MAX_THREADS     (4U)
+#define ITERATIONS      (200U)
+#define DATA_SIZE       (32U)
+
+/* VFS calls of one iteration of a worker */
+#define OPS_PER_ITER    (11U)
+
+static const unsigned thread_counts[] = { 1, 2, MAX_THREADS };
+
+static const uint8_t const_data[] = "read-only data on a constfs mount";
+
+static const constfs_file_t const_files[] = {
+    {
+        .path = "/data",
+        .size = sizeof(const_data),
+        .data = const_data,
+    },
+};
+
+static constfs_t const_desc = {
+    .files = const_files,
+    .nfiles = sizeof(const_files) / sizeof(const_files[0]),
+};
+
+static vfs_mount_t const_mounts[] = {
+    {
+        .fs = &constfs_file_system,
+        .mount_point = "/c0",
+        .private_data = &const_desc,
+    },
+    {
+        .fs = &constfs_file_system,
+        .mount_point = "/c1",
+        .private_data = &const_desc,
+    },
+    {
+        .fs = &constfs_file_system,
+        .mount_point = "/c2",
+        .private_data = &const_desc,
+    },
+};
+
+#define CONST_MOUNTS    (sizeof(const_mounts) / sizeof(const_mounts[0]))
+
+static littlefs_desc_t fs_desc;
+static vfs_mount_t fs_mount = {
+    .fs = &littlefs_file_system,
+    .mount_point = "/lfs",
+    .private_data = &fs_desc,
+};
+
+static char stacks[MAX_THREADS][THREAD_STACKSIZE_MAIN];
+static kernel_pid_t main_pid;
+static kernel_pid_t workers[MAX_THREADS];
+
+static int _const_file(unsigned n)
+{
+    char path[16];
+    uint8_t buf[sizeof(const_data)];
+    struct stat st;
+
+    sprintf(path, "/c%u/data", n % (unsigned)CONST_MOUNTS);
+    int fd = vfs_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int res = 0;
+    if ((vfs_read(fd, buf, sizeof(buf)) != sizeof(buf)) ||
+        (memcmp(buf, const_data, sizeof(buf)) != 0) ||
+        (vfs_fstat(fd, &st) < 0) || (st.st_size != sizeof(const_data))) {
+        res = -1;
+    }
+    if (vfs_close(fd) < 0) {
+        res = -1;
+    }
+    if (vfs_stat(path, &st) < 0) {
+        res = -1;
+    }
+    return res;
+}
+
+static int _own_file(unsigned id, unsigned n)
+{
+    char path[16];
+    uint8_t data[DATA_SIZE];
+    uint8_t buf[DATA_SIZE];
+
+    sprintf(path, "/lfs/t%u", id);
+    memset(data, (int)(id * ITERATIONS + n), sizeof(data));
+
+    int fd = vfs_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int res = (vfs_write(fd, data, sizeof(data)) == sizeof(data)) ? 0 : -1;
+    if (vfs_close(fd) < 0) {
+        res = -1;
+    }
+    fd = vfs_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((vfs_read(fd, buf, sizeof(buf)) != sizeof(buf)) ||
+        (memcmp(buf, data, sizeof(buf)) != 0)) {
+        res = -1;
+    }
+    if (vfs_close(fd) < 0) {
+        res = -1;
+    }
+    return res;
+}
+
+static void *worker(void *arg)
+{
+    unsigned id = (unsigned)(uintptr_t)arg;
+    msg_t msg;
+
+    while (1) {
+        msg_receive(&msg);
+        msg.content.value = 0;
+        for (unsigned n = 0; n < ITERATIONS; n++) {
+            if ((_const_file(id + n) < 0) || (_own_file(id, n) < 0)) {
+                msg.content.value = 1;
+                break;
+            }
+            thread_yield();
+        }
+        msg_send(&msg, main_pid);
+    }
+
+    return NULL;
+}
+
+static int bench(unsigned threads)
+{
+    msg_t msg;
+    int failed = 0;
+
+    uint32_t start = xtimer_now_usec();
+    for (unsigned i = 0; i < threads; i++) {
+        msg_send(&msg, workers[i]);
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        msg_receive(&msg);
+        failed |= msg.content.value;
+    }
+    uint32_t time = xtimer_now_usec() - start;
+
+    if (failed) {
+        puts("worker failed");
+        return -1;
+    }
+
+    uint32_t ops = threads * ITERATIONS * OPS_PER_ITER;
+    printf("{ \"threads\" : %u, \"ops\" : %" PRIu32 ", \"time_us\" : %" PRIu32
+           ", \"ops_per_s\" : %" PRIu32 " }\n",
+           threads, ops, time, (uint32_t)((uint64_t)ops * US_PER_SEC / time));
+
+    return 0;
+}
+
+int main(void)
+{
+    puts("VFS concurrency benchmark");
+
+    main_pid = thread_getpid();
+
+    for (unsigned i = 0; i < CONST_MOUNTS; i++) {
+        if (vfs_mount(&const_mounts[i]) < 0) {
+            puts("constfs mount failed");
+            puts("[FAILED]");
+            return 1;
+        }
+    }
+    fs_desc.dev = MTD_0;
+    fs_desc.config.block_count = FS_SECTORS;
+    if ((vfs_format(&fs_mount) < 0) || (vfs_mount(&fs_mount) < 0)) {
+        puts("littlefs mount failed");
+        puts("[FAILED]");
+        return 1;
+    }
+
+    /* the workers run below the main thread and wait for a round to start */
+    for (unsigned i = 0; i < MAX_THREADS; i++) {
+        workers[i] = thread_create(stacks[i], sizeof(stacks[i]),
+                                   THREAD_PRIORITY_MAIN + 1,
+                                   THREAD_CREATE_STACKTEST, worker,
+                                   (void *)(uintptr_t)i, "worker");
+    }
+
+    for (unsigned i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]);
+         i++) {
+        if (bench(thread_counts[i]) != 0) {
+            puts("[FAILED]");
+            return 1;
+        }
+    }
+
+    vfs_umount(&fs_mount);
+    for (unsigned i = 0; i < CONST_MOUNTS; i++) {
+        vfs_umount(&const_mounts[i]);
+    }
+
+    puts("[SUCCESS]");
+
+    return 0;
+}
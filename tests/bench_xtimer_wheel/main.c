@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       xtimer set/remove cost with many pending timers
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "random.h"
+#include "xtimer.h"
+
+#ifdef MODULE_XTIMER_WHEEL
+#define BACKEND         "wheel"
+#else
+#define BACKEND         "list"
+#endif
+
+#define TIMERS_MAX      (2000U)
+#define RESETS          (5000U)
+
+/* Pending timers don't fire during the measurement */
+#define OFFSET_MIN      (10U * US_PER_SEC)
+#define OFFSET_MAX      (70U * US_PER_SEC)
+
+#define FIRE_TIMERS     (500U)
+#define FIRE_OFFSET_MAX (50U * US_PER_MS)
+
+static const unsigned populations[] = { 10, 100, 500, 2000 };
+
+typedef struct {
+    xtimer_t timer;
+    uint32_t target;
+} bench_timer_t;
+
+static bench_timer_t timers[TIMERS_MAX];
+static unsigned order[TIMERS_MAX];
+
+static volatile unsigned fired;
+static volatile unsigned early;
+
+static uint32_t max_us;
+
+static void never(void *arg)
+{
+    (void)arg;
+}
+
+static void check_fired(void *arg)
+{
+    bench_timer_t *t = arg;
+
+    if ((int32_t)(xtimer_now_usec() - t->target) < 0) {
+        early++;
+    }
+    fired++;
+}
+
+/* Single call is shorter than the timer resolution on native, so the
+ * average is taken over the whole batch and the worst call separately */
+static inline void track(uint32_t start)
+{
+    uint32_t elapsed = xtimer_now_usec() - start;
+
+    if (elapsed > max_us) {
+        max_us = elapsed;
+    }
+}
+
+static void shuffle(unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    for (unsigned i = n - 1; i > 0; i--) {
+        unsigned j = random_uint32_range(0, i + 1);
+        unsigned tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+}
+
+static uint32_t per_op_ns(uint32_t elapsed_us, unsigned ops)
+{
+    return (uint32_t)(((uint64_t)elapsed_us * 1000) / ops);
+}
+
+static void bench(unsigned n)
+{
+    uint32_t start, elapsed, add_ns, reset_ns, remove_ns;
+
+    max_us = 0;
+
+    elapsed = 0;
+    for (unsigned i = 0; i < n; i++) {
+        uint32_t offset = random_uint32_range(OFFSET_MIN, OFFSET_MAX);
+        timers[i].timer.callback = never;
+        start = xtimer_now_usec();
+        xtimer_set(&timers[i].timer, offset);
+        track(start);
+        elapsed += xtimer_now_usec() - start;
+    }
+    add_ns = per_op_ns(elapsed, n);
+
+    elapsed = 0;
+    for (unsigned i = 0; i < RESETS; i++) {
+        xtimer_t *timer = &timers[random_uint32_range(0, n)].timer;
+        uint32_t offset = random_uint32_range(OFFSET_MIN, OFFSET_MAX);
+        start = xtimer_now_usec();
+        xtimer_set(timer, offset);
+        track(start);
+        elapsed += xtimer_now_usec() - start;
+    }
+    reset_ns = per_op_ns(elapsed, RESETS);
+
+    shuffle(n);
+    elapsed = 0;
+    for (unsigned i = 0; i < n; i++) {
+        start = xtimer_now_usec();
+        xtimer_remove(&timers[order[i]].timer);
+        track(start);
+        elapsed += xtimer_now_usec() - start;
+    }
+    remove_ns = per_op_ns(elapsed, n);
+
+    printf("{ \"backend\" : \"%s\", \"timers\" : %u, \"add_ns\" : %" PRIu32
+           ", \"reset_ns\" : %" PRIu32 ", \"remove_ns\" : %" PRIu32
+           ", \"max_us\" : %" PRIu32 " }\n",
+           BACKEND, n, add_ns, reset_ns, remove_ns, max_us);
+}
+
+static void fire(void)
+{
+    fired = 0;
+    early = 0;
+
+    for (unsigned i = 0; i < FIRE_TIMERS; i++) {
+        uint32_t offset = random_uint32_range(XTIMER_BACKOFF, FIRE_OFFSET_MAX);
+        timers[i].timer.callback = check_fired;
+        timers[i].timer.arg = &timers[i];
+        timers[i].target = xtimer_now_usec() + offset;
+        xtimer_set(&timers[i].timer, offset);
+    }
+
+    xtimer_usleep(2 * FIRE_OFFSET_MAX);
+
+    printf("{ \"backend\" : \"%s\", \"fired\" : %u, \"expected\" : %u, \"early\" : %u }\n",
+           BACKEND, fired, FIRE_TIMERS, early);
+}
+
+int main(void)
+{
+    puts("xtimer set/remove benchmark");
+
+    for (unsigned i = 0; i < sizeof(populations) / sizeof(populations[0]); i++) {
+        bench(populations[i]);
+    }
+
+    fire();
+
+    if ((fired == FIRE_TIMERS) && (early == 0)) {
+        puts("[SUCCESS]");
+    }
+    else {
+        puts("[FAILED]");
+    }
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+
+
+def testfunc(child):
+    for timers in (10, 100, 500, 2000):
+        child.expect(r"{ \"backend\" : \"\w+\", \"timers\" : %d, \"add_ns\" : \d+, "
+                     r"\"reset_ns\" : \d+, \"remove_ns\" : \d+, \"max_us\" : \d+ }" % timers)
+    child.expect(r"{ \"backend\" : \"\w+\", \"fired\" : (\d+), \"expected\" : (\d+), \"early\" : 0 }")
+    assert child.match.group(1) == child.match.group(2)
+    child.expect_exact("[SUCCESS]")
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTTOOLS'], 'testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc, timeout=60))
@@ -0,0 +1,530 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests fragment forwarding with the virtual reassembly buffer
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "byteorder.h"
+#include "embUnit.h"
+#include "net/gnrc.h"
+#include "net/gnrc/ipv6/nib.h"
+#include "net/gnrc/ipv6/nib/nc.h"
+#include "net/gnrc/netif.h"
+#include "net/gnrc/netif/hdr.h"
+#include "net/gnrc/netif/internal.h"
+#include "net/gnrc/sixlowpan/frag.h"
+#include "net/ipv6/hdr.h"
+#include "net/netdev_test.h"
+#include "net/sixlowpan.h"
+#include "xtimer.h"
+
+#define MAX_FRAG_SIZE   (102U)
+#define SENT_MAX        (8U)
+/* VRB_TIMEOUT of the virtual reassembly buffer */
+#define TIMEOUT         (3U * US_PER_SEC)
+
+/* IPHC with inline next header, source and destination address and elided
+ * hop limit */
+#define IPHC_LEN        (2U + 1U + 2 * sizeof(ipv6_addr_t))
+#define IPHC_NH_NONE    (59U)
+/* a datagram of three fragments, the first one covers the uncompressed IPv6
+ * header */
+#define FRAG1_PAYLOAD   (48U)
+#define FRAG2_OFFSET    (sizeof(ipv6_hdr_t) + FRAG1_PAYLOAD)
+#define FRAG2_PAYLOAD   (48U)
+#define FRAG3_OFFSET    (FRAG2_OFFSET + FRAG2_PAYLOAD)
+#define FRAG3_PAYLOAD   (24U)
+#define DATAGRAM_SIZE   (FRAG3_OFFSET + FRAG3_PAYLOAD)
+
+static const uint8_t _own_l2[] = { 0x02, 0x00, 0x00, 0xff,
+                                   0xfe, 0x00, 0x00, 0x01 };
+static const uint8_t _prev_l2[] = { 0x02, 0x00, 0x00, 0xff,
+                                    0xfe, 0x00, 0x00, 0x02 };
+static const uint8_t _next_l2[] = { 0x02, 0x00, 0x00, 0xff,
+                                    0xfe, 0x00, 0x00, 0x03 };
+static const ipv6_addr_t _own_gb = { {
+                0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01
+        } };
+static const ipv6_addr_t _src_gb = { {
+                0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02
+        } };
+/* reached over the next hop */
+static const ipv6_addr_t _dst_gb = { {
+                0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03
+        } };
+/* without a route */
+static const ipv6_addr_t _unreach_gb = { {
+                0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03
+        } };
+static const ipv6_addr_t _dst_ll = { {
+                0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0x03
+        } };
+
+static char _netif_stack[THREAD_STACKSIZE_DEFAULT];
+static netdev_test_t _dev;
+static gnrc_netif_t *_netif;
+
+/* fragments the interface was asked to send */
+static gnrc_pktsnip_t *_sent[SENT_MAX];
+static unsigned _sent_numof;
+/* datagrams handed to the IPv6 layer */
+static unsigned _reassembled;
+static size_t _reassembled_size;
+
+/* received fragment still referenced by another user, if _share is set */
+static gnrc_pktsnip_t *_shared;
+static bool _share;
+
+static gnrc_sixlowpan_frag_vrb_stats_t _stats;
+static uint16_t _tag;
+
+static int _netif_send(gnrc_netif_t *netif, gnrc_pktsnip_t *pkt)
+{
+    (void)netif;
+    if (_sent_numof >= SENT_MAX) {
+        gnrc_pktbuf_release(pkt);
+        return -ENOBUFS;
+    }
+    _sent[_sent_numof++] = pkt;
+    return (int)gnrc_pkt_len(pkt);
+}
+
+static gnrc_pktsnip_t *_netif_recv(gnrc_netif_t *netif)
+{
+    (void)netif;
+    return NULL;
+}
+
+static const gnrc_netif_ops_t _netif_ops = {
+    .send = _netif_send,
+    .recv = _netif_recv,
+    .get = gnrc_netif_get_from_netdev,
+    .set = gnrc_netif_set_from_netdev,
+};
+
+static void _ipv6_recv(uint16_t cmd, gnrc_pktsnip_t *pkt, void *ctx)
+{
+    (void)ctx;
+    if (cmd == GNRC_NETAPI_MSG_TYPE_RCV) {
+        _reassembled++;
+        _reassembled_size = pkt->size;
+    }
+    gnrc_pktbuf_release(pkt);
+}
+
+static gnrc_netreg_entry_cbd_t _ipv6_cbd = { .cb = _ipv6_recv };
+static gnrc_netreg_entry_t _ipv6_entry;
+
+static void _recv(uint16_t tag, uint16_t offset, const ipv6_addr_t *dst)
+{
+    gnrc_pktsnip_t *netif, *frag;
+    gnrc_netif_hdr_t *hdr;
+    sixlowpan_frag_t *frag_hdr;
+    uint8_t *data;
+    size_t hdr_len, len;
+
+    if (offset == 0) {
+        hdr_len = sizeof(sixlowpan_frag_t) + IPHC_LEN;
+        len = FRAG1_PAYLOAD;
+    }
+    else {
+        hdr_len = sizeof(sixlowpan_frag_n_t);
+        len = (offset == FRAG2_OFFSET) ? FRAG2_PAYLOAD : FRAG3_PAYLOAD;
+    }
+    netif = gnrc_netif_hdr_build((uint8_t *)_prev_l2, sizeof(_prev_l2),
+                                 (uint8_t *)_own_l2, sizeof(_own_l2));
+    TEST_ASSERT_NOT_NULL(netif);
+    hdr = netif->data;
+    hdr->if_pid = _netif->pid;
+    frag = gnrc_pktbuf_add(netif, NULL, hdr_len + len, GNRC_NETTYPE_SIXLOWPAN);
+    TEST_ASSERT_NOT_NULL(frag);
+
+    frag_hdr = frag->data;
+    frag_hdr->disp_size = byteorder_htons(DATAGRAM_SIZE);
+    frag_hdr->tag = byteorder_htons(tag);
+    data = frag->data;
+    if (offset == 0) {
+        frag_hdr->disp_size.u8[0] |= SIXLOWPAN_FRAG_1_DISP;
+        data += sizeof(sixlowpan_frag_t);
+        /* TF elided, next header inline, hop limit 255 */
+        *(data++) = SIXLOWPAN_IPHC1_DISP | SIXLOWPAN_IPHC1_TF |
+                    SIXLOWPAN_IPHC1_HL;
+        /* stateless, source and destination inline */
+        *(data++) = 0x00;
+        *(data++) = IPHC_NH_NONE;
+        memcpy(data, &_src_gb, sizeof(_src_gb));
+        data += sizeof(_src_gb);
+        memcpy(data, dst, sizeof(*dst));
+        data += sizeof(*dst);
+    }
+    else {
+        frag_hdr->disp_size.u8[0] |= SIXLOWPAN_FRAG_N_DISP;
+        ((sixlowpan_frag_n_t *)frag_hdr)->offset = offset / 8;
+        data += sizeof(sixlowpan_frag_n_t);
+    }
+    for (unsigned i = 0; i < len; i++) {
+        data[i] = offset + i;
+    }
+
+    if (_share) {
+        gnrc_pktbuf_hold(frag, 1);
+        _shared = frag;
+    }
+    gnrc_sixlowpan_frag_recv(frag, NULL, 0);
+}
+
+/* checks the n-th sent fragment, a first fragment sets the datagram tag
+ * the subsequent ones are checked against */
+static void _check_sent(unsigned n, uint16_t offset, uint16_t *tag)
+{
+    gnrc_pktsnip_t *pkt;
+    gnrc_netif_hdr_t *hdr;
+    sixlowpan_frag_t *frag_hdr;
+
+    TEST_ASSERT(n < _sent_numof);
+    pkt = _sent[n];
+    TEST_ASSERT_EQUAL_INT(GNRC_NETTYPE_NETIF, pkt->type);
+    hdr = pkt->data;
+    TEST_ASSERT_EQUAL_INT(_netif->pid, hdr->if_pid);
+    TEST_ASSERT_EQUAL_INT(sizeof(_next_l2), hdr->dst_l2addr_len);
+    TEST_ASSERT(memcmp(gnrc_netif_hdr_get_dst_addr(hdr), _next_l2,
+                       sizeof(_next_l2)) == 0);
+    TEST_ASSERT_NOT_NULL(pkt->next);
+    frag_hdr = pkt->next->data;
+    TEST_ASSERT_EQUAL_INT(DATAGRAM_SIZE, byteorder_ntohs(frag_hdr->disp_size) &
+                                         SIXLOWPAN_FRAG_SIZE_MASK);
+    if (offset == 0) {
+        TEST_ASSERT_EQUAL_INT(SIXLOWPAN_FRAG_1_DISP, frag_hdr->disp_size.u8[0] &
+                                                     SIXLOWPAN_FRAG_DISP_MASK);
+        TEST_ASSERT(gnrc_pkt_len(pkt->next) <= MAX_FRAG_SIZE);
+        *tag = byteorder_ntohs(frag_hdr->tag);
+    }
+    else {
+        size_t len = (offset == FRAG2_OFFSET) ? FRAG2_PAYLOAD : FRAG3_PAYLOAD;
+        uint8_t *data = ((uint8_t *)frag_hdr) + sizeof(sixlowpan_frag_n_t);
+
+        TEST_ASSERT_EQUAL_INT(SIXLOWPAN_FRAG_N_DISP, frag_hdr->disp_size.u8[0] &
+                                                     SIXLOWPAN_FRAG_DISP_MASK);
+        TEST_ASSERT_EQUAL_INT(offset / 8,
+                              ((sixlowpan_frag_n_t *)frag_hdr)->offset);
+        TEST_ASSERT_EQUAL_INT(sizeof(sixlowpan_frag_n_t) + len,
+                              pkt->next->size);
+        TEST_ASSERT_EQUAL_INT(*tag, byteorder_ntohs(frag_hdr->tag));
+        for (unsigned i = 0; i < len; i++) {
+            TEST_ASSERT_EQUAL_INT((uint8_t)(offset + i), data[i]);
+        }
+    }
+}
+
+static void _set_up(void)
+{
+    for (unsigned i = 0; i < _sent_numof; i++) {
+        gnrc_pktbuf_release(_sent[i]);
+    }
+    _sent_numof = 0;
+    if (_shared != NULL) {
+        gnrc_pktbuf_release(_shared);
+        _shared = NULL;
+    }
+    _share = false;
+    _reassembled = 0;
+    _reassembled_size = 0;
+    gnrc_sixlowpan_frag_vrb_get_stats(&_stats);
+    _tag++;
+}
+
+static void test_forward__in_order(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+    uint16_t tag;
+
+    _recv(_tag, 0, &_dst_gb);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(3, _sent_numof);
+    _check_sent(0, 0, &tag);
+    _check_sent(1, FRAG2_OFFSET, &tag);
+    _check_sent(2, FRAG3_OFFSET, &tag);
+    TEST_ASSERT_EQUAL_INT(0, _reassembled);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(3, stats.fragments - _stats.fragments);
+
+    /* the entry is gone with the last fragment */
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(3, _sent_numof);
+}
+
+static void test_forward__out_of_order(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+    uint16_t tag;
+
+    _recv(_tag, 0, &_dst_gb);
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(3, _sent_numof);
+    _check_sent(0, 0, &tag);
+    _check_sent(1, FRAG3_OFFSET, &tag);
+    _check_sent(2, FRAG2_OFFSET, &tag);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(3, stats.fragments - _stats.fragments);
+}
+
+static void test_forward__duplicates(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+    uint16_t tag;
+
+    _recv(_tag, 0, &_dst_gb);
+    _recv(_tag, 0, &_dst_gb);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    /* the duplicates must not end the entry before the last fragment */
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(3, _sent_numof);
+    _check_sent(0, 0, &tag);
+    _check_sent(1, FRAG2_OFFSET, &tag);
+    _check_sent(2, FRAG3_OFFSET, &tag);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(3, stats.fragments - _stats.fragments);
+    TEST_ASSERT_EQUAL_INT(2, stats.duplicates - _stats.duplicates);
+}
+
+static void test_forward__shared_fragment(void)
+{
+    /* far from the tags the forwarder assigns */
+    uint16_t in_tag = _tag ^ 0x8000;
+    uint16_t tag;
+
+    _recv(in_tag, 0, &_dst_gb);
+    _share = true;
+    _recv(in_tag, FRAG2_OFFSET, NULL);
+    _share = false;
+    TEST_ASSERT_EQUAL_INT(2, _sent_numof);
+    _check_sent(0, 0, &tag);
+    _check_sent(1, FRAG2_OFFSET, &tag);
+
+    /* the tag of the next hop went into a copy of the fragment */
+    TEST_ASSERT_NOT_NULL(_shared);
+    TEST_ASSERT(_sent[1]->next != _shared);
+    TEST_ASSERT_EQUAL_INT(in_tag,
+                          byteorder_ntohs(((sixlowpan_frag_n_t *)_shared->data)->tag));
+}
+
+static void test_forward__first_fragment_late(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+
+    /* a subsequent fragment without entry goes to the reassembly buffer, so
+     * does the rest of its datagram */
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    _recv(_tag, 0, &_dst_gb);
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(0, _sent_numof);
+    TEST_ASSERT_EQUAL_INT(1, _reassembled);
+    TEST_ASSERT_EQUAL_INT(DATAGRAM_SIZE, _reassembled_size);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.datagrams - _stats.datagrams);
+}
+
+static void test_fallback__local(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+
+    _recv(_tag, 0, &_own_gb);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(0, _sent_numof);
+    TEST_ASSERT_EQUAL_INT(1, _reassembled);
+    TEST_ASSERT_EQUAL_INT(DATAGRAM_SIZE, _reassembled_size);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(0, stats.fallbacks - _stats.fallbacks);
+}
+
+static void test_fallback__link_local(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+
+    _recv(_tag, 0, &_dst_ll);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(0, _sent_numof);
+    TEST_ASSERT_EQUAL_INT(1, _reassembled);
+    TEST_ASSERT_EQUAL_INT(DATAGRAM_SIZE, _reassembled_size);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(0, stats.fallbacks - _stats.fallbacks);
+}
+
+static void test_fallback__no_route(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+
+    _recv(_tag, 0, &_unreach_gb);
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    _recv(_tag, FRAG3_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(0, _sent_numof);
+    TEST_ASSERT_EQUAL_INT(1, _reassembled);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(1, stats.fallbacks - _stats.fallbacks);
+}
+
+static void test_timeout(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+
+    _recv(_tag, 0, &_dst_gb);
+    TEST_ASSERT_EQUAL_INT(1, _sent_numof);
+    xtimer_usleep(TIMEOUT + (100U * US_PER_MS));
+    gnrc_sixlowpan_frag_gc_rbuf();
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.timeouts - _stats.timeouts);
+    /* the rest of the datagram is not forwarded anymore */
+    _recv(_tag, FRAG2_OFFSET, NULL);
+    TEST_ASSERT_EQUAL_INT(1, _sent_numof);
+}
+
+static void test_evict(void)
+{
+    gnrc_sixlowpan_frag_vrb_stats_t stats;
+
+    /* all previous entries were completed or timed out */
+    for (unsigned i = 0; i <= VRB_SIZE; i++) {
+        _recv(_tag + i, 0, &_dst_gb);
+    }
+    _tag += VRB_SIZE;
+    TEST_ASSERT_EQUAL_INT(VRB_SIZE + 1, _sent_numof);
+
+    gnrc_sixlowpan_frag_vrb_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(VRB_SIZE + 1, stats.datagrams - _stats.datagrams);
+    TEST_ASSERT_EQUAL_INT(1, stats.evictions - _stats.evictions);
+}
+
+static Test *tests_gnrc_sixlowpan_frag_vrb(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_forward__in_order),
+        new_TestFixture(test_forward__out_of_order),
+        new_TestFixture(test_forward__duplicates),
+        new_TestFixture(test_forward__shared_fragment),
+        new_TestFixture(test_forward__first_fragment_late),
+        new_TestFixture(test_fallback__local),
+        new_TestFixture(test_fallback__link_local),
+        new_TestFixture(test_fallback__no_route),
+        /* both rely on a virtual reassembly buffer without entries */
+        new_TestFixture(test_timeout),
+        new_TestFixture(test_evict),
+    };
+
+    EMB_UNIT_TESTCALLER(tests, _set_up, NULL, fixtures);
+
+    return (Test *)&tests;
+}
+
+static int _get_device_type(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    assert(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = NETDEV_TYPE_IEEE802154;
+    return sizeof(uint16_t);
+}
+
+static int _get_max_packet_size(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    assert(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = MAX_FRAG_SIZE;
+    return sizeof(uint16_t);
+}
+
+static int _get_src_len(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    assert(max_len == sizeof(uint16_t));
+    *((uint16_t *)value) = sizeof(_own_l2);
+    return sizeof(uint16_t);
+}
+
+static int _get_address_long(netdev_t *dev, void *value, size_t max_len)
+{
+    (void)dev;
+    assert(max_len >= sizeof(_own_l2));
+    memcpy(value, _own_l2, sizeof(_own_l2));
+    return sizeof(_own_l2);
+}
+
+static void _tests_init(void)
+{
+    netopt_enable_t enable = NETOPT_ENABLE;
+
+    netdev_test_setup(&_dev, NULL);
+    netdev_test_set_get_cb(&_dev, NETOPT_DEVICE_TYPE, _get_device_type);
+    netdev_test_set_get_cb(&_dev, NETOPT_MAX_PACKET_SIZE,
+                           _get_max_packet_size);
+    netdev_test_set_get_cb(&_dev, NETOPT_SRC_LEN, _get_src_len);
+    netdev_test_set_get_cb(&_dev, NETOPT_ADDRESS_LONG, _get_address_long);
+    _netif = gnrc_netif_create(_netif_stack, sizeof(_netif_stack),
+                               GNRC_NETIF_PRIO, "vrb_netif",
+                               (netdev_t *)&_dev, &_netif_ops);
+    assert(_netif != NULL);
+    assert(gnrc_netif_is_6ln(_netif));
+    assert(_netif->sixlo.max_frag_size == MAX_FRAG_SIZE);
+
+    gnrc_netapi_set(_netif->pid, NETOPT_IPV6_FORWARDING, 0, &enable,
+                    sizeof(enable));
+    gnrc_netapi_set(_netif->pid, NETOPT_IPV6_ADDR,
+                    (64U << 8U) | GNRC_NETIF_IPV6_ADDRS_FLAGS_STATE_VALID,
+                    (void *)&_own_gb, sizeof(_own_gb));
+    /* stub next hop towards the forwarded datagrams */
+    gnrc_ipv6_nib_nc_set(&_dst_gb, _netif->pid, _next_l2, sizeof(_next_l2));
+
+    gnrc_netreg_entry_init_cb(&_ipv6_entry, GNRC_NETREG_DEMUX_CTX_ALL,
+                              &_ipv6_cbd);
+    gnrc_netreg_register(GNRC_NETTYPE_IPV6, &_ipv6_entry);
+}
+
+int main(void)
+{
+    _tests_init();
+
+    TESTS_START();
+    TESTS_RUN(tests_gnrc_sixlowpan_frag_vrb());
+    TESTS_END();
+
+    return 0;
+}
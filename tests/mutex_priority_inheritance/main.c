@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Test application for mutex priority inheritance
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "mutex.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define PRIO_LOW        (THREAD_PRIORITY_MAIN - 1)
+#define PRIO_MID        (THREAD_PRIORITY_MAIN - 2)
+#define PRIO_HIGH       (THREAD_PRIORITY_MAIN - 3)
+
+/* t_low holds the mutex this long */
+#define LOW_WORK_US     (300U * US_PER_MS)
+/* t_high and t_mid start after these delays */
+#define HIGH_DELAY_US   (100U * US_PER_MS)
+#define MID_DELAY_US    (150U * US_PER_MS)
+/* t_mid hogs the CPU this long */
+#define MID_SPIN_US     (1000U * US_PER_MS)
+/* o_high gives up waiting for the mutex after this */
+#define HIGH_TIMEOUT_US (50U * US_PER_MS)
+
+/* Worst case t_high may wait: rest of the t_low critical section plus some
+ * slack for the timers of the native board */
+#define LATENCY_LIMIT_US    (LOW_WORK_US - HIGH_DELAY_US + 50U * US_PER_MS)
+
+static mutex_t res_mtx = MUTEX_INIT;
+static mutex_t outer_mtx = MUTEX_INIT;
+static mutex_t inner_mtx = MUTEX_INIT;
+static mutex_t timeout_mtx = MUTEX_INIT;
+/* unlocked by the last thread of a phase */
+static mutex_t phase_done = MUTEX_INIT_LOCKED;
+
+static char stack_high[THREAD_STACKSIZE_DEFAULT];
+static char stack_mid[THREAD_STACKSIZE_DEFAULT];
+static char stack_low[THREAD_STACKSIZE_DEFAULT];
+
+static kernel_pid_t pid_low;
+static volatile bool done;
+static volatile bool failed;
+static volatile bool timed_out;
+static uint8_t low_prio_inner;
+
+static void busy_wait(uint32_t us)
+{
+    uint32_t start = xtimer_now_usec();
+
+    while (!done && (xtimer_now_usec() - start < us)) {}
+}
+
+static void *t_low_handler(void *arg)
+{
+    (void)arg;
+
+    mutex_lock(&res_mtx);
+    busy_wait(LOW_WORK_US);
+    mutex_unlock(&res_mtx);
+
+    return NULL;
+}
+
+static void *t_mid_handler(void *arg)
+{
+    (void)arg;
+
+    xtimer_usleep(MID_DELAY_US);
+    busy_wait(MID_SPIN_US);
+
+    return NULL;
+}
+
+static void *t_high_handler(void *arg)
+{
+    (void)arg;
+
+    xtimer_usleep(HIGH_DELAY_US);
+
+    uint32_t start = xtimer_now_usec();
+    mutex_lock(&res_mtx);
+    uint32_t latency = xtimer_now_usec() - start;
+
+    /* Stop t_mid before it can print anything */
+    done = true;
+
+    uint8_t low_prio = ((thread_t *)thread_get(pid_low))->priority;
+
+    mutex_unlock(&res_mtx);
+
+    printf("{ \"latency_us\" : %" PRIu32 ", \"limit_us\" : %u }\n",
+           latency, (unsigned)LATENCY_LIMIT_US);
+
+    if (latency > LATENCY_LIMIT_US) {
+        puts("[FAILED] t_high was blocked by t_mid");
+        failed = true;
+    }
+    else if (low_prio != PRIO_LOW) {
+        printf("[FAILED] t_low priority is %u after unlock\n", (unsigned)low_prio);
+        failed = true;
+    }
+
+    mutex_unlock(&phase_done);
+
+    return NULL;
+}
+
+static void *n_low_handler(void *arg)
+{
+    (void)arg;
+    volatile thread_t *me = thread_get(thread_getpid());
+    uint32_t start = xtimer_now_usec();
+
+    mutex_lock(&outer_mtx);
+    mutex_lock(&inner_mtx);
+    /* until n_high waits for outer_mtx */
+    while ((me->priority != PRIO_HIGH) &&
+           (xtimer_now_usec() - start < LOW_WORK_US)) {}
+
+    /* n_high still waits for outer_mtx, so the boost has to stay */
+    mutex_unlock(&inner_mtx);
+    low_prio_inner = me->priority;
+    mutex_unlock(&outer_mtx);
+
+    return NULL;
+}
+
+static void *n_high_handler(void *arg)
+{
+    (void)arg;
+
+    xtimer_usleep(HIGH_DELAY_US);
+
+    mutex_lock(&outer_mtx);
+    uint8_t low_prio = ((thread_t *)thread_get(pid_low))->priority;
+    mutex_unlock(&outer_mtx);
+
+    printf("{ \"inner_unlock_prio\" : %u, \"expected\" : %u }\n",
+           (unsigned)low_prio_inner, (unsigned)PRIO_HIGH);
+
+    if (low_prio_inner != PRIO_HIGH) {
+        puts("[FAILED] n_low lost the priority of n_high on the inner unlock");
+        failed = true;
+    }
+    else if (low_prio != PRIO_LOW) {
+        printf("[FAILED] n_low priority is %u after unlock\n", (unsigned)low_prio);
+        failed = true;
+    }
+
+    mutex_unlock(&phase_done);
+
+    return NULL;
+}
+
+static void *o_low_handler(void *arg)
+{
+    (void)arg;
+    volatile thread_t *me = thread_get(thread_getpid());
+    uint32_t start = xtimer_now_usec();
+
+    mutex_lock(&timeout_mtx);
+    /* until o_high has given up on timeout_mtx */
+    while (!timed_out && (xtimer_now_usec() - start < LOW_WORK_US)) {}
+
+    /* nobody waits for timeout_mtx anymore, the boost has to go */
+    mutex_unlock(&timeout_mtx);
+    uint8_t low_prio = me->priority;
+
+    printf("{ \"timeout_unlock_prio\" : %u, \"expected\" : %u }\n",
+           (unsigned)low_prio, (unsigned)PRIO_LOW);
+
+    if (!timed_out) {
+        puts("[FAILED] o_high did not time out");
+        failed = true;
+    }
+    else if (low_prio != PRIO_LOW) {
+        puts("[FAILED] o_low kept the priority of the timed out o_high");
+        failed = true;
+    }
+
+    mutex_unlock(&phase_done);
+
+    return NULL;
+}
+
+static void *o_high_handler(void *arg)
+{
+    (void)arg;
+
+    xtimer_usleep(HIGH_DELAY_US);
+
+    if (xtimer_mutex_lock_timeout(&timeout_mtx, HIGH_TIMEOUT_US) == 0) {
+        mutex_unlock(&timeout_mtx);
+        return NULL;
+    }
+    timed_out = true;
+
+    return NULL;
+}
+
+int main(void)
+{
+    puts("Mutex priority inheritance test");
+
+    thread_create(stack_high, sizeof(stack_high), PRIO_HIGH,
+                  THREAD_CREATE_STACKTEST, t_high_handler, NULL, "t_high");
+    thread_create(stack_mid, sizeof(stack_mid), PRIO_MID,
+                  THREAD_CREATE_STACKTEST, t_mid_handler, NULL, "t_mid");
+    pid_low = thread_create(stack_low, sizeof(stack_low), PRIO_LOW,
+                            THREAD_CREATE_STACKTEST, t_low_handler, NULL, "t_low");
+    /* main has the lowest priority, all threads of a phase have ended when
+     * it runs again */
+    mutex_lock(&phase_done);
+
+    /* n_low holds two mutexes while n_high waits for the outer one */
+    thread_create(stack_high, sizeof(stack_high), PRIO_HIGH,
+                  THREAD_CREATE_STACKTEST, n_high_handler, NULL, "n_high");
+    pid_low = thread_create(stack_low, sizeof(stack_low), PRIO_LOW,
+                            THREAD_CREATE_STACKTEST, n_low_handler, NULL, "n_low");
+    mutex_lock(&phase_done);
+
+    /* o_high stops waiting for the mutex held by o_low on a timeout */
+    thread_create(stack_high, sizeof(stack_high), PRIO_HIGH,
+                  THREAD_CREATE_STACKTEST, o_high_handler, NULL, "o_high");
+    pid_low = thread_create(stack_low, sizeof(stack_low), PRIO_LOW,
+                            THREAD_CREATE_STACKTEST, o_low_handler, NULL, "o_low");
+    mutex_lock(&phase_done);
+
+    puts(failed ? "[FAILED]" : "[SUCCESS]");
+
+    return 0;
+}
@@ -0,0 +1,26 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import sys
+
+
+def testfunc(child):
+    child.expect_exact("Mutex priority inheritance test")
+    child.expect(r"{ \"latency_us\" : \d+, \"limit_us\" : \d+ }")
+    child.expect(r"{ \"inner_unlock_prio\" : (\d+), \"expected\" : (\d+) }")
+    assert child.match.group(1) == child.match.group(2)
+    child.expect(r"{ \"timeout_unlock_prio\" : (\d+), \"expected\" : (\d+) }")
+    assert child.match.group(1) == child.match.group(2)
+    child.expect_exact("[SUCCESS]")
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.join(os.environ['RIOTTOOLS'], 'testrunner'))
+    from testrunner import run
+    sys.exit(run(testfunc, timeout=5))
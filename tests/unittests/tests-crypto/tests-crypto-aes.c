@@ -61,6 +61,32 @@ static void test_crypto_aes_encrypt(void)
     TEST_ASSERT_MESSAGE(1 == compare(TEST_1_ENC, data, AES_BLOCK_SIZE), "wrong ciphertext");
 }
 
+static void test_crypto_aes_encrypt_expanded(void)
+{
+    AES_KEY aeskey;
+    int err;
+    uint8_t data[AES_BLOCK_SIZE];
+
+    err = aes_expand_encrypt_key(TEST_0_KEY, AES_KEY_SIZE, &aeskey);
+    TEST_ASSERT_EQUAL_INT(0, err);
+
+    err = aes_encrypt_expanded(&aeskey, TEST_0_INP, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_0_ENC, data, AES_BLOCK_SIZE), "wrong ciphertext");
+
+    err = aes_expand_encrypt_key(TEST_1_KEY, AES_KEY_SIZE, &aeskey);
+    TEST_ASSERT_EQUAL_INT(0, err);
+
+    err = aes_encrypt_expanded(&aeskey, TEST_1_INP, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_1_ENC, data, AES_BLOCK_SIZE), "wrong ciphertext");
+
+    /* schedule is reusable for more blocks */
+    err = aes_encrypt_expanded(&aeskey, TEST_1_INP, data);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    TEST_ASSERT_MESSAGE(1 == compare(TEST_1_ENC, data, AES_BLOCK_SIZE), "wrong ciphertext");
+}
+
 static void test_crypto_aes_decrypt(void)
 {
 
@@ -87,6 +113,7 @@ Test* tests_crypto_aes_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_aes_encrypt),
+                        new_TestFixture(test_crypto_aes_encrypt_expanded),
                         new_TestFixture(test_crypto_aes_decrypt),
     };
 
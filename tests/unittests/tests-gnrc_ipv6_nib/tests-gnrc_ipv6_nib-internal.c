@@ -1409,6 +1409,36 @@ static void test_nib_offl_alloc__success_overwrite_unspecified(void)
     TEST_ASSERT(ipv6_addr_equal(&next_hop, &dst1->next_hop->ipv6));
 }
 
+/*
+ * Creates an off-link entry with no next hop address and then one with equal
+ * prefix and interface, but with a next hop address, and looks up the next
+ * hop by that address. Repeated for some addresses, so some are hashed to
+ * another bucket than the unspecified address.
+ * Expected result: the on-link entry of the next hop is found by its new
+ * address and is gone after the off-link entry is removed
+ */
+static void test_nib_offl_alloc__success_overwrite_unspecified_get(void)
+{
+    _nib_offl_entry_t *dst;
+    _nib_onl_entry_t *node;
+    ipv6_addr_t next_hop = { .u64 = { { .u8 = LINK_LOCAL_PREFIX },
+                                    { .u64 = TEST_UINT64 } } };
+    static const ipv6_addr_t pfx = { .u64 = { { .u8 = GLOBAL_PREFIX } } };
+
+    for (unsigned i = 0; i < 4; i++) {
+        TEST_ASSERT_NOT_NULL((dst = _nib_offl_alloc(NULL, IFACE, &pfx,
+                                                    GLOBAL_PREFIX_LEN)));
+        dst->mode |= _PL;
+        TEST_ASSERT(dst == _nib_offl_alloc(&next_hop, IFACE, &pfx,
+                                           GLOBAL_PREFIX_LEN));
+        TEST_ASSERT_NOT_NULL((node = _nib_onl_get(&next_hop, IFACE)));
+        TEST_ASSERT(dst->next_hop == node);
+        _nib_offl_remove(dst, _PL);
+        TEST_ASSERT_NULL(_nib_onl_get(&next_hop, IFACE));
+        next_hop.u64[1].u64++;
+    }
+}
+
 /*
  * Creates an off-link entry.
  * Expected result: new entry should contain the given prefix, address and
@@ -1977,6 +2007,7 @@ Test *tests_gnrc_ipv6_nib_internal_tests(void)
         new_TestFixture(test_nib_offl_alloc__no_space_left_diff_next_hop_iface_pfx_pfx_len),
         new_TestFixture(test_nib_offl_alloc__success_duplicate),
         new_TestFixture(test_nib_offl_alloc__success_overwrite_unspecified),
+        new_TestFixture(test_nib_offl_alloc__success_overwrite_unspecified_get),
         new_TestFixture(test_nib_offl_alloc__success),
         new_TestFixture(test_nib_offl_clear__uncleared),
         new_TestFixture(test_nib_offl_clear__same_next_hop),
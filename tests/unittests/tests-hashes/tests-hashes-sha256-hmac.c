@@ -328,6 +328,54 @@ static void test_hashes_hmac_sha256_ite_hash_PRF6_split(void)
                  "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2", hmac));
 }
 
+static void test_hashes_hmac_sha256_snapshot_PRF2(void)
+{
+    /* Test Case PRF-2: */
+    hmac_sha256_snapshot_t snapshot;
+    const unsigned char strPRF2[] = "what do ya want for nothing?";
+    unsigned char key[4] = {'J', 'e', 'f', 'e'};
+    static unsigned char hmac[SHA256_DIGEST_LENGTH];
+
+    hmac_sha256_precompute(&snapshot, key, sizeof(key));
+
+    /* the snapshot must stay usable for any number of messages */
+    for (int i = 0; i < 2; ++i) {
+        memset(hmac, 0, sizeof(hmac));
+        hmac_sha256_from_snapshot(&snapshot, strPRF2, strlen((char*)strPRF2), hmac);
+        TEST_ASSERT(compare_str_vs_digest(
+                     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", hmac));
+    }
+}
+
+static void test_hashes_hmac_sha256_snapshot_PRF6_split(void)
+{
+    /* Test Case PRF-6: */
+    hmac_context_t ctx;
+    hmac_sha256_snapshot_t snapshot;
+    const unsigned char strPRF6_1[] = "This is a test using a larger than block-size key and a ";
+    const unsigned char strPRF6_2[] = "larger than block-size data. The key needs to be hashed ";
+    const unsigned char strPRF6_3[] = "before being used by the HMAC algorithm.";
+
+    unsigned char longKey[131];
+    static unsigned char hmac[SHA256_DIGEST_LENGTH];
+    memset(longKey, 0xaa, sizeof(longKey));
+
+    /* the same key is used as above: 131 x 0xa */
+
+    hmac_sha256_init(&ctx, longKey, sizeof(longKey));
+    hmac_sha256_snapshot(&ctx, &snapshot);
+    memset(&ctx, 0, sizeof(ctx));
+
+    hmac_sha256_init_snapshot(&ctx, &snapshot);
+    hmac_sha256_update(&ctx, strPRF6_1, strlen((char*)strPRF6_1));
+    hmac_sha256_update(&ctx, strPRF6_2, strlen((char*)strPRF6_2));
+    hmac_sha256_update(&ctx, strPRF6_3, strlen((char*)strPRF6_3));
+    hmac_sha256_final(&ctx, hmac);
+
+    TEST_ASSERT(compare_str_vs_digest(
+                 "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2", hmac));
+}
+
 Test *tests_hashes_sha256_hmac_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -346,6 +394,8 @@ Test *tests_hashes_sha256_hmac_tests(void)
         new_TestFixture(test_hashes_hmac_sha256_ite_hash_PRF5),
         new_TestFixture(test_hashes_hmac_sha256_ite_hash_PRF6),
         new_TestFixture(test_hashes_hmac_sha256_ite_hash_PRF6_split),
+        new_TestFixture(test_hashes_hmac_sha256_snapshot_PRF2),
+        new_TestFixture(test_hashes_hmac_sha256_snapshot_PRF6_split),
     };
 
     EMB_UNIT_TESTCALLER(hashes_sha256_tests, NULL, NULL,
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "kvlog.h"
+
+#include "tests-kvlog.h"
+
+#define BASE            (64U)
+#define BANK_SIZE       (256U)
+#define INDEX_SIZE      (4U)
+
+/* RAM-based storage mock, losing power after a number of written bytes */
+static uint8_t storage[BASE + 2 * BANK_SIZE];
+static int budget;
+static unsigned overwrites;
+static uint8_t erased;
+
+static int _read(uint32_t addr, void *buf, size_t len)
+{
+    if (addr + len > sizeof(storage)) {
+        return -EOVERFLOW;
+    }
+    memcpy(buf, storage + addr, len);
+    return 0;
+}
+
+static int _write(uint32_t addr, const void *buf, size_t len)
+{
+    const uint8_t *data = buf;
+
+    if ((addr < BASE) || (addr + len > sizeof(storage)) ||
+        (addr % KVLOG_ALIGN) || (len % KVLOG_ALIGN)) {
+        return -EOVERFLOW;
+    }
+    for (unsigned i = 0; i < len; i++, budget--) {
+        if (budget == 0) {
+            return -EIO;
+        }
+        if (storage[addr + i] != erased) {
+            overwrites++;
+        }
+        storage[addr + i] = data[i];
+    }
+    return 0;
+}
+
+static int _erase(uint32_t addr, size_t len)
+{
+    if ((addr < BASE) || (addr + len > sizeof(storage))) {
+        return -EOVERFLOW;
+    }
+    for (unsigned i = 0; i < len; i++, budget--) {
+        if (budget == 0) {
+            return -EIO;
+        }
+        storage[addr + i] = erased;
+    }
+    return 0;
+}
+
+static const kvlog_driver_t _flash_driver = {
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .erased = 0xff,
+};
+
+static const kvlog_driver_t _eeprom_driver = {
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+    .erased = 0x00,
+};
+
+static kvlog_entry_t entries[INDEX_SIZE];
+static kvlog_t kv;
+
+static const uint8_t pattern[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/* power cycle with a new descriptor */
+static int _remount(void)
+{
+    const kvlog_driver_t *driver = kv.driver;
+
+    budget = -1;
+    memset(&kv, 0, sizeof(kv));
+    memset(entries, 0, sizeof(entries));
+    kv.driver = driver;
+    kv.base = BASE;
+    kv.bank_size = BANK_SIZE;
+    kv.index = entries;
+    kv.numof = INDEX_SIZE;
+    return kvlog_init(&kv);
+}
+
+static void _setup(const kvlog_driver_t *driver)
+{
+    erased = driver->erased;
+    /* never formatted */
+    memset(storage, 0x5a, sizeof(storage));
+    overwrites = 0;
+    kv.driver = driver;
+    _remount();
+}
+
+static void set_up(void)
+{
+    _setup(&_flash_driver);
+}
+
+static uint32_t _counter(uint8_t key)
+{
+    uint32_t value;
+
+    if (kvlog_get(&kv, key, &value, sizeof(value)) != sizeof(value)) {
+        return UINT32_MAX;
+    }
+    return value;
+}
+
+static void test_kvlog_format(void)
+{
+    uint8_t buf[4];
+
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvlog_get(&kv, 1, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, kv.used);
+    /* formatted storage is mounted again as is */
+    TEST_ASSERT_EQUAL_INT(0, _remount());
+    TEST_ASSERT_EQUAL_INT(0, kv.stats.compactions);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvlog_get(&kv, 1, buf, sizeof(buf)));
+}
+
+static void test_kvlog_set_get(void)
+{
+    uint8_t buf[sizeof(pattern)];
+
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, pattern, 5));
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 2, pattern + 5, 3));
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, pattern, sizeof(pattern)));
+
+    TEST_ASSERT_EQUAL_INT(sizeof(pattern), kvlog_get(&kv, 1, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, pattern, sizeof(pattern)));
+    TEST_ASSERT_EQUAL_INT(3, kvlog_get(&kv, 2, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, "FGH", 3));
+
+    /* truncated read returns the full size */
+    memset(buf, 0, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(sizeof(pattern), kvlog_get(&kv, 1, buf, 2));
+    TEST_ASSERT_EQUAL_INT(0, buf[2]);
+    TEST_ASSERT_EQUAL_INT(0, overwrites);
+}
+
+static void test_kvlog_invalid(void)
+{
+    TEST_ASSERT_EQUAL_INT(-EINVAL, kvlog_set(&kv, 1, pattern, 0));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, kvlog_set(&kv, KVLOG_KEY_MAX + 1, pattern, 1));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvlog_delete(&kv, 1));
+    for (unsigned i = 0; i < INDEX_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, i, pattern, 1));
+    }
+    TEST_ASSERT_EQUAL_INT(-ENOMEM, kvlog_set(&kv, INDEX_SIZE, pattern, 1));
+    /* existing keys can still be changed */
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 0, pattern, 2));
+}
+
+static void test_kvlog_skip_unchanged(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, pattern, 8));
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, pattern, 8));
+    TEST_ASSERT_EQUAL_INT(1, kv.stats.appends);
+    TEST_ASSERT_EQUAL_INT(1, kv.stats.skipped);
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, pattern + 1, 8));
+    TEST_ASSERT_EQUAL_INT(2, kv.stats.appends);
+}
+
+static void test_kvlog_persist(void)
+{
+    uint8_t buf[sizeof(pattern)];
+
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 7, pattern, 10));
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 9, pattern, 3));
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 7, pattern + 10, 10));
+    TEST_ASSERT_EQUAL_INT(0, kvlog_delete(&kv, 9));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvlog_get(&kv, 9, buf, sizeof(buf)));
+
+    TEST_ASSERT_EQUAL_INT(0, _remount());
+    TEST_ASSERT_EQUAL_INT(1, kv.used);
+    TEST_ASSERT_EQUAL_INT(10, kvlog_get(&kv, 7, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, pattern + 10, 10));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, kvlog_get(&kv, 9, buf, sizeof(buf)));
+}
+
+static void test_kvlog_compaction(void)
+{
+    uint8_t buf[sizeof(pattern)];
+
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 3, pattern, sizeof(pattern)));
+    for (uint32_t i = 0; i < 200; i++) {
+        TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, &i, sizeof(i)));
+    }
+    /* 8 bytes per update, 30 fit in a bank */
+    TEST_ASSERT(kv.stats.compactions >= 6);
+    TEST_ASSERT_EQUAL_INT(199, _counter(1));
+    TEST_ASSERT_EQUAL_INT(0, overwrites);
+
+    TEST_ASSERT_EQUAL_INT(0, _remount());
+    TEST_ASSERT_EQUAL_INT(199, _counter(1));
+    TEST_ASSERT_EQUAL_INT(sizeof(pattern), kvlog_get(&kv, 3, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, pattern, sizeof(pattern)));
+}
+
+static void test_kvlog_full(void)
+{
+    /* two values of 200 bytes do not fit in a bank of 256 bytes */
+    uint8_t big[KVLOG_VALUE_MAX] = { 0 };
+
+    TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, big, 200));
+    TEST_ASSERT_EQUAL_INT(-ENOSPC, kvlog_set(&kv, 2, big, 200));
+    TEST_ASSERT_EQUAL_INT(0, _remount());
+    TEST_ASSERT_EQUAL_INT(200, kvlog_get(&kv, 1, big, sizeof(big)));
+}
+
+/* loses power after every possible number of bytes of an update */
+static void _power_loss_append(void)
+{
+    for (int lost = 0; ; lost++) {
+        uint32_t old = 1, new = 2;
+
+        _setup(kv.driver);
+        TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, &old, sizeof(old)));
+        TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 2, pattern, 6));
+
+        budget = lost;
+        int res = kvlog_set(&kv, 1, &new, sizeof(new));
+
+        TEST_ASSERT_EQUAL_INT(0, _remount());
+        TEST_ASSERT_EQUAL_INT((res == 0) ? new : old, _counter(1));
+        TEST_ASSERT_EQUAL_INT(6, kvlog_get(&kv, 2, &old, 0));
+
+        /* the store keeps working after the power loss */
+        new = 3;
+        TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, &new, sizeof(new)));
+        TEST_ASSERT_EQUAL_INT(0, _remount());
+        TEST_ASSERT_EQUAL_INT(3, _counter(1));
+        TEST_ASSERT_EQUAL_INT(0, overwrites);
+
+        if (res == 0) {
+            break;
+        }
+    }
+}
+
+static void test_kvlog_power_loss_append(void)
+{
+    _power_loss_append();
+}
+
+static void test_kvlog_power_loss_append_eeprom(void)
+{
+    _setup(&_eeprom_driver);
+    _power_loss_append();
+}
+
+static void test_kvlog_power_loss_compaction(void)
+{
+    for (int lost = 0; ; lost++) {
+        uint32_t i;
+
+        _setup(&_flash_driver);
+        TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 2, pattern, sizeof(pattern)));
+        /* fill the bank up to the last update */
+        for (i = 0; kv.end + 8 <= BANK_SIZE; i++) {
+            TEST_ASSERT_EQUAL_INT(0, kvlog_set(&kv, 1, &i, sizeof(i)));
+        }
+        TEST_ASSERT_EQUAL_INT(0, kv.stats.compactions);
+
+        budget = lost;
+        int res = kvlog_set(&kv, 1, &i, sizeof(i));
+
+        TEST_ASSERT_EQUAL_INT(0, _remount());
+        TEST_ASSERT_EQUAL_INT((res == 0) ? i : i - 1, _counter(1));
+        TEST_ASSERT_EQUAL_INT(sizeof(pattern), kvlog_get(&kv, 2, &i, 0));
+        TEST_ASSERT_EQUAL_INT(0, overwrites);
+
+        if (res == 0) {
+            break;
+        }
+    }
+}
+
+Test *tests_kvlog_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_kvlog_format),
+        new_TestFixture(test_kvlog_set_get),
+        new_TestFixture(test_kvlog_invalid),
+        new_TestFixture(test_kvlog_skip_unchanged),
+        new_TestFixture(test_kvlog_persist),
+        new_TestFixture(test_kvlog_compaction),
+        new_TestFixture(test_kvlog_full),
+        new_TestFixture(test_kvlog_power_loss_append),
+        new_TestFixture(test_kvlog_power_loss_append_eeprom),
+        new_TestFixture(test_kvlog_power_loss_compaction),
+    };
+
+    EMB_UNIT_TESTCALLER(kvlog_tests, set_up, NULL, fixtures);
+
+    return (Test *)&kvlog_tests;
+}
+
+void tests_kvlog(void)
+{
+    TESTS_RUN(tests_kvlog_tests());
+}
+/** @} */
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+
+#include "embUnit.h"
+
+#include "lpm_trie.h"
+
+#include "tests-lpm_trie.h"
+
+#define TEST_PREFIXES   (4U)
+
+static lpm_trie_node_t nodes[LPM_TRIE_NODES_NUMOF(TEST_PREFIXES)];
+static lpm_trie_t trie;
+
+/* 2001:db8::/32, 2001:db8:0:1::/64, 2001:db8:0:1::1/128 and 2001:db8:8000::/33 */
+static const uint8_t pfx32[]  = { 0x20, 0x01, 0x0d, 0xb8 };
+static const uint8_t pfx64[]  = { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t pfx128[] = { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x01,
+                                  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t pfx33[]  = { 0x20, 0x01, 0x0d, 0xb8, 0x80 };
+/* 2001:db9::/32 */
+static const uint8_t pfx32b[] = { 0x20, 0x01, 0x0d, 0xb9 };
+
+static const uint8_t addr_in64[]  = { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x01,
+                                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 };
+static const uint8_t addr_in32[]  = { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x02,
+                                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t addr_in33[]  = { 0x20, 0x01, 0x0d, 0xb8, 0x80, 0x00, 0x00, 0x01,
+                                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t addr_other[] = { 0xfe, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+static int v32, v64, v128, v33;
+
+static void set_up(void)
+{
+    lpm_trie_init(&trie, nodes, sizeof(nodes) / sizeof(nodes[0]));
+}
+
+static void _add_all(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, lpm_trie_add(&trie, pfx64, 64, &v64));
+    TEST_ASSERT_EQUAL_INT(0, lpm_trie_add(&trie, pfx128, 128, &v128));
+    TEST_ASSERT_EQUAL_INT(0, lpm_trie_add(&trie, pfx32, 32, &v32));
+    TEST_ASSERT_EQUAL_INT(0, lpm_trie_add(&trie, pfx33, 33, &v33));
+}
+
+static void test_lpm_trie_match_empty(void)
+{
+    TEST_ASSERT_NULL(lpm_trie_match(&trie, addr_in64, 128, NULL));
+}
+
+static void test_lpm_trie_match_longest(void)
+{
+    uint8_t len;
+
+    _add_all();
+
+    TEST_ASSERT(lpm_trie_match(&trie, pfx128, 128, &len) == &v128);
+    TEST_ASSERT_EQUAL_INT(128, len);
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in64, 128, &len) == &v64);
+    TEST_ASSERT_EQUAL_INT(64, len);
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in32, 128, &len) == &v32);
+    TEST_ASSERT_EQUAL_INT(32, len);
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in33, 128, &len) == &v33);
+    TEST_ASSERT_EQUAL_INT(33, len);
+    TEST_ASSERT_NULL(lpm_trie_match(&trie, addr_other, 128, &len));
+}
+
+static void test_lpm_trie_add_exists(void)
+{
+    _add_all();
+
+    TEST_ASSERT_EQUAL_INT(-EEXIST, lpm_trie_add(&trie, pfx64, 64, &v32));
+    /* bits beyond the prefix length don't matter */
+    TEST_ASSERT_EQUAL_INT(-EEXIST, lpm_trie_add(&trie, addr_in64, 64, &v32));
+    TEST_ASSERT(lpm_trie_get(&trie, pfx64, 64) == &v64);
+}
+
+static void test_lpm_trie_add_full(void)
+{
+    /* the four prefixes extend each other and need no branching nodes */
+    lpm_trie_init(&trie, nodes, TEST_PREFIXES);
+    _add_all();
+
+    TEST_ASSERT_EQUAL_INT(-ENOMEM, lpm_trie_add(&trie, pfx32b, 32, &v32));
+}
+
+static void test_lpm_trie_get(void)
+{
+    _add_all();
+    TEST_ASSERT_EQUAL_INT(0, lpm_trie_add(&trie, pfx32b, 32, &v32));
+
+    TEST_ASSERT(lpm_trie_get(&trie, pfx32, 32) == &v32);
+    TEST_ASSERT(lpm_trie_get(&trie, pfx32b, 32) == &v32);
+    TEST_ASSERT(lpm_trie_get(&trie, pfx33, 33) == &v33);
+    /* branching node of both /32 prefixes has no value */
+    TEST_ASSERT_NULL(lpm_trie_get(&trie, pfx32, 31));
+    TEST_ASSERT_NULL(lpm_trie_get(&trie, addr_in64, 128));
+}
+
+static void test_lpm_trie_remove(void)
+{
+    _add_all();
+
+    TEST_ASSERT(lpm_trie_remove(&trie, pfx64, 64) == &v64);
+    TEST_ASSERT_NULL(lpm_trie_remove(&trie, pfx64, 64));
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in64, 128, NULL) == &v32);
+    TEST_ASSERT(lpm_trie_match(&trie, pfx128, 128, NULL) == &v128);
+
+    TEST_ASSERT(lpm_trie_remove(&trie, pfx32, 32) == &v32);
+    TEST_ASSERT_NULL(lpm_trie_match(&trie, addr_in32, 128, NULL));
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in33, 128, NULL) == &v33);
+
+    TEST_ASSERT(lpm_trie_remove(&trie, pfx128, 128) == &v128);
+    TEST_ASSERT(lpm_trie_remove(&trie, pfx33, 33) == &v33);
+    TEST_ASSERT_NULL(trie.root);
+}
+
+static void test_lpm_trie_remove_reuse(void)
+{
+    _add_all();
+
+    /* all nodes are returned, so everything fits again */
+    lpm_trie_remove(&trie, pfx64, 64);
+    lpm_trie_remove(&trie, pfx128, 128);
+    lpm_trie_remove(&trie, pfx32, 32);
+    lpm_trie_remove(&trie, pfx33, 33);
+    _add_all();
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in64, 128, NULL) == &v64);
+}
+
+static void test_lpm_trie_default_route(void)
+{
+    static const uint8_t any[] = { 0 };
+
+    _add_all();
+    TEST_ASSERT(lpm_trie_remove(&trie, pfx33, 33) == &v33);
+    TEST_ASSERT_EQUAL_INT(0, lpm_trie_add(&trie, any, 0, &v33));
+
+    TEST_ASSERT(lpm_trie_match(&trie, addr_other, 128, NULL) == &v33);
+    TEST_ASSERT(lpm_trie_match(&trie, addr_in64, 128, NULL) == &v64);
+}
+
+Test *tests_lpm_trie_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_lpm_trie_match_empty),
+        new_TestFixture(test_lpm_trie_match_longest),
+        new_TestFixture(test_lpm_trie_add_exists),
+        new_TestFixture(test_lpm_trie_add_full),
+        new_TestFixture(test_lpm_trie_get),
+        new_TestFixture(test_lpm_trie_remove),
+        new_TestFixture(test_lpm_trie_remove_reuse),
+        new_TestFixture(test_lpm_trie_default_route),
+    };
+
+    EMB_UNIT_TESTCALLER(lpm_trie_tests, set_up, NULL, fixtures);
+
+    return (Test *)&lpm_trie_tests;
+}
+
+void tests_lpm_trie(void)
+{
+    TESTS_RUN(tests_lpm_trie_tests());
+}
+/** @} */
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "msg_buf.h"
+#include "thread.h"
+
+#include "unittests-constants.h"
+#include "tests-msg_buf.h"
+
+#define TEST_PAYLOAD    (sizeof(TEST_STRING64))
+#define TEST_NUM        (4U)
+#define TEST_MSG_TYPE   (0x4242)
+
+static MSG_BUF_POOL_DATA(pool_data, TEST_PAYLOAD, TEST_NUM);
+static msg_buf_pool_t pool;
+
+static char receiver_stack[THREAD_STACKSIZE_DEFAULT];
+static msg_buf_t *received;
+static uint16_t received_type;
+static bool received_match;
+static msg_buf_t *allocated;
+
+static void set_up(void)
+{
+    msg_buf_pool_init(&pool, pool_data, TEST_PAYLOAD, TEST_NUM);
+    received = NULL;
+    received_match = false;
+    allocated = NULL;
+}
+
+static void *receiver(void *arg)
+{
+    (void)arg;
+    msg_t m;
+
+    msg_receive(&m);
+
+    received = msg_buf_get(&m);
+    received_type = m.type;
+    received_match = (received->len == sizeof(TEST_STRING64)) &&
+                     (memcmp(received->data, TEST_STRING64, received->len) == 0);
+    msg_buf_release(received);
+
+    return NULL;
+}
+
+static void *allocator(void *arg)
+{
+    (void)arg;
+
+    allocated = msg_buf_alloc_wait(&pool);
+    msg_buf_release(allocated);
+
+    return NULL;
+}
+
+static void test_msg_buf_pool_payload(void)
+{
+    TEST_ASSERT(msg_buf_pool_payload(&pool) >= TEST_PAYLOAD);
+}
+
+static void test_msg_buf_alloc_exhaust(void)
+{
+    msg_buf_t *bufs[TEST_NUM];
+
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        bufs[i] = msg_buf_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(bufs[i]);
+        TEST_ASSERT_EQUAL_INT(1, bufs[i]->refs);
+        TEST_ASSERT_EQUAL_INT(0, bufs[i]->len);
+        /* blocks don't overlap */
+        memset(bufs[i]->data, i, TEST_PAYLOAD);
+    }
+    TEST_ASSERT_NULL(msg_buf_alloc(&pool));
+    TEST_ASSERT_EQUAL_INT(TEST_NUM, pool.used);
+    TEST_ASSERT_EQUAL_INT(1, pool.alloc_failed);
+
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        TEST_ASSERT_EQUAL_INT(i, bufs[i]->data[0]);
+        TEST_ASSERT_EQUAL_INT(i, bufs[i]->data[TEST_PAYLOAD - 1]);
+        msg_buf_release(bufs[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, pool.used);
+    TEST_ASSERT_EQUAL_INT(TEST_NUM, pool.used_max);
+}
+
+static void test_msg_buf_release_reuse(void)
+{
+    msg_buf_t *buf = msg_buf_alloc(&pool);
+
+    msg_buf_release(buf);
+    TEST_ASSERT(msg_buf_alloc(&pool) == buf);
+    TEST_ASSERT_EQUAL_INT(1, pool.used);
+}
+
+static void test_msg_buf_hold(void)
+{
+    msg_buf_t *buf = msg_buf_alloc(&pool);
+
+    msg_buf_hold(buf);
+    TEST_ASSERT_EQUAL_INT(2, buf->refs);
+
+    msg_buf_release(buf);
+    TEST_ASSERT_EQUAL_INT(1, buf->refs);
+    TEST_ASSERT_EQUAL_INT(1, pool.used);
+
+    msg_buf_release(buf);
+    TEST_ASSERT_EQUAL_INT(0, pool.used);
+}
+
+static void test_msg_buf_alloc_wait(void)
+{
+    msg_buf_t *bufs[TEST_NUM];
+
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        bufs[i] = msg_buf_alloc(&pool);
+    }
+
+    /* allocator preempts us and blocks on the exhausted pool */
+    thread_create(receiver_stack, sizeof(receiver_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  allocator, NULL, "msg_buf allocator");
+    TEST_ASSERT_NULL(allocated);
+    TEST_ASSERT_EQUAL_INT(1, pool.waiting);
+
+    /* the release wakes the allocator, which gets the freed block */
+    msg_buf_release(bufs[0]);
+    TEST_ASSERT(allocated == bufs[0]);
+    TEST_ASSERT_EQUAL_INT(0, pool.waiting);
+    TEST_ASSERT_EQUAL_INT(TEST_NUM - 1, pool.used);
+
+    for (unsigned i = 1; i < TEST_NUM; i++) {
+        msg_buf_release(bufs[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, pool.used);
+}
+
+static void test_msg_buf_send(void)
+{
+    msg_buf_t *buf = msg_buf_alloc(&pool);
+
+    memcpy(buf->data, TEST_STRING64, sizeof(TEST_STRING64));
+    buf->len = sizeof(TEST_STRING64);
+
+    /* receiver preempts us and blocks in msg_receive() */
+    kernel_pid_t pid = thread_create(receiver_stack, sizeof(receiver_stack),
+                                     THREAD_PRIORITY_MAIN - 1,
+                                     THREAD_CREATE_STACKTEST,
+                                     receiver, NULL, "msg_buf receiver");
+
+    TEST_ASSERT_EQUAL_INT(1, msg_buf_send(buf, TEST_MSG_TYPE, pid));
+
+    /* receiver got the same block without a copy and released it */
+    TEST_ASSERT(received == buf);
+    TEST_ASSERT_EQUAL_INT(TEST_MSG_TYPE, received_type);
+    TEST_ASSERT(received_match);
+    TEST_ASSERT_EQUAL_INT(0, pool.used);
+}
+
+static void test_msg_buf_send_invalid(void)
+{
+    msg_buf_t *buf = msg_buf_alloc(&pool);
+
+    /* caller keeps the buffer */
+    TEST_ASSERT_EQUAL_INT(-1, msg_buf_send(buf, TEST_MSG_TYPE, KERNEL_PID_UNDEF));
+    TEST_ASSERT_EQUAL_INT(1, buf->refs);
+    TEST_ASSERT_EQUAL_INT(1, pool.used);
+}
+
+Test *tests_msg_buf_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_msg_buf_pool_payload),
+        new_TestFixture(test_msg_buf_alloc_exhaust),
+        new_TestFixture(test_msg_buf_release_reuse),
+        new_TestFixture(test_msg_buf_hold),
+        new_TestFixture(test_msg_buf_alloc_wait),
+        new_TestFixture(test_msg_buf_send),
+        new_TestFixture(test_msg_buf_send_invalid),
+    };
+
+    EMB_UNIT_TESTCALLER(msg_buf_tests, set_up, NULL, fixtures);
+
+    return (Test *)&msg_buf_tests;
+}
+
+void tests_msg_buf(void)
+{
+    TESTS_RUN(tests_msg_buf_tests());
+}
+/** @} */
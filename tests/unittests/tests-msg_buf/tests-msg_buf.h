@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @addtogroup  unittests
+ * @{
+ *
+ * @file
+ * @brief       Unittests for the ``msg_buf`` module
+ */
+#ifndef TESTS_MSG_BUF_H
+#define TESTS_MSG_BUF_H
+
+#include "embUnit.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   The entry point of this test suite.
+ */
+void tests_msg_buf(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TESTS_MSG_BUF_H */
+/** @} */
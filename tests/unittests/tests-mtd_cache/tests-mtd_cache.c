@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "mtd.h"
+#include "mtd_cache.h"
+
+#include "tests-mtd_cache.h"
+
+#define SECTOR_COUNT    (4U)
+#define PAGE_PER_SECTOR (4U)
+#define PAGE_SIZE       (32U)
+#define SECTOR_SIZE     (PAGE_PER_SECTOR * PAGE_SIZE)
+
+#define CACHE_PAGES     (3U)
+
+/* RAM-based flash mock counting the accesses */
+static uint8_t flash[SECTOR_COUNT * SECTOR_SIZE];
+static unsigned reads, writes;
+
+static int _init(mtd_dev_t *dev)
+{
+    (void)dev;
+    return 0;
+}
+
+static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if (addr + size > sizeof(flash)) {
+        return -EOVERFLOW;
+    }
+    memcpy(buff, flash + addr, size);
+    reads++;
+
+    return size;
+}
+
+static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if ((addr + size > sizeof(flash)) ||
+        (((addr % PAGE_SIZE) + size) > PAGE_SIZE)) {
+        return -EOVERFLOW;
+    }
+    for (unsigned i = 0; i < size; i++) {
+        flash[addr + i] &= ((const uint8_t *)buff)[i];
+    }
+    writes++;
+
+    return size;
+}
+
+static int _erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    memset(flash + addr, 0xff, size);
+    return 0;
+}
+
+static const mtd_desc_t _flash_driver = {
+    .init = _init,
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+};
+
+static mtd_dev_t _flash = {
+    .driver = &_flash_driver,
+    .sector_count = SECTOR_COUNT,
+    .pages_per_sector = PAGE_PER_SECTOR,
+    .page_size = PAGE_SIZE,
+};
+
+static uint8_t cache_buf[CACHE_PAGES * PAGE_SIZE];
+static mtd_cache_page_t cache_pages[CACHE_PAGES];
+static mtd_cache_t cache;
+static mtd_dev_t *dev = &cache.base;
+
+static const uint8_t pattern[] = "ABCDEFGH";
+
+static void set_up(void)
+{
+    memset(flash, 0xff, sizeof(flash));
+    memset(&cache, 0, sizeof(cache));
+    cache.base.driver = &mtd_cache_driver;
+    cache.parent = &_flash;
+    cache.buf = cache_buf;
+    cache.pages = cache_pages;
+    cache.numof = CACHE_PAGES;
+    mtd_init(dev);
+    reads = 0;
+    writes = 0;
+}
+
+static void _read_page(unsigned page)
+{
+    uint8_t buf[4];
+
+    TEST_ASSERT_EQUAL_INT(sizeof(buf),
+                          mtd_read(dev, buf, page * PAGE_SIZE, sizeof(buf)));
+}
+
+static void test_mtd_cache_init(void)
+{
+    TEST_ASSERT_EQUAL_INT(SECTOR_COUNT, dev->sector_count);
+    TEST_ASSERT_EQUAL_INT(PAGE_PER_SECTOR, dev->pages_per_sector);
+    TEST_ASSERT_EQUAL_INT(PAGE_SIZE, dev->page_size);
+}
+
+static void test_mtd_cache_read_hit(void)
+{
+    uint8_t buf[PAGE_SIZE + 8];
+
+    memcpy(flash + PAGE_SIZE - 4, pattern, sizeof(pattern));
+    for (unsigned i = 0; i < 4; i++) {
+        _read_page(0);
+    }
+    TEST_ASSERT_EQUAL_INT(1, reads);
+    TEST_ASSERT_EQUAL_INT(3, cache.stats.hits);
+
+    /* read across a page boundary */
+    TEST_ASSERT_EQUAL_INT(sizeof(buf), mtd_read(dev, buf, 0, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf + PAGE_SIZE - 4, pattern, sizeof(pattern)));
+    TEST_ASSERT_EQUAL_INT(2, reads);
+}
+
+static void test_mtd_cache_lru(void)
+{
+    _read_page(0);
+    _read_page(4);
+    _read_page(8);
+    _read_page(0);
+    /* page 4 is least recently used */
+    _read_page(12);
+    TEST_ASSERT_EQUAL_INT(4, reads);
+    _read_page(0);
+    _read_page(8);
+    TEST_ASSERT_EQUAL_INT(4, reads);
+    _read_page(4);
+    TEST_ASSERT_EQUAL_INT(5, reads);
+}
+
+static void test_mtd_cache_write_back(void)
+{
+    uint8_t buf[sizeof(pattern)];
+
+    TEST_ASSERT_EQUAL_INT(sizeof(pattern),
+                          mtd_write(dev, pattern, 3, sizeof(pattern)));
+    TEST_ASSERT_EQUAL_INT(0, writes);
+    TEST_ASSERT_EQUAL_INT(sizeof(buf), mtd_read(dev, buf, 3, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, pattern, sizeof(pattern)));
+    TEST_ASSERT_EQUAL_INT(0xff, flash[3]);
+
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(flash + 3, pattern, sizeof(pattern)));
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(1, writes);
+}
+
+static void test_mtd_cache_write_merge(void)
+{
+    /* adjacent writes to a page are written back at once */
+    for (unsigned i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(4, mtd_write(dev, pattern + 4 * (i % 2),
+                                           PAGE_SIZE + 4 * i, 4));
+    }
+    TEST_ASSERT_EQUAL_INT(3, cache.stats.merged);
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(flash + PAGE_SIZE, pattern, 8));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(flash + PAGE_SIZE + 8, pattern, 8));
+}
+
+static void test_mtd_cache_write_flash_semantics(void)
+{
+    static const uint8_t a[] = { 0xf0 }, b[] = { 0x3c };
+    uint8_t res;
+
+    mtd_write(dev, a, 0, 1);
+    mtd_write(dev, b, 0, 1);
+    mtd_read(dev, &res, 0, 1);
+    TEST_ASSERT_EQUAL_INT(0x30, res);
+    mtd_flush(dev);
+    TEST_ASSERT_EQUAL_INT(0x30, flash[0]);
+}
+
+static void test_mtd_cache_evict_dirty(void)
+{
+    mtd_write(dev, pattern, 0, sizeof(pattern));
+    _read_page(4);
+    _read_page(8);
+    TEST_ASSERT_EQUAL_INT(0, writes);
+    _read_page(12);
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(flash, pattern, sizeof(pattern)));
+}
+
+static void test_mtd_cache_erase(void)
+{
+    uint8_t buf[sizeof(pattern)];
+    uint8_t erased[sizeof(pattern)];
+
+    memset(erased, 0xff, sizeof(erased));
+    mtd_write(dev, pattern, SECTOR_SIZE, sizeof(pattern));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_erase(dev, PAGE_SIZE, SECTOR_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, mtd_erase(dev, SECTOR_SIZE, SECTOR_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, mtd_flush(dev));
+    TEST_ASSERT_EQUAL_INT(0, writes);
+
+    /* erased page stays cached */
+    mtd_read(dev, buf, SECTOR_SIZE, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(1, reads);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, erased, sizeof(erased)));
+}
+
+static void test_mtd_cache_readahead(void)
+{
+    uint8_t buf[PAGE_SIZE];
+
+    cache.readahead = 2;
+    for (unsigned i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT(PAGE_SIZE,
+                              mtd_read(dev, buf, i * PAGE_SIZE, PAGE_SIZE));
+    }
+    /* pages 0 and 1 miss, 1 reads 2 and 3 ahead, 4 misses and reads 5 and 6 */
+    TEST_ASSERT_EQUAL_INT(3, cache.stats.misses);
+    TEST_ASSERT_EQUAL_INT(4, cache.stats.readaheads);
+    TEST_ASSERT_EQUAL_INT(3, cache.stats.hits);
+}
+
+static void test_mtd_cache_overflow(void)
+{
+    uint8_t buf[4];
+
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_read(dev, buf, sizeof(flash) - 2,
+                                               sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_write(dev, buf, PAGE_SIZE - 2,
+                                                sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(-EOVERFLOW, mtd_write(dev, buf, sizeof(flash),
+                                                sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT(0, reads);
+}
+
+Test *tests_mtd_cache_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_mtd_cache_init),
+        new_TestFixture(test_mtd_cache_read_hit),
+        new_TestFixture(test_mtd_cache_lru),
+        new_TestFixture(test_mtd_cache_write_back),
+        new_TestFixture(test_mtd_cache_write_merge),
+        new_TestFixture(test_mtd_cache_write_flash_semantics),
+        new_TestFixture(test_mtd_cache_evict_dirty),
+        new_TestFixture(test_mtd_cache_erase),
+        new_TestFixture(test_mtd_cache_readahead),
+        new_TestFixture(test_mtd_cache_overflow),
+    };
+
+    EMB_UNIT_TESTCALLER(mtd_cache_tests, set_up, NULL, fixtures);
+
+    return (Test *)&mtd_cache_tests;
+}
+
+void tests_mtd_cache(void)
+{
+    TESTS_RUN(tests_mtd_cache_tests());
+}
+/** @} */
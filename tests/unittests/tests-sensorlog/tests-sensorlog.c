@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2018 Unwired Devices LLC <info@unwds.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "fs/littlefs_fs.h"
+#include "mtd.h"
+#include "sensorlog.h"
+#include "vfs.h"
+
+#include "tests-sensorlog.h"
+
+#define SECTOR_COUNT    (64U)
+#define PAGE_PER_SECTOR (4U)
+#define PAGE_SIZE       (64U)
+
+#define MOUNT_POINT     "/test-sensorlog"
+#define LOG_DIR         MOUNT_POINT "/log"
+
+/* 6 byte header and 10 byte data */
+#define REC_DATA        (10U)
+#define REC_SIZE        (SENSORLOG_HDR_SIZE + REC_DATA)
+#define BUF_RECORDS     (4U)
+
+/* RAM-based mtd */
+static uint8_t memory[PAGE_PER_SECTOR * PAGE_SIZE * SECTOR_COUNT];
+
+static int _init(mtd_dev_t *dev)
+{
+    (void)dev;
+
+    return 0;
+}
+
+static int _read(mtd_dev_t *dev, void *buff, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if (addr + size > sizeof(memory)) {
+        return -EOVERFLOW;
+    }
+    memcpy(buff, memory + addr, size);
+
+    return size;
+}
+
+static int _write(mtd_dev_t *dev, const void *buff, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if ((addr + size > sizeof(memory)) || (size > PAGE_SIZE)) {
+        return -EOVERFLOW;
+    }
+    memcpy(memory + addr, buff, size);
+
+    return size;
+}
+
+static int _erase(mtd_dev_t *dev, uint32_t addr, uint32_t size)
+{
+    (void)dev;
+
+    if ((size % (PAGE_PER_SECTOR * PAGE_SIZE) != 0) ||
+        (addr % (PAGE_PER_SECTOR * PAGE_SIZE) != 0) ||
+        (addr + size > sizeof(memory))) {
+        return -EOVERFLOW;
+    }
+    memset(memory + addr, 0xff, size);
+
+    return 0;
+}
+
+static const mtd_desc_t driver = {
+    .init = _init,
+    .read = _read,
+    .write = _write,
+    .erase = _erase,
+};
+
+static mtd_dev_t dev = {
+    .driver = &driver,
+    .sector_count = SECTOR_COUNT,
+    .pages_per_sector = PAGE_PER_SECTOR,
+    .page_size = PAGE_SIZE,
+};
+
+static littlefs_desc_t fs_desc = {
+    .dev = &dev,
+};
+
+static vfs_mount_t fs_mount = {
+    .fs = &littlefs_file_system,
+    .mount_point = MOUNT_POINT,
+    .private_data = &fs_desc,
+};
+
+static uint8_t buf[BUF_RECORDS * REC_SIZE];
+static sensorlog_t sl;
+
+/* records seen by the replay callback */
+static uint32_t replayed[64];
+static unsigned replayed_numof;
+static unsigned accept;
+
+static void _init_log(uint32_t file_size, uint16_t files)
+{
+    memset(&sl, 0, sizeof(sl));
+    sl.dir = LOG_DIR;
+    sl.buf = buf;
+    sl.buf_size = sizeof(buf);
+    sl.file_size = file_size;
+    sl.files = files;
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_init(&sl));
+}
+
+static void _data(uint32_t n, uint8_t *data)
+{
+    for (unsigned i = 0; i < REC_DATA; i++) {
+        data[i] = (uint8_t)(n * 3 + i);
+    }
+}
+
+static int _write_records(uint32_t from, unsigned numof)
+{
+    uint8_t data[REC_DATA];
+
+    for (uint32_t n = from; n < from + numof; n++) {
+        _data(n, data);
+        int res = sensorlog_write(&sl, n, (uint8_t)n, data, sizeof(data));
+        if (res < 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+/* accepts up to accept records, checking their contents */
+static int _cb(void *arg, const sensorlog_record_t *rec, const uint8_t *data)
+{
+    uint8_t expected[REC_DATA];
+
+    (void)arg;
+    if (replayed_numof >= accept) {
+        return -1;
+    }
+    _data(rec->time, expected);
+    if ((rec->id != (uint8_t)rec->time) || (rec->len != REC_DATA) ||
+        (memcmp(data, expected, REC_DATA) != 0)) {
+        /* makes the sequence checks fail */
+        replayed[replayed_numof++] = UINT32_MAX;
+        return 0;
+    }
+    replayed[replayed_numof++] = rec->time;
+    return 0;
+}
+
+static int _replay(unsigned max, unsigned limit)
+{
+    replayed_numof = 0;
+    accept = limit;
+    return sensorlog_replay(&sl, _cb, NULL, max);
+}
+
+static int _file_size(uint32_t file)
+{
+    char path[SENSORLOG_PATH_MAX];
+    struct stat st;
+
+    sprintf(path, LOG_DIR "/%08x", (unsigned)file);
+    int res = vfs_stat(path, &st);
+    return (res < 0) ? res : (int)st.st_size;
+}
+
+static unsigned _log_files(void)
+{
+    vfs_DIR dir;
+    vfs_dirent_t entry;
+    unsigned numof = 0;
+
+    if (vfs_opendir(&dir, LOG_DIR) < 0) {
+        return 0;
+    }
+    while (vfs_readdir(&dir, &entry) > 0) {
+        if (strlen(entry.d_name) == 8) {
+            numof++;
+        }
+    }
+    vfs_closedir(&dir);
+    return numof;
+}
+
+static void set_up(void)
+{
+    memset(memory, 0xff, sizeof(memory));
+    vfs_format(&fs_mount);
+    vfs_mount(&fs_mount);
+}
+
+static void tear_down(void)
+{
+    vfs_umount(&fs_mount);
+}
+
+static void test_sensorlog_init_invalid(void)
+{
+    memset(&sl, 0, sizeof(sl));
+    sl.dir = LOG_DIR;
+    sl.buf = buf;
+    sl.buf_size = SENSORLOG_HDR_SIZE;
+    sl.file_size = 256;
+    sl.files = 2;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, sensorlog_init(&sl));
+
+    sl.buf_size = sizeof(buf);
+    sl.files = 0;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, sensorlog_init(&sl));
+
+    sl.files = 2;
+    sl.dir = MOUNT_POINT "/a-log-directory-with-a-rather-long-name";
+    TEST_ASSERT_EQUAL_INT(-ENAMETOOLONG, sensorlog_init(&sl));
+}
+
+static void test_sensorlog_write_invalid(void)
+{
+    uint8_t data[sizeof(buf)] = { 0 };
+
+    _init_log(256, 2);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, sensorlog_write(&sl, 0, 0, data,
+                                    sizeof(buf) - SENSORLOG_HDR_SIZE + 1));
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_write(&sl, 0, 0, data,
+                                    sizeof(buf) - SENSORLOG_HDR_SIZE));
+    TEST_ASSERT_EQUAL_INT(1, sl.stats.records);
+}
+
+static void test_sensorlog_batching(void)
+{
+    _init_log(256, 2);
+
+    TEST_ASSERT_EQUAL_INT(0, _write_records(0, BUF_RECORDS));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, _file_size(0));
+    TEST_ASSERT_EQUAL_INT(0, sl.stats.flushes);
+
+    /* a record not fitting in the buffer writes it */
+    TEST_ASSERT_EQUAL_INT(0, _write_records(BUF_RECORDS, 1));
+    TEST_ASSERT_EQUAL_INT(BUF_RECORDS * REC_SIZE, _file_size(0));
+    TEST_ASSERT_EQUAL_INT(1, sl.stats.flushes);
+
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_flush(&sl));
+    TEST_ASSERT_EQUAL_INT((BUF_RECORDS + 1) * REC_SIZE, _file_size(0));
+    TEST_ASSERT_EQUAL_INT(2, sl.stats.flushes);
+
+    /* nothing to flush */
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_flush(&sl));
+    TEST_ASSERT_EQUAL_INT(2, sl.stats.flushes);
+}
+
+static void test_sensorlog_replay(void)
+{
+    _init_log(256, 2);
+    TEST_ASSERT(sensorlog_empty(&sl));
+
+    /* partly buffered records */
+    TEST_ASSERT_EQUAL_INT(0, _write_records(0, 10));
+    TEST_ASSERT(!sensorlog_empty(&sl));
+
+    TEST_ASSERT_EQUAL_INT(10, _replay(100, 100));
+    TEST_ASSERT_EQUAL_INT(10, replayed_numof);
+    for (unsigned i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(i, replayed[i]);
+    }
+    TEST_ASSERT(sensorlog_empty(&sl));
+    TEST_ASSERT_EQUAL_INT(0, _log_files());
+
+    TEST_ASSERT_EQUAL_INT(0, _replay(100, 100));
+
+    /* the log goes on after a complete replay */
+    TEST_ASSERT_EQUAL_INT(0, _write_records(10, 2));
+    TEST_ASSERT_EQUAL_INT(2, _replay(100, 100));
+    TEST_ASSERT_EQUAL_INT(10, replayed[0]);
+    TEST_ASSERT_EQUAL_INT(11, replayed[1]);
+}
+
+static void test_sensorlog_replay_partial(void)
+{
+    _init_log(256, 2);
+    TEST_ASSERT_EQUAL_INT(0, _write_records(0, 10));
+
+    /* limited by max */
+    TEST_ASSERT_EQUAL_INT(3, _replay(3, 100));
+    TEST_ASSERT_EQUAL_INT(2, replayed[2]);
+
+    /* refused by the callback, the refused record comes again */
+    TEST_ASSERT_EQUAL_INT(2, _replay(100, 2));
+    TEST_ASSERT_EQUAL_INT(3, replayed[0]);
+    TEST_ASSERT_EQUAL_INT(4, replayed[1]);
+
+    TEST_ASSERT_EQUAL_INT(5, _replay(100, 100));
+    TEST_ASSERT_EQUAL_INT(5, replayed[0]);
+    TEST_ASSERT_EQUAL_INT(9, replayed[4]);
+    TEST_ASSERT(sensorlog_empty(&sl));
+    TEST_ASSERT_EQUAL_INT(10, sl.stats.replayed);
+}
+
+static void test_sensorlog_persist(void)
+{
+    _init_log(256, 2);
+    TEST_ASSERT_EQUAL_INT(0, _write_records(0, 10));
+    TEST_ASSERT_EQUAL_INT(4, _replay(4, 100));
+    TEST_ASSERT_EQUAL_INT(0, _write_records(10, 2));
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_flush(&sl));
+
+    TEST_ASSERT_EQUAL_INT(0, vfs_umount(&fs_mount));
+    TEST_ASSERT_EQUAL_INT(0, vfs_mount(&fs_mount));
+    _init_log(256, 2);
+
+    TEST_ASSERT_EQUAL_INT(8, _replay(100, 100));
+    for (unsigned i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_INT(i + 4, replayed[i]);
+    }
+    TEST_ASSERT(sensorlog_empty(&sl));
+}
+
+static void test_sensorlog_rotation(void)
+{
+    /* files of 2 buffers, up to 3 files */
+    _init_log(2 * sizeof(buf), 3);
+
+    /* 3 files of 2 buffers and one buffer in RAM */
+    TEST_ASSERT_EQUAL_INT(0, _write_records(0, 7 * BUF_RECORDS));
+    TEST_ASSERT_EQUAL_INT(2, sl.stats.rotations);
+    TEST_ASSERT_EQUAL_INT(0, sl.stats.dropped);
+    TEST_ASSERT_EQUAL_INT(3, _log_files());
+
+    /* a fourth file drops the first one */
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_flush(&sl));
+    TEST_ASSERT_EQUAL_INT(3, sl.stats.rotations);
+    TEST_ASSERT_EQUAL_INT(1, sl.stats.dropped);
+    TEST_ASSERT_EQUAL_INT(3, _log_files());
+    TEST_ASSERT_EQUAL_INT(-ENOENT, _file_size(0));
+
+    TEST_ASSERT_EQUAL_INT(5 * BUF_RECORDS, _replay(100, 100));
+    for (unsigned i = 0; i < 5 * BUF_RECORDS; i++) {
+        TEST_ASSERT_EQUAL_INT(i + 2 * BUF_RECORDS, replayed[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, _log_files());
+}
+
+static void test_sensorlog_rotation_replaying(void)
+{
+    _init_log(2 * sizeof(buf), 2);
+
+    /* the file being replayed is dropped */
+    TEST_ASSERT_EQUAL_INT(0, _write_records(0, 4 * BUF_RECORDS));
+    TEST_ASSERT_EQUAL_INT(1, _replay(1, 100));
+    TEST_ASSERT_EQUAL_INT(0, _write_records(4 * BUF_RECORDS, BUF_RECORDS));
+    TEST_ASSERT_EQUAL_INT(0, sensorlog_flush(&sl));
+    TEST_ASSERT_EQUAL_INT(1, sl.stats.dropped);
+
+    TEST_ASSERT_EQUAL_INT(3 * BUF_RECORDS, _replay(100, 100));
+    TEST_ASSERT_EQUAL_INT(2 * BUF_RECORDS, replayed[0]);
+    TEST_ASSERT_EQUAL_INT(5 * BUF_RECORDS - 1, replayed[3 * BUF_RECORDS - 1]);
+}
+
+Test *tests_sensorlog_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_sensorlog_init_invalid),
+        new_TestFixture(test_sensorlog_write_invalid),
+        new_TestFixture(test_sensorlog_batching),
+        new_TestFixture(test_sensorlog_replay),
+        new_TestFixture(test_sensorlog_replay_partial),
+        new_TestFixture(test_sensorlog_persist),
+        new_TestFixture(test_sensorlog_rotation),
+        new_TestFixture(test_sensorlog_rotation_replaying),
+    };
+
+    EMB_UNIT_TESTCALLER(sensorlog_tests, set_up, tear_down, fixtures);
+
+    return (Test *)&sensorlog_tests;
+}
+
+void tests_sensorlog(void)
+{
+    TESTS_RUN(tests_sensorlog_tests());
+}
+/** @} */
@@ -171,6 +171,49 @@ static void test_vfs_constfs_read_lseek(void)
     TEST_ASSERT_EQUAL_INT(0, res);
 }
 
+static void test_vfs_constfs_span(void)
+{
+    int res;
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    int fd = vfs_open("/test/data.bin", O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+
+    const void *ptr = NULL;
+    ssize_t nbytes;
+    /* the whole file is served from the constfs data */
+    nbytes = vfs_span(fd, 0, 64, &ptr);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_data), nbytes);
+    TEST_ASSERT(ptr == &bin_data[0]);
+
+    /* a range in the middle */
+    nbytes = vfs_span(fd, 8, 4, &ptr);
+    TEST_ASSERT_EQUAL_INT(4, nbytes);
+    TEST_ASSERT(ptr == &bin_data[8]);
+
+    /* at and beyond the end of the file */
+    nbytes = vfs_span(fd, sizeof(bin_data), 4, &ptr);
+    TEST_ASSERT_EQUAL_INT(0, nbytes);
+    nbytes = vfs_span(fd, sizeof(bin_data) + 1, 4, &ptr);
+    TEST_ASSERT_EQUAL_INT(0, nbytes);
+    nbytes = vfs_span(fd, -1, 4, &ptr);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, nbytes);
+
+    /* the file position is not moved */
+    off_t pos = vfs_lseek(fd, 0, SEEK_CUR);
+    TEST_ASSERT_EQUAL_INT(0, pos);
+
+    res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    nbytes = vfs_span(fd, 0, 4, &ptr);
+    TEST_ASSERT_EQUAL_INT(-EBADF, nbytes);
+
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
 #if MODULE_NEWLIB || defined(BOARD_NATIVE)
 static void test_vfs_constfs__posix(void)
 {
@@ -210,6 +253,7 @@ Test *tests_vfs_mount_constfs_tests(void)
         new_TestFixture(test_vfs_umount__invalid_mount),
         new_TestFixture(test_vfs_constfs_open),
         new_TestFixture(test_vfs_constfs_read_lseek),
+        new_TestFixture(test_vfs_constfs_span),
 #if MODULE_NEWLIB || defined(BOARD_NATIVE)
         new_TestFixture(test_vfs_constfs__posix),
 #endif
@@ -127,9 +127,16 @@ static void counter_irq(void* arg)
     rtctimers_millis_set(&polling_timer, UMDK_COUNTER_SLEEP_TIME_MS);
 }
 
+/* counters change on every publication, the storage log spreads these writes */
+static inline void save_counters(void)
+{
+   unwds_write_nvram_storage(_UMDK_MID_, (uint8_t *) conf_counter.count_value, sizeof(conf_counter.count_value));
+}
+
 static inline void save_config(void)
 {
    unwds_write_nvram_config(_UMDK_MID_, (uint8_t *) &conf_counter, sizeof(conf_counter));
+   save_counters();
 }
 
 static void *handler(void *arg)
@@ -162,7 +169,7 @@ static void *handler(void *arg)
         *(tmp + 2) = (conf_counter.count_value[2] << 24);
         *(tmp + 2) |= conf_counter.count_value[3] & 0xFFFFFF;
 
-        save_config(); /* Save values into NVRAM */
+        save_counters(); /* Save values into NVRAM */
 
         callback(&data);
 
@@ -265,6 +272,8 @@ void umdk_counter_init(uwnds_cb_t *event_callback)
     if (!unwds_read_nvram_config(_UMDK_MID_, (uint8_t *) &conf_counter, sizeof(conf_counter))) {
         reset_config();
     }
+    /* the storage holds newer counters than a config saved by older firmware */
+    unwds_read_nvram_storage(_UMDK_MID_, (uint8_t *) conf_counter.count_value, sizeof(conf_counter.count_value));
 
     printf("[umdk-" _UMDK_NAME_ "] Current publish period: %d hour(s)\n", conf_counter.publish_period);
     
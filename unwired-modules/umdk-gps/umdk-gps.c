@@ -152,7 +152,7 @@ static void *timer_thread(void *arg) {
         /* Notify the application */
         callback(&data);
         /* Restart after delay */
-        rtctimers_millis_set_msg(&timer, 60000 * gps_config.publish_period_min, &timer_msg, timer_pid);
+        rtctimers_millis_set_msg_slack(&timer, 60000 * gps_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
     }
 
     return NULL;
@@ -181,7 +181,7 @@ static void set_period (int period) {
 
 	/* Don't restart timer if new period is zero */
 	if (gps_config.publish_period_min) {
-		rtctimers_millis_set_msg(&timer, 60000 * gps_config.publish_period_min, &timer_msg, timer_pid);
+		rtctimers_millis_set_msg_slack(&timer, 60000 * gps_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
 		printf("[umdk-" _UMDK_NAME_ "] Period set to %d minute (s)\n", gps_config.publish_period_min);
 	} else {
 		puts("[umdk-" _UMDK_NAME_ "] Timer stopped");
@@ -247,7 +247,7 @@ void umdk_gps_init(uwnds_cb_t *event_callback)
     timer_pid = thread_create(stack, UMDK_GPS_READER_STACK_SIZE, THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST, timer_thread, NULL, "gps thread");
 
     /* Start publishing timer */
-	rtctimers_millis_set_msg(&timer, 60000 * gps_config.publish_period_min, &timer_msg, timer_pid);
+	rtctimers_millis_set_msg_slack(&timer, 60000 * gps_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
     
     unwds_add_shell_command(_UMDK_NAME_, "type '" _UMDK_NAME_ "' for commands list", umdk_gps_shell_cmd);
 }
@@ -170,7 +170,7 @@ void set_period(int period) {
         
     printf("[umdk-" _UMDK_NAME_ "] Period set to %d minutes\n", hx711_config.publish_period_min);
     if (hx711_config.publish_period_min != 0) {
-        rtctimers_millis_set_msg(&timer, 60000 * hx711_config.publish_period_min, &timer_msg, timer_pid);
+        rtctimers_millis_set_msg_slack(&timer, 60000 * hx711_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
     } else {
         rtctimers_millis_remove(&timer);
     }
@@ -265,7 +265,7 @@ static void *timer_thread(void *arg) {
         callback(&data);
 
         /* Restart after delay */
-        rtctimers_millis_set_msg(&timer, 60000 * hx711_config.publish_period_min, &timer_msg, timer_pid);
+        rtctimers_millis_set_msg_slack(&timer, 60000 * hx711_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
     }
     
     return NULL;
@@ -294,7 +294,7 @@ void umdk_hx711_init(uwnds_cb_t *event_callback)
     
 
     /* Start publishing timer */
-	rtctimers_millis_set_msg(&timer, 60000 * hx711_config.publish_period_min, &timer_msg, timer_pid);
+	rtctimers_millis_set_msg_slack(&timer, 60000 * hx711_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
     
 #ifdef UNWD_CONNECT_BTN
     if (UNWD_USE_CONNECT_BTN) {
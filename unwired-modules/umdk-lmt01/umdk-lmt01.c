@@ -156,7 +156,7 @@ static void *timer_thread(void *arg) {
         callback(&data);
 
         /* Restart after delay */
-        rtctimers_millis_set_msg(&timer, 60000 * lmt01_config.publish_period_min, &timer_msg, timer_pid);
+        rtctimers_millis_set_msg_slack(&timer, 60000 * lmt01_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
     }
     
     return NULL;
@@ -184,7 +184,7 @@ static void set_period (int period) {
 
 	/* Don't restart timer if new period is zero */
 	if (lmt01_config.publish_period_min) {
-		rtctimers_millis_set_msg(&timer, 60000 * lmt01_config.publish_period_min, &timer_msg, timer_pid);
+		rtctimers_millis_set_msg_slack(&timer, 60000 * lmt01_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
 		printf("[umdk-" _UMDK_NAME_ "] Period set to %d minutes\n", lmt01_config.publish_period_min);
 	} else {
 		puts("[umdk-" _UMDK_NAME_ "] Timer stopped");
@@ -257,7 +257,7 @@ void umdk_lmt01_init(uwnds_cb_t *event_callback) {
 	timer_pid = thread_create(stack, UMDK_LMT01_STACK_SIZE, THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST, timer_thread, NULL, "lmt01 thread");
 
     /* Start publishing timer */
-	rtctimers_millis_set_msg(&timer, 60000 * lmt01_config.publish_period_min, &timer_msg, timer_pid);
+	rtctimers_millis_set_msg_slack(&timer, 60000 * lmt01_config.publish_period_min, UNWDS_PUBLISH_SLACK_MS, &timer_msg, timer_pid);
 }
 
 static void reply_fail(module_data_t *reply) {